@@ -12,5 +12,7 @@ set DEF_COMPILER_FLAGS=-mconsole -march=native -mtune=native -std=c89 -pedantic
 set DEF_FLAGS_LINKER=-lkernel32 -luser32 -lgdi32 -lopengl32
 
 cc -s -Os -shared %DEF_COMPILER_FLAGS% %NAME_APPLICATION%.c -o %NAME_APPLICATION%.dll
+REM Without AVX2/FMA for cpus that lack them, the platform layer picks it at runtime (speg_cpu_supports_avx2)
+cc -s -Os -shared %DEF_COMPILER_FLAGS% -march=x86-64-v2 %NAME_APPLICATION%.c -o %NAME_APPLICATION%_sse.dll
 cc -s -Os %DEF_COMPILER_FLAGS% -std=c99 %NAME_PLATFORM_LAYER%.c -o %NAME_PLATFORM_LAYER%.exe %DEF_FLAGS_LINKER%
 %NAME_PLATFORM_LAYER%.exe
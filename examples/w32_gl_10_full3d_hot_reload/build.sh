@@ -0,0 +1,29 @@
+#!/bin/sh
+# Builds the application code as shared object and the headless linux platform layer (no window, no OpenGL).
+# Used on build agents without a GPU to track the CPU cost of speg_update.
+
+NAME_PLATFORM_LAYER=speg_headless
+NAME_BENCHMARK=speg_bench
+NAME_APPLICATION=speg
+
+DEF_COMPILER_FLAGS="-march=native -mtune=native -pedantic \
+-Wall -Wextra -Werror -Wvla -Wconversion -Wdouble-promotion -Wsign-conversion -Wuninitialized -Winit-self -Wunused -Wunused-function -Wunused-macros -Wunused-parameter -Wunused-value -Wunused-variable -Wunused-local-typedefs"
+
+DEF_FLAGS_APPLICATION="-std=c89 -shared -fPIC -nodefaultlibs -nostdlib -fno-builtin -ffreestanding -fno-asynchronous-unwind-tables -Wl,-Bsymbolic"
+DEF_FLAGS_PLATFORM="-std=c99 -fno-builtin"
+DEF_FLAGS_LINKER="-ldl -lm -lpthread"
+
+set -e
+cd "$(dirname "$0")"
+
+cc -s -O2 $DEF_COMPILER_FLAGS $DEF_FLAGS_APPLICATION $NAME_APPLICATION.c -o $NAME_APPLICATION.so
+cc -s -O2 $DEF_COMPILER_FLAGS $DEF_FLAGS_APPLICATION -DSPEG_PERF_APPEND $NAME_APPLICATION.c -o ${NAME_APPLICATION}_perf.so
+# Without AVX2/FMA for cpus that lack them, the platform layer picks it at runtime (speg_cpu_supports_avx2)
+cc -s -O2 $DEF_COMPILER_FLAGS -march=x86-64-v2 $DEF_FLAGS_APPLICATION $NAME_APPLICATION.c -o ${NAME_APPLICATION}_sse.so
+# The scalar, SSE and AVX2 paths of vm.h for speg_bench
+cc -s -O2 $DEF_COMPILER_FLAGS $DEF_FLAGS_APPLICATION ${NAME_BENCHMARK}_vm.c -o ${NAME_BENCHMARK}_vm_scalar.so
+cc -s -O2 $DEF_COMPILER_FLAGS $DEF_FLAGS_APPLICATION -DVM_USE_SSE ${NAME_BENCHMARK}_vm.c -o ${NAME_BENCHMARK}_vm_sse.so
+cc -s -O2 $DEF_COMPILER_FLAGS $DEF_FLAGS_APPLICATION -DVM_USE_SSE -DVM_USE_AVX2 ${NAME_BENCHMARK}_vm.c -o ${NAME_BENCHMARK}_vm_avx2.so
+cc -s -O2 $DEF_COMPILER_FLAGS $DEF_FLAGS_PLATFORM $NAME_PLATFORM_LAYER.c -o $NAME_PLATFORM_LAYER $DEF_FLAGS_LINKER
+cc -s -O2 $DEF_COMPILER_FLAGS $DEF_FLAGS_PLATFORM $NAME_BENCHMARK.c -o $NAME_BENCHMARK $DEF_FLAGS_LINKER
+./$NAME_PLATFORM_LAYER "$@"
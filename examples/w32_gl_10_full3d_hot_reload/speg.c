@@ -1,6 +1,13 @@
 #include "speg.h"
 #define VM_USE_SSE
+#define VM_USE_AVX2
 #include "vm.h"
+#include "speg_bvh.h"
+#include "speg_scene.h"
+#include "speg_append.h"
+#include "speg_spatial.h"
+#define SPEG_OCCLUSION_USE_SSE
+#include "speg_occlusion.h"
 
 typedef struct speg_controller_input
 {
@@ -156,13 +163,15 @@ typedef struct camera
 
 void camera_update_vectors(camera *cam)
 {
-    float yawRadians = vm_radf(cam->yaw);
-    float pitchRadians = vm_radf(cam->pitch);
-    float pitchRadiansCos = vm_cosf(pitchRadians);
+    float yawSin, yawCos;
+    float pitchSin, pitchCos;
 
-    cam->front.x = vm_cosf(yawRadians) * pitchRadiansCos;
-    cam->front.y = vm_sinf(pitchRadians);
-    cam->front.z = vm_sinf(yawRadians) * pitchRadiansCos;
+    vm_sincosf(vm_radf(cam->yaw), &yawSin, &yawCos);
+    vm_sincosf(vm_radf(cam->pitch), &pitchSin, &pitchCos);
+
+    cam->front.x = yawCos * pitchCos;
+    cam->front.y = pitchSin;
+    cam->front.z = yawSin * pitchCos;
     cam->front = vm_v3_normalize(cam->front);
     cam->right = vm_v3_normalize(vm_v3_cross(cam->front, cam->worldUp));
     cam->up = vm_v3_normalize(vm_v3_cross(cam->right, cam->front));
@@ -294,53 +303,812 @@ void speg_float_to_string(float value, char *buffer, int precision)
     *buffer = '\0';
 }
 
+/* Profiler of the current frame (speg_state lives in permanent memory), set at the beginning of each speg_update */
+static speg_profiler *profiler;
+
+/* Registers name as profiler zone once and caches the zone index in the static variable zone */
+#define PROFILE_ZONE(p, zone, name) ((zone) < 0 ? ((zone) = (int)speg_profiler_zone_register(p, name)) : (zone))
+
+/* Records func_call as nested zone of the frame profiler (PROFILE_SUBMIT: of the submit phase profiler) */
 #define PROFILE(func_call) PROFILE_WITH_NAME(func_call, #func_call)
-#define PROFILE_WITH_NAME(func_call, name)                                       \
-    do                                                                           \
-    {                                                                            \
-        char floatBuffer[32];                                                    \
-        unsigned long __startCycles, __endCycles;                                \
-        double __startTimeNano, __endTimeNano;                                   \
-        float __timeMs;                                                          \
-        __startTimeNano = platformApi->platform_perf_current_time_nanoseconds(); \
-        __startCycles = platformApi->platform_perf_current_cycle_count();        \
-        func_call;                                                               \
-        __endCycles = platformApi->platform_perf_current_cycle_count();          \
-        __endTimeNano = platformApi->platform_perf_current_time_nanoseconds();   \
-        __timeMs = (float)((__endTimeNano - __startTimeNano) / 1000000.0);       \
-        speg_float_to_string(__timeMs, floatBuffer, 6);                          \
-        platformApi->platform_print_console(                                     \
-            __FILE__,                                                            \
-            __LINE__,                                                            \
-            "[speg-profiler] %8d cycles, %12s ms, \"%s\"\n",                     \
-            (__endCycles - __startCycles),                                       \
-            floatBuffer,                                                         \
-            name);                                                               \
+#define PROFILE_WITH_NAME(func_call, name) PROFILE_ON(profiler, func_call, name)
+#define PROFILE_SUBMIT(func_call, name) PROFILE_ON(submit_profiler, func_call, name)
+#define PROFILE_ON(p, func_call, name)                                       \
+    do                                                                       \
+    {                                                                        \
+        static int __zone = -1;                                              \
+        speg_profiler_begin(p, (unsigned int)PROFILE_ZONE(p, __zone, name)); \
+        func_call;                                                           \
+        speg_profiler_end(p, (unsigned int)__zone);                          \
     } while (0)
 
 static int default_texture_index = -1;
 
-void speg_draw_call_append(speg_draw_call *call, m4x4 *model, v3 *color, int texture_index)
+/* Commits pages of the growable draw calls (0 if the platform has none), set at the beginning of each speg_update */
+static func_speg_platform_memory_commit memory_commit;
+
+/* Job system of the platform (0 if it has none), set at the beginning of each speg_update */
+static func_speg_platform_job_parallel_for job_parallel_for;
+static func_speg_platform_job_wait job_wait;
+
+/* Calls function over [0, count) on the workers of the platform and waits for it, in place without a job system */
+void speg_parallel_for(speg_job_range_function function, void *data, int count, int batch)
 {
-    int m_offset = call->count_instances * VM_M4X4_ELEMENT_COUNT;
-    int c_offset = call->count_instances * VM_V3_ELEMENT_COUNT;
-    int t_offset = call->count_instances;
+    if (job_parallel_for && job_wait)
+    {
+        speg_job_counter counter = {0};
+
+        job_parallel_for(function, data, count, batch, &counter);
+        job_wait(&counter);
+    }
+    else if (count > 0)
+    {
+        function(data, 0, count, 0);
+    }
+}
+
+/* 32 bit words of the packed instance data, they alias the float instance buffers */
+#if defined(__GNUC__) || defined(__clang__)
+typedef unsigned int speg_word __attribute__((__may_alias__));
+#else
+typedef unsigned int speg_word;
+#endif
 
+/* Packs the instance to scratch memory and only writes it (and marks it dirty) if it differs from the current data */
+void speg_draw_call_update(speg_draw_call *call, int index, m4x4 *model, v3 *color, int texture_index)
+{
+    speg_word model_words[SPEG_INSTANCE_MAX_MODEL_SIZE / sizeof(speg_word)];
+    speg_word color_words[SPEG_INSTANCE_MAX_COLOR_SIZE / sizeof(speg_word)];
+    int model_count = speg_instance_model_size(call->instance_format) / (int)sizeof(speg_word);
+    int color_count = speg_instance_color_size(call->color_format) / (int)sizeof(speg_word);
+    speg_word *models = (speg_word *)call->models + index * model_count;
+    speg_word *colors = (speg_word *)call->colors + index * color_count;
+    speg_word differs = (speg_word)(call->texture_indices[index] != texture_index);
     int i;
 
-    assert(call->count_instances + 1 < call->count_instances_max);
+    speg_instance_pack_model(call->instance_format, model->e, model_words);
+    speg_instance_pack_color(call->color_format, &color->x, color_words);
 
-    for (i = 0; i < VM_M4X4_ELEMENT_COUNT; ++i)
+    for (i = 0; i < model_count; ++i)
     {
-        call->models[m_offset + i] = model->e[i];
+        differs |= models[i] ^ model_words[i];
+    }
+    for (i = 0; i < color_count; ++i)
+    {
+        differs |= colors[i] ^ color_words[i];
     }
 
-    call->colors[c_offset + 0] = color->x;
-    call->colors[c_offset + 1] = color->y;
-    call->colors[c_offset + 2] = color->z;
-    call->texture_indices[t_offset + 0] = texture_index;
+    if (!differs)
+    {
+        return;
+    }
+
+    for (i = 0; i < model_count; ++i)
+    {
+        models[i] = model_words[i];
+    }
+    for (i = 0; i < color_count; ++i)
+    {
+        colors[i] = color_words[i];
+    }
+    call->texture_indices[index] = texture_index;
+
+    speg_dirty_mark(&call->dirty, index, 1);
+}
+
+/* Growable draw calls: every array starts at a multiple of the allocation granularity of the reservation */
+#define SPEG_RESERVE_INSTANCES (1 << 20)
+#define SPEG_RESERVE_ALIGNMENT 65536UL
+#define SPEG_GROW_MIN_INSTANCES 1024
+
+#define SPEG_RESERVE_ALIGN(size) (((size) + SPEG_RESERVE_ALIGNMENT - 1) & ~(SPEG_RESERVE_ALIGNMENT - 1))
+
+/* Reserves address space for count instances of call in its formats, nothing is committed yet (count_instances_max
+ * is 0 until the first append). Returns the reserved size, 0 (call unchanged) if the platform can not reserve */
+unsigned long speg_draw_call_reserve(speg_draw_call *call, speg_platform_api *platformApi, int count)
+{
+    unsigned long size_models = SPEG_RESERVE_ALIGN((unsigned long)count * (unsigned long)speg_instance_model_size(call->instance_format));
+    unsigned long size_colors = SPEG_RESERVE_ALIGN((unsigned long)count * (unsigned long)speg_instance_color_size(call->color_format));
+    unsigned long size_textures = SPEG_RESERVE_ALIGN((unsigned long)count * sizeof(int));
+    unsigned char *memory;
+
+    if (!platformApi->platform_memory_reserve || !platformApi->platform_memory_commit || !platformApi->platform_memory_release)
+    {
+        return (0);
+    }
+
+    memory = (unsigned char *)platformApi->platform_memory_reserve(size_models + size_colors + size_textures);
+
+    if (!memory)
+    {
+        return (0);
+    }
+
+    call->models = (float *)memory;
+    call->colors = (float *)(memory + size_models);
+    call->texture_indices = (int *)(memory + size_models + size_colors);
+    call->count_instances = 0;
+    call->count_instances_max = 0;
+    call->count_instances_reserved = count;
+
+    return (size_models + size_colors + size_textures);
+}
+
+/* Commits the pages of a growable draw call for at least count instances, half the current capacity more so
+ * appends do not commit one page at a time. Returns 0 if call can not hold count instances */
+int speg_draw_call_grow(speg_draw_call *call, int count)
+{
+    unsigned long sizes[3];
+    unsigned char *arrays[3];
+    int capacity;
+    int i;
+
+    if (count <= call->count_instances_max)
+    {
+        return (1);
+    }
+
+    if (count > call->count_instances_reserved || !memory_commit)
+    {
+        return (0);
+    }
+
+    capacity = call->count_instances_max + call->count_instances_max / 2;
+    capacity = capacity < count ? count : capacity;
+    capacity = capacity < SPEG_GROW_MIN_INSTANCES ? SPEG_GROW_MIN_INSTANCES : capacity;
+    capacity = capacity > call->count_instances_reserved ? call->count_instances_reserved : capacity;
+
+    sizes[0] = (unsigned long)speg_instance_model_size(call->instance_format);
+    sizes[1] = (unsigned long)speg_instance_color_size(call->color_format);
+    sizes[2] = sizeof(int);
+    arrays[0] = (unsigned char *)call->models;
+    arrays[1] = (unsigned char *)call->colors;
+    arrays[2] = (unsigned char *)call->texture_indices;
+
+    /* Only the new part of each array, the committed part before it stays as it is */
+    for (i = 0; i < 3; ++i)
+    {
+        unsigned long committed = (unsigned long)call->count_instances_max * sizes[i];
+
+        if (!memory_commit(arrays[i] + committed, (unsigned long)capacity * sizes[i] - committed))
+        {
+            return (0);
+        }
+    }
+
+    call->count_instances_max = capacity;
+
+    return (1);
+}
+
+/* Packs one instance into index of a draw call without dirty tracking (capacity checked by the caller) */
+void speg_draw_call_write(speg_draw_call *call, int index, m4x4 *model, v3 *color, int texture_index)
+{
+    int i;
+
+    if (call->instance_format == SPEG_INSTANCE_FORMAT_M4X4)
+    {
+        int m_offset = index * VM_M4X4_ELEMENT_COUNT;
+
+        for (i = 0; i < VM_M4X4_ELEMENT_COUNT; ++i)
+        {
+            call->models[m_offset + i] = model->e[i];
+        }
+    }
+    else
+    {
+        unsigned char *models = (unsigned char *)call->models;
+        speg_instance_pack_model(call->instance_format, model->e, models + index * speg_instance_model_size(call->instance_format));
+    }
+
+    if (call->color_format == SPEG_INSTANCE_COLOR_RGB32F)
+    {
+        int c_offset = index * VM_V3_ELEMENT_COUNT;
+
+        call->colors[c_offset + 0] = color->x;
+        call->colors[c_offset + 1] = color->y;
+        call->colors[c_offset + 2] = color->z;
+    }
+    else
+    {
+        unsigned char *colors = (unsigned char *)call->colors;
+        speg_instance_pack_color(call->color_format, &color->x, colors + index * speg_instance_color_size(call->color_format));
+    }
+
+    call->texture_indices[index] = texture_index;
+}
+
+void speg_draw_call_append(speg_draw_call *call, m4x4 *model, v3 *color, int texture_index)
+{
+#ifdef SPEG_PERF_APPEND
+    /* Opt-in: a zone per append costs about as much as the append itself */
+    static int zone = -1;
+    speg_profiler_begin(profiler, (unsigned int)PROFILE_ZONE(profiler, zone, "speg_draw_call_append"));
+#endif
+
+    if (call->count_instances + 1 >= call->count_instances_max)
+    {
+        speg_draw_call_grow(call, call->count_instances + 2);
+    }
+
+    assert(call->count_instances + 1 < call->count_instances_max);
+
+    if (call->track_dirty)
+    {
+        speg_draw_call_update(call, call->count_instances, model, color, texture_index);
+    }
+    else
+    {
+        speg_draw_call_write(call, call->count_instances, model, color, texture_index);
+    }
 
     call->count_instances += 1;
+
+#ifdef SPEG_PERF_APPEND
+    speg_profiler_end(profiler, (unsigned int)zone);
+#endif
+}
+
+/* Instance arrays of call for count instances in its formats. Returns 0 (and leaves call without capacity) if the arena is full */
+int speg_draw_call_alloc(speg_draw_call *call, speg_arena *arena, int count)
+{
+    call->models = (float *)speg_arena_push(arena, (unsigned long)(count * speg_instance_model_size(call->instance_format)));
+    call->colors = (float *)speg_arena_push(arena, (unsigned long)(count * speg_instance_color_size(call->color_format)));
+    call->texture_indices = SPEG_ARENA_PUSH_ARRAY(arena, int, count);
+    call->count_instances = 0;
+    call->count_instances_max = call->models && call->colors && call->texture_indices ? count : 0;
+
+    return (call->count_instances_max == count);
+}
+
+/* Appends count instances with model = translate(position) * rotate(rotation) * scale(scale) (rotations and scales
+ * may be 0) and one color each. The batch kernels of vm.h write full and affine matrices straight into the models
+ * buffer, the other formats (and dirty tracked draw calls) go through a chunk of full matrices */
+#define SPEG_APPEND_CHUNK 64
+
+/* Writes count instances starting at first (capacity checked by the caller) */
+void speg_draw_call_write_trs(speg_draw_call *call, int first, const v3 *positions, const quat *rotations, const v3 *scales, const v3 *colors, int count, int texture_index)
+{
+    int model_size = speg_instance_model_size(call->instance_format);
+    int color_size = speg_instance_color_size(call->color_format);
+    unsigned char *models = (unsigned char *)call->models;
+    unsigned char *instance_colors = (unsigned char *)call->colors;
+    int i;
+
+    if (call->track_dirty || (call->instance_format != SPEG_INSTANCE_FORMAT_M4X4 && call->instance_format != SPEG_INSTANCE_FORMAT_AFFINE))
+    {
+        m4x4 chunk[SPEG_APPEND_CHUNK];
+        int chunk_first;
+
+        for (chunk_first = 0; chunk_first < count; chunk_first += SPEG_APPEND_CHUNK)
+        {
+            int chunk_count = count - chunk_first < SPEG_APPEND_CHUNK ? count - chunk_first : SPEG_APPEND_CHUNK;
+
+            vm_m4x4_trs_batch(positions + chunk_first, rotations ? rotations + chunk_first : 0, scales ? scales + chunk_first : 0, chunk_count, chunk[0].e, VM_M4X4_ELEMENT_COUNT);
+
+            for (i = 0; i < chunk_count; ++i)
+            {
+                v3 color = colors[chunk_first + i];
+
+                if (call->track_dirty)
+                {
+                    speg_draw_call_update(call, first + chunk_first + i, &chunk[i], &color, texture_index);
+                }
+                else
+                {
+                    speg_instance_pack_model(call->instance_format, chunk[i].e, models + (first + chunk_first + i) * model_size);
+                }
+            }
+        }
+    }
+    else
+    {
+        float *out = (float *)(models + first * model_size);
+
+        if (call->instance_format == SPEG_INSTANCE_FORMAT_M4X4)
+        {
+            vm_m4x4_trs_batch(positions, rotations, scales, count, out, VM_M4X4_ELEMENT_COUNT);
+        }
+        else
+        {
+            vm_affine_trs_batch(positions, rotations, scales, count, out, model_size / (int)sizeof(float));
+        }
+    }
+
+    if (!call->track_dirty)
+    {
+        for (i = 0; i < count; ++i)
+        {
+            speg_instance_pack_color(call->color_format, &colors[i].x, instance_colors + (first + i) * color_size);
+            call->texture_indices[first + i] = texture_index;
+        }
+    }
+}
+
+void speg_draw_call_append_trs(speg_draw_call *call, const v3 *positions, const quat *rotations, const v3 *scales, const v3 *colors, int count, int texture_index)
+{
+    int first = call->count_instances;
+
+    if (first + count + 1 > call->count_instances_max)
+    {
+        speg_draw_call_grow(call, first + count + 1);
+    }
+
+    assert(first + count < call->count_instances_max);
+
+    speg_draw_call_write_trs(call, first, positions, rotations, scales, colors, count, texture_index);
+
+    call->count_instances += count;
+}
+
+/* Copies count instances of src starting at src_first to dst_first of dst (both in the same instance/color format).
+ * Packed halves and bytes are copied as 32 bit words, they must not pass through float registers.
+ * With dst->track_dirty only the instances that differ are written and marked dirty. */
+void speg_draw_call_copy(speg_draw_call *dst, int dst_first, speg_draw_call *src, int src_first, int count)
+{
+    int model_words = speg_instance_model_size(src->instance_format) / (int)sizeof(speg_word);
+    int color_words = speg_instance_color_size(src->color_format) / (int)sizeof(speg_word);
+
+    speg_word *models_src = (speg_word *)src->models + src_first * model_words;
+    speg_word *models_dst = (speg_word *)dst->models + dst_first * model_words;
+    speg_word *colors_src = (speg_word *)src->colors + src_first * color_words;
+    speg_word *colors_dst = (speg_word *)dst->colors + dst_first * color_words;
+    int *textures_src = src->texture_indices + src_first;
+    int *textures_dst = dst->texture_indices + dst_first;
+
+    int i;
+    int k;
+
+    assert(dst->instance_format == src->instance_format && dst->color_format == src->color_format);
+
+    speg_draw_call_grow(dst, dst_first + count);
+    assert(dst_first + count <= dst->count_instances_max);
+
+    if (dst->track_dirty)
+    {
+        for (i = 0; i < count; ++i)
+        {
+            speg_word differs = (speg_word)(textures_dst[i] != textures_src[i]);
+
+            for (k = 0; k < model_words; ++k)
+            {
+                differs |= models_dst[k] ^ models_src[k];
+            }
+            for (k = 0; k < color_words; ++k)
+            {
+                differs |= colors_dst[k] ^ colors_src[k];
+            }
+
+            if (differs)
+            {
+                for (k = 0; k < model_words; ++k)
+                {
+                    models_dst[k] = models_src[k];
+                }
+                for (k = 0; k < color_words; ++k)
+                {
+                    colors_dst[k] = colors_src[k];
+                }
+                textures_dst[i] = textures_src[i];
+
+                speg_dirty_mark(&dst->dirty, dst_first + i, 1);
+            }
+
+            models_src += model_words;
+            models_dst += model_words;
+            colors_src += color_words;
+            colors_dst += color_words;
+        }
+        return;
+    }
+
+    for (i = 0; i < count * model_words; ++i)
+    {
+        models_dst[i] = models_src[i];
+    }
+    for (i = 0; i < count * color_words; ++i)
+    {
+        colors_dst[i] = colors_src[i];
+    }
+    for (i = 0; i < count; ++i)
+    {
+        textures_dst[i] = textures_src[i];
+    }
+}
+
+/* Appends to one draw call from parallel-for jobs. Each job appends through its own cursor into blocks reserved
+ * with one atomic add (speg_append.h), speg_parallel_append_end compacts the blocks behind the instances the call
+ * had before. With ordered the result is the same as appending the ranges one after another */
+typedef struct speg_parallel_append
+{
+    speg_append append;
+    speg_draw_call *call;
+    int first; /* count_instances of call at begin */
+
+} speg_parallel_append;
+
+/* blocks holds SPEG_APPEND_BLOCKS_CAPACITY(capacity, block_size). Ordered needs a second capacity behind the first
+ * one to put the blocks in order. Returns 0 if call can not hold that (append serially then) */
+int speg_parallel_append_begin(speg_parallel_append *append, speg_draw_call *call, speg_append_block *blocks, int capacity, int block_size, int ordered)
+{
+    int needed = call->count_instances + (ordered ? 2 * capacity : capacity) + 1;
+
+    /* Jobs write the instances in place, dirty tracking marks ranges from a single thread */
+    if (call->track_dirty || (needed > call->count_instances_max && !speg_draw_call_grow(call, needed)))
+    {
+        return (0);
+    }
+
+    speg_append_init(&append->append, blocks, SPEG_APPEND_BLOCKS_CAPACITY(capacity, block_size), capacity, block_size, ordered);
+    append->call = call;
+    append->first = call->count_instances;
+
+    return (1);
+}
+
+/* speg_draw_call_append_trs from a job, count instances through cursor */
+void speg_parallel_append_trs(speg_parallel_append *append, speg_append_cursor *cursor, const v3 *positions, const quat *rotations, const v3 *scales, const v3 *colors, int count, int texture_index)
+{
+    int done = 0;
+
+    while (done < count)
+    {
+        int granted;
+        int slot = speg_append_reserve(cursor, count - done, &granted);
+
+        if (slot < 0)
+        {
+            return;
+        }
+
+        speg_draw_call_write_trs(append->call, append->first + slot, positions + done, rotations ? rotations + done : 0, scales ? scales + done : 0, colors + done, granted, texture_index);
+        done += granted;
+    }
+}
+
+/* speg_draw_call_append from a job */
+void speg_parallel_append_instance(speg_parallel_append *append, speg_append_cursor *cursor, m4x4 *model, v3 *color, int texture_index)
+{
+    int granted;
+    int slot = speg_append_reserve(cursor, 1, &granted);
+
+    if (slot >= 0)
+    {
+        speg_draw_call_write(append->call, append->first + slot, model, color, texture_index);
+    }
+}
+
+/* Slots of the append are the instances behind the ones the call had at begin, speg_draw_call_copy runs forward */
+void speg_parallel_append_copy(void *data, int dst, int src, int count)
+{
+    speg_parallel_append *append = (speg_parallel_append *)data;
+    speg_draw_call_copy(append->call, append->first + dst, append->call, append->first + src, count);
+}
+
+/* After all jobs finished: compacts the blocks and returns the number of instances appended */
+int speg_parallel_append_end(speg_parallel_append *append)
+{
+    int total;
+
+    assert(append->append.dropped == 0);
+
+    speg_append_end(&append->append);
+    total = speg_append_compact(&append->append, speg_parallel_append_copy, append);
+    append->call->count_instances = append->first + total;
+
+    return (total);
+}
+
+/* Points the instance arrays of a changed draw call at the streaming memory of the current frame so appends write
+ * straight into the mapped GPU buffer. Without platform support the draw call uses its own arrays */
+void speg_draw_call_stream(speg_draw_call *call, speg_platform_api *platformApi, float *models, float *colors, int *texture_indices)
+{
+    unsigned int size_models = (unsigned int)(call->count_instances_max * speg_instance_model_size(call->instance_format));
+    unsigned int size_colors = (unsigned int)(call->count_instances_max * speg_instance_color_size(call->color_format));
+    unsigned int size_textures = (unsigned int)call->count_instances_max * (unsigned int)sizeof(int);
+    unsigned char *memory = 0;
+
+    assert(call->changed && !call->track_dirty);
+
+    if (platformApi->platform_stream_alloc)
+    {
+        memory = (unsigned char *)platformApi->platform_stream_alloc(size_models + size_colors + size_textures, &call->stream_position);
+    }
+
+    if (memory)
+    {
+        call->models = (float *)memory;
+        call->colors = (float *)(memory + size_models);
+        call->texture_indices = (int *)(memory + size_models + size_colors);
+        call->streamed = true;
+    }
+    else
+    {
+        call->models = models;
+        call->colors = colors;
+        call->texture_indices = texture_indices;
+        call->streamed = false;
+    }
+}
+
+/* Render queue: instances submitted with speg_draw_call_submit are packed into a slot per submission, sorted by key
+ * at the end of the frame and merged into one instanced draw per mesh and state. Prebuilt draw calls (the culled
+ * static scene, the dirty tracked text) are sorted with them and drawn as they are */
+#define SPEG_DEFAULT_QUEUE_CAPACITY 4096
+#define QUEUE_SLOT_WORDS ((SPEG_INSTANCE_MAX_MODEL_SIZE + SPEG_INSTANCE_MAX_COLOR_SIZE) / 4 + 1) /* model, color, texture index */
+
+#define SPEG_LAYER_WORLD 0
+#define SPEG_LAYER_GUI 1
+#define SPEG_LAYER_TEXT 2
+
+/* Everything the submit phase reads of a frame, filled by the simulate phase and not changed after it. Items, slots
+ * and calls live in the frame memory, allocated by speg_render_queue_begin. Pipelined frames (speg_simulate and
+ * speg_submit) give every packet its own part of the transient memory and copy the prebuilt draw calls into it */
+typedef struct speg_frame_packet
+{
+    speg_queue queue; /* sorted at the end of the simulate phase */
+    speg_word *slots;
+    speg_draw_call **calls; /* the submitting draw call (mesh and state) per item */
+
+    m4x4 projection_view;
+    m4x4 ortho_proj;
+
+    speg_arena *memory; /* scratch memory of the submit phase */
+    speg_arena arena;   /* memory of a pipelined packet */
+    int snapshots;      /* prebuilt draw calls are copies (speg_draw_call_snapshot), the live ones in speg_update */
+
+} speg_frame_packet;
+
+static speg_frame_packet frame_packets[SPEG_FRAME_PACKETS];
+static speg_frame_packet *frame; /* filled by the current simulate phase */
+static int frame_last = -1;      /* packet of the last simulated frame, drawn again while debug mode holds the frame */
+
+static speg_arena *render_queue_arena;  /* frame memory of the snapshots */
+static float render_queue_depth_row[4]; /* view space depth of a world position */
+static unsigned int render_queue_instances;
+
+/* Profiler of the submit phase: the frame profiler in speg_update, speg_state.profiler_submit in speg_submit */
+static speg_profiler *submit_profiler;
+
+/* Batches are streamed (speg_draw_call_stream), the fallback arrays come from transient memory */
+static speg_draw_call draw_call_batch = {0};
+
+/* Shared geometry of all meshes for the multi draw indirect passes (permanent memory) */
+static speg_geometry geometry;
+static speg_indirect_list pass_commands;
+
+/* Instance layout and color format select the shader program */
+speg_queue_key speg_draw_call_key(speg_draw_call *call, int prebuilt, float depth)
+{
+    unsigned int program = (unsigned int)(call->instance_format | call->color_format << 3);
+    return (speg_queue_key_make((unsigned int)call->layer, call->is_2d, call->mesh->faceCulling, program, (unsigned int)call->mesh->queue_index, prebuilt, depth));
+}
+
+/* Clears the queue of the current frame packet and allocates room for capacity submissions from the frame arena
+ * (none if it is full) */
+void speg_render_queue_begin(m4x4 view, speg_arena *arena, unsigned int capacity)
+{
+    speg_queue_item *items = SPEG_ARENA_PUSH_ARRAY(arena, speg_queue_item, capacity);
+    speg_queue_item *scratch = SPEG_ARENA_PUSH_ARRAY(arena, speg_queue_item, capacity);
+
+    frame->slots = SPEG_ARENA_PUSH_ARRAY(arena, speg_word, capacity * QUEUE_SLOT_WORDS);
+    frame->calls = SPEG_ARENA_PUSH_ARRAY(arena, speg_draw_call *, capacity);
+    render_queue_arena = arena;
+
+    render_queue_depth_row[0] = -view.e[2];
+    render_queue_depth_row[1] = -view.e[6];
+    render_queue_depth_row[2] = -view.e[10];
+    render_queue_depth_row[3] = -view.e[14];
+    render_queue_instances = 0;
+
+    speg_queue_init(&frame->queue, items, scratch, items && scratch && frame->slots && frame->calls ? capacity : 0);
+}
+
+/* Submits an instance drawn with the mesh and state of call (its instance arrays are not used) */
+void speg_draw_call_submit(speg_draw_call *call, m4x4 *model, v3 *color, int texture_index)
+{
+    unsigned int index = frame->queue.count;
+    speg_word *slot = frame->slots + index * QUEUE_SLOT_WORDS;
+    float depth = 0.0f;
+
+    /* 2D overlays keep their submission order */
+    if (!call->is_2d)
+    {
+        depth = render_queue_depth_row[0] * model->e[12] + render_queue_depth_row[1] * model->e[13] + render_queue_depth_row[2] * model->e[14] + render_queue_depth_row[3];
+    }
+
+    if (!speg_queue_push(&frame->queue, speg_draw_call_key(call, false, depth), index))
+    {
+        return;
+    }
+
+    frame->calls[index] = call;
+    render_queue_instances++;
+
+    speg_instance_pack_model(call->instance_format, model->e, slot);
+    speg_instance_pack_color(call->color_format, &color->x, (unsigned char *)slot + SPEG_INSTANCE_MAX_MODEL_SIZE);
+    slot[QUEUE_SLOT_WORDS - 1] = (speg_word)texture_index;
+}
+
+/* Copy of a prebuilt draw call for a pipelined frame packet, the simulate phase of the next frame changes call while
+ * this one is submitted. The instance arrays of draw calls written every frame (changed, track_dirty) are copied and
+ * their dirty ranges move to the copy, the others (static scene) are not written after they were built. Returns 0
+ * if the arena is full */
+speg_draw_call *speg_draw_call_snapshot(speg_draw_call *call, speg_arena *arena)
+{
+    speg_draw_call *copy = SPEG_ARENA_PUSH_ARRAY(arena, speg_draw_call, 1);
+
+    if (!copy)
+    {
+        return (0);
+    }
+
+    *copy = *call;
+
+    /* The commands already live in the frame memory */
+    if (call->indirect)
+    {
+        copy->indirect = SPEG_ARENA_PUSH_ARRAY(arena, speg_indirect_list, 1);
+
+        if (!copy->indirect)
+        {
+            return (0);
+        }
+        *copy->indirect = *call->indirect;
+    }
+
+    if (call->changed || call->track_dirty)
+    {
+        /* Sized to the instances: a platform reallocating its buffers for count_instances_max uploads only these */
+        copy->track_dirty = false;
+        copy->count_instances_reserved = 0;
+
+        if (!speg_draw_call_alloc(copy, arena, call->count_instances))
+        {
+            return (0);
+        }
+
+        speg_draw_call_copy(copy, 0, call, 0, call->count_instances);
+        copy->count_instances = call->count_instances;
+        speg_dirty_clear(&call->dirty);
+    }
+
+    return (copy);
+}
+
+/* Submits a whole draw call, sorted with the instances but never merged */
+void speg_render_queue_call(speg_draw_call *call)
+{
+    unsigned int index = frame->queue.count;
+
+    if (call->count_instances > 0 && frame->snapshots)
+    {
+        call = speg_draw_call_snapshot(call, render_queue_arena);
+    }
+
+    if (call && call->count_instances > 0 && speg_queue_push(&frame->queue, speg_draw_call_key(call, true, 0.0f), index))
+    {
+        frame->calls[index] = call;
+    }
+}
+
+/* Gathers the instances of the queue items [first, end) of packet in key order into the instance arrays of batch */
+void speg_render_queue_gather(speg_frame_packet *packet, speg_draw_call *batch, unsigned int first, unsigned int end)
+{
+    speg_queue_item *items = packet->queue.items;
+    int model_words = speg_instance_model_size(batch->instance_format) / (int)sizeof(speg_word);
+    int color_words = speg_instance_color_size(batch->color_format) / (int)sizeof(speg_word);
+    speg_word *models = (speg_word *)batch->models;
+    speg_word *colors = (speg_word *)batch->colors;
+    unsigned int i;
+    int k;
+
+    for (i = first; i < end; ++i)
+    {
+        speg_word *slot = packet->slots + items[i].index * QUEUE_SLOT_WORDS;
+        speg_word *slot_color = slot + SPEG_INSTANCE_MAX_MODEL_SIZE / (int)sizeof(speg_word);
+
+        for (k = 0; k < model_words; ++k)
+        {
+            *models++ = slot[k];
+        }
+        for (k = 0; k < color_words; ++k)
+        {
+            *colors++ = slot_color[k];
+        }
+        batch->texture_indices[i - first] = (int)slot[QUEUE_SLOT_WORDS - 1];
+    }
+}
+
+/* Draws the sorted queue of a frame packet, the instances of a batch are gathered in key order into draw_call_batch.
+ * With platform_draw_indirect the batches of all meshes in a pass are gathered together and drawn by one
+ * multi draw, one command per mesh selects its instances by base_instance. Per pass scratch memory comes from a
+ * temp block of the packet memory, the queue itself is left untouched (debug mode draws it again) */
+void speg_render_queue_flush(speg_frame_packet *packet, speg_platform_api *platformApi)
+{
+    int indirect = platformApi->platform_draw_indirect != 0;
+    float *projection_view = packet->projection_view.e;
+    float *ortho_proj = packet->ortho_proj.e;
+    speg_arena *arena = packet->memory;
+    unsigned int first;
+    unsigned int end;
+
+    for (first = 0; first < packet->queue.count; first = end)
+    {
+        speg_queue_item *items = packet->queue.items;
+        speg_draw_call *call = packet->calls[items[first].index];
+        speg_draw_call *batch = &draw_call_batch;
+        speg_arena_temp temp;
+        unsigned int batch_first;
+        unsigned int batch_end;
+
+        end = indirect ? speg_queue_pass_end(&packet->queue, first) : speg_queue_batch_end(&packet->queue, first);
+
+        if (speg_queue_key_prebuilt(items[first].key))
+        {
+            if (indirect && call->indirect)
+            {
+                if (call->indirect->count > 0)
+                {
+                    PROFILE_SUBMIT(platformApi->platform_draw_indirect(call, &geometry, call->indirect->commands, (int)call->indirect->count, call->is_2d ? ortho_proj : projection_view), "platform_draw_indirect");
+                }
+            }
+            else
+            {
+                PROFILE_SUBMIT(platformApi->platform_draw(call, call->is_2d ? ortho_proj : projection_view), "platform_draw");
+            }
+            continue;
+        }
+
+        batch->mesh = call->mesh;
+        batch->instance_format = call->instance_format;
+        batch->color_format = call->color_format;
+        batch->is_2d = call->is_2d;
+        batch->layer = call->layer;
+        batch->changed = true;
+        batch->count_instances = (int)(end - first);
+        batch->count_instances_max = batch->count_instances;
+
+        temp = speg_arena_temp_begin(arena);
+
+        speg_draw_call_stream(batch, platformApi,
+                              (float *)speg_arena_push(arena, (unsigned long)(batch->count_instances * speg_instance_model_size(batch->instance_format))),
+                              (float *)speg_arena_push(arena, (unsigned long)(batch->count_instances * speg_instance_color_size(batch->color_format))),
+                              SPEG_ARENA_PUSH_ARRAY(arena, int, batch->count_instances));
+
+        if (!batch->models || !batch->colors || !batch->texture_indices)
+        {
+            speg_arena_temp_end(temp);
+            continue;
+        }
+
+        speg_render_queue_gather(packet, batch, first, end);
+
+        if (!indirect)
+        {
+            PROFILE_SUBMIT(platformApi->platform_draw(batch, batch->is_2d ? ortho_proj : projection_view), "platform_draw");
+            speg_arena_temp_end(temp);
+            continue;
+        }
+
+        /* At most one command per batch */
+        speg_indirect_init(&pass_commands, SPEG_ARENA_PUSH_ARRAY(arena, speg_indirect_command, end - first), end - first);
+
+        for (batch_first = first; batch_first < end; batch_first = batch_end)
+        {
+            speg_mesh *mesh = packet->calls[items[batch_first].index]->mesh;
+
+            batch_end = speg_queue_batch_end(&packet->queue, batch_first);
+            speg_indirect_push(&pass_commands, (unsigned int)mesh->indicesCount, mesh->first_index, mesh->base_vertex, batch_first - first, batch_end - batch_first);
+        }
+
+        if (pass_commands.commands)
+        {
+            PROFILE_SUBMIT(platformApi->platform_draw_indirect(batch, &geometry, pass_commands.commands, (int)pass_commands.count, batch->is_2d ? ortho_proj : projection_view), "platform_draw_indirect");
+        }
+
+        speg_arena_temp_end(temp);
+    }
 }
 
 /* Render X, Y, Z axis lines (we use cubes but scaled in length and reduced in thichness)*/
@@ -375,178 +1143,387 @@ void render_coordinate_axis(speg_draw_call *call)
 
 void render_grid(speg_draw_call *call)
 {
+#define GRID_SIZE 101 /* Uneven for perfect alignment */
     float grid_line_thickness = 0.01f;
-    int grid_size = 101; /* Uneven for perfect alignment */
-    float grid_line_length = (float)grid_size - 1.0f;
+    float grid_line_length = (float)GRID_SIZE - 1.0f;
     v3 grid_color = vm_v3(0.3f, 0.3f, 0.3f);
 
+    /* Lines along x and z alternating */
+    v3 positions[GRID_SIZE * 2];
+    v3 scales[GRID_SIZE * 2];
+    v3 colors[GRID_SIZE * 2];
+
     int i;
 
-    for (i = 0; i < grid_size; ++i)
-    {
-        float grid_line_pos = (float)(i - (int)((float)grid_size * 0.5f));
-        m4x4 grid_line_model_x = vm_m4x4_scale(vm_m4x4_translate(vm_m4x4_identity, vm_v3(0.0f, 0.0f, grid_line_pos)), vm_v3(grid_line_length, grid_line_thickness, grid_line_thickness));
-        m4x4 grid_line_model_z = vm_m4x4_scale(vm_m4x4_translate(vm_m4x4_identity, vm_v3(grid_line_pos, 0.0f, 0.0f)), vm_v3(grid_line_thickness, grid_line_thickness, grid_line_length));
-        speg_draw_call_append(call, &grid_line_model_x, &grid_color, default_texture_index);
-        speg_draw_call_append(call, &grid_line_model_z, &grid_color, default_texture_index);
+    for (i = 0; i < GRID_SIZE; ++i)
+    {
+        float grid_line_pos = (float)(i - (int)((float)GRID_SIZE * 0.5f));
+
+        positions[i * 2 + 0] = vm_v3(0.0f, 0.0f, grid_line_pos);
+        scales[i * 2 + 0] = vm_v3(grid_line_length, grid_line_thickness, grid_line_thickness);
+        positions[i * 2 + 1] = vm_v3(grid_line_pos, 0.0f, 0.0f);
+        scales[i * 2 + 1] = vm_v3(grid_line_thickness, grid_line_thickness, grid_line_length);
+        colors[i * 2 + 0] = grid_color;
+        colors[i * 2 + 1] = grid_color;
+    }
+
+    speg_draw_call_append_trs(call, positions, 0, scales, colors, GRID_SIZE * 2, default_texture_index);
+}
+
+/* Takes 3 random numbers from seed, none for the first cube */
+void spawn_random_cube(int i, float range, unsigned int *seed, v3 *position, v3 *color)
+{
+    static const float color_scale = 1.0f / 255.0f;
+    unsigned int c = ((unsigned int)i == 0 ? 1 : (unsigned int)i) * 10000000;
+    float r = ((float)(((c >> 16) & 0xFF) >> 1)) * color_scale;
+    float g = ((float)((c >> 8) & 0xFF)) * color_scale;
+    float b = ((float)(c & 0xFF)) * color_scale;
+
+    if (i == 0)
+    {
+        *color = vm_v3_one;
+        *position = vm_v3_zero;
+    }
+    else
+    {
+        *color = vm_v3(r, g, b);
+        position->x = vm_randf_range_seed(seed, -range, range);
+        position->y = vm_randf_range_seed(seed, -range, range);
+        position->z = vm_randf_range_seed(seed, -range, range);
+    }
+}
+
+/* Software occlusion buffer of render_cubes */
+#define CUBES_OCCLUDER_DISTANCE 5.0f
+static speg_occlusion occlusion;
+
+/* Model matrices of a range of cubes (a parallel-for job, the cubes of a range never overlap another one) */
+#define CUBES_MODELS_BATCH 256
+typedef struct render_cubes_models
+{
+    v3 *positions;
+    quat *rotations;
+    m4x4 *models;
+
+} render_cubes_models;
+
+void render_cubes_models_range(void *data, int first, int count, int worker)
+{
+    render_cubes_models *job = (render_cubes_models *)data;
+    (void)worker;
+
+    vm_m4x4_trs_batch(&job->positions[first], &job->rotations[first], 0, count, job->models[first].e, VM_M4X4_ELEMENT_COUNT);
+}
+
+void render_cubes(speg_draw_call *call, m4x4 projection, m4x4 view, speg_state *state, speg_controller_input *input, float range, camera *cam)
+{
+
+#define NUM_INSTANCED_FRUST_CUBES 1000
+    static int numCubes = NUM_INSTANCED_FRUST_CUBES;
+
+    /* Spatial index of the cubes, they are inserted once and moved every frame */
+#define CUBES_GRID_CELLS 4
+    static speg_spatial_grid grid;
+    static speg_spatial_cell grid_cells[CUBES_GRID_CELLS * CUBES_GRID_CELLS * CUBES_GRID_CELLS];
+    static int grid_occupied[CUBES_GRID_CELLS * CUBES_GRID_CELLS * CUBES_GRID_CELLS];
+    static speg_spatial_object grid_objects[NUM_INSTANCED_FRUST_CUBES];
+    static int grid_handles[NUM_INSTANCED_FRUST_CUBES];
+    static int grid_results[NUM_INSTANCED_FRUST_CUBES];
+    static bool grid_initialized;
+
+    static v3 positions[NUM_INSTANCED_FRUST_CUBES];
+    static v3 colors[NUM_INSTANCED_FRUST_CUBES];
+    static quat rotations[NUM_INSTANCED_FRUST_CUBES]; /* 20 degrees more per cube, the same every frame */
+    static m4x4 models[NUM_INSTANCED_FRUST_CUBES];
+    static unsigned int visibility[(NUM_INSTANCED_FRUST_CUBES + 31) / 32];
+
+    m4x4 projection_view = vm_m4x4_mul(projection, view);
+    frustum frustum_planes = vm_frustum_extract_planes(projection_view);
+    int visible_count;
+    int i;
+
+    const v3 rotation_axis = vm_v3_normalize(vm_v3(1.0f, 0.3f, 0.5f));
+    const v3 color_red = vm_v3(1.0f, 0.0f, 0.0f);
+    const v3 color_occluded = vm_v3(1.0f, 0.0f, 1.0f);
+    const v3 cube_half_extents = vm_v3(0.5f, 0.5f, 0.5f);
+
+    /* Broad phase box around the bounding sphere of the unit cube, covers every rotation */
+    const float bounds_extents[3] = {0.8660254f, 0.8660254f, 0.8660254f};
+
+    if (!grid_initialized)
+    {
+        float origin[3];
+        origin[0] = origin[1] = origin[2] = -range;
+
+        speg_spatial_init(&grid, origin, 2.0f * range / (float)CUBES_GRID_CELLS, CUBES_GRID_CELLS, CUBES_GRID_CELLS, CUBES_GRID_CELLS,
+                          grid_cells, grid_occupied, grid_objects, NUM_INSTANCED_FRUST_CUBES);
+        grid_initialized = true;
+
+        for (i = 0; i < NUM_INSTANCED_FRUST_CUBES; ++i)
+        {
+            rotations[i] = vm_quat_from_axis_angle_m4x4(rotation_axis, vm_radf(20.0f * (float)i));
+        }
+    }
+
+    vm_seed_lcg = 12345;
+
+    for (i = 0; i < numCubes; ++i)
+    {
+        float center[3];
+
+        spawn_random_cube(i, range, &vm_seed_lcg, &positions[i], &colors[i]);
+
+        if (i == 0)
+        {
+            positions[i] = vm_v3(-2.0f, 0.0f, 0.0f);
+        }
+
+        center[0] = positions[i].x;
+        center[1] = positions[i].y;
+        center[2] = positions[i].z;
+
+        if (grid.objects_count < numCubes)
+        {
+            grid_handles[i] = speg_spatial_insert(&grid, center, bounds_extents, i);
+        }
+        else
+        {
+            speg_spatial_move(&grid, grid_handles[i], center, bounds_extents);
+        }
+    }
+
+    /* Model matrices of all cubes in batches spread over the workers, the first cube looks at the camera */
+    {
+        render_cubes_models models_job;
+
+        models_job.positions = positions;
+        models_job.rotations = rotations;
+        models_job.models = models;
+
+        speg_parallel_for(render_cubes_models_range, &models_job, numCubes, CUBES_MODELS_BATCH);
     }
-}
+    models[0] = vm_m4x4_lookAt_model(positions[0], cam->position, cam->worldUp);
 
-void spawn_random_cube(int i, float range, v3 *position, v3 *color)
-{
-    static const float color_scale = 1.0f / 255.0f;
-    unsigned int c = ((unsigned int)i == 0 ? 1 : (unsigned int)i) * 10000000;
-    float r = ((float)(((c >> 16) & 0xFF) >> 1)) * color_scale;
-    float g = ((float)((c >> 8) & 0xFF)) * color_scale;
-    float b = ((float)(c & 0xFF)) * color_scale;
+    visible_count = speg_spatial_query_frustum(&grid, (float *)vm_frustum_data(&frustum_planes), grid_results, NUM_INSTANCED_FRUST_CUBES);
 
-    if (i == 0)
+    for (i = 0; i < (numCubes + 31) / 32; ++i)
     {
-        *color = vm_v3_one;
-        *position = vm_v3_zero;
+        visibility[i] = 0;
     }
-    else
+
+    for (i = 0; i < visible_count; ++i)
     {
-        *color = vm_v3(r, g, b);
-        position->x = vm_randf_range(-range, range);
-        position->y = vm_randf_range(-range, range);
-        position->z = vm_randf_range(-range, range);
+        int index = grid.objects[grid_results[i]].user;
+        visibility[index >> 5] |= 1u << (index & 31);
     }
-}
-
-void render_cubes(speg_draw_call *call, m4x4 projection, m4x4 view, speg_state *state, speg_controller_input *input, float range, camera *cam)
-{
-
-#define NUM_INSTANCED_FRUST_CUBES 1000
-    static int numCubes = NUM_INSTANCED_FRUST_CUBES;
 
-    m4x4 projection_view = vm_m4x4_mul(projection, view);
-    frustum frustum_planes = vm_frustum_extract_planes(projection_view);
-    int i;
+    /* Occluders: the visible cubes close to the camera cover most of the screen behind them */
+    speg_occlusion_begin(&occlusion, projection_view.e);
 
-    const v3 rotation_axis = vm_v3_normalize(vm_v3(1.0f, 0.3f, 0.5f));
-    const v3 color_red = vm_v3(1.0f, 0.0f, 0.0f);
+    for (i = 0; i < numCubes; ++i)
+    {
+        if (vm_frustum_cull_mask_is_visible(visibility, i) && vm_v3_length(vm_v3_sub(positions[i], cam->position)) < CUBES_OCCLUDER_DISTANCE)
+        {
+            speg_occlusion_rasterize_mesh(&occlusion, models[i].e, cube_vertices, (int)array_size(cube_vertices) / 3, cube_indices, (int)array_size(cube_indices), call->mesh->faceCulling);
+        }
+    }
 
-    vm_seed_lcg = 12345;
+    speg_occlusion_finish(&occlusion);
 
     for (i = 0; i < numCubes; ++i)
     {
-        bool draw;
-        v3 targetPosition;
-        v3 targetColor;
+        bool draw = (bool)vm_frustum_cull_mask_is_visible(visibility, i);
 
-        spawn_random_cube(i, range, &targetPosition, &targetColor);
-
-        if (i == 0)
+        if (draw || input->cameraSimulate.active)
         {
-            targetPosition = vm_v3(-2.0f, 0.0f, 0.0f);
-        }
+            v3 targetColor = colors[i];
+            m4x4 *model = &models[i];
 
-        /* TODO: epsilon 0.15f is needed because cubes are rotating and its not considered in the frustum check */
-        draw = (bool)vm_frustum_is_cube_in(frustum_planes, targetPosition, vm_v3_one, 0.15f);
+            /* Narrow phase: exact test of the rotated cube for the ones the broad phase could not discard */
+            draw = (bool)(draw && vm_frustum_is_obb_in(&frustum_planes, model, cube_half_extents));
 
-        if (!draw)
-        {
-            /* DISCARD - but in case we want to show discarded objects e.g. simulateCam = true we still render them */
-            if (input->cameraSimulate.active)
+            if (!draw)
             {
-                draw = true;
+                /* DISCARD - but in case we want to show discarded objects e.g. simulateCam = true we still render them */
                 targetColor = color_red;
+                state->culledObjects++;
+            }
+            else
+            {
+                /* Hidden behind the occluders (occluders pass this test as they are never behind themselves) */
+                v3 center;
+                v3 extents;
+
+                vm_m4x4_aabb(model, cube_half_extents, &center, &extents);
+
+                if (!speg_occlusion_is_visible_aabb(&occlusion, &center.x, &extents.x))
+                {
+                    draw = false;
+                    targetColor = color_occluded;
+                    state->occludedObjects++;
+                }
+            }
+
+            /* Finally draw to screen by using platform api */
+            if (draw || input->cameraSimulate.active)
+            {
+                speg_draw_call_submit(call, model, &targetColor, default_texture_index);
             }
+        }
+        else
+        {
             state->culledObjects++;
         }
+    }
+}
+
+/* 20000 random cubes, generated in parallel-for ranges that append to call in ordered mode. Each range starts
+ * its own seed where the serial loop would be, the instances are the same as without a job system */
+#define CUBES_INSTANCED_COUNT 20000
+#define CUBES_INSTANCED_BATCH 1024
+#define CUBES_INSTANCED_CAPACITY SPEG_APPEND_CAPACITY(CUBES_INSTANCED_COUNT, 2 * CUBES_INSTANCED_COUNT / CUBES_INSTANCED_BATCH + 1, SPEG_APPEND_CHUNK)
+
+static speg_append_block cubes_instanced_blocks[SPEG_APPEND_BLOCKS_CAPACITY(CUBES_INSTANCED_CAPACITY, SPEG_APPEND_CHUNK)];
 
-        /* Finally draw to screen by using platform api */
-        if (draw)
+typedef struct render_cubes_instanced_job
+{
+    speg_parallel_append *append; /* 0 appends serially to call */
+    speg_draw_call *call;
+    float range;
+    unsigned int seed; /* before the first cube */
+
+} render_cubes_instanced_job;
+
+void render_cubes_instanced_range(void *data, int first, int count, int worker)
+{
+    render_cubes_instanced_job *job = (render_cubes_instanced_job *)data;
+    unsigned int seed = vm_seed_lcg_skip(job->seed, first > 0 ? 3 * (unsigned int)(first - 1) : 0);
+    speg_append_cursor cursor;
+    v3 positions[SPEG_APPEND_CHUNK];
+    v3 colors[SPEG_APPEND_CHUNK];
+    int chunk_first;
+    int i;
+    (void)worker;
+
+    if (job->append)
+    {
+        speg_append_cursor_begin(&cursor, &job->append->append, first);
+    }
+
+    for (chunk_first = first; chunk_first < first + count; chunk_first += SPEG_APPEND_CHUNK)
+    {
+        int chunk_count = first + count - chunk_first < SPEG_APPEND_CHUNK ? first + count - chunk_first : SPEG_APPEND_CHUNK;
+
+        for (i = 0; i < chunk_count; ++i)
         {
-            /* calculate the model matrix for each object and pass it to shader before drawing */
-            m4x4 model_base = vm_m4x4_translate(vm_m4x4_identity, targetPosition);
-            m4x4 model = (i > 0)
-                             ? vm_m4x4_rotate(model_base, vm_radf(20.0f * (float)i), rotation_axis)
-                             : vm_m4x4_lookAt_model(targetPosition, cam->position, cam->worldUp);
+            spawn_random_cube(chunk_first + i, job->range, &seed, &positions[i], &colors[i]);
+        }
 
-            speg_draw_call_append(call, &model, &targetColor, default_texture_index);
+        if (job->append)
+        {
+            speg_parallel_append_trs(job->append, &cursor, positions, 0, 0, colors, chunk_count, default_texture_index);
+        }
+        else
+        {
+            speg_draw_call_append_trs(job->call, positions, 0, 0, colors, chunk_count, default_texture_index);
         }
     }
 }
 
 void render_cubes_instanced(speg_draw_call *call, float range)
 {
-    int i;
+    speg_parallel_append append;
+    render_cubes_instanced_job job;
 
-    for (i = 0; i < 20000; ++i)
+    job.append = speg_parallel_append_begin(&append, call, cubes_instanced_blocks, CUBES_INSTANCED_CAPACITY, SPEG_APPEND_CHUNK, 1) ? &append : 0;
+    job.call = call;
+    job.range = range;
+    job.seed = vm_seed_lcg;
+
+    if (job.append)
     {
-        m4x4 model;
-        v3 targetPosition = vm_v3_zero;
-        v3 targetColor = vm_v3_one;
+        speg_parallel_for(render_cubes_instanced_range, &job, CUBES_INSTANCED_COUNT, CUBES_INSTANCED_BATCH);
+        speg_parallel_append_end(&append);
+    }
+    else
+    {
+        render_cubes_instanced_range(&job, 0, CUBES_INSTANCED_COUNT, 0);
+    }
+
+    vm_seed_lcg = vm_seed_lcg_skip(job.seed, 3 * (CUBES_INSTANCED_COUNT - 1));
+}
 
-        spawn_random_cube(i, range, &targetPosition, &targetColor);
+/* Nodes of the transformation hierarchy test in topological order (parents first) */
+typedef enum transformations_node
+{
+    TRANSFORMATIONS_PARENT,
+    TRANSFORMATIONS_CHILD,
+    TRANSFORMATIONS_CHILD2,
+    TRANSFORMATIONS_CHILD3,
+    TRANSFORMATIONS_CHILD4,
+    TRANSFORMATIONS_CHILD41,
+    TRANSFORMATIONS_CHILD411,
+    TRANSFORMATIONS_COUNT
 
-        model = vm_m4x4_translate(vm_m4x4_identity, targetPosition);
+} transformations_node;
 
-        speg_draw_call_append(call, &model, &targetColor, default_texture_index);
-    }
-}
+static speg_scene transformations;
+static bool transformations_initialized;
 
 void render_transformations_test(speg_draw_call *call, speg_state *state)
 {
-    transformation parent = vm_transformation_init();
-    transformation child = vm_transformation_init();
-    transformation child2 = vm_transformation_init();
-    transformation child3 = vm_transformation_init();
-    transformation child4 = vm_transformation_init();
-    transformation child41 = vm_transformation_init();
-    transformation child411 = vm_transformation_init();
+    static m4x4 locals[TRANSFORMATIONS_COUNT];
+    static m4x4 worlds[TRANSFORMATIONS_COUNT];
+    static v3 positions[TRANSFORMATIONS_COUNT];
+    static quat rotations[TRANSFORMATIONS_COUNT];
+    static v3 scales[TRANSFORMATIONS_COUNT];
+    static int parents[TRANSFORMATIONS_COUNT];
+    static unsigned char flags[TRANSFORMATIONS_COUNT];
+
+    static v3 colors[TRANSFORMATIONS_COUNT];
 
-    m4x4 current_transform;
-    v3 color;
+    const v3 up = vm_v3(0.0f, 1.0f, 0.0f);
+    int i;
 
     static float rotation = 90.0f;
     rotation += (100.0f * (float)state->dt);
 
-    parent.position.x = 4.0f;
-    vm_tranformation_rotate(&parent, vm_v3(0.0f, 1.0f, 0.0f), vm_radf(rotation));
-    current_transform = vm_transformation_matrix(&parent);
-    color = vm_v3(1.0f, 0.0f, 0.0f);
-    speg_draw_call_append(call, &current_transform, &color, default_texture_index);
-
-    child.position = vm_v3(3.0f, 0.0f, 0.0f);
-    child.parent = &parent;
-    current_transform = vm_transformation_matrix(&child);
-    color = vm_v3(1.0f, 0.8745f, 0.0f);
-    speg_draw_call_append(call, &current_transform, &color, default_texture_index);
-
-    child2.position = vm_v3(-3.0f, 0.0f, 0.0f);
-    child2.parent = &parent;
-    current_transform = vm_transformation_matrix(&child2);
-    color = vm_v3(1.0f, 0.8745f, 0.0f);
-    speg_draw_call_append(call, &current_transform, &color, default_texture_index);
-
-    child3.position = vm_v3(0.0f, 0.0f, 3.0f);
-    child3.parent = &parent;
-    current_transform = vm_transformation_matrix(&child3);
-    color = vm_v3(1.0f, 0.8745f, 0.0f);
-    speg_draw_call_append(call, &current_transform, &color, default_texture_index);
-
-    child4.position = vm_v3(0.0f, 0.0f, -3.0f);
-    child4.parent = &parent;
-    child4.rotation = vm_quat_rotate(vm_v3(0.0f, 1.0f, 0.0f), -vm_radf(rotation * 2.0f));
-    current_transform = vm_transformation_matrix(&child4);
-    color = vm_v3(1.0f, 0.8745f, 0.0f);
-    speg_draw_call_append(call, &current_transform, &color, default_texture_index);
-
-    child41.position = vm_v3(0.0f, 0.0f, -2.0f);
-    child41.parent = &child4;
-    child41.rotation = vm_quat_rotate(vm_v3(0.0f, 1.0f, 0.0f), -vm_radf(rotation * 4.0f));
-    current_transform = vm_transformation_matrix(&child41);
-    color = vm_v3(0.0f, 1.0f, 0.0f);
-    speg_draw_call_append(call, &current_transform, &color, default_texture_index);
-
-    child411.position = vm_v3(0.0f, 0.0f, -2.0f);
-    child411.parent = &child41;
-    current_transform = vm_transformation_matrix(&child411);
-    color = vm_v3_zero;
-    speg_draw_call_append(call, &current_transform, &color, default_texture_index);
+    if (!transformations_initialized)
+    {
+        const v3 color_parent = vm_v3(1.0f, 0.0f, 0.0f);
+        const v3 color_child = vm_v3(1.0f, 0.8745f, 0.0f);
+
+        speg_scene_init(&transformations, locals, worlds, positions, rotations, scales, parents, flags, TRANSFORMATIONS_COUNT);
+
+        speg_scene_add(&transformations, -1, vm_v3(4.0f, 0.0f, 0.0f), vm_quat_rot, vm_v3_one);
+        speg_scene_add(&transformations, TRANSFORMATIONS_PARENT, vm_v3(3.0f, 0.0f, 0.0f), vm_quat_rot, vm_v3_one);
+        speg_scene_add(&transformations, TRANSFORMATIONS_PARENT, vm_v3(-3.0f, 0.0f, 0.0f), vm_quat_rot, vm_v3_one);
+        speg_scene_add(&transformations, TRANSFORMATIONS_PARENT, vm_v3(0.0f, 0.0f, 3.0f), vm_quat_rot, vm_v3_one);
+        speg_scene_add(&transformations, TRANSFORMATIONS_PARENT, vm_v3(0.0f, 0.0f, -3.0f), vm_quat_rot, vm_v3_one);
+        speg_scene_add(&transformations, TRANSFORMATIONS_CHILD4, vm_v3(0.0f, 0.0f, -2.0f), vm_quat_rot, vm_v3_one);
+        speg_scene_add(&transformations, TRANSFORMATIONS_CHILD41, vm_v3(0.0f, 0.0f, -2.0f), vm_quat_rot, vm_v3_one);
+
+        colors[TRANSFORMATIONS_PARENT] = color_parent;
+        colors[TRANSFORMATIONS_CHILD] = color_child;
+        colors[TRANSFORMATIONS_CHILD2] = color_child;
+        colors[TRANSFORMATIONS_CHILD3] = color_child;
+        colors[TRANSFORMATIONS_CHILD4] = color_child;
+        colors[TRANSFORMATIONS_CHILD41] = vm_v3(0.0f, 1.0f, 0.0f);
+        colors[TRANSFORMATIONS_CHILD411] = vm_v3_zero;
+
+        transformations_initialized = true;
+    }
+
+    /* Only the animated nodes are marked, their subtrees are rebuilt once from the cached parent matrices */
+    speg_scene_set_rotation(&transformations, TRANSFORMATIONS_PARENT, vm_quat_rotate(up, vm_radf(rotation)));
+    speg_scene_set_rotation(&transformations, TRANSFORMATIONS_CHILD4, vm_quat_rotate(up, -vm_radf(rotation * 2.0f)));
+    speg_scene_set_rotation(&transformations, TRANSFORMATIONS_CHILD41, vm_quat_rotate(up, -vm_radf(rotation * 4.0f)));
+    speg_scene_update(&transformations);
+
+    for (i = 0; i < transformations.count; ++i)
+    {
+        speg_draw_call_submit(call, &transformations.worlds[i], &colors[i], default_texture_index);
+    }
 }
 
 void render_gui_rectangle(speg_draw_call *call, speg_state *state, speg_controller_input *input)
@@ -574,7 +1551,7 @@ void render_gui_rectangle(speg_draw_call *call, speg_state *state, speg_controll
                    mouseY >= position.y - element_height_half &&
                    mouseY <= position.y + element_height_half);
 
-    speg_draw_call_append(call, &model, inside ? &colorSelected : &colorDefault, default_texture_index);
+    speg_draw_call_submit(call, &model, inside ? &colorSelected : &colorDefault, default_texture_index);
 }
 
 void render_character(speg_draw_call *call, speg_state *state, char character, v3 color, v2 dimensions, float xOffset, float yOffset)
@@ -803,7 +1780,7 @@ void render_vector(speg_draw_call *call, v3 base_position, v3 vector, v3 color)
 
     model = vm_m4x4_mul(translation, vm_m4x4_mul(rotation, scale_matrix));
 
-    speg_draw_call_append(call, &model, &color, default_texture_index);
+    speg_draw_call_submit(call, &model, &color, default_texture_index);
 }
 
 v2 render_full_text(speg_draw_call *call, speg_state *state, char *str, v3 color, v2 dimensions, v2 offsets)
@@ -870,6 +1847,12 @@ typedef struct wheel
     /* Calculated */
     float distance_to_ground;
 
+    /* Forces of the last physics step, shown as text */
+    bool grounded;
+    v3 force_suspension;
+    v3 force_steering;
+    v3 force_acceleration;
+
 } wheel;
 
 wheel wheel_init_with_defaults(v3 local_position, float wheel_mass, bool steering_enabled, bool steering_inverted, bool acceleration_enabled)
@@ -888,19 +1871,30 @@ wheel wheel_init_with_defaults(v3 local_position, float wheel_mass, bool steerin
     result.steering_wheel_grip = 0.9f;
     result.acceleration_enabled = acceleration_enabled;
     result.acceleration_input = 0.0f;
+    result.grounded = false;
+    result.force_suspension = vm_v3_zero;
+    result.force_steering = vm_v3_zero;
+    result.force_acceleration = vm_v3_zero;
 
     return (result);
 }
 
+/* World transform of the wheel on the car body and its distance to the ground */
+void wheel_place(wheel *wh, rigid_body *car, float steering_angle)
+{
+    float current_ground_height = 0.0f;
+
+    /* TODO: check if rotate has to be applied after add !*/
+    wh->transform.position = vm_v3_add(car->position, vm_v3_rotate(wh->local_position, car->orientation));
+    wh->transform.rotation = wh->steering_enabled ? vm_quat_mul(car->orientation, vm_quat_rotate(vm_transformation_up(&wh->transform), wh->steering_inverted ? -steering_angle : steering_angle)) : car->orientation;
+    wh->distance_to_ground = wh->transform.position.y - current_ground_height;
+}
+
 void wheel_update(
     rigid_body *car,
     wheel *wh,
     float dt,
-    float car_top_speed,
-    int index,
-    speg_draw_call *call_txt,
-    speg_state *state,
-    speg_platform_api *platformApi)
+    float car_top_speed)
 {
     v3 wheel_position = wh->transform.position;
     v3 wheel_world_vel = vm_rigid_body_point_velocity(car, wheel_position);
@@ -914,21 +1908,9 @@ void wheel_update(
         float velocity = vm_v3_dot(spring_dir, wheel_world_vel);
         float force = (offset * wh->suspension_spring_strength) - (velocity * wh->suspension_spring_dampening);
 
-        v3 force_suspension = vm_v3_mulf(spring_dir, force);
+        wh->force_suspension = vm_v3_mulf(spring_dir, force);
 
-        /* Text rendering force information */
-        {
-            char xBuffer[32], yBuffer[32], zBuffer[32], outBuffer[256];
-            v2 txt_dimensions = vm_v2_mulf(vm_v2(17.0f, 32.0f), 0.6f);
-            v2 txt_offset = vm_v2(10.0f, 200.0f + ((float)(index + 1) * txt_dimensions.y));
-            speg_float_to_string(force_suspension.x, xBuffer, 6);
-            speg_float_to_string(force_suspension.y, yBuffer, 6);
-            speg_float_to_string(force_suspension.z, zBuffer, 6);
-            platformApi->platform_format_string(outBuffer, "[wh-%i]   force_suspension: %14s %14s %14s", index, xBuffer, yBuffer, zBuffer);
-            render_full_text(call_txt, state, outBuffer, vm_v3_one, txt_dimensions, txt_offset);
-        }
-
-        vm_rigid_body_apply_force_at_position(car, force_suspension, wheel_position);
+        vm_rigid_body_apply_force_at_position(car, wh->force_suspension, wheel_position);
     }
 
     /* Force 2: calculate steering force */
@@ -942,21 +1924,9 @@ void wheel_update(
         float desired_velocity_change = -steering_vel * wh->steering_wheel_grip;
         float desired_acceleration = desired_velocity_change / dt;
 
-        v3 force_steering = vm_v3_mulf(steering_dir, wh->steering_wheel_mass * desired_acceleration);
-
-        /* Text rendering force information */
-        {
-            char xBuffer[32], yBuffer[32], zBuffer[32], outBuffer[256];
-            v2 txt_dimensions = vm_v2_mulf(vm_v2(17.0f, 32.0f), 0.6f);
-            v2 txt_offset = vm_v2(10.0f, 300.0f + ((float)(index + 1) * txt_dimensions.y));
-            speg_float_to_string(force_steering.x, xBuffer, 6);
-            speg_float_to_string(force_steering.y, yBuffer, 6);
-            speg_float_to_string(force_steering.z, zBuffer, 6);
-            platformApi->platform_format_string(outBuffer, "[wh-%i]     force_steering: %14s %14s %14s", index, xBuffer, yBuffer, zBuffer);
-            render_full_text(call_txt, state, outBuffer, vm_v3_one, txt_dimensions, txt_offset);
-        }
+        wh->force_steering = vm_v3_mulf(steering_dir, wh->steering_wheel_mass * desired_acceleration);
 
-        vm_rigid_body_apply_force_at_position(car, force_steering, wheel_position);
+        vm_rigid_body_apply_force_at_position(car, wh->force_steering, wheel_position);
     }
 
     /* Force 3: acceleration / braking */
@@ -968,38 +1938,66 @@ void wheel_update(
         float normalized_speed = vm_clamp01f(vm_absf(car_speed) / car_top_speed);
         float available_torque = simple_power_curve_evaluate(normalized_speed) * wh->acceleration_input;
 
-        v3 force_acceleration = vm_v3_mulf(acceleration_dir, available_torque);
+        wh->force_acceleration = vm_v3_mulf(acceleration_dir, available_torque);
 
-        /* Text rendering force information */
-        {
-            char xBuffer[32], yBuffer[32], zBuffer[32], outBuffer[256];
-            v2 txt_dimensions = vm_v2_mulf(vm_v2(17.0f, 32.0f), 0.6f);
-            v2 txt_offset = vm_v2(10.0f, 400.0f + ((float)(index + 1) * txt_dimensions.y));
-            speg_float_to_string(force_acceleration.x, xBuffer, 6);
-            speg_float_to_string(force_acceleration.y, yBuffer, 6);
-            speg_float_to_string(force_acceleration.z, zBuffer, 6);
-            platformApi->platform_format_string(outBuffer, "[wh-%i] force_acceleration: %14s %14s %14s", index, xBuffer, yBuffer, zBuffer);
-            render_full_text(call_txt, state, outBuffer, vm_v3_one, txt_dimensions, txt_offset);
-        }
-
-        vm_rigid_body_apply_force_at_position(car, force_acceleration, wheel_position);
+        vm_rigid_body_apply_force_at_position(car, wh->force_acceleration, wheel_position);
     }
 }
 
+/* Text rendering force information of the last physics step */
+void wheel_render_forces(wheel *wh, int index, speg_draw_call *call_txt, speg_state *state, speg_platform_api *platformApi)
+{
+    char xBuffer[32], yBuffer[32], zBuffer[32], outBuffer[256];
+    v2 txt_dimensions = vm_v2_mulf(vm_v2(17.0f, 32.0f), 0.6f);
+    v2 txt_offset = vm_v2(10.0f, 200.0f + ((float)(index + 1) * txt_dimensions.y));
+
+    speg_float_to_string(wh->force_suspension.x, xBuffer, 6);
+    speg_float_to_string(wh->force_suspension.y, yBuffer, 6);
+    speg_float_to_string(wh->force_suspension.z, zBuffer, 6);
+    platformApi->platform_format_string(outBuffer, "[wh-%i]   force_suspension: %14s %14s %14s", index, xBuffer, yBuffer, zBuffer);
+    render_full_text(call_txt, state, outBuffer, vm_v3_one, txt_dimensions, txt_offset);
+
+    txt_offset = vm_v2(10.0f, 300.0f + ((float)(index + 1) * txt_dimensions.y));
+    speg_float_to_string(wh->force_steering.x, xBuffer, 6);
+    speg_float_to_string(wh->force_steering.y, yBuffer, 6);
+    speg_float_to_string(wh->force_steering.z, zBuffer, 6);
+    platformApi->platform_format_string(outBuffer, "[wh-%i]     force_steering: %14s %14s %14s", index, xBuffer, yBuffer, zBuffer);
+    render_full_text(call_txt, state, outBuffer, vm_v3_one, txt_dimensions, txt_offset);
+
+    txt_offset = vm_v2(10.0f, 400.0f + ((float)(index + 1) * txt_dimensions.y));
+    speg_float_to_string(wh->force_acceleration.x, xBuffer, 6);
+    speg_float_to_string(wh->force_acceleration.y, yBuffer, 6);
+    speg_float_to_string(wh->force_acceleration.z, zBuffer, 6);
+    platformApi->platform_format_string(outBuffer, "[wh-%i] force_acceleration: %14s %14s %14s", index, xBuffer, yBuffer, zBuffer);
+    render_full_text(call_txt, state, outBuffer, vm_v3_one, txt_dimensions, txt_offset);
+}
+
+#define SPEG_DEFAULT_PHYSICS_HZ 120.0f
+#define SPEG_DEFAULT_PHYSICS_SUBSTEPS 8
+
 static bool car_initialized;
 static rigid_body car;
 
+/* The car is simulated in fixed steps and rendered between the state before the last step and the current one */
+static rigid_body car_previous;
+static vm_fixed_step car_clock;
+
 void render_car(speg_draw_call *call, speg_draw_call *call_txt, speg_state *state, speg_platform_api *platformApi)
 {
-    float dt = (float)state->dt;
     float gravity = -9.81f;
     v3 gravity_force = vm_v3(0.0f, gravity, 0.0f);
 
     float car_top_speed = 20.0f;
     static float steering_angle = -0.3f;
 
+    /* Accumulated forces of the last step, the integration resets them */
+    static v3 car_force;
+    static v3 car_torque;
+
+    int steps;
     int i;
 
+    rigid_body body;
     transformation car_transform;
     m4x4 car_model;
     v3 car_color = vm_v3(0.4f, 0.4f, 0.4f);
@@ -1024,37 +2022,65 @@ void render_car(speg_draw_call *call, speg_draw_call *call_txt, speg_state *stat
         wheels[2] = wheel_init_with_defaults(vm_v3(-1.0f, 0.0f, 1.0f), car.mass / NUM_WHEELS, false, true, true);  /* Rear-Left */
         wheels[3] = wheel_init_with_defaults(vm_v3(1.0f, 0.0f, 1.0f), car.mass / NUM_WHEELS, false, true, true);   /* Rear-Right */
 
+        car_previous = car;
+        car_clock = vm_fixed_step_init(state->physics_hz > 0.0f ? state->physics_hz : SPEG_DEFAULT_PHYSICS_HZ,
+                                       state->physics_max_substeps > 0 ? state->physics_max_substeps : SPEG_DEFAULT_PHYSICS_SUBSTEPS);
+        car_force = vm_v3_zero;
+        car_torque = vm_v3_zero;
+
         car_initialized = true;
     }
 
-    /* Update the car transform so that the wheel transforms are also updated in the next step */
-    car.force = vm_v3_add(car.force, vm_v3_mulf(gravity_force, car.mass));
+    /* The same steps for the same total time no matter how it is split into frames */
+    steps = vm_fixed_step_advance(&car_clock, state->dt);
+
+    while (steps-- > 0)
+    {
+        car_previous = car;
+
+        /* Update the car transform so that the wheel transforms are also updated in the next step */
+        car.force = vm_v3_add(car.force, vm_v3_mulf(gravity_force, car.mass));
+
+        /* For each wheel */
+        for (i = 0; i < NUM_WHEELS; ++i)
+        {
+            wheel wh = wheels[i];
+            wheel_place(&wh, &car, steering_angle);
+            wh.acceleration_input = wh.acceleration_enabled ? 1.0f : 0.0f;
+            wh.grounded = wh.distance_to_ground < wh.suspension_rest_dist + wh.suspension_ray_dist;
+
+            if (wh.grounded)
+            {
+                wheel_update(&car, &wh, (float)car_clock.step, car_top_speed);
+            }
+
+            wheels[i].grounded = wh.grounded;
+            wheels[i].force_suspension = wh.force_suspension;
+            wheels[i].force_steering = wh.force_steering;
+            wheels[i].force_acceleration = wh.force_acceleration;
+        }
+
+        car_force = car.force;
+        car_torque = car.torque;
+
+        vm_rigid_body_integrate(&car, (float)car_clock.step);
+    }
+
+    /* Everything below only renders */
+    body = vm_rigid_body_interpolate(&car_previous, &car, vm_fixed_step_alpha(&car_clock));
 
     /* For each wheel */
     for (i = 0; i < NUM_WHEELS; ++i)
     {
-        float current_ground_height = 0.0f;
         m4x4 wheel_model;
         v3 wheel_color = vm_v3(1.0f, 0.0f, 0.0f);
 
-        /* TODO: check if rotate has to be applied after add !*/
         wheel wh = wheels[i];
-        wh.transform.position = vm_v3_add(car.position, vm_v3_rotate(wh.local_position, car.orientation));
-        wh.transform.rotation = wh.steering_enabled ? vm_quat_mul(car.orientation, vm_quat_rotate(vm_transformation_up(&wh.transform), wh.steering_inverted ? -steering_angle : steering_angle)) : car.orientation;
-        wh.acceleration_input = wh.acceleration_enabled ? 1.0f : 0.0f;
-        wh.distance_to_ground = wh.transform.position.y - current_ground_height;
+        wheel_place(&wh, &body, steering_angle);
 
-        if (wh.distance_to_ground < wh.suspension_rest_dist + wh.suspension_ray_dist)
+        if (wh.grounded)
         {
-            wheel_update(
-                &car,
-                &wh,
-                dt,
-                car_top_speed,
-                i,
-                call_txt,
-                state,
-                platformApi);
+            wheel_render_forces(&wh, i, call_txt, state, platformApi);
         }
 
         /* Visualizing the wheel up, forward, right vector */
@@ -1081,7 +2107,7 @@ void render_car(speg_draw_call *call, speg_draw_call *call_txt, speg_state *stat
 
         wh.transform.scale = vm_v3f(0.2f);
         wheel_model = vm_transformation_matrix(&wh.transform);
-        speg_draw_call_append(call, &wheel_model, &wheel_color, default_texture_index);
+        speg_draw_call_submit(call, &wheel_model, &wheel_color, default_texture_index);
     }
 
     /* Car information rendering */
@@ -1089,21 +2115,19 @@ void render_car(speg_draw_call *call, speg_draw_call *call_txt, speg_state *stat
         char xBuffer[32], yBuffer[32], zBuffer[32], outBuffer[256];
         v2 txt_dimensions = vm_v2_mulf(vm_v2(17.0f, 32.0f), 0.6f);
         v2 txt_offset = vm_v2(10.0f, 520.0f + txt_dimensions.y);
-        speg_float_to_string(car.force.x, xBuffer, 6);
-        speg_float_to_string(car.force.y, yBuffer, 6);
-        speg_float_to_string(car.force.z, zBuffer, 6);
+        speg_float_to_string(car_force.x, xBuffer, 6);
+        speg_float_to_string(car_force.y, yBuffer, 6);
+        speg_float_to_string(car_force.z, zBuffer, 6);
         platformApi->platform_format_string(outBuffer, " [car_force] %14s %14s %14s\n", xBuffer, yBuffer, zBuffer);
         txt_offset = render_full_text(call_txt, state, outBuffer, vm_v3_one, txt_dimensions, txt_offset);
 
-        speg_float_to_string(car.torque.x, xBuffer, 6);
-        speg_float_to_string(car.torque.y, yBuffer, 6);
-        speg_float_to_string(car.torque.z, zBuffer, 6);
+        speg_float_to_string(car_torque.x, xBuffer, 6);
+        speg_float_to_string(car_torque.y, yBuffer, 6);
+        speg_float_to_string(car_torque.z, zBuffer, 6);
         platformApi->platform_format_string(outBuffer, "[car_torque] %14s %14s %14s", xBuffer, yBuffer, zBuffer);
         render_full_text(call_txt, state, outBuffer, vm_v3_one, txt_dimensions, txt_offset);
     }
 
-    vm_rigid_body_integrate(&car, dt);
-
     /* Text Car information */
     {
         v2 txt_dimensions = vm_v2_mulf(vm_v2(17.0f, 32.0f), 0.6f);
@@ -1111,34 +2135,34 @@ void render_car(speg_draw_call *call, speg_draw_call *call_txt, speg_state *stat
         v3 txt_color = vm_v3_one;
         char xBuffer[32], yBuffer[32], zBuffer[32], wBuffer[32], outBuffer[512];
 
-        speg_float_to_string(car.position.x, xBuffer, 6);
-        speg_float_to_string(car.position.y, yBuffer, 6);
-        speg_float_to_string(car.position.z, zBuffer, 6);
+        speg_float_to_string(body.position.x, xBuffer, 6);
+        speg_float_to_string(body.position.y, yBuffer, 6);
+        speg_float_to_string(body.position.z, zBuffer, 6);
 
         platformApi->platform_format_string(outBuffer, "[car_pos] %10s %10s %10s\n", xBuffer, yBuffer, zBuffer);
         render_full_text(call_txt, state, outBuffer, txt_color, txt_dimensions, txt_offset);
 
-        speg_float_to_string(car.orientation.x, xBuffer, 6);
-        speg_float_to_string(car.orientation.y, yBuffer, 6);
-        speg_float_to_string(car.orientation.z, zBuffer, 6);
-        speg_float_to_string(car.orientation.w, wBuffer, 6);
+        speg_float_to_string(body.orientation.x, xBuffer, 6);
+        speg_float_to_string(body.orientation.y, yBuffer, 6);
+        speg_float_to_string(body.orientation.z, zBuffer, 6);
+        speg_float_to_string(body.orientation.w, wBuffer, 6);
 
         txt_offset = vm_v2(10.0f, 20.0f + ((float)(5 + 1) * txt_dimensions.y));
 
         platformApi->platform_format_string(outBuffer, "[car_rot] %10s %10s %10s %10s\n", xBuffer, yBuffer, zBuffer, wBuffer);
         render_full_text(call_txt, state, outBuffer, txt_color, txt_dimensions, txt_offset);
 
-        speg_float_to_string(car.velocity.x, xBuffer, 6);
-        speg_float_to_string(car.velocity.y, yBuffer, 6);
-        speg_float_to_string(car.velocity.z, zBuffer, 6);
+        speg_float_to_string(body.velocity.x, xBuffer, 6);
+        speg_float_to_string(body.velocity.y, yBuffer, 6);
+        speg_float_to_string(body.velocity.z, zBuffer, 6);
 
         txt_offset = vm_v2(10.0f, 20.0f + ((float)(6 + 1) * txt_dimensions.y));
         platformApi->platform_format_string(outBuffer, "[car_vel] %10s %10s %10s\n", xBuffer, yBuffer, zBuffer);
         render_full_text(call_txt, state, outBuffer, txt_color, txt_dimensions, txt_offset);
 
-        speg_float_to_string(car.angularVelocity.x, xBuffer, 6);
-        speg_float_to_string(car.angularVelocity.y, yBuffer, 6);
-        speg_float_to_string(car.angularVelocity.z, zBuffer, 6);
+        speg_float_to_string(body.angularVelocity.x, xBuffer, 6);
+        speg_float_to_string(body.angularVelocity.y, yBuffer, 6);
+        speg_float_to_string(body.angularVelocity.z, zBuffer, 6);
 
         txt_offset = vm_v2(10.0f, 20.0f + ((float)(7 + 1) * txt_dimensions.y));
         platformApi->platform_format_string(outBuffer, "[car_ang] %10s %10s %10s\n", xBuffer, yBuffer, zBuffer);
@@ -1146,77 +2170,188 @@ void render_car(speg_draw_call *call, speg_draw_call *call_txt, speg_state *stat
 
         txt_offset = vm_v2(10.0f, 20.0f + ((float)(8 + 1) * txt_dimensions.y));
 
-        speg_float_to_string(vm_v3_length(car.velocity), xBuffer, 6);
+        speg_float_to_string(vm_v3_length(body.velocity), xBuffer, 6);
 
         platformApi->platform_format_string(outBuffer, "[car_spd] %10s\n", xBuffer);
         render_full_text(call_txt, state, outBuffer, txt_color, txt_dimensions, txt_offset);
     }
 
     /* Visualizing the car up, forward, right vector */
-    render_vector(call, car.position, vm_v3_mulf(vm_rigid_body_up(&car), 2.0f), vm_v3(0.0f, 1.0f, 0.0f));
-    render_vector(call, car.position, vm_v3_mulf(vm_rigid_body_forward(&car), 2.0f), vm_v3(0.0f, 0.0f, 1.0f));
-    render_vector(call, car.position, vm_v3_mulf(vm_rigid_body_right(&car), 2.0f), vm_v3(1.0f, 0.0f, 0.0f));
-    render_vector(call, car.position, car.velocity, vm_v3(0.941f, 0.925f, 0.0f));
-    render_vector(call, car.position, car.angularVelocity, vm_v3(0.941f, 0.925f, 0.0f));
+    render_vector(call, body.position, vm_v3_mulf(vm_rigid_body_up(&body), 2.0f), vm_v3(0.0f, 1.0f, 0.0f));
+    render_vector(call, body.position, vm_v3_mulf(vm_rigid_body_forward(&body), 2.0f), vm_v3(0.0f, 0.0f, 1.0f));
+    render_vector(call, body.position, vm_v3_mulf(vm_rigid_body_right(&body), 2.0f), vm_v3(1.0f, 0.0f, 0.0f));
+    render_vector(call, body.position, body.velocity, vm_v3(0.941f, 0.925f, 0.0f));
+    render_vector(call, body.position, body.angularVelocity, vm_v3(0.941f, 0.925f, 0.0f));
 
     /* Visualize car not just as a cube. Doesn't affect the physics simulation !*/
     car_transform = vm_transformation_init();
-    car_transform.position = car.position;
+    car_transform.position = body.position;
     car_transform.position.y += 0.5f;
-    car_transform.rotation = car.orientation;
+    car_transform.rotation = body.orientation;
     car_transform.scale.y = 0.2f;
     car_transform.scale.x = 1.5f;
     car_transform.scale.z = 2.0f;
 
     car_model = vm_transformation_matrix(&car_transform);
 
-    speg_draw_call_append(call, &car_model, &car_color, default_texture_index);
+    speg_draw_call_submit(call, &car_model, &car_color, default_texture_index);
 }
 
-/* Draw call batching groups */
-#define MAX_STATIC_INSTANCES 22000
-static float all_static_models[MAX_STATIC_INSTANCES * VM_M4X4_ELEMENT_COUNT];
-static float all_static_colors[MAX_STATIC_INSTANCES * VM_V3_ELEMENT_COUNT];
-static int all_static_texture_indices[MAX_STATIC_INSTANCES];
+/* Draw call batching groups, the instance arrays are reserved at startup (growable) or allocated from the memory arenas */
 static speg_draw_call draw_call_static = {0};
 
-#define MAX_DYNAMIC_INSTANCES 2048
-static float all_dynamic_models[MAX_DYNAMIC_INSTANCES * VM_M4X4_ELEMENT_COUNT];
-static float all_dynamic_colors[MAX_DYNAMIC_INSTANCES * VM_V3_ELEMENT_COUNT];
-static int all_dynamic_texture_indices[MAX_DYNAMIC_INSTANCES];
-static speg_draw_call draw_call_dynamic = {0};
+/* The whole static scene in bvh order, built once. draw_call_static receives the visible part every frame.
+ * The scene is generated into scratch memory first, its arrays are then sized to the instances it really has */
+static speg_draw_call draw_call_static_scene = {0};
+
+static speg_bvh static_bvh;
 
-#define MAX_DYNAMIC_GUI_INSTANCES 128
-static float all_dynamic_gui_models[MAX_DYNAMIC_GUI_INSTANCES * VM_M4X4_ELEMENT_COUNT];
-static float all_dynamic_gui_colors[MAX_DYNAMIC_GUI_INSTANCES * VM_V3_ELEMENT_COUNT];
-static int all_dynamic_gui_texture_indices[MAX_DYNAMIC_GUI_INSTANCES];
+/* Draw commands of the visible ranges when the platform draws indirect, the scene is then drawn in place */
+static speg_indirect_list static_commands;
+
+/* Mesh and state of the dynamic cubes and the GUI, their instances go through the render queue */
+static speg_draw_call draw_call_dynamic = {0};
 static speg_draw_call draw_call_dynamic_gui = {0};
 
-#define MAX_DYNAMIC_TEXT_INSTANCES 2048
-static float all_text_models[MAX_DYNAMIC_TEXT_INSTANCES * VM_M4X4_ELEMENT_COUNT];
-static float all_text_colors[MAX_DYNAMIC_TEXT_INSTANCES * VM_V3_ELEMENT_COUNT];
-static int all_text_indices[MAX_DYNAMIC_TEXT_INSTANCES];
+#define SPEG_DEFAULT_TEXT_CAPACITY 2048
 static speg_draw_call draw_call_text = {0};
 
+/* Growable (speg_draw_call_reserve) if the platform reserves address space, the reservation is kept in state for
+ * the next initialization. Otherwise count instances from the permanent arena */
+int speg_draw_call_reserve_or_alloc(speg_draw_call *call, speg_platform_api *platformApi, speg_state *state, int count)
+{
+    unsigned long reserved = state->reservations_count < SPEG_MAX_RESERVATIONS ? speg_draw_call_reserve(call, platformApi, SPEG_RESERVE_INSTANCES) : 0;
+
+    if (reserved)
+    {
+        state->reservations[state->reservations_count] = call->models;
+        state->reservations_size[state->reservations_count] = reserved;
+        state->reservations_count++;
+        return (1);
+    }
+
+    return (speg_draw_call_alloc(call, &state->permanent, count));
+}
+
+/* Builds the bvh over the generated instances and copies them in bvh order into scene, sized to exactly these.
+ * Scene and bvh live in the permanent arena, the bounds are only needed during the build (temp block of the
+ * transient arena). Returns 0 if an arena is full */
+int static_scene_build_bvh(speg_draw_call *scene, speg_draw_call *generated, speg_arena *permanent, speg_arena *transient)
+{
+    const v3 cube_half_extents = vm_v3(0.5f, 0.5f, 0.5f);
+    int count = generated->count_instances;
+    int model_size = speg_instance_model_size(generated->instance_format);
+    speg_bvh_node *nodes = SPEG_ARENA_PUSH_ARRAY(permanent, speg_bvh_node, SPEG_BVH_NODES_CAPACITY(count));
+    int *indices = SPEG_ARENA_PUSH_ARRAY(permanent, int, count);
+    float *bounds = SPEG_ARENA_PUSH_ARRAY(permanent, float, count * 6);
+    speg_arena_temp temp;
+    float *centers;
+    float *extents;
+    int i;
+
+    if (!nodes || !indices || !bounds || !speg_draw_call_alloc(scene, permanent, count))
+    {
+        return (0);
+    }
+
+    temp = speg_arena_temp_begin(transient);
+    centers = SPEG_ARENA_PUSH_ARRAY(transient, float, count * 3);
+    extents = SPEG_ARENA_PUSH_ARRAY(transient, float, count * 3);
+
+    if (!centers || !extents)
+    {
+        speg_arena_temp_end(temp);
+        return (0);
+    }
+
+    for (i = 0; i < count; ++i)
+    {
+        m4x4 model;
+        v3 center;
+        v3 extent;
+
+        speg_instance_unpack_model(generated->instance_format, (unsigned char *)generated->models + i * model_size, model.e);
+        vm_m4x4_aabb(&model, cube_half_extents, &center, &extent);
+
+        centers[i * 3 + 0] = center.x;
+        centers[i * 3 + 1] = center.y;
+        centers[i * 3 + 2] = center.z;
+        extents[i * 3 + 0] = extent.x;
+        extents[i * 3 + 1] = extent.y;
+        extents[i * 3 + 2] = extent.z;
+    }
+
+    speg_bvh_build(&static_bvh, nodes, indices, bounds, centers, extents, count);
+    speg_arena_temp_end(temp);
+
+    for (i = 0; i < count; ++i)
+    {
+        speg_draw_call_copy(scene, i, generated, static_bvh.indices[i], 1);
+    }
+    scene->count_instances = count;
+
+    return (1);
+}
+
+/* Walks the static bvh against the frustum and compacts the visible instance ranges into call.
+ * If the scene is drawn indirect the ranges become draw commands into the scene instead, nothing is copied.
+ * Returns the visible instances */
+int render_static_scene(speg_draw_call *call, speg_draw_call *scene, m4x4 projection, m4x4 view, speg_state *state)
+{
+    frustum frustum_planes = vm_frustum_extract_planes(vm_m4x4_mul(projection, view));
+    int visible = 0;
+    speg_bvh_range *ranges = SPEG_ARENA_PUSH_ARRAY(&state->transient, speg_bvh_range, scene->count_instances);
+    int ranges_count = ranges ? speg_bvh_cull(&static_bvh, (float *)vm_frustum_data(&frustum_planes), ranges, scene->count_instances, &visible) : 0;
+    int r;
+
+    state->culledObjects += (unsigned int)(scene->count_instances - visible);
+
+    if (scene->indirect)
+    {
+        speg_mesh *mesh = scene->mesh;
+        speg_indirect_command *commands = SPEG_ARENA_PUSH_ARRAY(&state->transient, speg_indirect_command, ranges_count);
+
+        speg_indirect_init(scene->indirect, commands, commands ? (unsigned int)ranges_count : 0);
+
+        for (r = 0; r < ranges_count; ++r)
+        {
+            speg_indirect_push(scene->indirect, (unsigned int)mesh->indicesCount, mesh->first_index, mesh->base_vertex, (unsigned int)ranges[r].first, (unsigned int)ranges[r].count);
+        }
+
+        return (visible);
+    }
+
+    call->count_instances = 0;
+
+    for (r = 0; r < ranges_count; ++r)
+    {
+        speg_draw_call_copy(call, call->count_instances, scene, ranges[r].first, ranges[r].count);
+        call->count_instances += ranges[r].count;
+    }
+
+    return (visible);
+}
+
 /* MESH definition for each speg_draw_call */
-#define SPEG_INIT_MESH(name, culling, verts, indices, uvs) {name, false, culling, verts, sizeof(verts), indices, sizeof(indices), uvs, sizeof(uvs), array_size(indices), 0, 0, 0, 0, 0, 0, 0}
+#define SPEG_INIT_MESH(name, culling, verts, indices, uvs) {name, false, culling, verts, sizeof(verts), indices, sizeof(indices), uvs, sizeof(uvs), array_size(indices), 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
 
 static speg_mesh cube_static = SPEG_INIT_MESH("cube_static", true, cube_vertices, cube_indices, cube_uvs);
 static speg_mesh cube_dynamic = SPEG_INIT_MESH("cube_dynamic", true, cube_vertices, cube_indices, cube_uvs);
 static speg_mesh rectangle_static = SPEG_INIT_MESH("rectangle_static", false, rectangle_vertices, rectangle_indices, rectangle_uvs);
 static speg_mesh rectangle_text = SPEG_INIT_MESH("rectangle_text", false, rectangle_vertices, rectangle_indices, rectangle_uvs);
 
-void speg_update(speg_memory *memory, platform_controller_input *platform_input, speg_platform_api *platformApi)
+/* Input, simulation and the render queue of frame packet packet. Pipelined packets get their own part of the
+ * transient memory and snapshots of the prebuilt draw calls. Returns the packet to submit */
+int speg_simulate_frame(speg_memory *memory, platform_controller_input *platform_input, speg_platform_api *platformApi, int packet, int pipelined)
 {
     static camera cam;
 
     speg_state *state = (speg_state *)memory->permanentMemory;
     speg_controller_input input;
+    int static_visible;
 
     static m4x4 projection;
-    static m4x4 ortho_proj;
     static m4x4 view;
-    static m4x4 projection_view;
     static m4x4 view_simulated;
 
     assert(memory);
@@ -1225,6 +2360,11 @@ void speg_update(speg_memory *memory, platform_controller_input *platform_input,
     assert(platform_input);
     assert(platformApi);
 
+    profiler = &state->profiler;
+    memory_commit = platformApi->platform_memory_commit;
+    job_parallel_for = platformApi->platform_job_parallel_for;
+    job_wait = platformApi->platform_job_wait;
+
     /* Initialized only once at startup */
     if (!memory->initialized)
     {
@@ -1238,50 +2378,147 @@ void speg_update(speg_memory *memory, platform_controller_input *platform_input,
         state->clearColorG = 0.2f;
         state->clearColorB = 0.2f;
 
-        /* Static Cubes */
+        /* Everything after speg_state (rounded to a cache line) is the permanent arena */
+        {
+            unsigned long state_size = ((unsigned long)sizeof(speg_state) + 63UL) & ~63UL;
+
+            speg_arena_init(&state->permanent, (unsigned char *)memory->permanentMemory + state_size, memory->permanentMemorySize - state_size);
+            speg_arena_init(&state->transient, memory->transientMemory, memory->transientMemorySize);
+
+            state->capacity_queue = state->capacity_queue ? state->capacity_queue : SPEG_DEFAULT_QUEUE_CAPACITY;
+            state->capacity_text = state->capacity_text ? state->capacity_text : SPEG_DEFAULT_TEXT_CAPACITY;
+        }
+
+        /* Draw calls of the code before a hot reload */
+        while (state->reservations_count > 0)
+        {
+            state->reservations_count--;
+            platformApi->platform_memory_release(state->reservations[state->reservations_count], state->reservations_size[state->reservations_count]);
+        }
+
+        /* Static Cubes, only the visible part of the static scene is uploaded */
         draw_call_static.mesh = &cube_static;
-        draw_call_static.count_instances_max = MAX_STATIC_INSTANCES;
-        draw_call_static.count_instances = 0;
-        draw_call_static.models = all_static_models;
-        draw_call_static.colors = all_static_colors;
-        draw_call_static.texture_indices = all_static_texture_indices;
+        draw_call_static.instance_format = SPEG_INSTANCE_FORMAT_AFFINE_HALF;
+        draw_call_static.color_format = SPEG_INSTANCE_COLOR_RGBA8;
         draw_call_static.changed = false;
+        draw_call_static.track_dirty = true;
+
+        /* Static scene, drawn in place by the culled draw commands if the platform draws indirect */
+        draw_call_static_scene.mesh = &cube_static;
+        draw_call_static_scene.instance_format = SPEG_INSTANCE_FORMAT_AFFINE_HALF;
+        draw_call_static_scene.color_format = SPEG_INSTANCE_COLOR_RGBA8;
+        draw_call_static_scene.changed = false;
+        draw_call_static_scene.indirect = platformApi->platform_draw_indirect ? &static_commands : 0;
 
         /* Dynamic Cubes */
         draw_call_dynamic.mesh = &cube_dynamic;
-        draw_call_dynamic.count_instances_max = MAX_DYNAMIC_INSTANCES;
-        draw_call_dynamic.count_instances = 0;
-        draw_call_dynamic.models = all_dynamic_models;
-        draw_call_dynamic.colors = all_dynamic_colors;
-        draw_call_dynamic.texture_indices = all_dynamic_texture_indices;
-        draw_call_dynamic.changed = true;
+        draw_call_dynamic.instance_format = SPEG_INSTANCE_FORMAT_AFFINE_HALF;
+        draw_call_dynamic.color_format = SPEG_INSTANCE_COLOR_RGBA8;
+        draw_call_dynamic.layer = SPEG_LAYER_WORLD;
 
         /* 2D GUI Elements */
         draw_call_dynamic_gui.mesh = &rectangle_static;
-        draw_call_dynamic_gui.count_instances_max = MAX_DYNAMIC_GUI_INSTANCES;
-        draw_call_dynamic_gui.count_instances = 0;
-        draw_call_dynamic_gui.models = all_dynamic_gui_models;
-        draw_call_dynamic_gui.colors = all_dynamic_gui_colors;
-        draw_call_dynamic_gui.texture_indices = all_dynamic_gui_texture_indices;
-        draw_call_dynamic_gui.changed = true;
+        draw_call_dynamic_gui.instance_format = SPEG_INSTANCE_FORMAT_AFFINE;
+        draw_call_dynamic_gui.color_format = SPEG_INSTANCE_COLOR_RGBA8;
         draw_call_dynamic_gui.is_2d = true;
+        draw_call_dynamic_gui.layer = SPEG_LAYER_GUI;
 
         /* 3D Text */
         draw_call_text.mesh = &rectangle_text;
-        draw_call_text.count_instances_max = MAX_DYNAMIC_TEXT_INSTANCES;
-        draw_call_text.count_instances = 0;
-        draw_call_text.models = all_text_models;
-        draw_call_text.colors = all_text_colors;
-        draw_call_text.texture_indices = all_text_indices;
-        draw_call_text.changed = true;
+        draw_call_text.instance_format = SPEG_INSTANCE_FORMAT_AFFINE;
+        draw_call_text.color_format = SPEG_INSTANCE_COLOR_RGBA8;
+        draw_call_text.changed = false;
+        draw_call_text.track_dirty = true;
         draw_call_text.is_2d = true;
+        draw_call_text.layer = SPEG_LAYER_TEXT;
+        speg_draw_call_reserve_or_alloc(&draw_call_text, platformApi, state, (int)state->capacity_text);
+
+        /* Mesh indices of the render queue sort key and the meshes in the shared geometry */
+        {
+            speg_mesh *meshes[4];
+            unsigned int vertices_total = 0;
+            unsigned int indices_total = 0;
+            float *positions;
+            float *uvs;
+            unsigned int *indices;
+            int i;
+
+            meshes[0] = &cube_static;
+            meshes[1] = &cube_dynamic;
+            meshes[2] = &rectangle_static;
+            meshes[3] = &rectangle_text;
+
+            for (i = 0; i < (int)array_size(meshes); ++i)
+            {
+                vertices_total += (unsigned int)(meshes[i]->verticesSize / (long)(sizeof(float) * VM_V3_ELEMENT_COUNT));
+                indices_total += (unsigned int)meshes[i]->indicesCount;
+            }
+
+            positions = SPEG_ARENA_PUSH_ARRAY(&state->permanent, float, vertices_total * VM_V3_ELEMENT_COUNT);
+            uvs = SPEG_ARENA_PUSH_ARRAY(&state->permanent, float, vertices_total * 2);
+            indices = SPEG_ARENA_PUSH_ARRAY(&state->permanent, unsigned int, indices_total);
+
+            if (!positions || !uvs || !indices)
+            {
+                vertices_total = 0;
+                indices_total = 0;
+            }
+
+            speg_geometry_init(&geometry, positions, uvs, vertices_total, indices, indices_total);
+
+            for (i = 0; i < (int)array_size(meshes); ++i)
+            {
+                unsigned int vertices_count = (unsigned int)(meshes[i]->verticesSize / (long)(sizeof(float) * VM_V3_ELEMENT_COUNT));
+                int added = speg_geometry_add(&geometry, meshes[i]->vertices, meshes[i]->uvs, vertices_count, meshes[i]->indices, (unsigned int)meshes[i]->indicesCount, &meshes[i]->base_vertex, &meshes[i]->first_index);
 
-        /* Static scenes */
-        PROFILE(render_coordinate_axis(&draw_call_static));
-        PROFILE(render_grid(&draw_call_static));
-        PROFILE(render_cubes_instanced(&draw_call_static, 100.0f));
+                assert(added);
+                (void)added;
+                meshes[i]->queue_index = i;
+            }
+        }
+
+        /* Static scenes, generated into a growable draw call released after the build (without platform support
+         * into as many instances as fit the transient arena next to the bounds of the bvh build), then copied in
+         * bvh order into permanent arrays of the generated size */
+        {
+            speg_draw_call generated = draw_call_static_scene;
+            unsigned long reserved = speg_draw_call_reserve(&generated, platformApi, SPEG_RESERVE_INSTANCES);
+
+            if (!reserved)
+            {
+                unsigned long instance_size = (unsigned long)(speg_instance_model_size(generated.instance_format) + speg_instance_color_size(generated.color_format)) + sizeof(int);
+                unsigned long remaining = speg_arena_remaining(&state->transient);
+                int capacity = (int)((remaining > 256 ? remaining - 256 : 0) / (instance_size + 6 * sizeof(float)));
+
+                speg_draw_call_alloc(&generated, &state->transient, capacity);
+            }
+
+            PROFILE(render_coordinate_axis(&generated));
+            PROFILE(render_grid(&generated));
+            PROFILE(render_cubes_instanced(&generated, 100.0f));
+            PROFILE(static_scene_build_bvh(&draw_call_static_scene, &generated, &state->permanent, &state->transient));
+
+            /* The visible part is copied every frame unless the scene is drawn in place */
+            if (!draw_call_static_scene.indirect)
+            {
+                speg_draw_call_reserve_or_alloc(&draw_call_static, platformApi, state, draw_call_static_scene.count_instances);
+            }
+
+            if (reserved)
+            {
+                platformApi->platform_memory_release(generated.models, reserved);
+            }
+
+            speg_arena_reset(&state->transient);
+        }
+
+        if (state->permanent.failed || state->transient.failed)
+        {
+            platformApi->platform_print_console(__FILE__, __LINE__, "[speg] out of memory: %lu permanent, %lu transient allocations failed\n", state->permanent.failed, state->transient.failed);
+        }
 
-        platformApi->platform_print_console(__FILE__, __LINE__, "[speg] initialized\n");
+        platformApi->platform_print_console(__FILE__, __LINE__, "[speg] initialized: %i static instances, permanent memory %lu of %lu bytes used\n",
+                                            draw_call_static_scene.count_instances, state->permanent.used, state->permanent.size);
     }
 
     input = speg_map_controller_input(platform_input);
@@ -1316,26 +2553,39 @@ void speg_update(speg_memory *memory, platform_controller_input *platform_input,
 
         if (debug && !debug_run_step)
         {
-            /* Draw existing static and dynamic scenes */
-            platformApi->platform_draw(&draw_call_static, projection_view.e);
-            platformApi->platform_draw(&draw_call_dynamic, projection_view.e);
-            platformApi->platform_draw(&draw_call_dynamic_gui, ortho_proj.e);
-            platformApi->platform_draw(&draw_call_text, ortho_proj.e);
-
-            return;
+            /* Draw the render queue of the last frame again */
+            return (frame_last);
         }
     }
 
-    /* Reset dynamic draw call buffers */
-    draw_call_dynamic.count_instances = 0;
-    draw_call_dynamic_gui.count_instances = 0;
+    /* Reset dynamic draw call buffers and the per frame memory */
     draw_call_text.count_instances = 0;
+    frame = &frame_packets[packet];
+    frame->snapshots = pipelined;
+
+    if (pipelined)
+    {
+        unsigned long size = memory->transientMemorySize / SPEG_FRAME_PACKETS;
+        unsigned char *part = (unsigned char *)memory->transientMemory + (unsigned long)packet * size;
+
+        if (frame->arena.memory != part)
+        {
+            speg_arena_init(&frame->arena, part, size);
+        }
+
+        speg_arena_reset(&frame->arena);
+        state->transient = frame->arena;
+    }
+    else
+    {
+        speg_arena_reset(&state->transient);
+    }
 
     camera_update_movement(&input, &cam, 10.0f * (float)state->dt);
 
     projection = vm_m4x4_perspective(vm_radf(cam.fov), (float)state->width / (float)state->height, 0.1f, 1000.0f);
     view = vm_m4x4_lookAt(cam.position, vm_v3_add(cam.position, cam.front), cam.up);
-    ortho_proj = vm_m4x4_orthographic(0.0f, (float)state->width, 0.0f, (float)state->height, -1.0f, 1.0f);
+    frame->ortho_proj = vm_m4x4_orthographic(0.0f, (float)state->width, 0.0f, (float)state->height, -1.0f, 1.0f);
 
     if (input.cameraSimulate.active)
     {
@@ -1351,25 +2601,77 @@ void speg_update(speg_memory *memory, platform_controller_input *platform_input,
         view_simulated = view;
     }
 
+    speg_render_queue_begin(view, &state->transient, state->capacity_queue);
+
+    /* Static scene */
+    PROFILE_WITH_NAME(static_visible = render_static_scene(&draw_call_static, &draw_call_static_scene, projection, view_simulated, state), "render_static_scene");
+
     /* Dynamic scenes */
-    render_cubes(&draw_call_dynamic, projection, view_simulated, state, &input, 20.0f, &cam);
-    render_transformations_test(&draw_call_dynamic, state);
-    render_gui_rectangle(&draw_call_dynamic_gui, state, &input);
-    render_text(&draw_call_text, state, platformApi);
-    render_car(&draw_call_dynamic, &draw_call_text, state, platformApi);
+    PROFILE_WITH_NAME(render_cubes(&draw_call_dynamic, projection, view_simulated, state, &input, 20.0f, &cam), "render_cubes");
+    PROFILE_WITH_NAME(render_transformations_test(&draw_call_dynamic, state), "render_transformations_test");
+    PROFILE_WITH_NAME(render_gui_rectangle(&draw_call_dynamic_gui, state, &input), "render_gui_rectangle");
+    PROFILE_WITH_NAME(render_text(&draw_call_text, state, platformApi), "render_text");
+    PROFILE_WITH_NAME(render_car(&draw_call_dynamic, &draw_call_text, state, platformApi), "render_car");
+
+    speg_render_queue_call(draw_call_static_scene.indirect ? &draw_call_static_scene : &draw_call_static);
+    speg_render_queue_call(&draw_call_text);
+
+    state->renderedObjects = (unsigned int)(static_visible +
+                                            draw_call_text.count_instances) +
+                             render_queue_instances;
+
+    frame->projection_view = vm_m4x4_mul(projection, view);
+
+    /* The packet is complete, nothing changes it until it was submitted */
+    speg_queue_sort(&frame->queue);
+
+    if (pipelined)
+    {
+        frame->arena = state->transient;
+        frame->memory = &frame->arena;
+    }
+    else
+    {
+        frame->memory = &state->transient;
+    }
 
-    state->renderedObjects = (unsigned int)(draw_call_static.count_instances +
-                                            draw_call_dynamic.count_instances +
-                                            draw_call_dynamic_gui.count_instances +
-                                            draw_call_text.count_instances);
+    frame_last = packet;
+
+    return (packet);
+}
+
+/* Both phases of a frame one after the other */
+void speg_update(speg_memory *memory, platform_controller_input *platform_input, speg_platform_api *platformApi)
+{
+    speg_state *state = (speg_state *)memory->permanentMemory;
+    int packet = speg_simulate_frame(memory, platform_input, platformApi, 0, false);
 
-    projection_view = vm_m4x4_mul(projection, view);
+    submit_profiler = &state->profiler;
 
     /* Draw static and dynamic scenes */
-    platformApi->platform_draw(&draw_call_static, projection_view.e);
-    platformApi->platform_draw(&draw_call_dynamic, projection_view.e);
-    platformApi->platform_draw(&draw_call_dynamic_gui, ortho_proj.e);
-    platformApi->platform_draw(&draw_call_text, ortho_proj.e);
+    if (packet >= 0)
+    {
+        PROFILE_SUBMIT(speg_render_queue_flush(&frame_packets[packet], platformApi), "render_queue_flush");
+    }
+}
+
+int speg_simulate(speg_memory *memory, platform_controller_input *input, speg_platform_api *platformApi, int packet)
+{
+    assert(packet >= 0 && packet < SPEG_FRAME_PACKETS);
+
+    return (speg_simulate_frame(memory, input, platformApi, packet, true));
+}
+
+void speg_submit(speg_memory *memory, speg_platform_api *platformApi, int packet)
+{
+    speg_state *state = (speg_state *)memory->permanentMemory;
+
+    submit_profiler = &state->profiler_submit;
+
+    if (packet >= 0 && packet < SPEG_FRAME_PACKETS && frame_packets[packet].memory)
+    {
+        PROFILE_SUBMIT(speg_render_queue_flush(&frame_packets[packet], platformApi), "render_queue_flush");
+    }
 }
 
 #ifdef _WIN32
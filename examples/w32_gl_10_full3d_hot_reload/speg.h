@@ -1,12 +1,99 @@
 #ifndef SPEG_H
 #define SPEG_H
 
+/* memset and memcpy the compiler emits for struct copies and initializers. With SSE2/AVX2 targeted by the compiler
+ * (-march=native) blocks of a vector and more are written as an unaligned head vector, aligned vectors and an
+ * unaligned tail vector overlapping the bytes before it. Blocks of SPEG_MEMORY_NON_TEMPORAL bytes and more bypass
+ * the cache (they would only evict the working set). SPEG_MEMORY_NO_SIMD keeps the byte loops */
+#if !defined(SPEG_MEMORY_NO_SIMD) && defined(__AVX2__)
+#include <immintrin.h>
+#define SPEG_MEMORY_AVX2
+#define SPEG_MEMORY_VECTOR 32
+#elif !defined(SPEG_MEMORY_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define SPEG_MEMORY_SSE2
+#define SPEG_MEMORY_VECTOR 16
+#endif
+
+#ifndef SPEG_MEMORY_NON_TEMPORAL
+#define SPEG_MEMORY_NON_TEMPORAL (1024 * 1024)
+#endif
+
+/* Pointer sized integer for the alignment of the head */
+#if defined(__GNUC__) || defined(__clang__)
+__extension__ typedef __SIZE_TYPE__ speg_memory_address;
+#elif defined(_WIN64)
+typedef unsigned __int64 speg_memory_address;
+#else
+typedef unsigned int speg_memory_address;
+#endif
+
 #ifdef _MSC_VER
 #pragma function(memset)
 #endif
 void *memset(void *dest, int c, unsigned int count)
 {
     char *bytes = (char *)dest;
+
+#ifdef SPEG_MEMORY_VECTOR
+    if (count >= SPEG_MEMORY_VECTOR)
+    {
+        unsigned int head = (unsigned int)(SPEG_MEMORY_VECTOR - ((speg_memory_address)bytes & (SPEG_MEMORY_VECTOR - 1)));
+        char *end = bytes + count;
+        char *last = end - SPEG_MEMORY_VECTOR;
+#ifdef SPEG_MEMORY_AVX2
+        __m256i value = _mm256_set1_epi8((char)c);
+
+        _mm256_storeu_si256((__m256i *)bytes, value);
+        bytes += head;
+
+        if (count >= SPEG_MEMORY_NON_TEMPORAL)
+        {
+            for (; bytes + 4 * SPEG_MEMORY_VECTOR <= end; bytes += 4 * SPEG_MEMORY_VECTOR)
+            {
+                _mm256_stream_si256((__m256i *)bytes + 0, value);
+                _mm256_stream_si256((__m256i *)bytes + 1, value);
+                _mm256_stream_si256((__m256i *)bytes + 2, value);
+                _mm256_stream_si256((__m256i *)bytes + 3, value);
+            }
+            _mm_sfence();
+        }
+
+        for (; bytes < last; bytes += SPEG_MEMORY_VECTOR)
+        {
+            _mm256_store_si256((__m256i *)bytes, value);
+        }
+
+        _mm256_storeu_si256((__m256i *)last, value);
+#else
+        __m128i value = _mm_set1_epi8((char)c);
+
+        _mm_storeu_si128((__m128i *)bytes, value);
+        bytes += head;
+
+        if (count >= SPEG_MEMORY_NON_TEMPORAL)
+        {
+            for (; bytes + 4 * SPEG_MEMORY_VECTOR <= end; bytes += 4 * SPEG_MEMORY_VECTOR)
+            {
+                _mm_stream_si128((__m128i *)bytes + 0, value);
+                _mm_stream_si128((__m128i *)bytes + 1, value);
+                _mm_stream_si128((__m128i *)bytes + 2, value);
+                _mm_stream_si128((__m128i *)bytes + 3, value);
+            }
+            _mm_sfence();
+        }
+
+        for (; bytes < last; bytes += SPEG_MEMORY_VECTOR)
+        {
+            _mm_store_si128((__m128i *)bytes, value);
+        }
+
+        _mm_storeu_si128((__m128i *)last, value);
+#endif
+        return dest;
+    }
+#endif
+
     while (count--)
     {
         *bytes++ = (char)c;
@@ -21,6 +108,102 @@ void *memcpy(void *dest, const void *src, unsigned int count)
 {
     char *dest8 = (char *)dest;
     const char *src8 = (const char *)src;
+
+#ifdef SPEG_MEMORY_VECTOR
+    if (count >= SPEG_MEMORY_VECTOR)
+    {
+        unsigned int head = (unsigned int)(SPEG_MEMORY_VECTOR - ((speg_memory_address)dest8 & (SPEG_MEMORY_VECTOR - 1)));
+        char *end = dest8 + count;
+        char *last = end - SPEG_MEMORY_VECTOR;
+        const char *src_last = src8 + count - SPEG_MEMORY_VECTOR;
+#ifdef SPEG_MEMORY_AVX2
+        /* Only the destination is aligned by the head, the source is always loaded unaligned */
+        __m256i tail = _mm256_loadu_si256((const __m256i *)src_last);
+
+        _mm256_storeu_si256((__m256i *)dest8, _mm256_loadu_si256((const __m256i *)src8));
+        dest8 += head;
+        src8 += head;
+
+        if (count >= SPEG_MEMORY_NON_TEMPORAL)
+        {
+            for (; dest8 + 4 * SPEG_MEMORY_VECTOR <= end; dest8 += 4 * SPEG_MEMORY_VECTOR, src8 += 4 * SPEG_MEMORY_VECTOR)
+            {
+                __m256i v0 = _mm256_loadu_si256((const __m256i *)src8 + 0);
+                __m256i v1 = _mm256_loadu_si256((const __m256i *)src8 + 1);
+                __m256i v2 = _mm256_loadu_si256((const __m256i *)src8 + 2);
+                __m256i v3 = _mm256_loadu_si256((const __m256i *)src8 + 3);
+
+                _mm256_stream_si256((__m256i *)dest8 + 0, v0);
+                _mm256_stream_si256((__m256i *)dest8 + 1, v1);
+                _mm256_stream_si256((__m256i *)dest8 + 2, v2);
+                _mm256_stream_si256((__m256i *)dest8 + 3, v3);
+            }
+            _mm_sfence();
+        }
+
+        for (; dest8 < last; dest8 += SPEG_MEMORY_VECTOR, src8 += SPEG_MEMORY_VECTOR)
+        {
+            _mm256_store_si256((__m256i *)dest8, _mm256_loadu_si256((const __m256i *)src8));
+        }
+
+        _mm256_storeu_si256((__m256i *)last, tail);
+#else
+        __m128i tail = _mm_loadu_si128((const __m128i *)src_last);
+
+        _mm_storeu_si128((__m128i *)dest8, _mm_loadu_si128((const __m128i *)src8));
+        dest8 += head;
+        src8 += head;
+
+        if (count >= SPEG_MEMORY_NON_TEMPORAL)
+        {
+            for (; dest8 + 4 * SPEG_MEMORY_VECTOR <= end; dest8 += 4 * SPEG_MEMORY_VECTOR, src8 += 4 * SPEG_MEMORY_VECTOR)
+            {
+                __m128i v0 = _mm_loadu_si128((const __m128i *)src8 + 0);
+                __m128i v1 = _mm_loadu_si128((const __m128i *)src8 + 1);
+                __m128i v2 = _mm_loadu_si128((const __m128i *)src8 + 2);
+                __m128i v3 = _mm_loadu_si128((const __m128i *)src8 + 3);
+
+                _mm_stream_si128((__m128i *)dest8 + 0, v0);
+                _mm_stream_si128((__m128i *)dest8 + 1, v1);
+                _mm_stream_si128((__m128i *)dest8 + 2, v2);
+                _mm_stream_si128((__m128i *)dest8 + 3, v3);
+            }
+            _mm_sfence();
+        }
+
+        for (; dest8 < last; dest8 += SPEG_MEMORY_VECTOR, src8 += SPEG_MEMORY_VECTOR)
+        {
+            _mm_store_si128((__m128i *)dest8, _mm_loadu_si128((const __m128i *)src8));
+        }
+
+        _mm_storeu_si128((__m128i *)last, tail);
+#endif
+        return dest;
+    }
+
+    /* Below one vector: two overlapping halves of 16 or 8 bytes, then bytes */
+#ifdef SPEG_MEMORY_AVX2
+    if (count >= 16)
+    {
+        __m128i first = _mm_loadu_si128((const __m128i *)src8);
+        __m128i second = _mm_loadu_si128((const __m128i *)(src8 + count - 16));
+
+        _mm_storeu_si128((__m128i *)dest8, first);
+        _mm_storeu_si128((__m128i *)(dest8 + count - 16), second);
+        return dest;
+    }
+#endif
+    if (count >= 8)
+    {
+        __m128i first = _mm_loadl_epi64((const __m128i *)src8);
+        __m128i second = _mm_loadl_epi64((const __m128i *)(src8 + count - 8));
+
+        _mm_storel_epi64((__m128i *)dest8, first);
+        _mm_storel_epi64((__m128i *)(dest8 + count - 8), second);
+        return dest;
+    }
+#endif
+
     while (count--)
     {
         *dest8++ = *src8++;
@@ -43,6 +226,14 @@ typedef char bool;
 #define true 1
 #define false 0
 
+#include "speg_profiler.h"
+#include "speg_instance.h"
+#include "speg_dirty.h"
+#include "speg_queue.h"
+#include "speg_indirect.h"
+#include "speg_arena.h"
+#include "speg_jobs.h"
+
 typedef struct speg_mesh
 {
     char id[20];
@@ -71,20 +262,49 @@ typedef struct speg_mesh
     unsigned int CBO;
     unsigned int UBO; /* UV's */
     unsigned int TBO; /* Texture Index */
+    int instancesCapacity; /* Instances the IBO, CBO and TBO were allocated for */
+
+    int queue_index; /* Mesh part of the render queue sort key */
+
+    /* Location in the shared geometry of the indirect draws */
+    int base_vertex;
+    unsigned int first_index;
 
 } speg_mesh;
 
 typedef struct speg_draw_call
 {
     speg_mesh *mesh;
-    float *models;
-    float *colors;
+    float *models; /* speg_instance_model_size(instance_format) bytes per instance */
+    float *colors; /* speg_instance_color_size(color_format) bytes per instance */
     int *texture_indices;
     int count_instances;
     int count_instances_max;
 
+    /* Growable draw calls (speg_draw_call_reserve): the arrays lie in address space reserved for this many instances
+     * and never move, pages are committed as appends pass count_instances_max. 0 for fixed arrays */
+    int count_instances_reserved;
+
     int changed;
     int is_2d;
+    int layer; /* Render queue layer, draw order of whole passes */
+
+    int instance_format; /* SPEG_INSTANCE_FORMAT_*, the full 4x4 matrix by default */
+    int color_format;    /* SPEG_INSTANCE_COLOR_*, rgb floats by default */
+
+    /* Instead of changed (whole buffers every frame): writes are compared to the previous instance data and only
+     * the changed ranges are uploaded. The platform clears dirty after the upload */
+    int track_dirty;
+    speg_dirty dirty;
+
+    /* Set by speg_draw_call_stream for changed draw calls: models, colors and texture_indices (in this order,
+     * count_instances_max each) lie in platform memory the GPU reads directly, platform_draw uploads nothing */
+    int streamed;
+    unsigned int stream_position;
+
+    /* Prebuilt draw calls drawn by platform_draw_indirect: these commands select the instances (base_instance)
+     * and the meshes in the shared geometry, mesh only owns the instance buffers */
+    speg_indirect_list *indirect;
 
 } speg_draw_call;
 
@@ -97,6 +317,15 @@ typedef void (*func_speg_platform_sleep)(unsigned long milliseconds);
 typedef void (*func_speg_platform_draw)(speg_draw_call *draw_call, float uniformProjectionView[16]);
 typedef unsigned long (*func_speg_platform_perf_current_cycle_count)(void);
 typedef double (*func_platform_perf_current_time_nanoseconds)(void);
+typedef void *(*func_speg_platform_stream_alloc)(unsigned int size, unsigned int *position);
+typedef void (*func_speg_platform_draw_indirect)(speg_draw_call *draw_call, speg_geometry *geometry, speg_indirect_command *commands, int count_commands, float uniformProjectionView[16]);
+typedef void *(*func_speg_platform_memory_reserve)(unsigned long size);
+typedef int (*func_speg_platform_memory_commit)(void *memory, unsigned long size);
+typedef void (*func_speg_platform_memory_release)(void *memory, unsigned long size);
+typedef int (*func_speg_platform_job_workers)(void);
+typedef void (*func_speg_platform_job_submit)(speg_job_function function, void *data, speg_job_counter *counter);
+typedef void (*func_speg_platform_job_parallel_for)(speg_job_range_function function, void *data, int count, int batch, speg_job_counter *counter);
+typedef void (*func_speg_platform_job_wait)(speg_job_counter *counter);
 
 typedef struct speg_platform_api
 {
@@ -110,6 +339,30 @@ typedef struct speg_platform_api
     func_speg_platform_perf_current_cycle_count platform_perf_current_cycle_count;
     func_platform_perf_current_time_nanoseconds platform_perf_current_time_nanoseconds;
 
+    /* Optional, memory of the current frame in the persistently mapped streaming buffer (0 if unavailable) */
+    func_speg_platform_stream_alloc platform_stream_alloc;
+
+    /* Optional, draws the instances of draw_call with one multi draw of the commands from the shared geometry (0 if unavailable) */
+    func_speg_platform_draw_indirect platform_draw_indirect;
+
+    /* Optional, address space without memory (0 if unavailable), pages of it are committed on demand (zeroed,
+     * returns 0 on failure) and the whole reservation is released at once */
+    func_speg_platform_memory_reserve platform_memory_reserve;
+    func_speg_platform_memory_commit platform_memory_commit;
+    func_speg_platform_memory_release platform_memory_release;
+
+    /* Optional, work stealing job system (speg_jobs.h, 0 if unavailable). Jobs are counted on the counter of the
+     * caller until they finished, wait runs jobs until the counter reaches 0. parallel_for calls function over
+     * [0, count) in ranges of at most batch elements (0 = automatic) with the index of the running worker
+     * (0 to job_workers() - 1). Jobs run on other threads and must not record profiler zones. The only exception is
+     * the simulate job of pipelined frames the platform submits: speg_simulate records into speg_state.profiler
+     * on the worker, the main thread stays out of that profiler until the job is done and records into
+     * speg_state.profiler_submit instead */
+    func_speg_platform_job_workers platform_job_workers;
+    func_speg_platform_job_submit platform_job_submit;
+    func_speg_platform_job_parallel_for platform_job_parallel_for;
+    func_speg_platform_job_wait platform_job_wait;
+
 } speg_platform_api;
 
 /********************************/
@@ -229,6 +482,8 @@ typedef struct platform_controller_input
 
 #pragma GCC diagnostic pop
 
+#define SPEG_MAX_RESERVATIONS 4
+
 typedef struct speg_state
 {
     double dt;
@@ -236,10 +491,36 @@ typedef struct speg_state
     int height;
     unsigned int renderedObjects;
     unsigned int culledObjects;
+    unsigned int occludedObjects;
     float clearColorR;
     float clearColorG;
     float clearColorB;
 
+    /* Frame zones of the platform and the application, frames are started and ended by the platform */
+    speg_profiler profiler;
+
+    /* Zones of speg_submit and the swap in pipelined frames, recorded by the main thread while the simulate job
+     * records into profiler (only one thread per profiler at a time) */
+    speg_profiler profiler_submit;
+
+    /* Permanent memory after speg_state (scene, bvh, text) and transient memory (reset every frame) */
+    speg_arena permanent;
+    speg_arena transient;
+
+    /* Buffers sized at startup, the platform may set them before the first speg_update (0 = default) */
+    unsigned int capacity_queue; /* render queue submissions per frame */
+    unsigned int capacity_text;  /* text instances (without platform_memory_reserve) */
+
+    /* Fixed timestep of the car physics, read when the car is initialized (0 = default). Frames render between the
+     * last two steps, a frame longer than physics_max_substeps steps drops the rest of its time */
+    float physics_hz;
+    int physics_max_substeps;
+
+    /* Address space of the growable draw calls, released by the next initialization (hot reload) */
+    void *reservations[SPEG_MAX_RESERVATIONS];
+    unsigned long reservations_size[SPEG_MAX_RESERVATIONS];
+    unsigned int reservations_count;
+
 } speg_state;
 
 typedef struct speg_memory
@@ -254,6 +535,13 @@ typedef struct speg_memory
 
 } speg_memory;
 
+/* Pipelined frames: speg_update runs both phases of a frame. A platform can call them on their own instead,
+ * speg_simulate (input, simulation, render queue) fills a frame packet and returns the packet to submit (the last
+ * filled one while debug mode holds the frame, -1 for none), speg_submit draws a packet and does not change the
+ * simulation. The simulate phase of the next frame can run on another thread while a packet is submitted, into the
+ * other packet. A platform uses either speg_update or speg_simulate/speg_submit and drops its packets on reload */
+#define SPEG_FRAME_PACKETS 2
+
 #ifdef SPEG_IMPORT
 void speg_update_stub(speg_memory *memory, platform_controller_input *input, speg_platform_api *platformApi)
 {
@@ -263,8 +551,57 @@ void speg_update_stub(speg_memory *memory, platform_controller_input *input, spe
 }
 typedef void (*func_speg_update)(speg_memory *memory, platform_controller_input *input, speg_platform_api *platformApi);
 static func_speg_update speg_update = speg_update_stub;
+
+typedef int (*func_speg_simulate)(speg_memory *memory, platform_controller_input *input, speg_platform_api *platformApi, int packet);
+typedef void (*func_speg_submit)(speg_memory *memory, speg_platform_api *platformApi, int packet);
+static func_speg_simulate speg_simulate; /* 0 if the code has no pipelined frames */
+static func_speg_submit speg_submit;
+
+/* AVX2 and FMA (CPUID 1 and 7) with the ymm registers saved by the OS (XGETBV). The platform layers load the
+ * application code built for the cpu with it: speg (-march=native, vm.h with VM_USE_AVX2) or speg_sse (x86-64-v2) */
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+int speg_cpu_supports_avx2(void)
+{
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    unsigned int eax, ebx, ecx, edx;
+    unsigned int xcr0;
+
+    /* FMA, OSXSAVE and AVX */
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & (1u << 12)) || !(ecx & (1u << 27)) || !(ecx & (1u << 28)))
+    {
+        return 0;
+    }
+
+    __asm__ __volatile__("xgetbv" : "=a"(xcr0), "=d"(edx) : "c"(0));
+    if ((xcr0 & 6) != 6 || !__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+    {
+        return 0;
+    }
+
+    return ((ebx & (1u << 5)) != 0);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int info[4];
+
+    __cpuid(info, 1);
+    if (!(info[2] & (1 << 12)) || !(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || (_xgetbv(0) & 6) != 6)
+    {
+        return 0;
+    }
+
+    __cpuidex(info, 7, 0);
+    return ((info[1] & (1 << 5)) != 0);
+#else
+    return 0;
+#endif
+}
 #else
 void speg_update(speg_memory *memory, platform_controller_input *input, speg_platform_api *platformApi);
+int speg_simulate(speg_memory *memory, platform_controller_input *input, speg_platform_api *platformApi, int packet);
+void speg_submit(speg_memory *memory, speg_platform_api *platformApi, int packet);
 #endif
 
 #endif /* SPEG_H */
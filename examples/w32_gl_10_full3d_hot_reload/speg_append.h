@@ -0,0 +1,281 @@
+/* speg_append.h - v0.1 - public domain parallel append with block reservation - nickscha 2025
+
+A C89 standard compliant, single header, nostdlib (no C Standard Library) slot allocator for appending to one
+array from several threads.
+
+A single shared count would need an atomic operation per element and makes neighbouring writes of different
+threads share cache lines. Instead every writer reserves a block of slots with one atomic fetch-add on the shared
+cursor and fills it without further synchronization. Blocks are recorded with the key of their writer (e.g. the
+first index of a parallel-for range) and a sequence number within it.
+
+After all writers finished speg_append_end puts the blocks into their final order: by position, or with ordered
+by key and sequence, so the result is the same as a serial append no matter which worker ran which range and when.
+Blocks are only partially filled at the end of a range, speg_append_compact moves the used slots of the blocks in
+that order into one contiguous array through a copy function of the caller. When the order of the blocks is also
+their position order (always without ordered, usually with it) the slots move down in place, otherwise they are
+gathered behind the capacity (the array then needs twice the capacity) and copied back.
+
+The capacity has to cover the unused end of the last block of every writer, SPEG_APPEND_CAPACITY. Reservations
+past the capacity fail and are counted as dropped. All memory is provided by the caller, nothing is allocated.
+
+speg_jobs.h (the atomics) has to be included before this file.
+
+USAGE
+
+  speg_append_init(&append, blocks, SPEG_APPEND_BLOCKS_CAPACITY(capacity, block_size), capacity, block_size, ordered);
+
+  (every writer, e.g. a parallel-for range)
+  speg_append_cursor_begin(&cursor, &append, key);
+  first = speg_append_reserve(&cursor, count, &granted);  (write slots [first, first + granted), -1 when full)
+
+  total = speg_append_end(&append);
+  speg_append_compact(&append, copy, data);  (slots [0, total) now hold the appended elements in order)
+
+LICENSE
+
+  Placed in the public domain and also MIT licensed.
+  See end of file for detailed license information.
+
+*/
+#ifndef SPEG_APPEND_H
+#define SPEG_APPEND_H
+
+/* #############################################################################
+ * # COMPILER SETTINGS
+ * #############################################################################
+ */
+/* Check if using C99 or later (inline is supported) */
+#if __STDC_VERSION__ >= 199901L
+#define SPEG_APPEND_INLINE inline
+#define SPEG_APPEND_API extern
+#elif defined(__GNUC__) || defined(__clang__)
+#define SPEG_APPEND_INLINE __inline__
+#define SPEG_APPEND_API static
+#elif defined(_MSC_VER)
+#define SPEG_APPEND_INLINE __inline
+#define SPEG_APPEND_API static
+#else
+#define SPEG_APPEND_INLINE
+#define SPEG_APPEND_API static
+#endif
+
+/* Capacity for count slots written by at most writers cursors (the last block of each one may stay partly empty) */
+#define SPEG_APPEND_CAPACITY(count, writers, block_size) ((count) + (writers) * (block_size))
+
+/* Upper bound of blocks, every reservation takes at least block_size slots of the capacity */
+#define SPEG_APPEND_BLOCKS_CAPACITY(capacity, block_size) ((capacity) / (block_size) + 1)
+
+/* #############################################################################
+ * # DATA STRUCTURES
+ * #############################################################################
+ */
+typedef struct speg_append_block
+{
+    int first;    /* slot of the block */
+    int count;    /* slots written */
+    int size;     /* slots reserved */
+    int key;      /* of the writer */
+    int sequence; /* blocks of the writer before this one */
+
+} speg_append_block;
+
+typedef struct speg_append
+{
+    volatile long reserved;     /* slots reserved so far (the shared cursor) */
+    volatile long blocks_count; /* blocks reserved so far */
+    volatile long dropped;      /* slots that did not fit the capacity */
+
+    speg_append_block *blocks;
+    int blocks_capacity;
+
+    int capacity;
+    int block_size;
+    int ordered;  /* blocks by key and sequence instead of by position */
+    int in_place; /* set by speg_append_end: the final order of the blocks is their position order */
+
+} speg_append;
+
+/* Copies count slots of the caller's array from src to dst. Ranges only overlap with dst below src, a forward
+ * copy is enough */
+typedef void (*speg_append_copy)(void *data, int dst, int src, int count);
+
+/* One writer, owned by a single thread */
+typedef struct speg_append_cursor
+{
+    speg_append *append;
+    speg_append_block *block; /* current block, 0 before the first reservation */
+    int key;
+    int sequence;
+
+} speg_append_cursor;
+
+/* #############################################################################
+ * # FUNCTIONS
+ * #############################################################################
+ */
+SPEG_APPEND_API SPEG_APPEND_INLINE void speg_append_init(speg_append *append, speg_append_block *blocks, int blocks_capacity, int capacity, int block_size, int ordered)
+{
+    append->reserved = 0;
+    append->blocks_count = 0;
+    append->dropped = 0;
+    append->blocks = blocks;
+    append->blocks_capacity = blocks_capacity;
+    append->capacity = capacity;
+    append->block_size = block_size > 0 ? block_size : 1;
+    append->ordered = ordered;
+    append->in_place = 1;
+}
+
+SPEG_APPEND_API SPEG_APPEND_INLINE void speg_append_cursor_begin(speg_append_cursor *cursor, speg_append *append, int key)
+{
+    cursor->append = append;
+    cursor->block = 0;
+    cursor->key = key;
+    cursor->sequence = 0;
+}
+
+/* Up to count contiguous slots (*granted, at least 1) from the current block of the cursor or a new one of at
+ * least block_size slots. Returns the first slot, -1 (nothing granted) when the capacity is used up */
+SPEG_APPEND_API SPEG_APPEND_INLINE int speg_append_reserve(speg_append_cursor *cursor, int count, int *granted)
+{
+    speg_append *append = cursor->append;
+    speg_append_block *block = cursor->block;
+    int first;
+
+    if (!block || block->count == block->size)
+    {
+        int size = count > append->block_size ? count : append->block_size;
+        long reserved = speg_atomic_fetch_add(&append->reserved, size);
+        long index;
+
+        if (reserved >= append->capacity)
+        {
+            speg_atomic_fetch_add(&append->dropped, count);
+            *granted = 0;
+            return (-1);
+        }
+
+        /* The last block gets what is left of the capacity */
+        size = reserved + size > append->capacity ? append->capacity - (int)reserved : size;
+
+        index = speg_atomic_fetch_add(&append->blocks_count, 1);
+        block = &append->blocks[index];
+        block->first = (int)reserved;
+        block->count = 0;
+        block->size = size;
+        block->key = cursor->key;
+        block->sequence = cursor->sequence++;
+        cursor->block = block;
+    }
+
+    first = block->first + block->count;
+    *granted = block->size - block->count < count ? block->size - block->count : count;
+    block->count += *granted;
+
+    return (first);
+}
+
+/* Sorts the blocks into their final order after all writers finished and returns the number of slots written */
+SPEG_APPEND_API SPEG_APPEND_INLINE int speg_append_end(speg_append *append)
+{
+    speg_append_block *blocks = append->blocks;
+    int count = (int)append->blocks_count;
+    int total = 0;
+    int i;
+
+    /* Insertion sort, the blocks of a parallel-for are mostly in order already */
+    for (i = 1; i < count; ++i)
+    {
+        speg_append_block block = blocks[i];
+        int j = i;
+
+        while (j > 0 && (append->ordered ? (blocks[j - 1].key > block.key || (blocks[j - 1].key == block.key && blocks[j - 1].sequence > block.sequence))
+                                         : blocks[j - 1].first > block.first))
+        {
+            blocks[j] = blocks[j - 1];
+            --j;
+        }
+        blocks[j] = block;
+    }
+
+    append->in_place = 1;
+    for (i = 0; i < count; ++i)
+    {
+        append->in_place &= i == 0 || blocks[i - 1].first < blocks[i].first;
+        total += blocks[i].count;
+    }
+
+    return (total);
+}
+
+/* After speg_append_end: moves the written slots of the blocks in their final order to [0, total) and returns total.
+ * Blocks in position order move down in place, otherwise they are gathered in [capacity, capacity + total) and
+ * copied back in one piece */
+SPEG_APPEND_API SPEG_APPEND_INLINE int speg_append_compact(speg_append *append, speg_append_copy copy, void *data)
+{
+    int dst = append->in_place ? 0 : append->capacity;
+    int i;
+
+    for (i = 0; i < (int)append->blocks_count; ++i)
+    {
+        speg_append_block *block = &append->blocks[i];
+
+        if (dst != block->first && block->count > 0)
+        {
+            copy(data, dst, block->first, block->count);
+        }
+        dst += block->count;
+    }
+
+    if (!append->in_place && dst > append->capacity)
+    {
+        copy(data, 0, append->capacity, dst - append->capacity);
+    }
+
+    return (append->in_place ? dst : dst - append->capacity);
+}
+
+#endif /* SPEG_APPEND_H */
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+
+*/
@@ -0,0 +1,193 @@
+/* speg_arena.h - v0.1 - public domain linear arena allocator - nickscha 2025
+
+A C89 standard compliant, single header, nostdlib (no C Standard Library) linear allocator over a caller provided
+memory block (the permanent and transient blocks of speg_memory).
+
+A push bumps the used offset, nothing is freed on its own. Temp blocks save the offset and restore it (scratch
+memory of a function), a reset frees everything (the transient arena once per frame). The high water mark keeps
+the most bytes ever used so the blocks can be sized from real runs, pushes that do not fit return 0 and are counted.
+
+Alignment is applied to the offset from the start of the block, the memory itself must be aligned to the largest
+alignment used (blocks from VirtualAlloc/mmap are page aligned).
+
+USAGE
+
+  speg_arena_init(&arena, memory, size);
+
+  models = SPEG_ARENA_PUSH_ARRAY(&arena, float, count * 16);
+  block = speg_arena_push_aligned(&arena, size, 64);
+
+  temp = speg_arena_temp_begin(&arena);
+  (scratch pushes)
+  speg_arena_temp_end(temp);
+
+  speg_arena_reset(&arena);
+
+LICENSE
+
+  Placed in the public domain and also MIT licensed.
+  See end of file for detailed license information.
+
+*/
+#ifndef SPEG_ARENA_H
+#define SPEG_ARENA_H
+
+/* #############################################################################
+ * # COMPILER SETTINGS
+ * #############################################################################
+ */
+/* Check if using C99 or later (inline is supported) */
+#if __STDC_VERSION__ >= 199901L
+#define SPEG_ARENA_INLINE inline
+#define SPEG_ARENA_API extern
+#elif defined(__GNUC__) || defined(__clang__)
+#define SPEG_ARENA_INLINE __inline__
+#define SPEG_ARENA_API static
+#elif defined(_MSC_VER)
+#define SPEG_ARENA_INLINE __inline
+#define SPEG_ARENA_API static
+#else
+#define SPEG_ARENA_INLINE
+#define SPEG_ARENA_API static
+#endif
+
+#define SPEG_ARENA_DEFAULT_ALIGNMENT 16 /* SSE loads, enough for every scalar type */
+
+/* #############################################################################
+ * # DATA STRUCTURES
+ * #############################################################################
+ */
+typedef struct speg_arena
+{
+    unsigned char *memory;
+    unsigned long size;
+    unsigned long used;
+    unsigned long high_water; /* most bytes ever used */
+    unsigned long failed;     /* pushes that did not fit */
+    unsigned int temp_count;  /* open temp blocks */
+
+} speg_arena;
+
+typedef struct speg_arena_temp
+{
+    speg_arena *arena;
+    unsigned long used;
+
+} speg_arena_temp;
+
+/* #############################################################################
+ * # FUNCTIONS
+ * #############################################################################
+ */
+SPEG_ARENA_API SPEG_ARENA_INLINE void speg_arena_init(speg_arena *arena, void *memory, unsigned long size)
+{
+    arena->memory = (unsigned char *)memory;
+    arena->size = memory ? size : 0;
+    arena->used = 0;
+    arena->high_water = 0;
+    arena->failed = 0;
+    arena->temp_count = 0;
+}
+
+/* alignment must be a power of two. Returns 0 if the arena is full */
+SPEG_ARENA_API SPEG_ARENA_INLINE void *speg_arena_push_aligned(speg_arena *arena, unsigned long size, unsigned long alignment)
+{
+    unsigned long start = (arena->used + alignment - 1) & ~(alignment - 1);
+
+    if (start < arena->used || start > arena->size || size > arena->size - start)
+    {
+        arena->failed++;
+        return (0);
+    }
+
+    arena->used = start + size;
+
+    if (arena->used > arena->high_water)
+    {
+        arena->high_water = arena->used;
+    }
+
+    return (arena->memory + start);
+}
+
+SPEG_ARENA_API SPEG_ARENA_INLINE void *speg_arena_push(speg_arena *arena, unsigned long size)
+{
+    return (speg_arena_push_aligned(arena, size, SPEG_ARENA_DEFAULT_ALIGNMENT));
+}
+
+#define SPEG_ARENA_PUSH_ARRAY(arena, type, count) ((type *)speg_arena_push((arena), (unsigned long)(count) * (unsigned long)sizeof(type)))
+
+SPEG_ARENA_API SPEG_ARENA_INLINE unsigned long speg_arena_remaining(const speg_arena *arena)
+{
+    return (arena->size - arena->used);
+}
+
+SPEG_ARENA_API SPEG_ARENA_INLINE speg_arena_temp speg_arena_temp_begin(speg_arena *arena)
+{
+    speg_arena_temp temp;
+
+    temp.arena = arena;
+    temp.used = arena->used;
+    arena->temp_count++;
+
+    return (temp);
+}
+
+/* Frees everything pushed since temp_begin */
+SPEG_ARENA_API SPEG_ARENA_INLINE void speg_arena_temp_end(speg_arena_temp temp)
+{
+    temp.arena->used = temp.used;
+    temp.arena->temp_count--;
+}
+
+/* Frees everything, the high water mark is kept */
+SPEG_ARENA_API SPEG_ARENA_INLINE void speg_arena_reset(speg_arena *arena)
+{
+    arena->used = 0;
+    arena->temp_count = 0;
+}
+
+#endif /* SPEG_ARENA_H */
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+
+*/
@@ -0,0 +1,3213 @@
+/* Frame benchmark for speg.c on the headless linux host.
+ *
+ * Drives speg_update through deterministic camera fly-throughs (scripted platform_controller_input
+ * sequences with a fixed dt) and reports p50/p90/p99/max frame times per path plus the inclusive and
+ * exclusive cycles of every profiler zone (render_cubes, render_text, render_car, ...).
+ *
+ * Usage: speg_bench [repeats] [speg.so]
+ *
+ * Every bench_* check returns its mismatches, the exit code is 1 if any check failed.
+ *
+ * speg_draw_call_append is only a zone when the code is built with -DSPEG_PERF_APPEND
+ * (build.sh produces speg_perf.so for that).
+ */
+#include "speg_headless.h"
+
+#define VM_USE_SSE
+#define VM_USE_AVX2
+#include "vm.h"
+#include "speg_bvh.h"
+#include "speg_scene.h"
+#include "speg_append.h"
+#include "speg_spatial.h"
+#define SPEG_OCCLUSION_USE_SSE
+#include "speg_occlusion.h"
+
+#include <stdlib.h>
+#include <math.h>
+
+/* Keys held down while the segment runs: w,a,s,d = move, u = up (space), j = down (control) */
+typedef struct bench_segment
+{
+  int frames;
+  char *keys;
+  float mouse_x; /* mouse offset per frame, 10 = 1 degree yaw */
+  float mouse_y; /* mouse offset per frame, 10 = 1 degree pitch */
+
+} bench_segment;
+
+typedef struct bench_path
+{
+  char *name;
+  bench_segment *segments;
+  int segments_count;
+  bool camera_simulate; /* F3: render culled objects as well */
+
+} bench_path;
+
+/* Camera starts at (0, 2, 13) looking towards -z into the random cube field (range 20 around the origin) */
+static bench_segment path_idle[] = {
+    {600, "", 0.0f, 0.0f}};
+
+static bench_segment path_flythrough[] = {
+    {180, "w", 0.0f, 0.0f},   /* into the cube field */
+    {90, "w", 10.0f, 0.0f},   /* curve right */
+    {120, "wu", 0.0f, -2.0f}, /* climb and look down */
+    {90, "d", -10.0f, 0.0f},  /* strafe while turning back */
+    {120, "sj", 0.0f, 2.0f}}; /* back off and descend */
+
+static bench_segment path_orbit[] = {
+    {720, "a", 5.0f, 0.0f}}; /* strafe left while yawing right: full circle around the field */
+
+static bench_segment path_sweep[] = {
+    {360, "", 20.0f, 0.0f}, /* fast 720 degree turn, culling result changes every frame */
+    {120, "", 0.0f, 5.0f},
+    {120, "", 0.0f, -10.0f}};
+
+static bench_path paths[] = {
+    {"idle", path_idle, array_size(path_idle), false},
+    {"flythrough", path_flythrough, array_size(path_flythrough), false},
+    {"orbit", path_orbit, array_size(path_orbit), false},
+    {"sweep", path_sweep, array_size(path_sweep), false},
+    {"flythrough_sim", path_flythrough, array_size(path_flythrough), true}};
+
+typedef struct bench_frame
+{
+  double nanoseconds;
+  unsigned long cycles;
+  unsigned long inclusive[SPEG_PROFILER_MAX_ZONES];
+  unsigned long exclusive[SPEG_PROFILER_MAX_ZONES];
+  unsigned int hits[SPEG_PROFILER_MAX_ZONES];
+
+} bench_frame;
+
+platform_controller_state *bench_key(platform_controller_input *input, char key)
+{
+  switch (key)
+  {
+  case 'w':
+    return &input->key_w;
+  case 'a':
+    return &input->key_a;
+  case 's':
+    return &input->key_s;
+  case 'd':
+    return &input->key_d;
+  case 'u':
+    return &input->key_space;
+  case 'j':
+    return &input->key_control;
+  default:
+    return NULL;
+  }
+}
+
+void bench_input_set(platform_controller_input *input, bench_segment *segment, bool camera_simulate, bool reset_camera)
+{
+  platform_controller_input empty = {0};
+  *input = empty;
+
+  input->mouse_attached = true;
+  input->mouse_offset_x = segment->mouse_x;
+  input->mouse_offset_y = segment->mouse_y;
+  input->key_f3.active = camera_simulate;
+  input->key_f5.endedDown = reset_camera;
+
+  for (char *k = segment->keys; *k; ++k)
+  {
+    platform_controller_state *key = bench_key(input, *k);
+    if (key)
+    {
+      key->endedDown = true;
+    }
+  }
+}
+
+int bench_compare_double(const void *a, const void *b)
+{
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile of an ascending sorted array */
+double bench_percentile(double *sorted, int count, double percentile)
+{
+  int rank = (int)(percentile / 100.0 * (double)count + 0.999999);
+  rank = rank < 1 ? 1 : (rank > count ? count : rank);
+  return sorted[rank - 1];
+}
+
+/* Cost of an empty zone (begin + end) and of the counter read inside it, measured on a separate profiler so the
+ * frame zones stay untouched. What a zone costs beyond its two counter reads is the bookkeeping of the profiler.
+ * The best of 8 frames is kept, the first one faults in the fresh event pages (speg_state is warm after a frame) */
+void bench_profiler_overhead(void)
+{
+  int zones = SPEG_PROFILER_MAX_EVENTS / 2;
+  speg_profiler *profiler = (speg_profiler *)calloc(1, sizeof(speg_profiler));
+
+  if (!profiler)
+  {
+    return;
+  }
+
+  unsigned int zone = speg_profiler_zone_register(profiler, "empty");
+  unsigned long best_zones = (unsigned long)-1;
+  unsigned long best_reads = (unsigned long)-1;
+
+  for (int frame = 0; frame < 8; ++frame)
+  {
+    speg_profiler_frame_begin(profiler, headless_rdtsc);
+
+    unsigned long start = headless_rdtsc();
+    for (int i = 0; i < zones; ++i)
+    {
+      speg_profiler_begin(profiler, zone);
+      speg_profiler_end(profiler, zone);
+    }
+    unsigned long cycles = headless_rdtsc() - start;
+    best_zones = cycles < best_zones ? cycles : best_zones;
+
+    speg_profiler_frame_end(profiler);
+
+    start = headless_rdtsc();
+    for (int i = 0; i < zones * 2; ++i)
+    {
+      (void)speg_profiler_cycles(profiler);
+    }
+    cycles = headless_rdtsc() - start;
+    best_reads = cycles < best_reads ? cycles : best_reads;
+  }
+
+  free(profiler);
+
+  double per_zone = (double)best_zones / (double)zones;
+  double per_read = (double)best_reads / (double)(zones * 2);
+
+  printf("[bench] profiler: %.1f cycles per zone, %.1f cycles per cycle counter read, %.1f cycles bookkeeping per zone\n",
+         per_zone, per_read, per_zone - 2.0 * per_read);
+}
+
+/* The byte loops speg.h had before, kept from being turned into memcpy/memset calls (which would measure speg.h) */
+__attribute__((noinline, optimize("no-tree-loop-distribute-patterns"))) void *bench_memcpy_bytes(void *dest, const void *src, unsigned int count)
+{
+  char *dest8 = (char *)dest;
+  const char *src8 = (const char *)src;
+  while (count--)
+  {
+    *dest8++ = *src8++;
+  }
+  return dest;
+}
+
+__attribute__((noinline, optimize("no-tree-loop-distribute-patterns"))) void *bench_memset_bytes(void *dest, int c, unsigned int count)
+{
+  char *bytes = (char *)dest;
+  while (count--)
+  {
+    *bytes++ = (char)c;
+  }
+  return dest;
+}
+
+/* string.h would clash with the memcpy/memset of speg.h */
+int bench_memory_differs(const unsigned char *a, const unsigned char *b, unsigned int count)
+{
+  for (unsigned int i = 0; i < count; ++i)
+  {
+    if (a[i] != b[i])
+    {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+#ifdef SPEG_MEMORY_AVX2
+#define BENCH_MEMORY_SIMD "avx2"
+#elif defined(SPEG_MEMORY_SSE2)
+#define BENCH_MEMORY_SIMD "sse2"
+#else
+#define BENCH_MEMORY_SIMD "bytes"
+#endif
+
+/* memcpy/memset of speg.h against the byte loops from 16 B to 16 MB (bytes per cycle, about 16 MB moved per size).
+ * Random sizes and misalignments around the vector width and a non temporal copy are checked byte by byte */
+int bench_memory(void)
+{
+  enum
+  {
+    size_max = 16 * 1024 * 1024,
+    checks = 4000
+  };
+
+  unsigned char *src = (unsigned char *)malloc(size_max + 64);
+  unsigned char *dest = (unsigned char *)malloc(size_max + 64);
+  unsigned char *reference = (unsigned char *)malloc(size_max + 64);
+  int mismatches = 0;
+
+  if (!src || !dest || !reference)
+  {
+    free(src);
+    free(dest);
+    free(reference);
+    return 0;
+  }
+
+  for (unsigned int i = 0; i < size_max + 64; ++i)
+  {
+    src[i] = (unsigned char)(i * 7 + (i >> 11));
+  }
+
+  for (unsigned int size = 16; size <= size_max; size *= 4)
+  {
+    unsigned int repeats = (16 * 1024 * 1024) / size < 4 ? 4 : (16 * 1024 * 1024) / size;
+    double cycles[4];
+
+    for (int k = 0; k < 4; ++k)
+    {
+      unsigned long start = headless_rdtsc();
+
+      for (unsigned int r = 0; r < repeats; ++r)
+      {
+        switch (k)
+        {
+        case 0:
+          bench_memcpy_bytes(dest, src, size);
+          break;
+        case 1:
+          memcpy(dest, src, size);
+          break;
+        case 2:
+          bench_memset_bytes(dest, (int)r, size);
+          break;
+        default:
+          memset(dest, (int)r, size);
+          break;
+        }
+      }
+
+      cycles[k] = (double)(headless_rdtsc() - start);
+    }
+
+    double bytes = (double)size * (double)repeats;
+    printf("[bench] memory %8u B: memcpy bytes %6.2f, " BENCH_MEMORY_SIMD " %6.2f bytes/cycle (%5.1fx), memset bytes %6.2f, " BENCH_MEMORY_SIMD " %6.2f bytes/cycle (%5.1fx)\n",
+           size, bytes / cycles[0], bytes / cycles[1], cycles[0] / cycles[1], bytes / cycles[2], bytes / cycles[3], cycles[2] / cycles[3]);
+  }
+
+  /* Every head/body/tail combination: sizes up to a few vectors at any misalignment, the bytes around stay */
+  vm_seed_lcg = 29;
+  for (int i = 0; i < checks; ++i)
+  {
+    unsigned int size = (unsigned int)vm_randf_range(0.0f, 300.0f);
+    unsigned int src_offset = (unsigned int)vm_randf_range(0.0f, 63.0f);
+    unsigned int dest_offset = (unsigned int)vm_randf_range(0.0f, 63.0f);
+    int value = (int)vm_randf_range(0.0f, 255.0f);
+
+    bench_memset_bytes(dest, 0xEE, 512);
+    bench_memset_bytes(reference, 0xEE, 512);
+
+    if (i & 1)
+    {
+      memcpy(dest + dest_offset, src + src_offset, size);
+      bench_memcpy_bytes(reference + dest_offset, src + src_offset, size);
+    }
+    else
+    {
+      memset(dest + dest_offset, value, size);
+      bench_memset_bytes(reference + dest_offset, value, size);
+    }
+
+    mismatches += bench_memory_differs(dest, reference, 512);
+  }
+
+  /* Non temporal paths, misaligned with a tail */
+  {
+    unsigned int size = SPEG_MEMORY_NON_TEMPORAL * 3 + 37;
+
+    bench_memset_bytes(dest, 0xEE, size + 16);
+    memcpy(dest + 5, src + 3, size);
+    mismatches += bench_memory_differs(dest + 5, src + 3, size) || dest[4] != 0xEE || dest[size + 5] != 0xEE;
+
+    bench_memset_bytes(dest, 0xEE, size + 16);
+    memset(dest + 9, 0x5A, size);
+    bench_memset_bytes(reference, 0x5A, size);
+    mismatches += bench_memory_differs(dest + 9, reference, size) || dest[8] != 0xEE || dest[size + 9] != 0xEE;
+  }
+
+  printf("[bench] memory: " BENCH_MEMORY_SIMD ", non temporal from %d bytes, %d random copies/sets, %d mismatches\n", SPEG_MEMORY_NON_TEMPORAL, checks, mismatches);
+
+  free(src);
+  free(dest);
+  free(reference);
+
+  return mismatches;
+}
+
+#ifdef VM_USE_AVX2
+#define BENCH_SIMD "avx2"
+#elif defined(VM_USE_SSE)
+#define BENCH_SIMD "sse"
+#else
+#define BENCH_SIMD "scalar"
+#endif
+
+/* Per box cost of vm_frustum_is_cube_in (8 corners) against the batched vm_frustum_cull_aabb_soa */
+int bench_frustum_culling(void)
+{
+  int count = 128 * 1024;
+  int runs = 10;
+  float *soa = (float *)malloc(sizeof(float) * (size_t)count * 6);
+  unsigned int *mask = (unsigned int *)malloc(sizeof(unsigned int) * (size_t)(count + 31) / 32);
+  unsigned char *reference = (unsigned char *)malloc((size_t)count);
+
+  if (!soa || !mask || !reference)
+  {
+    return 0;
+  }
+
+  float *center_x = soa;
+  float *center_y = soa + count;
+  float *center_z = soa + count * 2;
+  float *extent_x = soa + count * 3;
+  float *extent_y = soa + count * 4;
+  float *extent_z = soa + count * 5;
+
+  vm_seed_lcg = 42;
+  for (int i = 0; i < count; ++i)
+  {
+    center_x[i] = vm_randf_range(-100.0f, 100.0f);
+    center_y[i] = vm_randf_range(-100.0f, 100.0f);
+    center_z[i] = vm_randf_range(-100.0f, 100.0f);
+    extent_x[i] = vm_randf_range(0.25f, 2.0f);
+    extent_y[i] = vm_randf_range(0.25f, 2.0f);
+    extent_z[i] = vm_randf_range(0.25f, 2.0f);
+  }
+
+  m4x4 projection = vm_m4x4_perspective(vm_radf(90.0f), 800.0f / 600.0f, 0.1f, 1000.0f);
+  m4x4 view = vm_m4x4_lookAt(vm_v3(0.0f, 2.0f, 13.0f), vm_v3(0.0f, 2.0f, 12.0f), vm_v3(0.0f, 1.0f, 0.0f));
+  frustum planes = vm_frustum_extract_planes(vm_m4x4_mul(projection, view));
+
+  unsigned long best_corners = (unsigned long)-1;
+  unsigned long best_batch = (unsigned long)-1;
+  int visible = 0;
+  int mismatches = 0;
+
+  for (int r = 0; r < runs; ++r)
+  {
+    unsigned long start = headless_rdtsc();
+    for (int i = 0; i < count; ++i)
+    {
+      v3 dimensions = vm_v3(extent_x[i] * 2.0f, extent_y[i] * 2.0f, extent_z[i] * 2.0f);
+      reference[i] = (unsigned char)vm_frustum_is_cube_in(planes, vm_v3(center_x[i], center_y[i], center_z[i]), dimensions, 0.0f);
+    }
+    unsigned long cycles = headless_rdtsc() - start;
+    best_corners = cycles < best_corners ? cycles : best_corners;
+
+    start = headless_rdtsc();
+    vm_frustum_cull_aabb_soa(planes, center_x, center_y, center_z, extent_x, extent_y, extent_z, count, mask);
+    cycles = headless_rdtsc() - start;
+    best_batch = cycles < best_batch ? cycles : best_batch;
+  }
+
+  for (int i = 0; i < count; ++i)
+  {
+    int batch = vm_frustum_cull_mask_is_visible(mask, i);
+    visible += batch;
+    mismatches += batch != reference[i];
+  }
+
+  printf("[bench] frustum culling %d boxes (%d visible): corners %.1f cycles/box, batch " BENCH_SIMD " %.2f cycles/box, %d mismatches\n",
+         count,
+         visible,
+         (double)best_corners / (double)count,
+         (double)best_batch / (double)count,
+         mismatches);
+
+  free(soa);
+  free(mask);
+  free(reference);
+
+  return mismatches;
+}
+
+/* 500k static props: bvh walk against the batched brute force test of every box */
+int bench_bvh_culling(void)
+{
+  int count = 500 * 1000;
+  int runs = 10;
+  float *centers = (float *)malloc(sizeof(float) * (size_t)count * 3);
+  float *extents = (float *)malloc(sizeof(float) * (size_t)count * 3);
+  float *soa = (float *)malloc(sizeof(float) * (size_t)count * 6);
+  unsigned int *mask = (unsigned int *)malloc(sizeof(unsigned int) * (size_t)(count + 31) / 32);
+  speg_bvh_node *nodes = (speg_bvh_node *)malloc(sizeof(speg_bvh_node) * (size_t)SPEG_BVH_NODES_CAPACITY(count));
+  int *indices = (int *)malloc(sizeof(int) * (size_t)count);
+  float *bounds = (float *)malloc(sizeof(float) * (size_t)count * 6);
+  speg_bvh_range *ranges = (speg_bvh_range *)malloc(sizeof(speg_bvh_range) * (size_t)count);
+  unsigned char *in_bvh = (unsigned char *)malloc((size_t)count);
+
+  if (!centers || !extents || !soa || !mask || !nodes || !indices || !bounds || !ranges || !in_bvh)
+  {
+    return 0;
+  }
+
+  vm_seed_lcg = 42;
+  for (int i = 0; i < count; ++i)
+  {
+    for (int a = 0; a < 3; ++a)
+    {
+      centers[i * 3 + a] = vm_randf_range(-500.0f, 500.0f);
+      extents[i * 3 + a] = vm_randf_range(0.25f, 2.0f);
+      soa[a * count + i] = centers[i * 3 + a];
+      soa[(3 + a) * count + i] = extents[i * 3 + a];
+    }
+  }
+
+  unsigned long start = headless_rdtsc();
+  speg_bvh bvh;
+  int nodes_count = speg_bvh_build(&bvh, nodes, indices, bounds, centers, extents, count);
+  unsigned long build_cycles = headless_rdtsc() - start;
+
+  m4x4 projection = vm_m4x4_perspective(vm_radf(90.0f), 800.0f / 600.0f, 0.1f, 1000.0f);
+  m4x4 view = vm_m4x4_lookAt(vm_v3(0.0f, 2.0f, 13.0f), vm_v3(0.0f, 2.0f, 12.0f), vm_v3(0.0f, 1.0f, 0.0f));
+  frustum planes = vm_frustum_extract_planes(vm_m4x4_mul(projection, view));
+
+  unsigned long best_batch = (unsigned long)-1;
+  unsigned long best_bvh = (unsigned long)-1;
+  int ranges_count = 0;
+  int visible = 0;
+
+  for (int r = 0; r < runs; ++r)
+  {
+    start = headless_rdtsc();
+    vm_frustum_cull_aabb_soa(planes, soa, soa + count, soa + count * 2, soa + count * 3, soa + count * 4, soa + count * 5, count, mask);
+    unsigned long cycles = headless_rdtsc() - start;
+    best_batch = cycles < best_batch ? cycles : best_batch;
+
+    start = headless_rdtsc();
+    ranges_count = speg_bvh_cull(&bvh, (float *)vm_frustum_data(&planes), ranges, count, &visible);
+    cycles = headless_rdtsc() - start;
+    best_bvh = cycles < best_bvh ? cycles : best_bvh;
+  }
+
+  memset(in_bvh, 0, (unsigned int)count);
+  for (int r = 0; r < ranges_count; ++r)
+  {
+    for (int i = ranges[r].first; i < ranges[r].first + ranges[r].count; ++i)
+    {
+      in_bvh[indices[i]] = 1;
+    }
+  }
+
+  int mismatches = 0;
+  for (int i = 0; i < count; ++i)
+  {
+    mismatches += vm_frustum_cull_mask_is_visible(mask, i) != in_bvh[i];
+  }
+
+  printf("[bench] bvh culling %d boxes (%d visible, %d ranges, %d nodes, build %.1f Mcycles): batch " BENCH_SIMD " %lu cycles, bvh %lu cycles, %d mismatches\n",
+         count,
+         visible,
+         ranges_count,
+         nodes_count,
+         (double)build_cycles / 1.0e6,
+         best_batch,
+         best_bvh,
+         mismatches);
+
+  free(centers);
+  free(extents);
+  free(soa);
+  free(mask);
+  free(nodes);
+  free(indices);
+  free(bounds);
+  free(ranges);
+  free(in_bvh);
+
+  return mismatches;
+}
+
+/* Number of handles in results that are not equal to the brute force reference flags (plus missing ones) */
+static int bench_spatial_mismatches(speg_spatial_grid *grid, int *results, int results_count, unsigned char *reference, int count)
+{
+  int mismatches = 0;
+  int found = 0;
+
+  for (int i = 0; i < results_count; ++i)
+  {
+    int user = grid->objects[results[i]].user;
+    mismatches += !reference[user];
+    found += reference[user];
+  }
+
+  for (int i = 0; i < count; ++i)
+  {
+    found -= reference[i];
+  }
+
+  return (mismatches - found);
+}
+
+/* 100k moving objects in the loose grid: incremental updates and every query type against a brute force scan */
+int bench_spatial_grid(void)
+{
+  enum
+  {
+    cells = 32
+  };
+  int count = 100 * 1000;
+  speg_spatial_cell *grid_cells = (speg_spatial_cell *)malloc(sizeof(speg_spatial_cell) * cells * cells * cells);
+  int *occupied = (int *)malloc(sizeof(int) * cells * cells * cells);
+  speg_spatial_object *objects = (speg_spatial_object *)malloc(sizeof(speg_spatial_object) * (size_t)count);
+  int *handles = (int *)malloc(sizeof(int) * (size_t)count);
+  int *results = (int *)malloc(sizeof(int) * (size_t)count);
+  float *boxes = (float *)malloc(sizeof(float) * (size_t)count * 6);
+  unsigned char *alive = (unsigned char *)malloc((size_t)count);
+  unsigned char *reference = (unsigned char *)malloc((size_t)count);
+
+  if (!grid_cells || !occupied || !objects || !handles || !results || !boxes || !alive || !reference)
+  {
+    return 0;
+  }
+
+  speg_spatial_grid grid;
+  float origin[3] = {-500.0f, -500.0f, -500.0f};
+  speg_spatial_init(&grid, origin, 1000.0f / cells, cells, cells, cells, grid_cells, occupied, objects, count);
+
+  vm_seed_lcg = 42;
+  unsigned long start = headless_rdtsc();
+  for (int i = 0; i < count; ++i)
+  {
+    float *box = &boxes[i * 6];
+    for (int a = 0; a < 3; ++a)
+    {
+      box[a] = vm_randf_range(-520.0f, 520.0f); /* a few outside the world box */
+      box[3 + a] = vm_randf_range(0.25f, 2.0f);
+    }
+    handles[i] = speg_spatial_insert(&grid, box, box + 3, i);
+    alive[i] = 1;
+  }
+  unsigned long insert_cycles = headless_rdtsc() - start;
+
+  /* Every object moves a bit, every 10th one far, every 50th is removed */
+  start = headless_rdtsc();
+  for (int i = 0; i < count; ++i)
+  {
+    float *box = &boxes[i * 6];
+    float step = (i % 10 == 0) ? 100.0f : 0.5f;
+    for (int a = 0; a < 3; ++a)
+    {
+      box[a] += vm_randf_range(-step, step);
+    }
+    speg_spatial_move(&grid, handles[i], box, box + 3);
+  }
+  unsigned long move_cycles = headless_rdtsc() - start;
+
+  for (int i = 0; i < count; i += 50)
+  {
+    speg_spatial_remove(&grid, handles[i]);
+    alive[i] = 0;
+  }
+  speg_spatial_refit(&grid);
+
+  int mismatches = 0;
+
+  /* Frustum */
+  m4x4 projection = vm_m4x4_perspective(vm_radf(90.0f), 800.0f / 600.0f, 0.1f, 1000.0f);
+  m4x4 view = vm_m4x4_lookAt(vm_v3(0.0f, 2.0f, 13.0f), vm_v3(0.0f, 2.0f, 12.0f), vm_v3(0.0f, 1.0f, 0.0f));
+  frustum planes = vm_frustum_extract_planes(vm_m4x4_mul(projection, view));
+
+  start = headless_rdtsc();
+  int frustum_count = speg_spatial_query_frustum(&grid, (float *)vm_frustum_data(&planes), results, count);
+  unsigned long frustum_cycles = headless_rdtsc() - start;
+
+  for (int i = 0; i < count; ++i)
+  {
+    reference[i] = (unsigned char)(alive[i] && vm_frustum_is_cube_in(planes, vm_v3(boxes[i * 6], boxes[i * 6 + 1], boxes[i * 6 + 2]), vm_v3(boxes[i * 6 + 3] * 2.0f, boxes[i * 6 + 4] * 2.0f, boxes[i * 6 + 5] * 2.0f), 0.0f));
+  }
+  mismatches += bench_spatial_mismatches(&grid, results, frustum_count, reference, count);
+
+  /* Sphere and box around a point of the field */
+  float query_center[3] = {100.0f, -50.0f, 30.0f};
+  float query_radius = 40.0f;
+  float query_extents[3] = {30.0f, 60.0f, 20.0f};
+
+  start = headless_rdtsc();
+  int sphere_count = speg_spatial_query_sphere(&grid, query_center, query_radius, results, count);
+  unsigned long sphere_cycles = headless_rdtsc() - start;
+
+  for (int i = 0; i < count; ++i)
+  {
+    float distance_squared = 0.0f;
+    for (int a = 0; a < 3; ++a)
+    {
+      float lo = boxes[i * 6 + a] - boxes[i * 6 + 3 + a];
+      float hi = boxes[i * 6 + a] + boxes[i * 6 + 3 + a];
+      float d = query_center[a] < lo ? lo - query_center[a] : (query_center[a] > hi ? query_center[a] - hi : 0.0f);
+      distance_squared += d * d;
+    }
+    reference[i] = (unsigned char)(alive[i] && distance_squared <= query_radius * query_radius);
+  }
+  mismatches += bench_spatial_mismatches(&grid, results, sphere_count, reference, count);
+
+  start = headless_rdtsc();
+  int aabb_count = speg_spatial_query_aabb(&grid, query_center, query_extents, results, count);
+  unsigned long aabb_cycles = headless_rdtsc() - start;
+
+  for (int i = 0; i < count; ++i)
+  {
+    int overlaps = alive[i];
+    for (int a = 0; a < 3; ++a)
+    {
+      overlaps = overlaps && vm_absf(boxes[i * 6 + a] - query_center[a]) <= boxes[i * 6 + 3 + a] + query_extents[a];
+    }
+    reference[i] = (unsigned char)overlaps;
+  }
+  mismatches += bench_spatial_mismatches(&grid, results, aabb_count, reference, count);
+
+  /* Ray from the camera through the field */
+  float ray_origin[3] = {0.0f, 2.0f, 13.0f};
+  float ray_direction[3] = {0.3f, -0.1f, -1.0f};
+  float ray_distance = 0.0f;
+
+  start = headless_rdtsc();
+  int ray_hit = speg_spatial_raycast(&grid, ray_origin, ray_direction, 2000.0f, &ray_distance);
+  unsigned long ray_cycles = headless_rdtsc() - start;
+
+  int ray_reference = -1;
+  float ray_reference_distance = 2000.0f;
+  for (int i = 0; i < count; ++i)
+  {
+    float t_near = 0.0f;
+    float t_far = ray_reference_distance;
+    for (int a = 0; a < 3 && alive[i]; ++a)
+    {
+      float t0 = (boxes[i * 6 + a] - boxes[i * 6 + 3 + a] - ray_origin[a]) / ray_direction[a];
+      float t1 = (boxes[i * 6 + a] + boxes[i * 6 + 3 + a] - ray_origin[a]) / ray_direction[a];
+      t_near = vm_maxf(t_near, vm_minf(t0, t1));
+      t_far = vm_minf(t_far, vm_maxf(t0, t1));
+    }
+    if (alive[i] && t_near <= t_far && t_near < ray_reference_distance)
+    {
+      ray_reference = i;
+      ray_reference_distance = t_near;
+    }
+  }
+  mismatches += (ray_hit == SPEG_SPATIAL_NONE ? -1 : grid.objects[ray_hit].user) != ray_reference;
+
+  printf("[bench] spatial grid %d objects (%d occupied cells): insert %.1f, move %.1f cycles/object, "
+         "frustum %d in %lu, sphere %d in %lu, aabb %d in %lu, ray %lu cycles, %d mismatches\n",
+         grid.objects_count,
+         grid.occupied_count,
+         (double)insert_cycles / (double)count,
+         (double)move_cycles / (double)count,
+         frustum_count, frustum_cycles,
+         sphere_count, sphere_cycles,
+         aabb_count, aabb_cycles,
+         ray_cycles,
+         mismatches);
+
+  free(grid_cells);
+  free(occupied);
+  free(objects);
+  free(handles);
+  free(results);
+  free(boxes);
+  free(alive);
+  free(reference);
+
+  return mismatches;
+}
+
+static v3 bench_transform_point(m4x4 m, v3 p)
+{
+  return vm_v3(m.e[0] * p.x + m.e[4] * p.y + m.e[8] * p.z + m.e[12],
+               m.e[1] * p.x + m.e[5] * p.y + m.e[9] * p.z + m.e[13],
+               m.e[2] * p.x + m.e[6] * p.y + m.e[10] * p.z + m.e[14]);
+}
+
+/* A wall in front of the camera: boxes behind it must be occluded, boxes in front of it or next to it visible */
+int bench_occlusion(void)
+{
+  static float cube_vertices[] = {
+      -0.5f, -0.5f, -0.5f, 0.5f, -0.5f, -0.5f, 0.5f, 0.5f, -0.5f, -0.5f, 0.5f, -0.5f,
+      -0.5f, -0.5f, 0.5f, 0.5f, -0.5f, 0.5f, 0.5f, 0.5f, 0.5f, -0.5f, 0.5f, 0.5f};
+  static unsigned int cube_indices[] = {
+      0, 3, 2, 2, 1, 0, 4, 5, 6, 6, 7, 4, 0, 4, 7, 7, 3, 0,
+      1, 2, 6, 6, 5, 1, 0, 1, 5, 5, 4, 0, 3, 7, 6, 6, 2, 3};
+  static speg_occlusion occlusion;
+
+  int count = 10000;
+  int runs = 10;
+
+  m4x4 projection = vm_m4x4_perspective(vm_radf(90.0f), 800.0f / 600.0f, 0.1f, 1000.0f);
+  m4x4 view = vm_m4x4_lookAt(vm_v3(0.0f, 2.0f, 13.0f), vm_v3(0.0f, 2.0f, 12.0f), vm_v3(0.0f, 1.0f, 0.0f));
+  m4x4 projection_view = vm_m4x4_mul(projection, view);
+
+  /* 20 x 12 wall at z = 0 (8 to 14 in y) rotated a bit around y, covers the view center */
+  m4x4 wall = vm_m4x4_scale(vm_m4x4_rotate(vm_m4x4_translate(vm_m4x4_identity, vm_v3(0.0f, 2.0f, 0.0f)), vm_radf(10.0f), vm_v3(0.0f, 1.0f, 0.0f)), vm_v3(20.0f, 12.0f, 1.0f));
+  m4x4 wall_inverse = vm_m4x4_inverse(wall);
+
+  unsigned long best_raster = (unsigned long)-1;
+  unsigned long best_test = (unsigned long)-1;
+  int wrong_occluded = 0;
+  int missed_occluded = 0;
+  int expected_occluded = 0;
+  int occluded = 0;
+
+  for (int r = 0; r < runs; ++r)
+  {
+    unsigned long start = headless_rdtsc();
+    speg_occlusion_begin(&occlusion, projection_view.e);
+    speg_occlusion_rasterize_mesh(&occlusion, wall.e, cube_vertices, 8, cube_indices, 36, 1);
+    speg_occlusion_finish(&occlusion);
+    unsigned long cycles = headless_rdtsc() - start;
+    best_raster = cycles < best_raster ? cycles : best_raster;
+
+    vm_seed_lcg = 7;
+    wrong_occluded = 0;
+    missed_occluded = 0;
+    expected_occluded = 0;
+    occluded = 0;
+    cycles = 0;
+
+    for (int i = 0; i < count; ++i)
+    {
+      /* Behind the wall (z < -2) or in front of it (z > 2), lateral spread beyond the wall edges */
+      float z = (i & 1) ? vm_randf_range(-60.0f, -2.0f) : vm_randf_range(2.0f, 9.0f);
+      float center[3] = {vm_randf_range(-30.0f, 30.0f), vm_randf_range(-10.0f, 14.0f), z};
+      float extents[3] = {0.5f, 0.5f, 0.5f};
+
+      start = headless_rdtsc();
+      int visible = speg_occlusion_is_visible_aabb(&occlusion, center, extents);
+      cycles += headless_rdtsc() - start;
+
+      /* Reference: behind the wall and every corner ray towards the camera crosses the wall plane inside it */
+      int hidden = z < -2.0f;
+      for (int corner = 0; corner < 8 && hidden; ++corner)
+      {
+        v3 p = vm_v3(center[0] + ((corner & 1) ? 0.5f : -0.5f), center[1] + ((corner & 2) ? 0.5f : -0.5f), center[2] + ((corner & 4) ? 0.5f : -0.5f));
+        v3 eye = vm_v3(0.0f, 2.0f, 13.0f);
+        v3 local_eye = bench_transform_point(wall_inverse, eye);
+        v3 local_p = bench_transform_point(wall_inverse, p);
+        float t = (0.5f - local_eye.z) / (local_p.z - local_eye.z); /* front face of the wall in local space */
+        v3 hit = vm_v3_add(local_eye, vm_v3_mulf(vm_v3_sub(local_p, local_eye), t));
+        hidden = t > 0.0f && t < 1.0f && vm_absf(hit.x) < 0.5f && vm_absf(hit.y) < 0.5f;
+      }
+
+      expected_occluded += hidden;
+      occluded += !visible;
+      wrong_occluded += !visible && !hidden;
+      missed_occluded += visible && hidden;
+    }
+
+    best_test = cycles < best_test ? cycles : best_test;
+  }
+
+  printf("[bench] occlusion %d boxes (%d occluded of %d fully hidden): raster + hiz %lu cycles, %.1f cycles/test, %d wrongly occluded, %d missed\n",
+         count,
+         occluded,
+         expected_occluded,
+         best_raster,
+         (double)best_test / (double)count,
+         wrong_occluded,
+         missed_occluded);
+
+  return wrong_occluded;
+}
+
+/* Error of value in units in the last place of the float closest to reference */
+double bench_ulp_error(float value, double reference)
+{
+  int exponent;
+  frexp(reference, &exponent);
+  return fabs((double)value - reference) / ldexp(1.0, exponent - 24 < -149 ? -149 : exponent - 24);
+}
+
+/* vm_sincosf tiers (scalar, vm_sincosf4, vm_sincosf8) against the double precision libm: max ulp on [-2 pi, 2 pi],
+ * max absolute error on [-8192, 8192] and cycles per angle against vm_sinf + vm_cosf (lookup table) */
+int bench_sincos(void)
+{
+  enum
+  {
+    count = 1 << 18,
+    repeats = 20,
+    widths = 3
+  };
+
+  static const char *tiers[3] = {"fast", "medium", "precise"};
+  static const float bounds[3] = {1e-3f, 4e-6f, 2e-7f};
+  static const double ulp_bounds[3] = {1e9, 64.0, 2.0};
+  static const int lanes[widths] = {1, 4, 8};
+  float *x = (float *)malloc(sizeof(float) * count);
+  float *s = (float *)malloc(sizeof(float) * count);
+  float *c = (float *)malloc(sizeof(float) * count);
+  double *reference_s = (double *)malloc(sizeof(double) * count);
+  double *reference_c = (double *)malloc(sizeof(double) * count);
+
+  if (!x || !s || !c || !reference_s || !reference_c)
+  {
+    free(x);
+    free(s);
+    free(c);
+    free(reference_s);
+    free(reference_c);
+    return 0;
+  }
+
+  /* First half dense around the first periods, second half over the whole range */
+  vm_seed_lcg = 53;
+  for (int i = 0; i < count; ++i)
+  {
+    x[i] = i < count / 2 ? vm_randf_range(-VM_PI2, VM_PI2) : vm_randf_range(-8192.0f, 8192.0f);
+    reference_s[i] = sin((double)x[i]);
+    reference_c[i] = cos((double)x[i]);
+  }
+
+  int mismatches_total = 0;
+
+  for (int tier = -1; tier < 3; ++tier)
+  {
+    double ulp[widths] = {0.0};
+    double cycles[widths] = {0.0};
+    double error = 0.0;
+    int mismatches = 0;
+
+    for (int w = 0; w < (tier < 0 ? 1 : widths); ++w)
+    {
+      unsigned long start = headless_rdtsc();
+
+      for (int r = 0; r < repeats; ++r)
+      {
+        if (tier < 0)
+        {
+          for (int i = 0; i < count; ++i)
+          {
+            s[i] = vm_sinf(x[i]);
+            c[i] = vm_cosf(x[i]);
+          }
+        }
+        else if (lanes[w] == 1)
+        {
+          for (int i = 0; i < count; ++i)
+          {
+            vm_sincosf_accuracy(x[i], tier, s + i, c + i);
+          }
+        }
+        else if (lanes[w] == 4)
+        {
+          for (int i = 0; i < count; i += 4)
+          {
+            __m128 s4, c4;
+            vm_sincosf4(_mm_loadu_ps(x + i), tier, &s4, &c4);
+            _mm_storeu_ps(s + i, s4);
+            _mm_storeu_ps(c + i, c4);
+          }
+        }
+        else
+        {
+          for (int i = 0; i < count; i += 8)
+          {
+            __m256 s8, c8;
+            vm_sincosf8(_mm256_loadu_ps(x + i), tier, &s8, &c8);
+            _mm256_storeu_ps(s + i, s8);
+            _mm256_storeu_ps(c + i, c8);
+          }
+        }
+      }
+      cycles[w] = (double)(headless_rdtsc() - start) / (double)(count * repeats);
+
+      for (int i = 0; i < count; ++i)
+      {
+        double e = fmax(fabs((double)s[i] - reference_s[i]), fabs((double)c[i] - reference_c[i]));
+        double u = i < count / 2 ? fmax(bench_ulp_error(s[i], reference_s[i]), bench_ulp_error(c[i], reference_c[i])) : 0.0;
+
+        ulp[w] = fmax(ulp[w], u);
+        error = fmax(error, e);
+        mismatches += tier >= 0 && !(e <= (double)bounds[tier] && u <= ulp_bounds[tier]);
+      }
+    }
+
+    if (tier < 0)
+    {
+      printf("[bench] sincos table   (vm_sinf + vm_cosf): max error %.2e, max %.3g ulp, %.1f cycles/angle\n", error, ulp[0], cycles[0]);
+      continue;
+    }
+
+    printf("[bench] sincos %-7s max error %.2e, max %.3g/%.3g/%.3g ulp, %.1f/%.1f/%.1f cycles/angle (scalar/sse/avx2), %d mismatches\n",
+           tiers[tier], error, ulp[0], ulp[1], ulp[2], cycles[0], cycles[1], cycles[2], mismatches);
+    mismatches_total += mismatches;
+  }
+
+  free(x);
+  free(s);
+  free(c);
+  free(reference_s);
+  free(reference_c);
+
+  return mismatches_total;
+}
+
+/* Batch kernels of vm.h against the per instance matrix chain: full and affine layouts, with and without rotations
+ * and scales, counts with a scalar tail. The cube rotations of render_cubes through vm_quat_from_axis_angle_m4x4
+ * match vm_m4x4_rotate up to the sine table */
+int bench_batch_transforms(void)
+{
+  enum
+  {
+    count = 4099,
+    repeats = 20
+  };
+
+  v3 *positions = (v3 *)malloc(sizeof(v3) * count);
+  quat *rotations = (quat *)malloc(sizeof(quat) * count);
+  v3 *scales = (v3 *)malloc(sizeof(v3) * count);
+  float *models = (float *)malloc(sizeof(float) * 16 * count);
+  float *affine = (float *)malloc(sizeof(float) * 12 * count);
+  int mismatches = 0;
+  float rotate_error = 0.0f;
+
+  if (!positions || !rotations || !scales || !models || !affine)
+  {
+    free(positions);
+    free(rotations);
+    free(scales);
+    free(models);
+    free(affine);
+    return 0;
+  }
+
+  vm_seed_lcg = 31;
+  for (int i = 0; i < count; ++i)
+  {
+    v3 axis = vm_v3_normalize(vm_v3(vm_randf_range(-1.0f, 1.0f), vm_randf_range(-1.0f, 1.0f), vm_randf_range(0.1f, 1.0f)));
+    positions[i] = vm_v3(vm_randf_range(-100.0f, 100.0f), vm_randf_range(-100.0f, 100.0f), vm_randf_range(-100.0f, 100.0f));
+    rotations[i] = vm_quat_rotate(axis, vm_randf_range(-VM_PI, VM_PI));
+    scales[i] = vm_v3(vm_randf_range(0.1f, 4.0f), vm_randf_range(0.1f, 4.0f), vm_randf_range(0.1f, 4.0f));
+  }
+
+  /* Every combination of rotations/scales against vm_transformation_matrix */
+  for (int variant = 0; variant < 4; ++variant)
+  {
+    quat *r = (variant & 1) ? rotations : 0;
+    v3 *sc = (variant & 2) ? scales : 0;
+
+    vm_m4x4_trs_batch(positions, r, sc, count, models, 16);
+    vm_affine_trs_batch(positions, r, sc, count, affine, 12);
+
+    for (int i = 0; i < count; ++i)
+    {
+      transformation t = vm_transformation_init();
+      t.position = positions[i];
+      t.rotation = r ? r[i] : vm_quat_rot;
+      t.scale = sc ? sc[i] : vm_v3_one;
+
+      m4x4 expected = vm_transformation_matrix(&t);
+      float *m = models + i * 16;
+      float *a = affine + i * 12;
+      int differs = 0;
+
+      for (int k = 0; k < 16; ++k)
+      {
+        differs |= m[k] != expected.e[k];
+      }
+      for (int k = 0; k < 3; ++k)
+      {
+        differs |= a[k] != expected.e[12 + k];
+        differs |= a[3 + k] != expected.e[k] || a[6 + k] != expected.e[4 + k] || a[9 + k] != expected.e[8 + k];
+      }
+      mismatches += differs;
+    }
+  }
+
+  /* render_cubes: rotation about one axis, 20 degrees more per cube */
+  {
+    v3 axis = vm_v3_normalize(vm_v3(1.0f, 0.3f, 0.5f));
+
+    for (int i = 0; i < 1000; ++i)
+    {
+      rotations[i] = vm_quat_from_axis_angle_m4x4(axis, vm_radf(20.0f * (float)i));
+    }
+    vm_m4x4_trs_batch(positions, rotations, 0, 1000, models, 16);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+      m4x4 expected = vm_m4x4_rotate(vm_m4x4_translate(vm_m4x4_identity, positions[i]), vm_radf(20.0f * (float)i), axis);
+
+      for (int k = 0; k < 16; ++k)
+      {
+        float error = vm_absf(models[i * 16 + k] - expected.e[k]);
+        rotate_error = error > rotate_error ? error : rotate_error;
+      }
+    }
+    mismatches += rotate_error > 1e-3f;
+  }
+
+  /* Throughput: the matrix chain of vm_transformation_matrix per instance against one batch */
+  unsigned long start = headless_rdtsc();
+  for (int r = 0; r < repeats; ++r)
+  {
+    for (int i = 0; i < count; ++i)
+    {
+      transformation t = vm_transformation_init();
+      t.position = positions[i];
+      t.rotation = rotations[i];
+      t.scale = scales[i];
+
+      m4x4 m = vm_transformation_matrix(&t);
+      for (int k = 0; k < 16; ++k)
+      {
+        models[i * 16 + k] = m.e[k];
+      }
+    }
+  }
+  double cycles_chain = (double)(headless_rdtsc() - start) / (double)(count * repeats);
+
+  start = headless_rdtsc();
+  for (int r = 0; r < repeats; ++r)
+  {
+    vm_m4x4_trs_batch(positions, rotations, scales, count, models, 16);
+  }
+  double cycles_batch = (double)(headless_rdtsc() - start) / (double)(count * repeats);
+
+  start = headless_rdtsc();
+  for (int r = 0; r < repeats; ++r)
+  {
+    vm_affine_trs_batch(positions, rotations, scales, count, affine, 12);
+  }
+  double cycles_affine = (double)(headless_rdtsc() - start) / (double)(count * repeats);
+
+  printf("[bench] batch transforms %d instances: chain %.1f, batch m4x4 %.1f, batch affine %.1f cycles/instance (" BENCH_SIMD "), rotate error %.2e, %d mismatches\n",
+         (int)count, cycles_chain, cycles_batch, cycles_affine, (double)rotate_error, mismatches);
+
+  free(positions);
+  free(rotations);
+  free(scales);
+  free(models);
+  free(affine);
+
+  return mismatches;
+}
+
+/* World matrices of the scene graph against vm_transformation_matrix on the same parent pointers */
+static int bench_scene_mismatches(speg_scene *scene, transformation *reference)
+{
+  int mismatches = 0;
+
+  for (int i = 0; i < scene->count; ++i)
+  {
+    m4x4 expected = vm_transformation_matrix(&reference[i]);
+    int differs = 0;
+
+    for (int k = 0; k < 16; ++k)
+    {
+      differs |= scene->worlds[i].e[k] != expected.e[k];
+    }
+    mismatches += differs;
+  }
+
+  return mismatches;
+}
+
+/* A rig of 4095 nodes (binary tree, 12 levels): recursive vm_transformation_matrix per node against the cached
+ * world matrices of speg_scene_update for a full, a partial (one subtree) and a clean update */
+int bench_scene_graph(void)
+{
+  enum
+  {
+    count = 4095,
+    repeats = 20,
+    partial_node = 7 /* third level, a subtree of 511 nodes */
+  };
+
+  m4x4 *locals = (m4x4 *)malloc(sizeof(m4x4) * count);
+  m4x4 *worlds = (m4x4 *)malloc(sizeof(m4x4) * count);
+  v3 *positions = (v3 *)malloc(sizeof(v3) * count);
+  quat *rotations = (quat *)malloc(sizeof(quat) * count);
+  v3 *scales = (v3 *)malloc(sizeof(v3) * count);
+  int *parents = (int *)malloc(sizeof(int) * count);
+  unsigned char *flags = (unsigned char *)malloc((size_t)count);
+  transformation *reference = (transformation *)malloc(sizeof(transformation) * count);
+  unsigned char *changed = (unsigned char *)malloc((size_t)count);
+  speg_scene scene;
+  int mismatches = 0;
+  int depth = 0;
+
+  if (!locals || !worlds || !positions || !rotations || !scales || !parents || !flags || !reference || !changed)
+  {
+    free(locals);
+    free(worlds);
+    free(positions);
+    free(rotations);
+    free(scales);
+    free(parents);
+    free(flags);
+    free(reference);
+    free(changed);
+    return 0;
+  }
+
+  speg_scene_init(&scene, locals, worlds, positions, rotations, scales, parents, flags, count);
+
+  vm_seed_lcg = 17;
+  for (int i = 0; i < count; ++i)
+  {
+    v3 axis = vm_v3_normalize(vm_v3(vm_randf_range(-1.0f, 1.0f), vm_randf_range(0.1f, 1.0f), vm_randf_range(-1.0f, 1.0f)));
+    int parent = i > 0 ? (i - 1) / 2 : -1;
+
+    reference[i] = vm_transformation_init();
+    reference[i].position = vm_v3(vm_randf_range(-2.0f, 2.0f), vm_randf_range(-2.0f, 2.0f), vm_randf_range(-2.0f, 2.0f));
+    reference[i].rotation = vm_quat_rotate(axis, vm_randf_range(-VM_PI, VM_PI));
+    reference[i].scale = vm_v3(vm_randf_range(0.8f, 1.2f), vm_randf_range(0.8f, 1.2f), vm_randf_range(0.8f, 1.2f));
+    reference[i].parent = parent < 0 ? 0 : &reference[parent];
+
+    mismatches += speg_scene_add(&scene, parent, reference[i].position, reference[i].rotation, reference[i].scale) != i;
+  }
+  for (transformation *t = &reference[count - 1]; t->parent; t = t->parent)
+  {
+    ++depth;
+  }
+
+  /* A child before its parent is rejected */
+  mismatches += speg_scene_add(&scene, count, vm_v3_zero, vm_quat_rot, vm_v3_one) != -1;
+
+  speg_scene_update(&scene);
+  mismatches += scene.locals_updated != count || scene.worlds_updated != count;
+  mismatches += bench_scene_mismatches(&scene, &reference[0]);
+
+  /* Nothing dirty, nothing rebuilt */
+  speg_scene_update(&scene);
+  mismatches += scene.locals_updated != 0 || scene.worlds_updated != 0;
+
+  /* Random edits rebuild exactly the edited nodes and their descendants */
+  for (int run = 0; run < 20; ++run)
+  {
+    int edits = 1 + run;
+    int expected_locals = 0;
+    int expected_worlds = 0;
+
+    for (int i = 0; i < count; ++i)
+    {
+      changed[i] = 0;
+    }
+
+    for (int e = 0; e < edits; ++e)
+    {
+      int node = (int)vm_randf_range(0.0f, (float)count) % count;
+      v3 axis = vm_v3_normalize(vm_v3(vm_randf_range(-1.0f, 1.0f), 1.0f, vm_randf_range(-1.0f, 1.0f)));
+
+      reference[node].rotation = vm_quat_rotate(axis, vm_randf_range(-VM_PI, VM_PI));
+      if (e & 1)
+      {
+        reference[node].position.y += 0.5f;
+        speg_scene_set_transform(&scene, node, reference[node].position, reference[node].rotation, reference[node].scale);
+      }
+      else
+      {
+        speg_scene_set_rotation(&scene, node, reference[node].rotation);
+      }
+      expected_locals += !changed[node];
+      changed[node] = 1;
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+      changed[i] |= i > 0 && changed[(i - 1) / 2];
+      expected_worlds += changed[i];
+    }
+
+    speg_scene_update(&scene);
+    mismatches += scene.locals_updated != expected_locals || scene.worlds_updated != expected_worlds;
+    mismatches += bench_scene_mismatches(&scene, &reference[0]);
+  }
+
+  /* Throughput */
+  unsigned long start = headless_rdtsc();
+  for (int r = 0; r < repeats; ++r)
+  {
+    for (int i = 0; i < count; ++i)
+    {
+      worlds[i] = vm_transformation_matrix(&reference[i]);
+    }
+  }
+  double cycles_recursive = (double)(headless_rdtsc() - start) / (double)(count * repeats);
+
+  /* Restore the cache the recursive loop overwrote */
+  for (int i = 0; i < count; ++i)
+  {
+    speg_scene_set_rotation(&scene, i, reference[i].rotation);
+  }
+  speg_scene_update(&scene);
+
+  start = headless_rdtsc();
+  for (int r = 0; r < repeats; ++r)
+  {
+    for (int i = 0; i < count; ++i)
+    {
+      speg_scene_set_rotation(&scene, i, reference[i].rotation);
+    }
+    speg_scene_update(&scene);
+  }
+  double cycles_full = (double)(headless_rdtsc() - start) / (double)(count * repeats);
+
+  start = headless_rdtsc();
+  for (int r = 0; r < repeats; ++r)
+  {
+    speg_scene_set_rotation(&scene, partial_node, reference[partial_node].rotation);
+    speg_scene_update(&scene);
+  }
+  double cycles_partial = (double)(headless_rdtsc() - start) / (double)repeats;
+  int partial_worlds = scene.worlds_updated;
+
+  start = headless_rdtsc();
+  for (int r = 0; r < repeats; ++r)
+  {
+    speg_scene_update(&scene);
+  }
+  double cycles_clean = (double)(headless_rdtsc() - start) / (double)repeats;
+
+  mismatches += bench_scene_mismatches(&scene, &reference[0]);
+
+  printf("[bench] scene graph %d nodes depth %d: recursive %.1f, full update %.1f cycles/node, subtree of %d nodes %.0f, clean %.0f cycles/update, %d mismatches\n",
+         (int)count, depth, cycles_recursive, cycles_full, partial_worlds, cycles_partial, cycles_clean, mismatches);
+
+  free(locals);
+  free(worlds);
+  free(positions);
+  free(rotations);
+  free(scales);
+  free(parents);
+  free(flags);
+  free(reference);
+  free(changed);
+
+  return mismatches;
+}
+
+/* One vm.h code path, loaded from the speg_bench_vm_<path>.so that build.sh compiles from speg_bench_vm.c */
+typedef struct bench_vm
+{
+  const char *(*path)(void);
+  void (*m4x4_mul)(const m4x4 *a, const m4x4 *b, m4x4 *out, int count);
+  void (*m4x4_inverse)(const m4x4 *m, m4x4 *out, int count);
+  void (*quat_mul)(const quat *a, const quat *b, quat *out, int count);
+  void (*quat_normalize)(const quat *a, quat *out, int count);
+  void (*quat_to_rotation_matrix)(const quat *q, m4x4 *out, int count);
+  void (*v3_rotate)(const v3 *a, const quat *q, v3 *out, int count);
+  void (*trs_batch)(const v3 *positions, const quat *rotations, const v3 *scales, int count, float *out, int affine);
+} bench_vm;
+
+typedef enum bench_vm_kernel
+{
+  BENCH_VM_M4X4_MUL,
+  BENCH_VM_M4X4_INVERSE,
+  BENCH_VM_QUAT_MUL,
+  BENCH_VM_QUAT_NORMALIZE,
+  BENCH_VM_QUAT_TO_ROTATION_MATRIX,
+  BENCH_VM_V3_ROTATE,
+  BENCH_VM_M4X4_TRS_BATCH,
+  BENCH_VM_AFFINE_TRS_BATCH,
+  BENCH_VM_KERNEL_COUNT
+} bench_vm_kernel;
+
+typedef struct bench_vm_kernel_info
+{
+  const char *name;
+  int floats;    /* output floats per item */
+  int compared;  /* leading floats of them that are compared (a v3 has 1 float padding) */
+  float tolerance; /* error relative to max(1, |scalar|), FMA and the reordered sums round differently */
+} bench_vm_kernel_info;
+
+static bench_vm_kernel_info bench_vm_kernels[BENCH_VM_KERNEL_COUNT] = {
+    {"m4x4_mul", 16, 16, 1e-5f},
+    {"m4x4_inverse", 16, 16, 1e-4f},
+    {"quat_mul", 4, 4, 1e-6f},
+    {"quat_normalize", 4, 4, 2e-3f}, /* scalar vm_invsqrt is the 0x5f3759df approximation, SSE uses rsqrtps */
+    {"quat_to_rotation_matrix", 16, 16, 0.0f},
+    {"v3_rotate", 4, 3, 1e-5f},
+    {"m4x4_trs_batch", 16, 16, 0.0f},
+    {"affine_trs_batch", 12, 12, 0.0f},
+};
+
+typedef struct bench_vm_inputs
+{
+  m4x4 *a;
+  m4x4 *b;
+  quat *q;
+  quat *r;
+  v3 *v;
+  v3 *s;
+} bench_vm_inputs;
+
+int bench_vm_load(bench_vm *vm, const char *soName)
+{
+  void *handle = dlopen(soName, RTLD_NOW | RTLD_LOCAL);
+
+  if (!handle)
+  {
+    printf("[bench] vm paths: cannot load %s (%s)\n", soName, dlerror());
+    return 0;
+  }
+
+  *(void **)(&vm->path) = dlsym(handle, "bench_vm_path");
+  *(void **)(&vm->m4x4_mul) = dlsym(handle, "bench_vm_m4x4_mul");
+  *(void **)(&vm->m4x4_inverse) = dlsym(handle, "bench_vm_m4x4_inverse");
+  *(void **)(&vm->quat_mul) = dlsym(handle, "bench_vm_quat_mul");
+  *(void **)(&vm->quat_normalize) = dlsym(handle, "bench_vm_quat_normalize");
+  *(void **)(&vm->quat_to_rotation_matrix) = dlsym(handle, "bench_vm_quat_to_rotation_matrix");
+  *(void **)(&vm->v3_rotate) = dlsym(handle, "bench_vm_v3_rotate");
+  *(void **)(&vm->trs_batch) = dlsym(handle, "bench_vm_trs_batch");
+
+  return vm->path && vm->m4x4_mul && vm->m4x4_inverse && vm->quat_mul && vm->quat_normalize &&
+         vm->quat_to_rotation_matrix && vm->v3_rotate && vm->trs_batch;
+}
+
+void bench_vm_run(bench_vm *vm, bench_vm_kernel kernel, bench_vm_inputs *in, int count, float *out)
+{
+  switch (kernel)
+  {
+  case BENCH_VM_M4X4_MUL:
+    vm->m4x4_mul(in->a, in->b, (m4x4 *)out, count);
+    break;
+  case BENCH_VM_M4X4_INVERSE:
+    vm->m4x4_inverse(in->a, (m4x4 *)out, count);
+    break;
+  case BENCH_VM_QUAT_MUL:
+    vm->quat_mul(in->q, in->r, (quat *)out, count);
+    break;
+  case BENCH_VM_QUAT_NORMALIZE:
+    vm->quat_normalize(in->r, (quat *)out, count);
+    break;
+  case BENCH_VM_QUAT_TO_ROTATION_MATRIX:
+    vm->quat_to_rotation_matrix(in->q, (m4x4 *)out, count);
+    break;
+  case BENCH_VM_V3_ROTATE:
+    vm->v3_rotate(in->v, in->q, (v3 *)out, count);
+    break;
+  case BENCH_VM_M4X4_TRS_BATCH:
+    vm->trs_batch(in->v, in->q, in->s, count, out, 0);
+    break;
+  case BENCH_VM_AFFINE_TRS_BATCH:
+    vm->trs_batch(in->v, in->q, in->s, count, out, 1);
+    break;
+  default:
+    break;
+  }
+}
+
+/* The scalar, SSE and AVX2 paths of vm.h against each other: the scalar path is the reference */
+int bench_vm_paths(void)
+{
+  enum
+  {
+    paths = 3,
+    count = 4099, /* not a multiple of 8, the tails run as well */
+    repeats = 20
+  };
+
+  static const char *soNames[paths] = {"./speg_bench_vm_scalar.so", "./speg_bench_vm_sse.so", "./speg_bench_vm_avx2.so"};
+  bench_vm vm[paths];
+  bench_vm_inputs in;
+  float *out[paths];
+  int mismatches_total = 0;
+
+  for (int p = 0; p < paths; ++p)
+  {
+    if (!bench_vm_load(&vm[p], soNames[p]))
+    {
+      return 0;
+    }
+  }
+
+  in.a = (m4x4 *)malloc(sizeof(m4x4) * count);
+  in.b = (m4x4 *)malloc(sizeof(m4x4) * count);
+  in.q = (quat *)malloc(sizeof(quat) * count);
+  in.r = (quat *)malloc(sizeof(quat) * count);
+  in.v = (v3 *)malloc(sizeof(v3) * count);
+  in.s = (v3 *)malloc(sizeof(v3) * count);
+  for (int p = 0; p < paths; ++p)
+  {
+    out[p] = (float *)malloc(sizeof(float) * 16 * count);
+  }
+
+  if (in.a && in.b && in.q && in.r && in.v && in.s && out[0] && out[1] && out[2])
+  {
+    vm_seed_lcg = 47;
+    for (int i = 0; i < count; ++i)
+    {
+      /* Diagonally dominant, so that the inverse is well conditioned */
+      for (int k = 0; k < 16; ++k)
+      {
+        in.a[i].e[k] = vm_randf_range(-1.0f, 1.0f) + ((k % 5) == 0 ? 4.0f : 0.0f);
+        in.b[i].e[k] = vm_randf_range(-10.0f, 10.0f);
+      }
+      in.q[i] = vm_quat_rotate(vm_v3_normalize(vm_v3(vm_randf_range(-1.0f, 1.0f), vm_randf_range(-1.0f, 1.0f), vm_randf_range(0.1f, 1.0f))), vm_randf_range(-VM_PI, VM_PI));
+      in.r[i] = vm_quat(vm_randf_range(-4.0f, 4.0f), vm_randf_range(-4.0f, 4.0f), vm_randf_range(-4.0f, 4.0f), vm_randf_range(0.1f, 4.0f));
+      in.v[i] = vm_v3(vm_randf_range(-100.0f, 100.0f), vm_randf_range(-100.0f, 100.0f), vm_randf_range(-100.0f, 100.0f));
+      in.s[i] = vm_v3(vm_randf_range(0.1f, 4.0f), vm_randf_range(0.1f, 4.0f), vm_randf_range(0.1f, 4.0f));
+    }
+
+    for (int kernel = 0; kernel < BENCH_VM_KERNEL_COUNT; ++kernel)
+    {
+      bench_vm_kernel_info *info = &bench_vm_kernels[kernel];
+      double cycles[paths];
+      float error[paths] = {0.0f};
+      int mismatches = 0;
+
+      for (int p = 0; p < paths; ++p)
+      {
+        bench_vm_run(&vm[p], (bench_vm_kernel)kernel, &in, count, out[p]);
+
+        unsigned long start = headless_rdtsc();
+        for (int r = 0; r < repeats; ++r)
+        {
+          bench_vm_run(&vm[p], (bench_vm_kernel)kernel, &in, count, out[p]);
+        }
+        cycles[p] = (double)(headless_rdtsc() - start) / (double)(count * repeats);
+      }
+
+      for (int p = 1; p < paths; ++p)
+      {
+        for (int i = 0; i < count; ++i)
+        {
+          int differs = 0;
+
+          for (int k = 0; k < info->compared; ++k)
+          {
+            float reference = out[0][i * info->floats + k];
+            float e = vm_absf(out[p][i * info->floats + k] - reference) / vm_maxf(1.0f, vm_absf(reference));
+
+            differs |= !(e <= info->tolerance);
+            error[p] = e > error[p] ? e : error[p];
+          }
+          mismatches += differs;
+        }
+      }
+
+      printf("[bench] vm %-24s %s %6.1f, %s %6.1f, %s %6.1f cycles/item, max error %.2e %s %.2e %s, %d mismatches\n",
+             info->name, vm[0].path(), cycles[0], vm[1].path(), cycles[1], vm[2].path(), cycles[2],
+             (double)error[1], vm[1].path(), (double)error[2], vm[2].path(), mismatches);
+      mismatches_total += mismatches;
+    }
+  }
+
+  free(in.a);
+  free(in.b);
+  free(in.q);
+  free(in.r);
+  free(in.v);
+  free(in.s);
+  for (int p = 0; p < paths; ++p)
+  {
+    free(out[p]);
+  }
+
+  return mismatches_total;
+}
+
+/* Compact instance formats: exhaustive half float round trip, random affine models packed and unpacked per format */
+int bench_instance_formats(void)
+{
+  static const char *names[SPEG_INSTANCE_FORMAT_COUNT] = {"m4x4", "affine", "affine_half", "trs", "trs_half"};
+  static const float tolerances[SPEG_INSTANCE_FORMAT_COUNT] = {0.0f, 0.0f, 1.0f / 2048.0f, 1e-5f, 4e-3f}; /* relative to the largest scale */
+
+  int count = 64 * 1024;
+  int runs = 5;
+  int mismatches_total = 0;
+  float *models = (float *)malloc(sizeof(float) * 16 * (size_t)count);
+  unsigned char *packed = (unsigned char *)malloc(SPEG_INSTANCE_MAX_MODEL_SIZE * (size_t)count);
+
+  if (!models || !packed)
+  {
+    return 0;
+  }
+
+  /* Every half survives half -> float -> half, NaN stays NaN */
+  int half_mismatches = 0;
+  for (unsigned int h = 0; h < 0x10000; ++h)
+  {
+    speg_instance_half back = speg_instance_float_to_half(speg_instance_half_to_float((speg_instance_half)h));
+    bool nan = (h & 0x7C00) == 0x7C00 && (h & 0x03FF) != 0;
+    half_mismatches += nan ? !((back & 0x7C00) == 0x7C00 && (back & 0x03FF) != 0) : back != h;
+  }
+
+#ifdef __F16C__
+  /* Rounding of float -> half against the hardware conversion, NaN payloads differ by design */
+  int f16c_mismatches = 0;
+  for (unsigned long long u = 0; u < 0x100000000ull; u += 997)
+  {
+    speg_instance_bits bits;
+    bits.u = (unsigned int)u;
+    if ((bits.u & 0x7F800000u) == 0x7F800000u && (bits.u & 0x007FFFFFu) != 0)
+    {
+      continue;
+    }
+    f16c_mismatches += speg_instance_float_to_half(bits.f) != (speg_instance_half)_cvtss_sh(bits.f, 0);
+  }
+  printf("[bench] half float: %d round trip mismatches, %d mismatches against f16c\n", half_mismatches, f16c_mismatches);
+  mismatches_total += f16c_mismatches;
+#else
+  printf("[bench] half float: %d round trip mismatches\n", half_mismatches);
+#endif
+  mismatches_total += half_mismatches;
+
+  /* translate * rotate * scale from a random unit quaternion and non uniform scale, every 8th mirrored.
+   * Built with speg_instance_compose, the vm.h rotations are not orthonormal enough for a float exact round trip */
+  vm_seed_lcg = 7;
+  for (int i = 0; i < count; ++i)
+  {
+    float rotation[4] = {vm_randf_range(-1.0f, 1.0f), vm_randf_range(-1.0f, 1.0f), vm_randf_range(-1.0f, 1.0f), vm_randf_range(-1.0f, 1.0f)};
+    float scale[3] = {vm_randf_range(0.1f, 10.0f), vm_randf_range(0.1f, 10.0f), vm_randf_range(0.1f, 10.0f)};
+    float position[3] = {vm_randf_range(-100.0f, 100.0f), vm_randf_range(-100.0f, 100.0f), vm_randf_range(-100.0f, 100.0f)};
+    float length = speg_instance_sqrtf(rotation[0] * rotation[0] + rotation[1] * rotation[1] + rotation[2] * rotation[2] + rotation[3] * rotation[3]);
+
+    for (int k = 0; k < 4; ++k)
+    {
+      rotation[k] /= length;
+    }
+
+    if ((i & 7) == 0)
+    {
+      scale[1] = -scale[1];
+    }
+
+    speg_instance_compose(position, rotation, scale, &models[i * 16]);
+  }
+
+  for (int format = 0; format < SPEG_INSTANCE_FORMAT_COUNT; ++format)
+  {
+    int size = speg_instance_model_size(format);
+    unsigned long best_pack = (unsigned long)-1;
+    unsigned long best_unpack = (unsigned long)-1;
+    float max_error = 0.0f;
+    int mismatches = 0;
+
+    for (int r = 0; r < runs; ++r)
+    {
+      unsigned long start = headless_rdtsc();
+      for (int i = 0; i < count; ++i)
+      {
+        speg_instance_pack_model(format, &models[i * 16], packed + i * size);
+      }
+      unsigned long cycles = headless_rdtsc() - start;
+      best_pack = cycles < best_pack ? cycles : best_pack;
+    }
+
+    for (int r = 0; r < runs; ++r)
+    {
+      float m[16];
+      float sum = 0.0f;
+      unsigned long start = headless_rdtsc();
+      for (int i = 0; i < count; ++i)
+      {
+        speg_instance_unpack_model(format, packed + i * size, m);
+        sum += m[0];
+      }
+      unsigned long cycles = headless_rdtsc() - start;
+      best_unpack = cycles < best_unpack ? cycles : best_unpack;
+      max_error += sum * 0.0f; /* keeps the unpack loop alive */
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+      float *reference = &models[i * 16];
+      float m[16];
+      float scale_max = 0.0f;
+      float error = 0.0f;
+
+      speg_instance_unpack_model(format, packed + i * size, m);
+
+      for (int c = 0; c < 3; ++c)
+      {
+        float length = vm_sqrtf(reference[c * 4] * reference[c * 4] + reference[c * 4 + 1] * reference[c * 4 + 1] + reference[c * 4 + 2] * reference[c * 4 + 2]);
+        scale_max = length > scale_max ? length : scale_max;
+      }
+      for (int k = 0; k < 16; ++k)
+      {
+        float e = vm_absf(m[k] - reference[k]);
+        error = e > error ? e : error;
+      }
+
+      error /= scale_max;
+      max_error = error > max_error ? error : max_error;
+      mismatches += error > tolerances[format];
+    }
+
+    printf("[bench] instance format %-11s %2d bytes: pack %6.1f cycles, unpack %6.1f cycles, max error %.2e of scale, %d mismatches\n",
+           names[format],
+           size,
+           (double)best_pack / (double)count,
+           (double)best_unpack / (double)count,
+           (double)max_error,
+           mismatches);
+    mismatches_total += mismatches;
+  }
+
+  /* Every rgba8 channel within half a step of the float color */
+  int color_mismatches = 0;
+  for (int i = 0; i <= 1000; ++i)
+  {
+    float rgb[3] = {(float)i / 1000.0f, 1.0f - (float)i / 1000.0f, 0.5f};
+    float back[3];
+    unsigned char rgba[4];
+
+    speg_instance_pack_color(SPEG_INSTANCE_COLOR_RGBA8, rgb, rgba);
+    speg_instance_unpack_color(SPEG_INSTANCE_COLOR_RGBA8, rgba, back);
+
+    for (int c = 0; c < 3; ++c)
+    {
+      color_mismatches += vm_absf(back[c] - rgb[c]) > 0.5f / 255.0f + 1e-6f;
+    }
+    color_mismatches += rgba[3] != 255;
+  }
+  printf("[bench] instance color rgba8: %d mismatches\n", color_mismatches);
+  mismatches_total += color_mismatches;
+
+  free(models);
+  free(packed);
+
+  return mismatches_total;
+}
+
+/* Sorted, disjoint, at most SPEG_DIRTY_MAX_RANGES ranges and every marked instance covered */
+static int bench_dirty_mismatches(speg_dirty *dirty, unsigned char *marked, int count)
+{
+  int mismatches = dirty->count > SPEG_DIRTY_MAX_RANGES;
+
+  for (int i = 0; i + 1 < dirty->count; ++i)
+  {
+    mismatches += dirty->ranges[i].first + dirty->ranges[i].count >= dirty->ranges[i + 1].first;
+  }
+
+  for (int i = 0; i < count; ++i)
+  {
+    bool covered = false;
+    for (int r = 0; r < dirty->count; ++r)
+    {
+      covered |= i >= dirty->ranges[r].first && i < dirty->ranges[r].first + dirty->ranges[r].count;
+    }
+    mismatches += marked[i] && !covered;
+  }
+
+  return mismatches;
+}
+
+/* Dirty range merging and the bytes the headless platform_draw uploads for a dirty tracked draw call */
+int bench_dirty_ranges(void)
+{
+  speg_dirty dirty = {0};
+  int mismatches = 0;
+
+  /* In order writes extend one range */
+  speg_dirty_mark(&dirty, 0, 1);
+  speg_dirty_mark(&dirty, 1, 1);
+  speg_dirty_mark(&dirty, 2, 1);
+  mismatches += dirty.count != 1 || dirty.ranges[0].first != 0 || dirty.ranges[0].count != 3;
+
+  /* Out of order writes are sorted, gaps up to SPEG_DIRTY_MERGE_GAP are merged */
+  speg_dirty_clear(&dirty);
+  speg_dirty_mark(&dirty, 100, 5);
+  speg_dirty_mark(&dirty, 10, 5);
+  mismatches += dirty.count != 2 || dirty.ranges[0].first != 10 || dirty.ranges[1].first != 100;
+  speg_dirty_mark(&dirty, 15 + SPEG_DIRTY_MERGE_GAP, 1);
+  mismatches += dirty.count != 2 || dirty.ranges[0].count != 6 + SPEG_DIRTY_MERGE_GAP;
+  speg_dirty_mark(&dirty, 50, 1);
+  mismatches += dirty.count != 3;
+
+  /* A range bridging all others collapses the list */
+  speg_dirty_mark(&dirty, 5, 200);
+  mismatches += dirty.count != 1 || dirty.ranges[0].first != 5 || dirty.ranges[0].count != 200;
+
+  /* Overflow merges the closest ranges, nothing marked gets lost */
+  {
+    int count = 4096;
+    unsigned char *marked = (unsigned char *)calloc((size_t)count, 1);
+
+    if (!marked)
+    {
+      return 0;
+    }
+
+    speg_dirty_clear(&dirty);
+    for (int i = 40; i >= 0; --i)
+    {
+      int first = i * 100 + (i % 3) * 7;
+      speg_dirty_mark(&dirty, first, 2);
+      marked[first] = marked[first + 1] = 1;
+    }
+    mismatches += dirty.count != SPEG_DIRTY_MAX_RANGES;
+    mismatches += bench_dirty_mismatches(&dirty, marked, count);
+
+    vm_seed_lcg = 3;
+    for (int run = 0; run < 100; ++run)
+    {
+      speg_dirty_clear(&dirty);
+      for (int i = 0; i < count; ++i)
+      {
+        marked[i] = 0;
+      }
+      for (int m = 0; m < 64; ++m)
+      {
+        int first = (int)vm_randf_range(0.0f, (float)(count - 64));
+        int length = 1 + (int)vm_randf_range(0.0f, 16.0f);
+        speg_dirty_mark(&dirty, first, length);
+        for (int i = first; i < first + length; ++i)
+        {
+          marked[i] = 1;
+        }
+      }
+      mismatches += bench_dirty_mismatches(&dirty, marked, count);
+    }
+
+    free(marked);
+  }
+
+  /* Headless upload accounting of a dirty tracked draw call */
+  static float models[1000 * 16];
+  static float colors[1000 * 3];
+  static int textures[1000];
+  speg_mesh mesh = {0};
+  speg_draw_call call = {0};
+  unsigned long size = 0;
+  float pv[16] = {0};
+
+  call.mesh = &mesh;
+  call.models = models;
+  call.colors = colors;
+  call.texture_indices = textures;
+  call.count_instances = 100;
+  call.count_instances_max = 1000;
+  call.instance_format = SPEG_INSTANCE_FORMAT_AFFINE_HALF;
+  call.color_format = SPEG_INSTANCE_COLOR_RGBA8;
+  call.track_dirty = true;
+  size = HEADLESS_SIZE_INSTANCE(&call);
+
+  unsigned long expected[5] = {100 * size, 0, 6 * size, 1000 * size, 150 * size};
+  unsigned long uploaded[5];
+
+  for (int frame = 0; frame < 5; ++frame)
+  {
+    if (frame == 2)
+    {
+      speg_dirty_mark(&call.dirty, 10, 5);
+      speg_dirty_mark(&call.dirty, 50, 1);
+      speg_dirty_mark(&call.dirty, 900, 10); /* past count_instances, not uploaded */
+    }
+    if (frame == 3)
+    {
+      call.count_instances = 150; /* grows past the buffers */
+    }
+    if (frame == 4)
+    {
+      call.changed = true;
+    }
+
+    recorder.draw_records_count = 0;
+    headless_platform_draw(&call, pv);
+    uploaded[frame] = recorder.draw_records[0].bytes_uploaded;
+    mismatches += uploaded[frame] != expected[frame];
+  }
+  mismatches += call.dirty.count != 0;
+
+  printf("[bench] dirty ranges: %lu bytes per instance, uploads %lu/%lu/%lu/%lu/%lu bytes (init/clean/dirty/grow/changed), %d mismatches\n",
+         size,
+         uploaded[0],
+         uploaded[1],
+         uploaded[2],
+         uploaded[3],
+         uploaded[4],
+         mismatches);
+
+  return mismatches;
+}
+
+typedef struct bench_ring_allocation
+{
+  unsigned int position;
+  unsigned int offset;
+  unsigned int size;
+  unsigned long frame; /* last frame that reads it */
+
+} bench_ring_allocation;
+
+/* Allocations overlapping [offset, offset + size) that a frame the simulated GPU has not finished still reads */
+static int bench_ring_overlaps(bench_ring_allocation *history, int history_count, headless_gpu *gpu, unsigned int offset, unsigned int size)
+{
+  int overlaps = 0;
+
+  for (int i = 0; i < history_count; ++i)
+  {
+    bench_ring_allocation *a = &history[i];
+    overlaps += a->frame >= gpu->completed && offset < a->offset + a->size && a->offset < offset + size;
+  }
+
+  return overlaps;
+}
+
+/* Streaming ring buffer against a simulated GPU: no allocation may overwrite memory of an unfinished frame */
+int bench_ring_buffer(void)
+{
+  enum
+  {
+    capacity = 4096,
+    history_capacity = 4096
+  };
+  static unsigned char memory[capacity];
+  static bench_ring_allocation history[history_capacity];
+  unsigned long latencies[] = {0, 1, 2, 3, 6};
+  unsigned long waits[5];
+  unsigned long wraps[5];
+  int mismatches = 0;
+
+  headless_gpu gpu = {0};
+  speg_ring_fences fences = headless_gpu_fences(&gpu);
+  speg_ring ring;
+  unsigned int position;
+
+  mismatches += speg_ring_init(&ring, memory, 3000, &fences) != 0;
+
+  vm_seed_lcg = 7;
+  for (int l = 0; l < (int)array_size(latencies); ++l)
+  {
+    int history_count = 0;
+
+    gpu = (headless_gpu){0};
+    gpu.latency = latencies[l];
+    speg_ring_init(&ring, memory, capacity, &fences);
+
+    for (int frame = 0; frame < 2000; ++frame)
+    {
+      int allocations = 1 + (int)vm_randf_range(0.0f, 4.0f);
+
+      speg_ring_begin_frame(&ring);
+      mismatches += gpu.submitted - gpu.completed > SPEG_RING_FRAMES - 1;
+
+      /* Every 10th frame redraws the data of the previous frame without allocating (paused simulation) */
+      if (frame % 10 == 9)
+      {
+        for (int i = 0; i < history_count; ++i)
+        {
+          if (history[i].frame == gpu.submitted - 1)
+          {
+            history[i].frame = gpu.submitted;
+            speg_ring_reuse(&ring, history[i].position);
+          }
+        }
+        allocations = 0;
+      }
+
+      for (int a = 0; a < allocations; ++a)
+      {
+        unsigned int size = 1 + (unsigned int)vm_randf_range(0.0f, 400.0f);
+        unsigned int alignment = 1u << (unsigned int)vm_randf_range(0.0f, 7.0f);
+        unsigned char *data = (unsigned char *)speg_ring_alloc(&ring, size, alignment, &position);
+        unsigned int offset = speg_ring_offset(&ring, position);
+
+        mismatches += data != memory + offset || offset % alignment != 0 || offset + size > capacity;
+        mismatches += bench_ring_overlaps(history, history_count, &gpu, offset, size);
+
+        if (history_count == history_capacity)
+        {
+          history_count = 0;
+        }
+        history[history_count].position = position;
+        history[history_count].offset = offset;
+        history[history_count].size = size;
+        history[history_count].frame = gpu.submitted;
+        history_count++;
+      }
+
+      speg_ring_end_frame(&ring);
+    }
+
+    speg_ring_finish(&ring);
+    mismatches += ring.frames_count != 0;
+    waits[l] = ring.waits;
+    wraps[l] = ring.wraps;
+  }
+
+  /* More than SPEG_RING_FRAMES - 1 frames of latency throttle every frame, below only a full buffer waits */
+  mismatches += waits[0] != 0 || waits[3] < 2000 || waits[4] < 2000;
+
+  /* Larger than the buffer or than what is left next to the open frame */
+  gpu = (headless_gpu){0};
+  gpu.latency = 2;
+  speg_ring_init(&ring, memory, capacity, &fences);
+  speg_ring_begin_frame(&ring);
+  mismatches += speg_ring_alloc(&ring, capacity + 1, 4, &position) != NULL;
+  mismatches += speg_ring_alloc(&ring, capacity - 16, 4, &position) == NULL;
+  mismatches += speg_ring_alloc(&ring, 32, 4, &position) != NULL;
+  speg_ring_end_frame(&ring);
+  speg_ring_begin_frame(&ring);
+  mismatches += speg_ring_alloc(&ring, 32, 4, &position) == NULL; /* waits for the full frame */
+  mismatches += ring.waits != 1;
+  speg_ring_end_frame(&ring);
+  speg_ring_finish(&ring);
+
+  printf("[bench] ring buffer: latency 0/1/2/3/6 frames, waits %lu/%lu/%lu/%lu/%lu, wraps %lu/%lu/%lu/%lu/%lu, %d mismatches\n",
+         waits[0], waits[1], waits[2], waits[3], waits[4],
+         wraps[0], wraps[1], wraps[2], wraps[3], wraps[4],
+         mismatches);
+
+  return mismatches;
+}
+
+static int bench_compare_queue_item(const void *a, const void *b)
+{
+  const speg_queue_item *x = (const speg_queue_item *)a;
+  const speg_queue_item *y = (const speg_queue_item *)b;
+
+  if (x->key != y->key)
+  {
+    return x->key < y->key ? -1 : 1;
+  }
+  return x->index < y->index ? -1 : (x->index > y->index);
+}
+
+/* Render queue: radix sort against qsort (ties by submission order), batches against the distinct render states */
+int bench_render_queue(void)
+{
+  unsigned int count = 64 * 1024;
+  int runs = 10;
+  speg_queue_item *submitted = (speg_queue_item *)malloc(sizeof(speg_queue_item) * count);
+  speg_queue_item *reference = (speg_queue_item *)malloc(sizeof(speg_queue_item) * count);
+  speg_queue_item *items = (speg_queue_item *)malloc(sizeof(speg_queue_item) * count);
+  speg_queue_item *scratch = (speg_queue_item *)malloc(sizeof(speg_queue_item) * count);
+  int mismatches = 0;
+
+  if (!submitted || !reference || !items || !scratch)
+  {
+    return 0;
+  }
+
+  /* Depth keeps its order, everything behind the camera sorts first */
+  mismatches += speg_queue_depth_bits(-1.0f) != 0 || speg_queue_depth_bits(0.5f) >= speg_queue_depth_bits(2.0f) || speg_queue_depth_bits(2.0f) >= speg_queue_depth_bits(1000.0f);
+
+  /* 300 mesh types, 10 programs, 3 layers, every 64th submission a prebuilt draw call, few distinct depths for ties */
+  vm_seed_lcg = 11;
+  for (unsigned int i = 0; i < count; ++i)
+  {
+    unsigned int layer = (unsigned int)vm_randf_range(0.0f, 3.0f);
+    unsigned int program = (unsigned int)vm_randf_range(0.0f, 10.0f);
+    unsigned int mesh = (unsigned int)vm_randf_range(0.0f, 300.0f);
+    float depth = (float)(int)vm_randf_range(-10.0f, 500.0f);
+
+    submitted[i].key = speg_queue_key_make(layer, layer == 1, (int)(mesh & 1), program, mesh, (i % 64) == 0, depth);
+    submitted[i].index = i;
+  }
+
+  for (unsigned int i = 0; i < count; ++i)
+  {
+    reference[i] = submitted[i];
+  }
+  unsigned long start = headless_rdtsc();
+  qsort(reference, count, sizeof(speg_queue_item), bench_compare_queue_item);
+  unsigned long cycles_qsort = headless_rdtsc() - start;
+
+  speg_queue queue;
+  unsigned long best = (unsigned long)-1;
+
+  for (int r = 0; r < runs; ++r)
+  {
+    speg_queue_init(&queue, items, scratch, count);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+      speg_queue_push(&queue, submitted[i].key, submitted[i].index);
+    }
+
+    start = headless_rdtsc();
+    speg_queue_sort(&queue);
+    unsigned long cycles = headless_rdtsc() - start;
+    best = cycles < best ? cycles : best;
+  }
+
+  for (unsigned int i = 0; i < count; ++i)
+  {
+    mismatches += queue.items[i].key != reference[i].key || queue.items[i].index != reference[i].index;
+  }
+
+  /* Every distinct render state is exactly one batch, prebuilt submissions are one batch each */
+  unsigned int batches = 0;
+  unsigned int expected = 0;
+
+  for (unsigned int i = 0; i < count; ++i)
+  {
+    speg_queue_key key = reference[i].key;
+    expected += speg_queue_key_prebuilt(key) || i == 0 || (key >> SPEG_QUEUE_SHIFT_STATE) != (reference[i - 1].key >> SPEG_QUEUE_SHIFT_STATE) || speg_queue_key_prebuilt(reference[i - 1].key);
+  }
+
+  for (unsigned int first = 0, end = 0; first < queue.count; first = end)
+  {
+    end = speg_queue_batch_end(&queue, first);
+    batches++;
+
+    for (unsigned int i = first + 1; i < end; ++i)
+    {
+      mismatches += (queue.items[i].key >> SPEG_QUEUE_SHIFT_STATE) != (queue.items[first].key >> SPEG_QUEUE_SHIFT_STATE);
+    }
+  }
+  mismatches += batches != expected;
+
+  /* Full queue drops */
+  speg_queue_init(&queue, items, scratch, 2);
+  speg_queue_push(&queue, 1, 0);
+  speg_queue_push(&queue, 2, 1);
+  mismatches += speg_queue_push(&queue, 3, 2) != 0 || queue.dropped != 1 || queue.count != 2;
+
+  printf("[bench] render queue %u submissions (%u batches): radix %.1f cycles/item, qsort %.1f cycles/item, %d mismatches\n",
+         count,
+         batches,
+         (double)best / (double)count,
+         (double)cycles_qsort / (double)count,
+         mismatches);
+
+  free(submitted);
+  free(reference);
+  free(items);
+  free(scratch);
+
+  return mismatches;
+}
+
+typedef struct bench_jobs_data
+{
+  speg_jobs *jobs;
+  speg_job_counter *counter;
+  volatile long *visits; /* per element */
+  volatile long executed;
+  volatile long bad_workers; /* worker index out of range or ranges larger than the batch */
+  int batch;
+  int depth;
+
+} bench_jobs_data;
+
+static void bench_jobs_visit(void *data, int first, int count, int worker)
+{
+  bench_jobs_data *d = (bench_jobs_data *)data;
+
+  if (worker < 0 || worker >= d->jobs->workers_count || count > d->batch)
+  {
+    speg_atomic_fetch_add(&d->bad_workers, 1);
+  }
+  for (int i = first; i < first + count; ++i)
+  {
+    speg_atomic_fetch_add(&d->visits[i], 1);
+  }
+}
+
+static void bench_jobs_count(void *data, int worker)
+{
+  bench_jobs_data *d = (bench_jobs_data *)data;
+
+  if (worker < 0 || worker >= d->jobs->workers_count)
+  {
+    speg_atomic_fetch_add(&d->bad_workers, 1);
+  }
+  speg_atomic_fetch_add(&d->executed, 1);
+}
+
+/* A binary tree of jobs submitted from jobs, depth levels below the first */
+typedef struct bench_jobs_node
+{
+  bench_jobs_data *data;
+  int depth;
+
+} bench_jobs_node;
+
+static void bench_jobs_tree(void *data, int worker)
+{
+  bench_jobs_node *node = (bench_jobs_node *)data;
+  bench_jobs_node children[2];
+  speg_job_counter counter = {0};
+
+  bench_jobs_count(node->data, worker);
+
+  if (node->depth > 0)
+  {
+    for (int c = 0; c < 2; ++c)
+    {
+      children[c].data = node->data;
+      children[c].depth = node->depth - 1;
+      speg_jobs_submit(node->data->jobs, bench_jobs_tree, &children[c], &counter);
+    }
+    speg_jobs_wait(node->data->jobs, &counter);
+  }
+}
+
+typedef struct bench_jobs_trs
+{
+  v3 *positions;
+  quat *rotations;
+  float *models;
+
+} bench_jobs_trs;
+
+static void bench_jobs_trs_range(void *data, int first, int count, int worker)
+{
+  bench_jobs_trs *d = (bench_jobs_trs *)data;
+  (void)worker;
+
+  vm_m4x4_trs_batch(&d->positions[first], &d->rotations[first], 0, count, d->models + first * 16, 16);
+}
+
+/* Work stealing job system with more workers than cpus: every element of a parallel-for exactly once, jobs
+ * submitted from jobs, deque overflow, submit/wait overhead and the parallel model matrix generation */
+int bench_jobs(void)
+{
+  enum
+  {
+    workers_count = 4,
+    elements = 100000,
+    tree_depth = 10,
+    submits = 3000, /* more than a deque holds */
+    matrices = 65536,
+    repeats = 10
+  };
+
+  speg_jobs_worker *workers = (speg_jobs_worker *)malloc(sizeof(speg_jobs_worker) * workers_count);
+  volatile long *visits = (volatile long *)calloc(elements, sizeof(long));
+  v3 *positions = (v3 *)malloc(sizeof(v3) * matrices);
+  quat *rotations = (quat *)malloc(sizeof(quat) * matrices);
+  float *models = (float *)malloc(sizeof(float) * 16 * matrices);
+  float *expected = (float *)malloc(sizeof(float) * 16 * matrices);
+  speg_jobs jobs;
+  bench_jobs_data data = {0};
+  int mismatches = 0;
+
+  if (!workers || !visits || !positions || !rotations || !models || !expected || speg_jobs_init(&jobs, workers, workers_count) != workers_count)
+  {
+    free(workers);
+    free((void *)visits);
+    free(positions);
+    free(rotations);
+    free(models);
+    free(expected);
+    return 0;
+  }
+
+  data.jobs = &jobs;
+  data.visits = visits;
+
+  /* Parallel-for with several batch sizes, automatic (0) included */
+  int batches[4] = {1, 7, 1000, 0};
+  for (int b = 0; b < 4; ++b)
+  {
+    speg_job_counter counter = {0};
+
+    for (int i = 0; i < elements; ++i)
+    {
+      visits[i] = 0;
+    }
+
+    data.batch = batches[b] > 0 ? batches[b] : elements / (workers_count * 4);
+    speg_jobs_parallel_for(&jobs, bench_jobs_visit, &data, elements, batches[b], &counter);
+    speg_jobs_wait(&jobs, &counter);
+
+    for (int i = 0; i < elements; ++i)
+    {
+      mismatches += visits[i] != 1;
+    }
+    mismatches += counter.pending != 0;
+  }
+
+  /* Jobs submitting and waiting for jobs */
+  {
+    bench_jobs_node root = {&data, tree_depth};
+    speg_job_counter counter = {0};
+
+    data.executed = 0;
+    speg_jobs_submit(&jobs, bench_jobs_tree, &root, &counter);
+    speg_jobs_wait(&jobs, &counter);
+    mismatches += data.executed != (1 << (tree_depth + 1)) - 1;
+  }
+
+  /* More submits than the deque holds, the rest runs in place */
+  long inline_before = workers[0].inline_runs;
+  {
+    speg_job_counter counter = {0};
+
+    data.executed = 0;
+    for (int i = 0; i < submits; ++i)
+    {
+      speg_jobs_submit(&jobs, bench_jobs_count, &data, &counter);
+    }
+    speg_jobs_wait(&jobs, &counter);
+    mismatches += data.executed != submits;
+  }
+  long inline_runs = workers[0].inline_runs - inline_before;
+  mismatches += data.bad_workers != 0;
+
+  /* Submit + wait of one empty job */
+  unsigned long start = headless_rdtsc();
+  for (int r = 0; r < 1000; ++r)
+  {
+    speg_job_counter counter = {0};
+    speg_jobs_submit(&jobs, bench_jobs_count, &data, &counter);
+    speg_jobs_wait(&jobs, &counter);
+  }
+  double cycles_job = (double)(headless_rdtsc() - start) / 1000.0;
+
+  /* Model matrices serial against a parallel-for, the results are the same */
+  vm_seed_lcg = 5;
+  for (int i = 0; i < matrices; ++i)
+  {
+    positions[i] = vm_v3(vm_randf_range(-100.0f, 100.0f), vm_randf_range(-100.0f, 100.0f), vm_randf_range(-100.0f, 100.0f));
+    rotations[i] = vm_quat_rotate(vm_v3(0.0f, 1.0f, 0.0f), vm_randf_range(-VM_PI, VM_PI));
+  }
+
+  bench_jobs_trs trs = {positions, rotations, models};
+  bench_jobs_trs_range(&trs, 0, matrices, 0); /* both outputs paged in */
+  vm_m4x4_trs_batch(positions, rotations, 0, matrices, expected, 16);
+
+  start = headless_rdtsc();
+  for (int r = 0; r < repeats; ++r)
+  {
+    vm_m4x4_trs_batch(positions, rotations, 0, matrices, expected, 16);
+  }
+  double cycles_serial = (double)(headless_rdtsc() - start) / (double)repeats;
+
+  start = headless_rdtsc();
+  for (int r = 0; r < repeats; ++r)
+  {
+    speg_job_counter counter = {0};
+    speg_jobs_parallel_for(&jobs, bench_jobs_trs_range, &trs, matrices, 1024, &counter);
+    speg_jobs_wait(&jobs, &counter);
+  }
+  double cycles_parallel = (double)(headless_rdtsc() - start) / (double)repeats;
+
+  for (int i = 0; i < matrices * 16; ++i)
+  {
+    mismatches += models[i] != expected[i];
+  }
+
+  long stolen = 0;
+  for (int w = 0; w < workers_count; ++w)
+  {
+    stolen += workers[w].stolen;
+  }
+
+  speg_jobs_shutdown(&jobs);
+
+  printf("[bench] jobs %d workers on %d cpus: submit+wait %.0f cycles, %d matrices serial %.0f / parallel %.0f kcycles, %ld stolen, %ld of %d submits in place, %d mismatches\n",
+         (int)workers_count, speg_jobs_processor_count(), cycles_job, (int)matrices, cycles_serial / 1000.0, cycles_parallel / 1000.0, stolen, inline_runs, (int)submits, mismatches);
+
+  free(workers);
+  free((void *)visits);
+  free(positions);
+  free(rotations);
+  free(models);
+  free(expected);
+
+  return mismatches;
+}
+
+typedef struct bench_append_data
+{
+  speg_append *append;
+  int *slots;
+
+} bench_append_data;
+
+/* About 7 of 8 elements are appended, like the visible ones of a culling pass */
+static int bench_append_keeps(int i)
+{
+  return (((unsigned int)i * 2654435761U) >> 29) != 0;
+}
+
+static void bench_append_range(void *data, int first, int count, int worker)
+{
+  bench_append_data *d = (bench_append_data *)data;
+  speg_append_cursor cursor;
+  (void)worker;
+
+  speg_append_cursor_begin(&cursor, d->append, first);
+  for (int i = first; i < first + count; ++i)
+  {
+    int granted;
+
+    if (bench_append_keeps(i))
+    {
+      int slot = speg_append_reserve(&cursor, 1, &granted);
+
+      if (slot >= 0)
+      {
+        d->slots[slot] = i;
+      }
+    }
+  }
+}
+
+/* Forward copy like speg_draw_call_copy, so overlapping in place moves behave the same */
+static void bench_append_copy(void *data, int dst, int src, int count)
+{
+  int *slots = (int *)data;
+
+  for (int i = 0; i < count; ++i)
+  {
+    slots[dst + i] = slots[src + i];
+  }
+}
+
+/* speg_append_compact as speg_parallel_append_end runs it, on plain ints. slots holds twice the capacity */
+static int bench_append_compact(speg_append *append, int *slots)
+{
+  int total = speg_append_end(append);
+  int compacted = speg_append_compact(append, bench_append_copy, slots);
+
+  return (compacted == total ? total : -1);
+}
+
+/* Parallel append with block reservation: ordered mode gives the serial result, unordered mode every element
+ * once, overflow is counted, the lcg jump-ahead that seeds parallel ranges, and the cost per element */
+int bench_parallel_append(void)
+{
+  enum
+  {
+    workers_count = 4,
+    elements = 200000,
+    batch = 1000,
+    block_size = 64,
+    capacity = SPEG_APPEND_CAPACITY(elements, 2 * elements / batch + 1, block_size),
+    repeats = 10
+  };
+
+  speg_jobs_worker *workers = (speg_jobs_worker *)malloc(sizeof(speg_jobs_worker) * workers_count);
+  speg_append_block *blocks = (speg_append_block *)malloc(sizeof(speg_append_block) * SPEG_APPEND_BLOCKS_CAPACITY(capacity, block_size));
+  int *slots = (int *)malloc(sizeof(int) * 2 * capacity);
+  int *expected = (int *)malloc(sizeof(int) * elements);
+  unsigned char *seen = (unsigned char *)malloc(elements);
+  speg_jobs jobs;
+  speg_append append;
+  bench_append_data data = {&append, slots};
+  int mismatches = 0;
+  int expected_count = 0;
+  int out_of_place = 0;
+
+  if (!workers || !blocks || !slots || !expected || !seen || speg_jobs_init(&jobs, workers, workers_count) != workers_count)
+  {
+    free(workers);
+    free(blocks);
+    free(slots);
+    free(expected);
+    free(seen);
+    return 0;
+  }
+
+  for (int i = 0; i < elements; ++i)
+  {
+    if (bench_append_keeps(i))
+    {
+      expected[expected_count++] = i;
+    }
+  }
+
+  /* Ordered: the serial sequence, no matter which worker appended which range */
+  for (int r = 0; r < repeats; ++r)
+  {
+    speg_job_counter counter = {0};
+
+    speg_append_init(&append, blocks, SPEG_APPEND_BLOCKS_CAPACITY(capacity, block_size), capacity, block_size, 1);
+    speg_jobs_parallel_for(&jobs, bench_append_range, &data, elements, batch, &counter);
+    speg_jobs_wait(&jobs, &counter);
+
+    int total = bench_append_compact(&append, slots);
+    out_of_place += !append.in_place;
+    mismatches += total != expected_count || append.dropped != 0;
+    for (int i = 0; i < expected_count && i < total; ++i)
+    {
+      mismatches += slots[i] != expected[i];
+    }
+  }
+
+  /* Ordered, later ranges reserved first: the blocks are gathered behind the capacity and copied back */
+  {
+    speg_append_init(&append, blocks, SPEG_APPEND_BLOCKS_CAPACITY(capacity, block_size), capacity, block_size, 1);
+    for (int first = elements - batch; first >= 0; first -= batch)
+    {
+      bench_append_range(&data, first, batch, 0);
+    }
+
+    int total = bench_append_compact(&append, slots);
+    mismatches += total != expected_count || append.in_place;
+    for (int i = 0; i < expected_count && i < total; ++i)
+    {
+      mismatches += slots[i] != expected[i];
+    }
+  }
+
+  /* Unordered: every appended element exactly once */
+  {
+    speg_job_counter counter = {0};
+
+    speg_append_init(&append, blocks, SPEG_APPEND_BLOCKS_CAPACITY(capacity, block_size), capacity, block_size, 0);
+    speg_jobs_parallel_for(&jobs, bench_append_range, &data, elements, batch, &counter);
+    speg_jobs_wait(&jobs, &counter);
+
+    int total = bench_append_compact(&append, slots);
+    mismatches += total != expected_count || !append.in_place;
+    memset(seen, 0, (unsigned int)elements);
+    for (int i = 0; i < total; ++i)
+    {
+      mismatches += slots[i] < 0 || slots[i] >= elements || !bench_append_keeps(slots[i]) || seen[slots[i]]++;
+    }
+  }
+
+  /* Half the capacity: appends past it are dropped and counted, nothing written out of bounds */
+  {
+    speg_job_counter counter = {0};
+
+    slots[capacity / 2] = -1;
+    speg_append_init(&append, blocks, SPEG_APPEND_BLOCKS_CAPACITY(capacity / 2, block_size), capacity / 2, block_size, 0);
+    speg_jobs_parallel_for(&jobs, bench_append_range, &data, elements, batch, &counter);
+    speg_jobs_wait(&jobs, &counter);
+
+    mismatches += slots[capacity / 2] != -1;
+    mismatches += bench_append_compact(&append, slots) + (int)append.dropped != expected_count || append.dropped == 0;
+  }
+
+  /* Jump-ahead of the lcg against stepping it */
+  unsigned int counts[5] = {0, 1, 2, 3 * 1023, 100000};
+  for (int c = 0; c < 5; ++c)
+  {
+    unsigned int seed = 12345;
+
+    for (unsigned int i = 0; i < counts[c]; ++i)
+    {
+      vm_randi_seed(&seed);
+    }
+    mismatches += vm_seed_lcg_skip(12345, counts[c]) != seed;
+  }
+
+  /* Cost per element: a plain serial append against the parallel one (ordered, compaction included) */
+  unsigned long start = headless_rdtsc();
+  for (int r = 0; r < repeats; ++r)
+  {
+    int count = 0;
+
+    for (int i = 0; i < elements; ++i)
+    {
+      if (bench_append_keeps(i))
+      {
+        slots[count++] = i;
+      }
+    }
+    mismatches += count != expected_count;
+  }
+  double cycles_serial = (double)(headless_rdtsc() - start) / (double)(repeats * elements);
+
+  start = headless_rdtsc();
+  for (int r = 0; r < repeats; ++r)
+  {
+    speg_job_counter counter = {0};
+
+    speg_append_init(&append, blocks, SPEG_APPEND_BLOCKS_CAPACITY(capacity, block_size), capacity, block_size, 1);
+    speg_jobs_parallel_for(&jobs, bench_append_range, &data, elements, batch, &counter);
+    speg_jobs_wait(&jobs, &counter);
+    bench_append_compact(&append, slots);
+  }
+  double cycles_parallel = (double)(headless_rdtsc() - start) / (double)(repeats * elements);
+
+  speg_jobs_shutdown(&jobs);
+
+  printf("[bench] parallel append %d elements, %d workers on %d cpus, blocks of %d: serial %.2f / parallel %.2f cycles per element, %d of %d ordered runs out of place, %d mismatches\n",
+         (int)elements, (int)workers_count, speg_jobs_processor_count(), (int)block_size, cycles_serial, cycles_parallel, out_of_place, (int)repeats, mismatches);
+
+  free(workers);
+  free(blocks);
+  free(slots);
+  free(expected);
+  free(seen);
+
+  return mismatches;
+}
+
+/* One step of a body on a damped spring off its center (the car suspension without the wheels) */
+static void bench_fixed_step_body(rigid_body *body, float dt)
+{
+  v3 anchor = vm_v3_add(body->position, vm_v3_rotate(vm_v3(1.0f, 0.0f, -1.0f), body->orientation));
+  float spring = (0.5f - anchor.y) * 30000.0f - vm_rigid_body_point_velocity(body, anchor).y * 2500.0f;
+
+  vm_rigid_body_apply_force_at_position(body, vm_v3(0.0f, -9.81f * body->mass, 0.0f), body->position);
+  vm_rigid_body_apply_force_at_position(body, vm_v3(0.0f, spring, 0.0f), anchor);
+  vm_rigid_body_integrate(body, dt);
+}
+
+/* Fixed timestep: every frame rate takes the same steps with the same results for the same time, physics cost
+ * follows the step rate instead of the frame rate, hitches are clamped and rendering interpolates between steps */
+int bench_fixed_step(void)
+{
+  enum
+  {
+    max_steps = 512
+  };
+
+  static float reference_y[max_steps];
+  static quat reference_rotation[max_steps];
+  float fps[] = {60.0f, 30.0f, 144.0f, 240.0f, 1000.0f, 9000.0f};
+  float hz = 120.0f;
+  float seconds = 2.0f;
+  int reference_steps = 0;
+  int mismatches = 0;
+
+  for (int f = 0; f < (int)(sizeof(fps) / sizeof(fps[0])); ++f)
+  {
+    vm_fixed_step clock = vm_fixed_step_init(hz, 8);
+    rigid_body body = vm_rigid_body_init(vm_v3(0.0f, 2.0f, 0.0f), vm_quat(0.0f, 0.0f, 0.0f, 1.0f), 1200.0f, 2500.0f);
+    int frames = (int)(seconds * fps[f] + 0.5f);
+    double frame_time = 1.0 / (double)fps[f];
+    double total_time = 0.0;
+    int steps = 0;
+
+    for (int i = 0; i < frames; ++i)
+    {
+      int count = vm_fixed_step_advance(&clock, frame_time);
+      total_time += frame_time;
+
+      for (int k = 0; k < count; ++k, ++steps)
+      {
+        bench_fixed_step_body(&body, (float)clock.step);
+
+        if (f == 0 && steps < max_steps)
+        {
+          reference_y[steps] = body.position.y;
+          reference_rotation[steps] = body.orientation;
+        }
+        else if (steps < reference_steps)
+        {
+          /* Bit identical, the frame rate does not change the steps */
+          quat rotation = reference_rotation[steps];
+          mismatches += body.position.y != reference_y[steps] || body.orientation.x != rotation.x || body.orientation.y != rotation.y || body.orientation.z != rotation.z || body.orientation.w != rotation.w;
+        }
+      }
+
+      mismatches += clock.accumulator < 0.0 || clock.accumulator >= clock.step;
+    }
+
+    /* Simulated plus pending time is the frame time, nothing is created or lost below max_substeps */
+    mismatches += fabs((double)steps * clock.step + clock.accumulator - total_time) > 1e-9;
+
+    reference_steps = f == 0 ? steps : reference_steps;
+
+    /* Rounding of the frame times may leave out or add a step at the end */
+    mismatches += steps < (int)(seconds * hz) - 1 || steps > (int)(seconds * hz) + 1 || clock.steps != (unsigned long)steps;
+  }
+
+  /* A hitch takes max_substeps steps and drops the rest, frames shorter than a step take none */
+  {
+    vm_fixed_step clock = vm_fixed_step_init(hz, 8);
+
+    mismatches += vm_fixed_step_advance(&clock, 0.5) != 8 || clock.accumulator != 0.0;
+    mismatches += vm_fixed_step_advance(&clock, clock.step * 0.25) != 0 || vm_fixed_step_advance(&clock, -1.0) != 0;
+    mismatches += vm_fixed_step_advance(&clock, clock.step) != 1 || vm_fixed_step_alpha(&clock) != 0.25f;
+  }
+
+  /* Interpolation ends at both states, the shorter arc of q and -q is no rotation */
+  {
+    rigid_body previous = vm_rigid_body_init(vm_v3(0.0f, 1.0f, 0.0f), vm_quat(0.0f, 0.0f, 0.0f, 1.0f), 1.0f, 1.0f);
+    rigid_body current = vm_rigid_body_init(vm_v3(2.0f, 1.0f, 0.0f), vm_quat_rotate(vm_v3(0.0f, 1.0f, 0.0f), 0.5f), 1.0f, 1.0f);
+    quat q = vm_quat_rotate(vm_v3(1.0f, 0.0f, 0.0f), 0.7f);
+    quat negated = vm_quat(-q.x, -q.y, -q.z, -q.w);
+    rigid_body start = vm_rigid_body_interpolate(&previous, &current, 0.0f);
+    rigid_body end = vm_rigid_body_interpolate(&previous, &current, 1.0f);
+    rigid_body middle = vm_rigid_body_interpolate(&previous, &current, 0.5f);
+
+    mismatches += start.position.x != 0.0f || end.position.x != 2.0f || middle.position.x != 1.0f;
+    mismatches += fabsf(vm_quat_dot(start.orientation, previous.orientation)) < 0.9999f || fabsf(vm_quat_dot(end.orientation, current.orientation)) < 0.9999f;
+    mismatches += fabsf(vm_quat_dot(vm_quat_nlerp(q, negated, 0.5f), q)) < 0.9999f;
+  }
+
+  /* Physics cost of one second at 9000 fps: a step per frame against the fixed rate */
+  unsigned long cycles_variable;
+  unsigned long cycles_fixed;
+  {
+    rigid_body body = vm_rigid_body_init(vm_v3(0.0f, 2.0f, 0.0f), vm_quat(0.0f, 0.0f, 0.0f, 1.0f), 1200.0f, 2500.0f);
+    vm_fixed_step clock = vm_fixed_step_init(hz, 8);
+    unsigned long start = headless_rdtsc();
+
+    for (int i = 0; i < 9000; ++i)
+    {
+      bench_fixed_step_body(&body, 1.0f / 9000.0f);
+    }
+    cycles_variable = headless_rdtsc() - start;
+
+    start = headless_rdtsc();
+    for (int i = 0; i < 9000; ++i)
+    {
+      for (int count = vm_fixed_step_advance(&clock, 1.0 / 9000.0); count > 0; --count)
+      {
+        bench_fixed_step_body(&body, (float)clock.step);
+      }
+    }
+    cycles_fixed = headless_rdtsc() - start;
+  }
+
+  printf("[bench] fixed step: %d steps of %.0f hz over %.0f s at 6 frame rates, 1 s at 9000 fps %lu cycles per frame step, %lu cycles fixed step, %d mismatches\n",
+         reference_steps, (double)hz, (double)seconds, cycles_variable, cycles_fixed, mismatches);
+
+  return mismatches;
+}
+
+/* Arena: alignment, failed pushes, temp blocks, reset and the high water mark */
+int bench_arena(void)
+{
+  enum
+  {
+    size = 64 * 1024
+  };
+
+  unsigned char *memory = (unsigned char *)malloc(size + 64);
+  unsigned char *aligned;
+  int mismatches = 0;
+  speg_arena arena;
+
+  if (!memory)
+  {
+    return 0;
+  }
+
+  aligned = memory + (64 - ((size_t)memory & 63)) % 64;
+  speg_arena_init(&arena, aligned, size);
+
+  /* Random sizes and alignments never overlap and stay inside the block */
+  unsigned char *last_end = aligned;
+  unsigned long pushes = 0;
+
+  vm_seed_lcg = 23;
+  for (;;)
+  {
+    unsigned long push_size = 1 + (unsigned long)vm_randf_range(0.0f, 999.0f);
+    unsigned long alignment = 1UL << (unsigned int)vm_randf_range(0.0f, 6.99f);
+    unsigned char *block = (unsigned char *)speg_arena_push_aligned(&arena, push_size, alignment);
+
+    if (!block)
+    {
+      break;
+    }
+
+    mismatches += ((size_t)block & (alignment - 1)) != 0 || block < last_end || block + push_size > aligned + size;
+    last_end = block + push_size;
+    pushes++;
+  }
+  mismatches += arena.failed != 1 || arena.high_water != arena.used || arena.used > size;
+
+  /* Temp blocks restore the offset, nested */
+  speg_arena_reset(&arena);
+  mismatches += arena.used != 0 || arena.high_water <= size - 1024;
+
+  void *before = speg_arena_push(&arena, 100);
+  speg_arena_temp outer = speg_arena_temp_begin(&arena);
+  void *scratch = speg_arena_push(&arena, 1000);
+  speg_arena_temp inner = speg_arena_temp_begin(&arena);
+  speg_arena_push(&arena, 1000);
+  speg_arena_temp_end(inner);
+  mismatches += speg_arena_push(&arena, 1000) != (unsigned char *)scratch + 1008 || arena.temp_count != 1;
+  speg_arena_temp_end(outer);
+  mismatches += speg_arena_push(&arena, 1000) != scratch || arena.temp_count != 0 || before != aligned;
+
+  /* Arrays are aligned to the default, too large and overflowing sizes fail */
+  mismatches += ((size_t)SPEG_ARENA_PUSH_ARRAY(&arena, char, 3) & (SPEG_ARENA_DEFAULT_ALIGNMENT - 1)) != 0;
+  mismatches += speg_arena_push(&arena, size) != 0 || speg_arena_push(&arena, (unsigned long)-8) != 0;
+
+  printf("[bench] arena: %lu random pushes in %d bytes, %d mismatches\n", pushes, (int)size, mismatches);
+
+  free(memory);
+
+  return mismatches;
+}
+
+/* Reserved address space: levels of very different instance counts commit pages on demand, the memory never moves,
+ * earlier data survives every commit and the committed bytes follow the largest level, not the reservation */
+int bench_reserve(void)
+{
+  enum
+  {
+    instance_size = 56,
+    reserve_instances = 1 << 20
+  };
+
+  static const int levels[] = {2000, 200000, 20000, 650000, 1000};
+
+  unsigned long page = (unsigned long)sysconf(_SC_PAGESIZE);
+  unsigned long reserved_before = recorder.bytes_reserved;
+  unsigned long committed_before = recorder.bytes_committed;
+  unsigned char *memory = (unsigned char *)headless_memory_reserve(reserve_instances * instance_size);
+  unsigned long committed = 0;
+  unsigned long commits = 0;
+  int mismatches = 0;
+  int largest = 0;
+
+  if (!memory)
+  {
+    printf("[bench] reserve: unavailable\n");
+    return 0;
+  }
+
+  for (int l = 0; l < (int)array_size(levels); ++l)
+  {
+    unsigned long size = (unsigned long)levels[l] * instance_size;
+
+    if (size > committed)
+    {
+      mismatches += !headless_memory_commit(memory + committed, size - committed);
+      committed = size;
+      commits++;
+    }
+
+    /* Every level writes its instances, the first bytes keep the value of the first level */
+    for (unsigned long i = 1; i < size; ++i)
+    {
+      memory[i] = (unsigned char)(i * 31 + (unsigned long)l);
+    }
+    if (l == 0)
+    {
+      memory[0] = 0xA5;
+    }
+
+    mismatches += memory[0] != 0xA5 || memory[size - 1] != (unsigned char)((size - 1) * 31 + (unsigned long)l);
+    largest = levels[l] > largest ? levels[l] : largest;
+  }
+
+  unsigned long committed_expected = ((unsigned long)largest * instance_size + page - 1) & ~(page - 1);
+  mismatches += recorder.bytes_committed - committed_before != committed_expected;
+  mismatches += recorder.bytes_reserved - reserved_before != reserve_instances * instance_size;
+
+  /* Past the end of the reservation nothing is committed */
+  mismatches += headless_memory_commit(memory + reserve_instances * instance_size - page, 2 * page) != 0;
+
+  printf("[bench] reserve: %d levels (%d to %d instances), %lu commits, %lu of %lu bytes committed, %d mismatches\n",
+         (int)array_size(levels), levels[0], largest, commits, recorder.bytes_committed - committed_before,
+         (unsigned long)reserve_instances * instance_size, mismatches);
+
+  headless_memory_release(memory, reserve_instances * instance_size);
+  mismatches += recorder.bytes_reserved != reserved_before || recorder.bytes_committed != committed_before;
+
+  if (mismatches)
+  {
+    printf("[bench] reserve: release did not restore the reservation, %d mismatches\n", mismatches);
+  }
+
+  return mismatches;
+}
+
+/* Multi draw indirect: mesh sub allocation in the shared geometry, command generation from sorted render queue
+ * passes executed on the CPU (every instance drawn exactly once with its own mesh), merging and validation */
+int bench_indirect(void)
+{
+  enum
+  {
+    meshes_count = 300,
+    vertices_capacity = 16 * 1024,
+    indices_capacity = 48 * 1024,
+    count = 64 * 1024
+  };
+
+  float *positions = (float *)malloc(sizeof(float) * 3 * vertices_capacity);
+  float *uvs = (float *)malloc(sizeof(float) * 2 * vertices_capacity);
+  unsigned int *indices = (unsigned int *)malloc(sizeof(unsigned int) * indices_capacity);
+  unsigned int *mesh_indices = (unsigned int *)malloc(sizeof(unsigned int) * 256);
+  float *mesh_positions = (float *)malloc(sizeof(float) * 3 * 64);
+  float *mesh_uvs = (float *)malloc(sizeof(float) * 2 * 64);
+  speg_queue_item *items = (speg_queue_item *)malloc(sizeof(speg_queue_item) * count);
+  speg_queue_item *scratch = (speg_queue_item *)malloc(sizeof(speg_queue_item) * count);
+  unsigned int *instance_mesh = (unsigned int *)malloc(sizeof(unsigned int) * count);
+  unsigned int *instance_draws = (unsigned int *)malloc(sizeof(unsigned int) * count);
+  speg_indirect_command *commands = (speg_indirect_command *)malloc(sizeof(speg_indirect_command) * count);
+  int mismatches = 0;
+
+  if (!positions || !uvs || !indices || !mesh_indices || !mesh_positions || !mesh_uvs || !items || !scratch || !instance_mesh || !instance_draws || !commands)
+  {
+    return 0;
+  }
+
+  /* Meshes of 3..64 vertices, every vertex position holds the mesh number */
+  speg_geometry geometry;
+  int base_vertex[meshes_count];
+  unsigned int first_index[meshes_count];
+  unsigned int mesh_index_count[meshes_count];
+  unsigned int added = 0;
+
+  speg_geometry_init(&geometry, positions, uvs, vertices_capacity, indices, indices_capacity);
+
+  vm_seed_lcg = 17;
+  for (unsigned int m = 0; m < meshes_count; ++m)
+  {
+    unsigned int vertices_count = 3 + (unsigned int)vm_randf_range(0.0f, 61.0f);
+    unsigned int indices_count = 3 * (1 + (unsigned int)vm_randf_range(0.0f, 80.0f));
+
+    for (unsigned int v = 0; v < vertices_count * 3; ++v)
+    {
+      mesh_positions[v] = (float)m;
+    }
+    for (unsigned int v = 0; v < vertices_count * 2; ++v)
+    {
+      mesh_uvs[v] = (float)m;
+    }
+    for (unsigned int k = 0; k < indices_count; ++k)
+    {
+      mesh_indices[k] = (unsigned int)vm_randf_range(0.0f, (float)vertices_count - 0.5f);
+    }
+
+    unsigned int vertices_before = geometry.vertices_count;
+    unsigned int indices_before = geometry.indices_count;
+
+    if (!speg_geometry_add(&geometry, mesh_positions, mesh_uvs, vertices_count, mesh_indices, indices_count, &base_vertex[m], &first_index[m]))
+    {
+      /* Nothing changes when the mesh does not fit */
+      mismatches += geometry.vertices_count != vertices_before || geometry.indices_count != indices_before;
+      break;
+    }
+
+    /* Sub allocations follow each other and hold the mesh */
+    mismatches += base_vertex[m] != (int)vertices_before || first_index[m] != indices_before;
+    mismatches += geometry.vertices_count != vertices_before + vertices_count || geometry.indices_count != indices_before + indices_count;
+
+    for (unsigned int k = 0; k < indices_count; ++k)
+    {
+      mismatches += geometry.indices[first_index[m] + k] != mesh_indices[k];
+    }
+
+    mesh_index_count[m] = indices_count;
+    added++;
+  }
+
+  for (unsigned int v = 0; v < geometry.vertices_count; ++v)
+  {
+    unsigned int m = (unsigned int)geometry.positions[v * 3];
+    mismatches += m >= added || v < (unsigned int)base_vertex[m] || geometry.uvs[v * 2] != (float)m;
+  }
+
+  /* Full geometry */
+  {
+    speg_geometry full;
+    int full_base = -1;
+    unsigned int full_first = 7;
+
+    speg_geometry_init(&full, positions, uvs, 4, indices, 6);
+    mismatches += speg_geometry_add(&full, mesh_positions, mesh_uvs, 5, mesh_indices, 3, &full_base, &full_first) != 0 || full_base != -1 || full_first != 7 || full.changed;
+  }
+
+  /* Random submissions of one pass (same layer, 2D, culling and program) over all meshes, sorted by the queue */
+  speg_queue queue;
+  speg_queue_init(&queue, items, scratch, count);
+
+  for (unsigned int i = 0; i < count; ++i)
+  {
+    unsigned int mesh = (unsigned int)vm_randf_range(0.0f, (float)added - 0.5f);
+    speg_queue_push(&queue, speg_queue_key_make(0, 0, 1, 3, mesh, 0, vm_randf_range(0.0f, 100.0f)), i);
+  }
+  speg_queue_sort(&queue);
+
+  mismatches += speg_queue_pass_end(&queue, 0) != count;
+
+  /* The batches of the pass become commands, instance i of the gathered pass is queue item i */
+  speg_indirect_list list;
+  speg_indirect_init(&list, commands, count);
+
+  unsigned long start = headless_rdtsc();
+  for (unsigned int first = 0, end = 0; first < count; first = end)
+  {
+    unsigned int mesh = speg_queue_key_mesh(queue.items[first].key);
+
+    end = speg_queue_batch_end(&queue, first);
+    speg_indirect_push(&list, mesh_index_count[mesh], first_index[mesh], base_vertex[mesh], first, end - first);
+  }
+  unsigned long cycles = headless_rdtsc() - start;
+
+  /* One command per used mesh */
+  unsigned int meshes_used = 0;
+  for (unsigned int i = 0; i < count; ++i)
+  {
+    meshes_used += i == 0 || speg_queue_key_mesh(queue.items[i].key) != speg_queue_key_mesh(queue.items[i - 1].key);
+    instance_mesh[i] = speg_queue_key_mesh(queue.items[i].key);
+    instance_draws[i] = 0;
+  }
+  mismatches += list.count != meshes_used || list.dropped != 0;
+  mismatches += speg_indirect_validate(list.commands, list.count, &geometry, count) != 0;
+  mismatches += speg_indirect_instances(list.commands, list.count) != count;
+
+  /* Executes the multi draw: every vertex fetched for an instance belongs to the mesh of the instance */
+  for (unsigned int c = 0; c < list.count; ++c)
+  {
+    speg_indirect_command *command = &list.commands[c];
+
+    for (unsigned int i = command->base_instance; i < command->base_instance + command->instance_count; ++i)
+    {
+      instance_draws[i]++;
+
+      mismatches += command->count != mesh_index_count[instance_mesh[i]];
+
+      for (unsigned int k = 0; k < command->count; ++k)
+      {
+        unsigned int vertex = geometry.indices[command->first_index + k] + (unsigned int)command->base_vertex;
+        mismatches += (unsigned int)geometry.positions[vertex * 3] != instance_mesh[i];
+      }
+    }
+  }
+  for (unsigned int i = 0; i < count; ++i)
+  {
+    mismatches += instance_draws[i] != 1;
+  }
+
+  /* Merging: contiguous instances of the same mesh extend the last command, gaps and other meshes do not */
+  speg_indirect_clear(&list);
+  speg_indirect_push(&list, 36, 0, 0, 0, 10);
+  speg_indirect_push(&list, 36, 0, 0, 10, 5);
+  speg_indirect_push(&list, 36, 0, 0, 20, 5);
+  speg_indirect_push(&list, 6, 36, 24, 25, 5);
+  speg_indirect_push(&list, 6, 36, 24, 30, 0);
+  mismatches += list.count != 3 || list.commands[0].instance_count != 15 || list.commands[1].base_instance != 20 || list.commands[2].base_vertex != 24;
+
+  /* Full list drops */
+  speg_indirect_init(&list, commands, 1);
+  speg_indirect_push(&list, 36, 0, 0, 0, 1);
+  mismatches += speg_indirect_push(&list, 6, 36, 24, 1, 1) != 0 || list.dropped != 1 || list.count != 1;
+
+  /* Validation finds every broken command */
+  {
+    speg_indirect_command broken[5];
+    for (int b = 0; b < 5; ++b)
+    {
+      broken[b].count = mesh_index_count[0];
+      broken[b].instance_count = 4;
+      broken[b].first_index = first_index[0];
+      broken[b].base_vertex = base_vertex[0];
+      broken[b].base_instance = 0;
+    }
+    mismatches += speg_indirect_validate(broken, 5, &geometry, 4) != 0;
+
+    broken[0].base_instance = 1;                                        /* past the instances */
+    broken[1].first_index = geometry.indices_count - 1;                 /* past the indices */
+    broken[2].base_vertex = (int)geometry.vertices_count;               /* past the vertices */
+    broken[3].instance_count = 0;                                       /* empty */
+    mismatches += speg_indirect_validate(broken, 5, &geometry, 4) != 4;
+  }
+
+  printf("[bench] indirect %u meshes (%u vertices, %u indices), %u instances in %u commands: %.1f cycles/command, %d mismatches\n",
+         added,
+         geometry.vertices_count,
+         geometry.indices_count,
+         count,
+         meshes_used,
+         (double)cycles / (double)meshes_used,
+         mismatches);
+
+  free(positions);
+  free(uvs);
+  free(indices);
+  free(mesh_indices);
+  free(mesh_positions);
+  free(mesh_uvs);
+  free(items);
+  free(scratch);
+  free(instance_mesh);
+  free(instance_draws);
+  free(commands);
+
+  return mismatches;
+}
+
+int main(int argc, char **argv)
+{
+  int repeats = argc > 1 ? atoi(argv[1]) : 3;
+  char *soName = argc > 2 ? argv[2] : "./speg.so";
+
+  int width = 800;
+  int height = 600;
+  double dt = 1.0 / 60.0;
+
+  if (repeats <= 0 || !headless_load_code(soName))
+  {
+    return 1;
+  }
+
+  speg_platform_api platformApi = headless_platform_api(1);
+
+  speg_memory memory = {0};
+  if (!headless_memory_init(&memory, 1024 * 1024 * 8, 1024 * 1024 * 4))
+  {
+    return 1;
+  }
+
+  speg_state *state = (speg_state *)memory.permanentMemory;
+  platform_controller_input input = {0};
+
+  /* Startup frame builds the static scene */
+  headless_run_frame(&memory, &input, &platformApi, dt, width, height);
+
+  printf("[bench] %s, %d repeats per path, dt %.4f, %dx%d\n", soName, repeats, dt, width, height);
+  bench_profiler_overhead();
+  int mismatches = 0;
+  mismatches += bench_frustum_culling();
+  mismatches += bench_bvh_culling();
+  mismatches += bench_spatial_grid();
+  mismatches += bench_occlusion();
+  mismatches += bench_instance_formats();
+  mismatches += bench_batch_transforms();
+  mismatches += bench_scene_graph();
+  mismatches += bench_vm_paths();
+  mismatches += bench_sincos();
+  mismatches += bench_dirty_ranges();
+  mismatches += bench_ring_buffer();
+  mismatches += bench_render_queue();
+  mismatches += bench_indirect();
+  mismatches += bench_jobs();
+  mismatches += bench_parallel_append();
+  mismatches += bench_fixed_step();
+  mismatches += bench_arena();
+  mismatches += bench_reserve();
+  mismatches += bench_memory();
+  printf("[bench] checks: %d mismatches\n", mismatches);
+
+  printf("[bench] %-16s %7s %9s %9s %9s %9s %9s %11s\n", "path", "frames", "mean ms", "p50 ms", "p90 ms", "p99 ms", "max ms", "cycles/f");
+
+  int paths_count = (int)array_size(paths);
+
+  for (int p = 0; p < paths_count; ++p)
+  {
+    bench_path *path = &paths[p];
+
+    int frames_per_run = 0;
+    for (int s = 0; s < path->segments_count; ++s)
+    {
+      frames_per_run += path->segments[s].frames;
+    }
+
+    int frames_count = frames_per_run * repeats;
+    bench_frame *frames = (bench_frame *)malloc(sizeof(bench_frame) * (size_t)frames_count);
+    double *sorted = (double *)malloc(sizeof(double) * (size_t)frames_count);
+    int f = 0;
+
+    if (!frames || !sorted)
+    {
+      return 1;
+    }
+
+    for (int r = 0; r < repeats; ++r)
+    {
+      for (int s = 0; s < path->segments_count; ++s)
+      {
+        bench_segment *segment = &path->segments[s];
+
+        for (int i = 0; i < segment->frames; ++i)
+        {
+          bench_input_set(&input, segment, path->camera_simulate, s == 0 && i == 0);
+
+          headless_frame_timing timing = headless_run_frame(&memory, &input, &platformApi, dt, width, height);
+
+          frames[f].nanoseconds = timing.nanoseconds;
+          frames[f].cycles = timing.cycles;
+          for (int z = 0; z < SPEG_PROFILER_MAX_ZONES; ++z)
+          {
+            frames[f].inclusive[z] = state->profiler.zones[z].cycles_inclusive;
+            frames[f].exclusive[z] = state->profiler.zones[z].cycles_exclusive;
+            frames[f].hits[z] = state->profiler.zones[z].hits;
+          }
+          sorted[f] = timing.nanoseconds;
+          f++;
+        }
+      }
+    }
+
+    double total_nano = 0.0;
+    double total_cycles = 0.0;
+
+    for (int i = 0; i < frames_count; ++i)
+    {
+      total_nano += frames[i].nanoseconds;
+      total_cycles += (double)frames[i].cycles;
+    }
+
+    qsort(sorted, (size_t)frames_count, sizeof(double), bench_compare_double);
+
+    printf("[bench] %-16s %7d %9.4f %9.4f %9.4f %9.4f %9.4f %11.0f\n",
+           path->name,
+           frames_count,
+           total_nano / (double)frames_count / 1000000.0,
+           bench_percentile(sorted, frames_count, 50.0) / 1000000.0,
+           bench_percentile(sorted, frames_count, 90.0) / 1000000.0,
+           bench_percentile(sorted, frames_count, 99.0) / 1000000.0,
+           sorted[frames_count - 1] / 1000000.0,
+           total_cycles / (double)frames_count);
+
+    /* Zone break down: mean inclusive/exclusive cycles, p99 of the inclusive cycles and share of the frame */
+    for (unsigned int z = 0; z < state->profiler.zones_count; ++z)
+    {
+      double total_inclusive = 0.0;
+      double total_exclusive = 0.0;
+      double total_hits = 0.0;
+
+      for (int i = 0; i < frames_count; ++i)
+      {
+        total_inclusive += (double)frames[i].inclusive[z];
+        total_exclusive += (double)frames[i].exclusive[z];
+        total_hits += (double)frames[i].hits[z];
+        sorted[i] = (double)frames[i].inclusive[z];
+      }
+
+      if (total_hits == 0.0)
+      {
+        continue;
+      }
+
+      qsort(sorted, (size_t)frames_count, sizeof(double), bench_compare_double);
+
+      printf("[bench]   %-28s %9.0f incl, %9.0f excl, %9.0f p99 cycles/f, %5.1f%% of frame, %6.0f hits/f\n",
+             state->profiler.zones[z].name,
+             total_inclusive / (double)frames_count,
+             total_exclusive / (double)frames_count,
+             bench_percentile(sorted, frames_count, 99.0),
+             total_cycles > 0.0 ? 100.0 * total_inclusive / total_cycles : 0.0,
+             total_hits / (double)frames_count);
+    }
+
+    free(frames);
+    free(sorted);
+  }
+
+  /* A failed check fails the build agent like speg_headless does for invalid commands */
+  return (mismatches > 0 ? 1 : 0);
+}
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+
+*/
@@ -0,0 +1,120 @@
+/* vm.h kernels of one code path for the scalar/SSE/AVX2 comparison of speg_bench.
+ *
+ * build.sh compiles this file once per path (no define, -DVM_USE_SSE, -DVM_USE_SSE -DVM_USE_AVX2) into
+ * speg_bench_vm_scalar.so, speg_bench_vm_sse.so and speg_bench_vm_avx2.so. Every function runs count times
+ * over arrays so that the timings are not dominated by the calls through the shared object.
+ */
+#include "vm.h"
+
+const char *bench_vm_path(void)
+{
+#ifdef VM_USE_AVX2
+    return "avx2";
+#elif defined(VM_USE_SSE)
+    return "sse";
+#else
+    return "scalar";
+#endif
+}
+
+void bench_vm_m4x4_mul(const m4x4 *a, const m4x4 *b, m4x4 *out, int count)
+{
+    int i;
+    for (i = 0; i < count; ++i)
+    {
+        out[i] = vm_m4x4_mul(a[i], b[i]);
+    }
+}
+
+void bench_vm_m4x4_inverse(const m4x4 *m, m4x4 *out, int count)
+{
+    int i;
+    for (i = 0; i < count; ++i)
+    {
+        out[i] = vm_m4x4_inverse(m[i]);
+    }
+}
+
+void bench_vm_quat_mul(const quat *a, const quat *b, quat *out, int count)
+{
+    int i;
+    for (i = 0; i < count; ++i)
+    {
+        out[i] = vm_quat_mul(a[i], b[i]);
+    }
+}
+
+void bench_vm_quat_normalize(const quat *a, quat *out, int count)
+{
+    int i;
+    for (i = 0; i < count; ++i)
+    {
+        out[i] = vm_quat_normalize(a[i]);
+    }
+}
+
+void bench_vm_quat_to_rotation_matrix(const quat *q, m4x4 *out, int count)
+{
+    int i;
+    for (i = 0; i < count; ++i)
+    {
+        out[i] = vm_quat_to_rotation_matrix(q[i]);
+    }
+}
+
+void bench_vm_v3_rotate(const v3 *a, const quat *q, v3 *out, int count)
+{
+    int i;
+    for (i = 0; i < count; ++i)
+    {
+        out[i] = vm_v3_rotate(a[i], q[i]);
+    }
+}
+
+void bench_vm_trs_batch(const v3 *positions, const quat *rotations, const v3 *scales, int count, float *out, int affine)
+{
+    vm_trs_batch(positions, rotations, scales, count, out, affine ? 12 : 16, affine);
+}
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+
+*/
@@ -0,0 +1,462 @@
+/* speg_bvh.h - v0.1 - public domain bounding volume hierarchy for static instances - nickscha 2025
+
+A C89 standard compliant, single header, nostdlib (no C Standard Library) BVH over axis aligned boxes.
+
+The tree is built once (top down, median split on the longest axis of the box centers) and stored depth first:
+the left child of a node is always the next node and every subtree covers a contiguous range of instances in
+bvh order (bvh->indices maps the bvh order back to the original instance index). The caller reorders its
+instance data into bvh order once after the build so that culling returns ranges that can be copied as a block.
+
+The frustum walk keeps a bit per plane the node still straddles. Planes a node is completely inside of are
+dropped for the whole subtree, so nodes that are fully inside the frustum emit their range without any
+further plane test and the cost of the walk scales with the number of nodes crossing the frustum border.
+
+All memory is provided by the caller, nothing is allocated.
+
+USAGE
+
+  speg_bvh_build(&bvh, nodes, indices, bounds, centers, extents, count); (nodes: SPEG_BVH_NODES_CAPACITY(count))
+  (reorder the instance data: new[i] = old[bvh.indices[i]])
+
+  ranges_count = speg_bvh_cull(&bvh, planes, ranges, count, &visible_count);
+  (copy the instances [ranges[r].first, ranges[r].first + ranges[r].count) for every range)
+
+LICENSE
+
+  Placed in the public domain and also MIT licensed.
+  See end of file for detailed license information.
+
+*/
+#ifndef SPEG_BVH_H
+#define SPEG_BVH_H
+
+/* #############################################################################
+ * # COMPILER SETTINGS
+ * #############################################################################
+ */
+/* Check if using C99 or later (inline is supported) */
+#if __STDC_VERSION__ >= 199901L
+#define SPEG_BVH_INLINE inline
+#define SPEG_BVH_API extern
+#elif defined(__GNUC__) || defined(__clang__)
+#define SPEG_BVH_INLINE __inline__
+#define SPEG_BVH_API static
+#elif defined(_MSC_VER)
+#define SPEG_BVH_INLINE __inline
+#define SPEG_BVH_API static
+#else
+#define SPEG_BVH_INLINE
+#define SPEG_BVH_API static
+#endif
+
+#define SPEG_BVH_LEAF_SIZE 4                     /* max instances per leaf */
+#define SPEG_BVH_MAX_DEPTH 64                    /* median splits keep the depth at log2(count / SPEG_BVH_LEAF_SIZE) */
+#define SPEG_BVH_PLANES 6                        /* left, right, bottom, top, near, far as (x, y, z, w) each */
+#define SPEG_BVH_NODES_CAPACITY(count) (2 * (count) + 1) /* upper bound of nodes for count instances */
+
+/* #############################################################################
+ * # DATA STRUCTURES
+ * #############################################################################
+ */
+typedef struct speg_bvh_node
+{
+    float center[3];
+    float extents[3]; /* half size of the box */
+
+    int first; /* first instance of the subtree in bvh order */
+    int count; /* instances of the whole subtree */
+    int right; /* right child, the left child is always the next node. 0 for leaves */
+
+} speg_bvh_node;
+
+typedef struct speg_bvh
+{
+    speg_bvh_node *nodes;
+    int nodes_count;
+
+    int *indices;  /* original instance index for every position in bvh order */
+    float *bounds; /* center xyz + extents xyz per instance in bvh order */
+    int count;
+
+} speg_bvh;
+
+typedef struct speg_bvh_range
+{
+    int first;
+    int count;
+
+} speg_bvh_range;
+
+/* #############################################################################
+ * # BUILD
+ * #############################################################################
+ */
+SPEG_BVH_API SPEG_BVH_INLINE float speg_bvh_absf(float x)
+{
+    return (x < 0.0f ? -x : x);
+}
+
+/* Partial sort of indices[lo..hi] so that indices[k] holds the instance with the k-th smallest center on axis,
+ * smaller ones before and larger ones after it (quickselect, O(n) on average) */
+SPEG_BVH_API SPEG_BVH_INLINE void speg_bvh_select(int *indices, const float *centers, int axis, int lo, int hi, int k)
+{
+    while (lo < hi)
+    {
+        float pivot = centers[indices[lo + (hi - lo) / 2] * 3 + axis];
+        int i = lo;
+        int j = hi;
+
+        while (i <= j)
+        {
+            while (centers[indices[i] * 3 + axis] < pivot)
+            {
+                ++i;
+            }
+            while (centers[indices[j] * 3 + axis] > pivot)
+            {
+                --j;
+            }
+            if (i <= j)
+            {
+                int swap = indices[i];
+                indices[i] = indices[j];
+                indices[j] = swap;
+                ++i;
+                --j;
+            }
+        }
+
+        if (k <= j)
+        {
+            hi = j;
+        }
+        else if (k >= i)
+        {
+            lo = i;
+        }
+        else
+        {
+            break;
+        }
+    }
+}
+
+/* Builds the tree over count boxes given by centers and extents (3 floats per instance each, original order).
+ * nodes must hold SPEG_BVH_NODES_CAPACITY(count) nodes, indices count ints and bounds count * 6 floats.
+ * Returns the number of nodes. */
+SPEG_BVH_API SPEG_BVH_INLINE int speg_bvh_build(speg_bvh *bvh, speg_bvh_node *nodes, int *indices, float *bounds, const float *centers, const float *extents, int count)
+{
+    /* Pending subtrees: instance range and the parent whose right child it becomes (-1 for left children) */
+    int stack_first[SPEG_BVH_MAX_DEPTH];
+    int stack_count[SPEG_BVH_MAX_DEPTH];
+    int stack_parent[SPEG_BVH_MAX_DEPTH];
+    int stack_size = 0;
+    int i;
+
+    bvh->nodes = nodes;
+    bvh->nodes_count = 0;
+    bvh->indices = indices;
+    bvh->bounds = bounds;
+    bvh->count = count;
+
+    for (i = 0; i < count; ++i)
+    {
+        indices[i] = i;
+    }
+
+    if (count <= 0)
+    {
+        return (0);
+    }
+
+    stack_first[0] = 0;
+    stack_count[0] = count;
+    stack_parent[0] = -1;
+    stack_size = 1;
+
+    while (stack_size > 0)
+    {
+        int first;
+        int n;
+        int node_index;
+        speg_bvh_node *node;
+        float box_min[3], box_max[3];
+        float centroid_min[3], centroid_max[3];
+        int axis;
+        int a;
+
+        --stack_size;
+        first = stack_first[stack_size];
+        n = stack_count[stack_size];
+        node_index = bvh->nodes_count++;
+        node = &nodes[node_index];
+
+        if (stack_parent[stack_size] >= 0)
+        {
+            nodes[stack_parent[stack_size]].right = node_index;
+        }
+
+        for (a = 0; a < 3; ++a)
+        {
+            box_min[a] = centroid_min[a] = 3.402823466e+38f;
+            box_max[a] = centroid_max[a] = -3.402823466e+38f;
+        }
+
+        for (i = first; i < first + n; ++i)
+        {
+            const float *c = &centers[indices[i] * 3];
+            const float *e = &extents[indices[i] * 3];
+
+            for (a = 0; a < 3; ++a)
+            {
+                box_min[a] = c[a] - e[a] < box_min[a] ? c[a] - e[a] : box_min[a];
+                box_max[a] = c[a] + e[a] > box_max[a] ? c[a] + e[a] : box_max[a];
+                centroid_min[a] = c[a] < centroid_min[a] ? c[a] : centroid_min[a];
+                centroid_max[a] = c[a] > centroid_max[a] ? c[a] : centroid_max[a];
+            }
+        }
+
+        for (a = 0; a < 3; ++a)
+        {
+            node->center[a] = (box_min[a] + box_max[a]) * 0.5f;
+            node->extents[a] = (box_max[a] - box_min[a]) * 0.5f;
+        }
+
+        node->first = first;
+        node->count = n;
+        node->right = 0;
+
+        if (n <= SPEG_BVH_LEAF_SIZE || stack_size + 2 > SPEG_BVH_MAX_DEPTH)
+        {
+            continue;
+        }
+
+        axis = 0;
+        for (a = 1; a < 3; ++a)
+        {
+            if (centroid_max[a] - centroid_min[a] > centroid_max[axis] - centroid_min[axis])
+            {
+                axis = a;
+            }
+        }
+
+        speg_bvh_select(indices, centers, axis, first, first + n - 1, first + n / 2);
+
+        /* Right is pushed first so the left subtree is built next and directly follows its parent */
+        stack_first[stack_size] = first + n / 2;
+        stack_count[stack_size] = n - n / 2;
+        stack_parent[stack_size] = node_index;
+        ++stack_size;
+
+        stack_first[stack_size] = first;
+        stack_count[stack_size] = n / 2;
+        stack_parent[stack_size] = -1;
+        ++stack_size;
+    }
+
+    for (i = 0; i < count; ++i)
+    {
+        const float *c = &centers[indices[i] * 3];
+        const float *e = &extents[indices[i] * 3];
+        float *b = &bounds[i * 6];
+
+        b[0] = c[0];
+        b[1] = c[1];
+        b[2] = c[2];
+        b[3] = e[0];
+        b[4] = e[1];
+        b[5] = e[2];
+    }
+
+    return (bvh->nodes_count);
+}
+
+/* #############################################################################
+ * # FRUSTUM CULLING
+ * #############################################################################
+ */
+
+/* Appends [first, first + count) to ranges and merges it with the previous range if they touch */
+SPEG_BVH_API SPEG_BVH_INLINE void speg_bvh_emit(speg_bvh_range *ranges, int ranges_capacity, int *ranges_count, int first, int count)
+{
+    if (*ranges_count > 0 && ranges[*ranges_count - 1].first + ranges[*ranges_count - 1].count == first)
+    {
+        ranges[*ranges_count - 1].count += count;
+    }
+    else if (*ranges_count < ranges_capacity)
+    {
+        ranges[*ranges_count].first = first;
+        ranges[*ranges_count].count = count;
+        *ranges_count += 1;
+    }
+}
+
+/* Writes the ranges (in bvh order) of all instances inside or intersecting the frustum planes and returns the
+ * number of ranges. A box is outside if it is completely behind one plane, the same test as
+ * vm_frustum_cull_aabb_soa. ranges_capacity = bvh->count is always enough. */
+SPEG_BVH_API SPEG_BVH_INLINE int speg_bvh_cull(const speg_bvh *bvh, const float *planes, speg_bvh_range *ranges, int ranges_capacity, int *visible_count)
+{
+    int stack_node[SPEG_BVH_MAX_DEPTH];
+    unsigned int stack_mask[SPEG_BVH_MAX_DEPTH];
+    int stack_size = 0;
+    int ranges_count = 0;
+    int visible = 0;
+
+    float plane_abs[SPEG_BVH_PLANES][3];
+    int p;
+
+    for (p = 0; p < SPEG_BVH_PLANES; ++p)
+    {
+        plane_abs[p][0] = speg_bvh_absf(planes[p * 4 + 0]);
+        plane_abs[p][1] = speg_bvh_absf(planes[p * 4 + 1]);
+        plane_abs[p][2] = speg_bvh_absf(planes[p * 4 + 2]);
+    }
+
+    if (bvh->nodes_count > 0)
+    {
+        stack_node[0] = 0;
+        stack_mask[0] = (1u << SPEG_BVH_PLANES) - 1;
+        stack_size = 1;
+    }
+
+    while (stack_size > 0)
+    {
+        const speg_bvh_node *node;
+        unsigned int mask;
+        int outside = 0;
+
+        --stack_size;
+        node = &bvh->nodes[stack_node[stack_size]];
+        mask = stack_mask[stack_size];
+
+        for (p = 0; p < SPEG_BVH_PLANES; ++p)
+        {
+            const float *plane = &planes[p * 4];
+            float distance;
+            float radius;
+
+            if (!(mask & (1u << p)))
+            {
+                continue;
+            }
+
+            distance = (plane[0] * node->center[0] + plane[1] * node->center[1]) + (plane[2] * node->center[2] + plane[3]);
+            radius = (plane_abs[p][0] * node->extents[0] + plane_abs[p][1] * node->extents[1]) + plane_abs[p][2] * node->extents[2];
+
+            if (distance + radius < 0.0f)
+            {
+                outside = 1;
+                break;
+            }
+
+            if (distance - radius > 0.0f)
+            {
+                mask &= ~(1u << p); /* inside of this plane, so is every child */
+            }
+        }
+
+        if (outside)
+        {
+            continue;
+        }
+
+        if (mask == 0)
+        {
+            speg_bvh_emit(ranges, ranges_capacity, &ranges_count, node->first, node->count);
+            visible += node->count;
+        }
+        else if (node->right == 0)
+        {
+            int i;
+
+            for (i = node->first; i < node->first + node->count; ++i)
+            {
+                const float *b = &bvh->bounds[i * 6];
+                int inside = 1;
+
+                for (p = 0; p < SPEG_BVH_PLANES; ++p)
+                {
+                    const float *plane = &planes[p * 4];
+
+                    if ((mask & (1u << p)) &&
+                        (plane[0] * b[0] + plane[1] * b[1]) + (plane[2] * b[2] + plane[3]) +
+                                ((plane_abs[p][0] * b[3] + plane_abs[p][1] * b[4]) + plane_abs[p][2] * b[5]) <
+                            0.0f)
+                    {
+                        inside = 0;
+                        break;
+                    }
+                }
+
+                if (inside)
+                {
+                    speg_bvh_emit(ranges, ranges_capacity, &ranges_count, i, 1);
+                    visible += 1;
+                }
+            }
+        }
+        else
+        {
+            /* Right first so the left child (next node) is visited next and the ranges stay in bvh order */
+            stack_node[stack_size] = node->right;
+            stack_mask[stack_size] = mask;
+            ++stack_size;
+
+            stack_node[stack_size] = (int)(node - bvh->nodes) + 1;
+            stack_mask[stack_size] = mask;
+            ++stack_size;
+        }
+    }
+
+    if (visible_count)
+    {
+        *visible_count = visible;
+    }
+
+    return (ranges_count);
+}
+
+#endif /* SPEG_BVH_H */
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+
+*/
@@ -0,0 +1,227 @@
+/* speg_dirty.h - v0.1 - public domain dirty instance range tracking - nickscha 2025
+
+A C89 standard compliant, single header, nostdlib (no C Standard Library) list of changed instance ranges.
+
+The application marks the instances it changed since the last upload and the platform uploads only these
+ranges (glBufferSubData) instead of the whole instance buffers. Ranges are kept sorted and disjoint. Ranges
+that overlap, touch or are less than SPEG_DIRTY_MERGE_GAP instances apart are merged, uploading a few clean
+instances is cheaper than an additional upload call. When more than SPEG_DIRTY_MAX_RANGES ranges would be
+needed the two ranges with the smallest gap are merged, so the list never overflows.
+
+USAGE
+
+  speg_dirty_mark(&dirty, first, count);
+
+  for (i = 0; i < dirty.count; ++i)
+    (upload dirty.ranges[i].first, dirty.ranges[i].count)
+
+  speg_dirty_clear(&dirty);
+
+LICENSE
+
+  Placed in the public domain and also MIT licensed.
+  See end of file for detailed license information.
+
+*/
+#ifndef SPEG_DIRTY_H
+#define SPEG_DIRTY_H
+
+/* #############################################################################
+ * # COMPILER SETTINGS
+ * #############################################################################
+ */
+/* Check if using C99 or later (inline is supported) */
+#if __STDC_VERSION__ >= 199901L
+#define SPEG_DIRTY_INLINE inline
+#define SPEG_DIRTY_API extern
+#elif defined(__GNUC__) || defined(__clang__)
+#define SPEG_DIRTY_INLINE __inline__
+#define SPEG_DIRTY_API static
+#elif defined(_MSC_VER)
+#define SPEG_DIRTY_INLINE __inline
+#define SPEG_DIRTY_API static
+#else
+#define SPEG_DIRTY_INLINE
+#define SPEG_DIRTY_API static
+#endif
+
+#define SPEG_DIRTY_MAX_RANGES 16 /* upload calls per buffer and frame at most */
+#define SPEG_DIRTY_MERGE_GAP 8   /* clean instances between two ranges that are uploaded instead of splitting */
+
+/* #############################################################################
+ * # DATA STRUCTURES
+ * #############################################################################
+ */
+typedef struct speg_dirty_range
+{
+    int first;
+    int count;
+
+} speg_dirty_range;
+
+typedef struct speg_dirty
+{
+    speg_dirty_range ranges[SPEG_DIRTY_MAX_RANGES + 1]; /* one spare slot for the insert before the overflow merge */
+    int count;
+
+} speg_dirty;
+
+/* #############################################################################
+ * # FUNCTIONS
+ * #############################################################################
+ */
+SPEG_DIRTY_API SPEG_DIRTY_INLINE void speg_dirty_clear(speg_dirty *dirty)
+{
+    dirty->count = 0;
+}
+
+/* Merges range i + 1 into range i and closes the gap in the list */
+SPEG_DIRTY_API SPEG_DIRTY_INLINE void speg_dirty_merge_next(speg_dirty *dirty, int i)
+{
+    int end = dirty->ranges[i].first + dirty->ranges[i].count;
+    int next_end = dirty->ranges[i + 1].first + dirty->ranges[i + 1].count;
+    int k;
+
+    dirty->ranges[i].count = (next_end > end ? next_end : end) - dirty->ranges[i].first;
+
+    for (k = i + 1; k < dirty->count - 1; ++k)
+    {
+        dirty->ranges[k] = dirty->ranges[k + 1];
+    }
+    dirty->count--;
+}
+
+/* Adds the instances [first, first + count) to the dirty ranges */
+SPEG_DIRTY_API SPEG_DIRTY_INLINE void speg_dirty_mark(speg_dirty *dirty, int first, int count)
+{
+    speg_dirty_range *last;
+    int i;
+    int k;
+
+    if (count <= 0)
+    {
+        return;
+    }
+
+    /* Instances are usually written in order, the new range extends the last one */
+    if (dirty->count > 0)
+    {
+        last = &dirty->ranges[dirty->count - 1];
+
+        if (first >= last->first && first <= last->first + last->count + SPEG_DIRTY_MERGE_GAP)
+        {
+            int end = first + count;
+
+            if (end > last->first + last->count)
+            {
+                last->count = end - last->first;
+            }
+            return;
+        }
+    }
+
+    /* Sorted insert */
+    i = dirty->count;
+    while (i > 0 && dirty->ranges[i - 1].first > first)
+    {
+        dirty->ranges[i] = dirty->ranges[i - 1];
+        --i;
+    }
+    dirty->ranges[i].first = first;
+    dirty->ranges[i].count = count;
+    dirty->count++;
+
+    /* Merge with the previous range and every following range it reaches */
+    if (i > 0 && dirty->ranges[i - 1].first + dirty->ranges[i - 1].count + SPEG_DIRTY_MERGE_GAP >= first)
+    {
+        --i;
+        speg_dirty_merge_next(dirty, i);
+    }
+    while (i + 1 < dirty->count && dirty->ranges[i].first + dirty->ranges[i].count + SPEG_DIRTY_MERGE_GAP >= dirty->ranges[i + 1].first)
+    {
+        speg_dirty_merge_next(dirty, i);
+    }
+
+    /* Overflow, merge the two ranges with the smallest gap */
+    if (dirty->count > SPEG_DIRTY_MAX_RANGES)
+    {
+        int best = 0;
+        int best_gap = dirty->ranges[1].first - (dirty->ranges[0].first + dirty->ranges[0].count);
+
+        for (k = 1; k + 1 < dirty->count; ++k)
+        {
+            int gap = dirty->ranges[k + 1].first - (dirty->ranges[k].first + dirty->ranges[k].count);
+
+            if (gap < best_gap)
+            {
+                best = k;
+                best_gap = gap;
+            }
+        }
+
+        speg_dirty_merge_next(dirty, best);
+    }
+}
+
+/* Instances covered by the ranges, clipped to [0, limit) */
+SPEG_DIRTY_API SPEG_DIRTY_INLINE int speg_dirty_instances(const speg_dirty *dirty, int limit)
+{
+    int total = 0;
+    int i;
+
+    for (i = 0; i < dirty->count; ++i)
+    {
+        int first = dirty->ranges[i].first;
+        int end = first + dirty->ranges[i].count;
+
+        end = end > limit ? limit : end;
+        total += end > first ? end - first : 0;
+    }
+
+    return (total);
+}
+
+#endif /* SPEG_DIRTY_H */
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+
+*/
@@ -0,0 +1,245 @@
+/* Headless linux host for speg.c. Runs speg_update without a window/GPU and reports the CPU cost per frame.
+ *
+ * Usage: speg_headless [frames] [speg.so] [trace.json] [indirect] [pipelined]
+ *
+ * Without a shared object name speg.so is loaded, speg_sse.so on cpus without AVX2/FMA.
+ * With a trace file name all frames are captured as Chrome Trace Event JSON (chrome://tracing, ui.perfetto.dev).
+ * indirect 0 disables the multi draw indirect path (on by default), the application then draws every batch on its own.
+ * pipelined 1 simulates each frame on a worker while the previous one is submitted (speg_simulate/speg_submit), the
+ * last frame is submitted after the loop so the report shows the same frame as the serial run.
+ */
+#include "speg_headless.h"
+
+#include <stdlib.h>
+
+int main(int argc, char **argv)
+{
+  int frames = argc > 1 ? atoi(argv[1]) : 10000;
+  char *soName = argc > 2 ? argv[2] : (speg_cpu_supports_avx2() ? "./speg.so" : "./speg_sse.so");
+  char *traceName = argc > 3 && argv[3][0] ? argv[3] : NULL;
+  int indirect = argc > 4 ? atoi(argv[4]) : 1;
+  int pipelined = argc > 5 ? atoi(argv[5]) : 0;
+  int pending = -1;
+
+  int width = 800;
+  int height = 600;
+  double dt = 1.0 / 60.0; /* Fixed step so every run simulates the same scene */
+
+  double totalNano = 0.0;
+  unsigned long totalCycles = 0;
+  double maxNano = 0.0;
+
+  if (frames <= 0 || !headless_load_code(soName))
+  {
+    return 1;
+  }
+
+  if (pipelined && (!speg_simulate || !speg_submit))
+  {
+    printf("[headless] %s has no pipelined frames\n", soName);
+    return 1;
+  }
+
+  speg_platform_api platformApi = headless_platform_api(indirect);
+
+  speg_memory memory = {0};
+  if (!headless_memory_init(&memory, 1024 * 1024 * 8, 1024 * 1024 * 4))
+  {
+    return 1;
+  }
+
+  speg_profiler_trace trace = {0};
+  if (traceName && !headless_trace_begin(&trace, 1024 * 1024 * 64))
+  {
+    return 1;
+  }
+
+  platform_controller_input input = {0};
+
+  for (int i = 0; i < frames; ++i)
+  {
+    headless_frame_timing timing = pipelined ? headless_run_frame_pipelined(&memory, &input, &platformApi, dt, width, height, &pending)
+                                             : headless_run_frame(&memory, &input, &platformApi, dt, width, height);
+
+    if (traceName)
+    {
+      speg_state *traced = (speg_state *)memory.permanentMemory;
+
+      /* The submit phase of pipelined frames is a second trace thread */
+      speg_profiler_trace_frame(&trace, &traced->profiler, timing.frameBeginMicroseconds);
+      if (pipelined)
+      {
+        speg_profiler_trace_thread(&trace, &traced->profiler_submit, 2, "submit");
+      }
+    }
+
+    /* The first frame builds the static scene, keep it out of the steady state numbers */
+    if (i == 0)
+    {
+      printf("[headless] first frame: %.3f ms, %lu cycles\n", timing.nanoseconds / 1000000.0, timing.cycles);
+      continue;
+    }
+
+    totalNano += timing.nanoseconds;
+    totalCycles += timing.cycles;
+    maxNano = timing.nanoseconds > maxNano ? timing.nanoseconds : maxNano;
+  }
+
+  if (pipelined)
+  {
+    headless_submit_frame(&memory, &platformApi, pending);
+  }
+
+  speg_state *state = (speg_state *)memory.permanentMemory;
+  double measured = frames > 1 ? (double)(frames - 1) : 1.0;
+
+  printf("[headless] %d frames, %.4f ms/f avg, %.4f ms/f max, %.0f fps, %.0f cycles/f\n",
+         frames,
+         totalNano / measured / 1000000.0,
+         maxNano / 1000000.0,
+         totalNano > 0.0 ? measured * 1000000000.0 / totalNano : 0.0,
+         (double)totalCycles / measured);
+  printf("[headless] last frame: %4u objs, %4u culled, %4u occluded, %2u dc/f, %6lu instances, %8lu bytes uploaded, %8lu bytes streamed\n",
+         state->renderedObjects,
+         state->culledObjects,
+         state->occludedObjects,
+         recorder.draw_records_count,
+         recorder.frame_instances,
+         recorder.frame_bytes_uploaded,
+         recorder.frame_bytes_streamed);
+
+  for (unsigned int i = 0; i < recorder.draw_records_count; ++i)
+  {
+    headless_draw_record *record = &recorder.draw_records[i];
+    printf("[headless]   draw %u: mesh %-20s instances: %6d, commands: %4d, bytes: %8lu, uploads: %2u, streamed: %8lu, changed: %d, is_2d: %d\n",
+           i,
+           record->mesh->id,
+           record->count_instances,
+           record->commands,
+           record->bytes_uploaded,
+           record->uploads,
+           record->bytes_streamed,
+           record->changed,
+           record->is_2d);
+  }
+
+  printf("[headless] last frame zones: %u events, %u dropped\n", state->profiler.events_count, state->profiler.events_dropped);
+
+  for (unsigned int i = 0; i < state->profiler.zones_count; ++i)
+  {
+    speg_profiler_zone *zone = &state->profiler.zones[i];
+    if (zone->hits > 0)
+    {
+      printf("[headless]   %10lu incl, %10lu excl, %5u hits, %s\n", zone->cycles_inclusive, zone->cycles_exclusive, zone->hits, zone->name);
+    }
+  }
+
+  for (unsigned int i = 0; pipelined && i < state->profiler_submit.zones_count; ++i)
+  {
+    speg_profiler_zone *zone = &state->profiler_submit.zones[i];
+    if (zone->hits > 0)
+    {
+      printf("[headless]   %10lu incl, %10lu excl, %5u hits, %s (submit)\n", zone->cycles_inclusive, zone->cycles_exclusive, zone->hits, zone->name);
+    }
+  }
+
+  printf("[headless] totals: %llu draw calls, %llu instances, %llu bytes uploaded, %llu bytes streamed\n",
+         recorder.total_draw_calls,
+         recorder.total_instances,
+         recorder.total_bytes_uploaded,
+         recorder.total_bytes_streamed);
+  printf("[headless] memory: permanent %lu of %lu bytes, transient %lu of %lu bytes last frame (high water %lu), %lu allocations failed\n",
+         state->permanent.used,
+         state->permanent.size,
+         state->transient.used,
+         state->transient.size,
+         state->transient.high_water,
+         state->permanent.failed + state->transient.failed);
+  printf("[headless] reserved: %u reservations, %lu bytes address space, %lu bytes committed\n",
+         recorder.reservations_count,
+         recorder.bytes_reserved,
+         recorder.bytes_committed);
+  printf("[headless] indirect: %s, %llu multi draws, %llu commands, %llu invalid commands\n",
+         platformApi.platform_draw_indirect ? "on" : "off",
+         recorder.total_multi_draws,
+         recorder.total_commands,
+         recorder.total_invalid_commands);
+  printf("[headless] pipelined: %s\n", pipelined ? "on, simulate overlaps submit" : "off");
+  printf("[headless] stream: %lu frames, %lu waits, %lu wraps, %lu bytes allocated\n",
+         headless_stream.frames_total,
+         headless_stream.waits,
+         headless_stream.wraps,
+         headless_stream.bytes);
+
+  {
+    long executed = 0;
+    long stolen = 0;
+    long inline_runs = 0;
+
+    for (int i = 0; i < headless_jobs.workers_count; ++i)
+    {
+      executed += headless_jobs.workers[i].executed;
+      stolen += headless_jobs.workers[i].stolen;
+      inline_runs += headless_jobs.workers[i].inline_runs;
+    }
+
+    printf("[headless] jobs: %d workers, %ld jobs executed, %ld stolen, %ld run in place\n", headless_job_workers(), executed, stolen, inline_runs);
+  }
+  speg_jobs_shutdown(&headless_jobs);
+
+  if (traceName && !headless_trace_write(&trace, traceName))
+  {
+    return 1;
+  }
+
+  /* The GPU would read outside of its buffers */
+  if (recorder.total_invalid_commands > 0)
+  {
+    return 1;
+  }
+
+  return 0;
+}
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+
+*/
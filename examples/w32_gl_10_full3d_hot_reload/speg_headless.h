@@ -0,0 +1,870 @@
+/* speg_headless.h - v0.1 - public domain data structures - nickscha 2025
+
+A headless POSIX platform layer for speg.c (no window, no OpenGL, no GPU).
+
+Fills the speg_platform_api with a recording platform_draw stand-in and POSIX
+timer/cycle-count callbacks so that speg_update can be driven thousands of
+times per second on build agents and its CPU cost can be tracked.
+
+LICENSE
+
+  Placed in the public domain and also MIT licensed.
+  See end of file for detailed license information.
+
+*/
+#ifndef SPEG_HEADLESS_H
+#define SPEG_HEADLESS_H
+
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE /* MAP_ANONYMOUS */
+#endif
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <time.h>
+#include <dlfcn.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/* The platform independent nostdlib application code/logic, the job system with its pthreads backend */
+#define SPEG_IMPORT
+#define SPEG_JOBS_THREADS
+#include "speg.h"
+#include "speg_ring.h"
+
+/* Bytes per instance of the instance, color and texture index buffers in the formats of the draw call (as the win32 platform layer) */
+#define HEADLESS_SIZE_INSTANCE(draw_call) ((unsigned long)(speg_instance_model_size((draw_call)->instance_format) + \
+                                                           speg_instance_color_size((draw_call)->color_format) + (int)sizeof(int)))
+
+#define HEADLESS_MAX_DRAW_RECORDS 64
+
+/* One platform_draw call as the GPU would have seen it */
+typedef struct headless_draw_record
+{
+  speg_mesh *mesh;
+  int count_instances;
+  int commands; /* multi draw indirect commands, 0 for a plain instanced draw */
+  int changed;
+  int is_2d;
+  unsigned long bytes_uploaded;
+  unsigned int uploads; /* glBufferData/glBufferSubData calls per instance buffer */
+  unsigned long bytes_streamed; /* written by the application straight into the streaming buffer */
+  float projection_view[16];
+
+} headless_draw_record;
+
+#define HEADLESS_MAX_RESERVATIONS 16
+
+typedef struct headless_reservation
+{
+  unsigned char *memory;
+  unsigned long size;
+  unsigned long committed;
+
+} headless_reservation;
+
+typedef struct headless_recorder
+{
+  /* Current frame, reset by headless_run_frame */
+  headless_draw_record draw_records[HEADLESS_MAX_DRAW_RECORDS];
+  unsigned int draw_records_count;
+  unsigned long frame_instances;
+  unsigned long frame_bytes_uploaded;
+  unsigned long frame_bytes_streamed;
+
+  /* Totals since startup */
+  unsigned long long total_draw_calls;
+  unsigned long long total_instances;
+  unsigned long long total_bytes_uploaded;
+  unsigned long long total_bytes_streamed;
+  unsigned long long total_multi_draws;
+  unsigned long long total_commands;
+  unsigned long long total_invalid_commands; /* commands reading outside of the geometry or the instances */
+  unsigned int meshes_initialized;
+
+  /* Address space of the growable draw calls, committed is counted in whole pages */
+  headless_reservation reservations[HEADLESS_MAX_RESERVATIONS];
+  unsigned int reservations_count;
+  unsigned long bytes_reserved;
+  unsigned long bytes_committed;
+
+  /* Optional copy of every uploaded model matrix of the current frame (set capture_models to a buffer) */
+  float *capture_models;
+  unsigned long capture_models_capacity; /* in floats */
+  unsigned long capture_models_count;    /* in floats */
+
+} headless_recorder;
+
+static headless_recorder recorder;
+
+/* Fake GL object names so meshes look initialized to the application */
+static unsigned int headless_gl_names = 0;
+
+#define HEADLESS_STREAM_CAPACITY (1024 * 512)
+#define HEADLESS_GPU_FENCES (SPEG_RING_FRAMES + 1)
+
+/* Simulated GPU behind the streaming ring buffer fences, a frame completes latency frames after its fence */
+typedef struct headless_gpu
+{
+  unsigned long latency;
+  unsigned long submitted; /* frames fenced so far */
+  unsigned long completed; /* frames the GPU finished */
+  unsigned long fences[HEADLESS_GPU_FENCES]; /* frame each fence belongs to, handed out round robin */
+  unsigned int fences_next;
+
+} headless_gpu;
+
+/* Fencing a frame submits it, the GPU finishes the frame submitted latency frames earlier */
+void *headless_gpu_fence_insert(void *user)
+{
+  headless_gpu *gpu = (headless_gpu *)user;
+  unsigned long *fence = &gpu->fences[gpu->fences_next++ % HEADLESS_GPU_FENCES];
+
+  *fence = gpu->submitted++;
+
+  if (gpu->submitted > gpu->latency && gpu->submitted - gpu->latency > gpu->completed)
+  {
+    gpu->completed = gpu->submitted - gpu->latency;
+  }
+
+  return (fence);
+}
+
+int headless_gpu_fence_signaled(void *user, void *fence)
+{
+  return (*(unsigned long *)fence < ((headless_gpu *)user)->completed);
+}
+
+/* The CPU blocks until the GPU finished the frame of the fence */
+void headless_gpu_fence_wait(void *user, void *fence)
+{
+  headless_gpu *gpu = (headless_gpu *)user;
+
+  if (*(unsigned long *)fence >= gpu->completed)
+  {
+    gpu->completed = *(unsigned long *)fence + 1;
+  }
+}
+
+void headless_gpu_fence_release(void *user, void *fence)
+{
+  (void)user;
+  (void)fence;
+}
+
+speg_ring_fences headless_gpu_fences(headless_gpu *gpu)
+{
+  speg_ring_fences fences;
+  fences.insert = headless_gpu_fence_insert;
+  fences.signaled = headless_gpu_fence_signaled;
+  fences.wait = headless_gpu_fence_wait;
+  fences.release = headless_gpu_fence_release;
+  fences.user = gpu;
+  return (fences);
+}
+
+/* Streaming ring buffer in plain memory instead of a persistently mapped GL buffer */
+static headless_gpu headless_stream_gpu = {2, 0, 0, {0}, 0};
+static speg_ring headless_stream;
+
+void *headless_stream_alloc(unsigned int size, unsigned int *position)
+{
+  return (headless_stream.memory ? speg_ring_alloc(&headless_stream, size, 16, position) : NULL);
+}
+
+/* Mirrors the instance buffer uploads of the win32 platform layer */
+void headless_upload_instances(speg_draw_call *draw_call, unsigned long *bytes_uploaded, unsigned int *uploads)
+{
+  speg_mesh *mesh = draw_call->mesh;
+  unsigned long bytes_instances = (unsigned long)draw_call->count_instances * HEADLESS_SIZE_INSTANCE(draw_call);
+
+  if (!mesh->initialized)
+  {
+    mesh->VAO = ++headless_gl_names;
+    mesh->VBO = ++headless_gl_names;
+    mesh->EBO = ++headless_gl_names;
+    mesh->UBO = ++headless_gl_names;
+    mesh->IBO = ++headless_gl_names;
+    mesh->CBO = ++headless_gl_names;
+    mesh->TBO = ++headless_gl_names;
+
+    *bytes_uploaded += (unsigned long)(mesh->verticesSize + mesh->indicesSize + mesh->uvsSize);
+    *bytes_uploaded += bytes_instances;
+    (*uploads)++;
+
+    mesh->instancesCapacity = draw_call->count_instances;
+    mesh->initialized = true;
+    recorder.meshes_initialized++;
+  }
+
+  if (draw_call->streamed)
+  {
+    /* Already in the streaming buffer, keeps it alive when the data of an earlier frame is drawn again */
+    speg_ring_reuse(&headless_stream, draw_call->stream_position);
+  }
+  else if (draw_call->changed)
+  {
+    *bytes_uploaded += bytes_instances;
+    (*uploads)++;
+    mesh->instancesCapacity = draw_call->count_instances;
+  }
+  else if (draw_call->count_instances > mesh->instancesCapacity)
+  {
+    /* Reallocated and uploaded up to count_instances_max so later dirty ranges always fit */
+    *bytes_uploaded += (unsigned long)draw_call->count_instances_max * HEADLESS_SIZE_INSTANCE(draw_call);
+    (*uploads)++;
+    mesh->instancesCapacity = draw_call->count_instances_max;
+  }
+  else if (draw_call->dirty.count > 0)
+  {
+    *bytes_uploaded += (unsigned long)speg_dirty_instances(&draw_call->dirty, draw_call->count_instances) * HEADLESS_SIZE_INSTANCE(draw_call);
+    *uploads += (unsigned int)draw_call->dirty.count;
+  }
+
+  speg_dirty_clear(&draw_call->dirty);
+}
+
+/* Records a draw of the instances [first, first + count) of draw_call */
+void headless_record_instances(speg_draw_call *draw_call, int first, int count)
+{
+  /* Compact formats are unpacked so the capture always holds full 4x4 matrices */
+  unsigned long model_size = (unsigned long)speg_instance_model_size(draw_call->instance_format);
+  unsigned long capture = (unsigned long)count;
+  unsigned long i;
+
+  if (!recorder.capture_models)
+  {
+    return;
+  }
+
+  if (recorder.capture_models_count + capture * 16 > recorder.capture_models_capacity)
+  {
+    capture = (recorder.capture_models_capacity - recorder.capture_models_count) / 16;
+  }
+
+  for (i = 0; i < capture; ++i)
+  {
+    speg_instance_unpack_model(draw_call->instance_format, (unsigned char *)draw_call->models + ((unsigned long)first + i) * model_size, &recorder.capture_models[recorder.capture_models_count + i * 16]);
+  }
+  recorder.capture_models_count += capture * 16;
+}
+
+void headless_record_draw(speg_draw_call *draw_call, int instances, int commands, unsigned long bytes_uploaded, unsigned int uploads, float uniformProjectionView[16])
+{
+  unsigned long bytes_streamed = draw_call->streamed ? (unsigned long)draw_call->count_instances * HEADLESS_SIZE_INSTANCE(draw_call) : 0;
+
+  if (recorder.draw_records_count < HEADLESS_MAX_DRAW_RECORDS)
+  {
+    headless_draw_record *record;
+    int i;
+
+    record = &recorder.draw_records[recorder.draw_records_count++];
+    record->mesh = draw_call->mesh;
+    record->count_instances = instances;
+    record->commands = commands;
+    record->changed = draw_call->changed;
+    record->is_2d = draw_call->is_2d;
+    record->bytes_uploaded = bytes_uploaded;
+    record->uploads = uploads;
+    record->bytes_streamed = bytes_streamed;
+
+    for (i = 0; i < 16; ++i)
+    {
+      record->projection_view[i] = uniformProjectionView[i];
+    }
+  }
+
+  recorder.frame_instances += (unsigned long)instances;
+  recorder.frame_bytes_uploaded += bytes_uploaded;
+  recorder.frame_bytes_streamed += bytes_streamed;
+
+  recorder.total_draw_calls++;
+  recorder.total_instances += (unsigned long long)instances;
+  recorder.total_bytes_uploaded += bytes_uploaded;
+  recorder.total_bytes_streamed += bytes_streamed;
+}
+
+void headless_platform_draw(speg_draw_call *draw_call, float uniformProjectionView[16])
+{
+  unsigned long bytes_uploaded = 0;
+  unsigned int uploads = 0;
+
+  if (draw_call->count_instances == 0)
+  {
+    return;
+  }
+
+  headless_upload_instances(draw_call, &bytes_uploaded, &uploads);
+  headless_record_instances(draw_call, 0, draw_call->count_instances);
+  headless_record_draw(draw_call, draw_call->count_instances, 0, bytes_uploaded, uploads, uniformProjectionView);
+}
+
+/* One glMultiDrawElementsIndirect: every command is checked against the shared geometry and the instances */
+void headless_platform_draw_indirect(speg_draw_call *draw_call, speg_geometry *geometry, speg_indirect_command *commands, int count_commands, float uniformProjectionView[16])
+{
+  unsigned long bytes_uploaded = 0;
+  unsigned int uploads = 0;
+  int i;
+
+  if (count_commands <= 0 || draw_call->count_instances == 0)
+  {
+    return;
+  }
+
+  if (!geometry->VAO)
+  {
+    geometry->VAO = ++headless_gl_names;
+    geometry->VBO = ++headless_gl_names;
+    geometry->UBO = ++headless_gl_names;
+    geometry->EBO = ++headless_gl_names;
+  }
+
+  if (geometry->changed)
+  {
+    bytes_uploaded += (unsigned long)(geometry->vertices_count * (3 + 2) + geometry->indices_count) * sizeof(float);
+    uploads++;
+    geometry->changed = false;
+  }
+
+  headless_upload_instances(draw_call, &bytes_uploaded, &uploads);
+
+  recorder.total_invalid_commands += speg_indirect_validate(commands, (unsigned int)count_commands, geometry, (unsigned int)draw_call->count_instances);
+
+  for (i = 0; i < count_commands; ++i)
+  {
+    headless_record_instances(draw_call, (int)commands[i].base_instance, (int)commands[i].instance_count);
+  }
+
+  /* The command buffer is uploaded every draw */
+  bytes_uploaded += (unsigned long)count_commands * sizeof(speg_indirect_command);
+  uploads++;
+
+  headless_record_draw(draw_call, (int)speg_indirect_instances(commands, (unsigned int)count_commands), count_commands, bytes_uploaded, uploads, uniformProjectionView);
+
+  recorder.total_multi_draws++;
+  recorder.total_commands += (unsigned long long)count_commands;
+}
+
+unsigned long headless_rdtsc(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  unsigned int low_part, high_part;
+  __asm __volatile("rdtsc" : "=a"(low_part), "=d"(high_part));
+  return ((unsigned long)high_part << 31 << 1) | (unsigned long)low_part;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long)ts.tv_sec * 1000000000UL + (unsigned long)ts.tv_nsec;
+#endif
+}
+
+double headless_perf_current_time_nanoseconds(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1000000000.0 + (double)ts.tv_nsec;
+}
+
+void headless_sleep(unsigned long milliseconds)
+{
+  struct timespec ts;
+  ts.tv_sec = (time_t)(milliseconds / 1000);
+  ts.tv_nsec = (long)((milliseconds % 1000) * 1000000);
+  nanosleep(&ts, NULL);
+}
+
+void headless_print_console(char *file, int line, char *formatString, ...)
+{
+  va_list args;
+
+  printf("%s:%d ", file, line);
+
+  va_start(args, formatString);
+  vprintf(formatString, args);
+  va_end(args);
+}
+
+void headless_format_string(char *buffer, char *formatString, ...)
+{
+  va_list args;
+  va_start(args, formatString);
+  vsprintf(buffer, formatString, args);
+  va_end(args);
+}
+
+/* Reservation containing memory, NULL for addresses the platform did not reserve */
+headless_reservation *headless_reservation_find(void *memory)
+{
+  for (unsigned int i = 0; i < recorder.reservations_count; ++i)
+  {
+    headless_reservation *reservation = &recorder.reservations[i];
+
+    if ((unsigned char *)memory >= reservation->memory && (unsigned char *)memory < reservation->memory + reservation->size)
+    {
+      return reservation;
+    }
+  }
+
+  return NULL;
+}
+
+/* Address space only, every access faults until headless_memory_commit */
+void *headless_memory_reserve(unsigned long size)
+{
+  void *memory;
+
+  if (recorder.reservations_count == HEADLESS_MAX_RESERVATIONS)
+  {
+    return NULL;
+  }
+
+  memory = mmap(0, (size_t)size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+  if (memory == MAP_FAILED)
+  {
+    return NULL;
+  }
+
+  recorder.reservations[recorder.reservations_count].memory = (unsigned char *)memory;
+  recorder.reservations[recorder.reservations_count].size = size;
+  recorder.reservations[recorder.reservations_count].committed = 0;
+  recorder.reservations_count++;
+  recorder.bytes_reserved += size;
+
+  return (memory);
+}
+
+/* Makes the pages of [memory, memory + size) readable and writable, the kernel backs them on first touch */
+int headless_memory_commit(void *memory, unsigned long size)
+{
+  headless_reservation *reservation = headless_reservation_find(memory);
+  unsigned long page = (unsigned long)sysconf(_SC_PAGESIZE);
+  unsigned long first = (unsigned long)memory & ~(page - 1);
+  unsigned long end = ((unsigned long)memory + size + page - 1) & ~(page - 1);
+
+  if (!reservation || (unsigned char *)memory + size > reservation->memory + reservation->size)
+  {
+    return 0;
+  }
+
+  if (size == 0)
+  {
+    return 1;
+  }
+
+  if (mprotect((void *)first, (size_t)(end - first), PROT_READ | PROT_WRITE) != 0)
+  {
+    return 0;
+  }
+
+  /* Commits continue where the last one ended, a page shared with it is already counted */
+  if (first < (unsigned long)memory && reservation->committed > 0)
+  {
+    first += page;
+  }
+
+  reservation->committed += end > first ? end - first : 0;
+  recorder.bytes_committed += end > first ? end - first : 0;
+
+  return 1;
+}
+
+void headless_memory_release(void *memory, unsigned long size)
+{
+  headless_reservation *reservation = headless_reservation_find(memory);
+
+  if (!reservation)
+  {
+    return;
+  }
+
+  munmap(memory, (size_t)size);
+
+  recorder.bytes_reserved -= reservation->size;
+  recorder.bytes_committed -= reservation->committed;
+  *reservation = recorder.reservations[--recorder.reservations_count];
+}
+
+/* Job system behind platform_job_*, started with the first headless_platform_api */
+static speg_jobs headless_jobs;
+static speg_jobs_worker *headless_job_workers_memory;
+
+/* One worker per online cpu (the calling thread is worker 0), 0 = everything runs in place on submit */
+int headless_jobs_start(int workers)
+{
+  size_t size = sizeof(speg_jobs_worker) * SPEG_JOBS_MAX_WORKERS;
+
+  if (!headless_job_workers_memory)
+  {
+    void *memory = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    headless_job_workers_memory = memory != MAP_FAILED ? (speg_jobs_worker *)memory : NULL;
+  }
+
+  if (!headless_job_workers_memory)
+  {
+    return 0;
+  }
+
+  return speg_jobs_init(&headless_jobs, headless_job_workers_memory, workers);
+}
+
+int headless_job_workers(void)
+{
+  return headless_jobs.workers_count > 0 ? headless_jobs.workers_count : 1;
+}
+
+void headless_job_submit(speg_job_function function, void *data, speg_job_counter *counter)
+{
+  speg_jobs_submit(&headless_jobs, function, data, counter);
+}
+
+void headless_job_parallel_for(speg_job_range_function function, void *data, int count, int batch, speg_job_counter *counter)
+{
+  speg_jobs_parallel_for(&headless_jobs, function, data, count, batch, counter);
+}
+
+void headless_job_wait(speg_job_counter *counter)
+{
+  speg_jobs_wait(&headless_jobs, counter);
+}
+
+/* With indirect the application draws its passes through platform_draw_indirect */
+speg_platform_api headless_platform_api(int indirect)
+{
+  speg_platform_api platformApi = {0};
+  platformApi.platform_draw = headless_platform_draw;
+  platformApi.platform_print_console = headless_print_console;
+  platformApi.platform_format_string = headless_format_string;
+  platformApi.platform_sleep = headless_sleep;
+  platformApi.platform_perf_current_cycle_count = headless_rdtsc;
+  platformApi.platform_perf_current_time_nanoseconds = headless_perf_current_time_nanoseconds;
+  platformApi.platform_stream_alloc = headless_stream_alloc;
+  platformApi.platform_draw_indirect = indirect ? headless_platform_draw_indirect : NULL;
+  platformApi.platform_memory_reserve = headless_memory_reserve;
+  platformApi.platform_memory_commit = headless_memory_commit;
+  platformApi.platform_memory_release = headless_memory_release;
+  platformApi.platform_job_workers = headless_job_workers;
+  platformApi.platform_job_submit = headless_job_submit;
+  platformApi.platform_job_parallel_for = headless_job_parallel_for;
+  platformApi.platform_job_wait = headless_job_wait;
+
+  if (headless_jobs.workers_count == 0)
+  {
+    headless_jobs_start(speg_jobs_processor_count());
+  }
+
+  if (!headless_stream.memory)
+  {
+    void *memory = mmap(0, HEADLESS_STREAM_CAPACITY, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    speg_ring_fences fences = headless_gpu_fences(&headless_stream_gpu);
+
+    if (memory != MAP_FAILED)
+    {
+      speg_ring_init(&headless_stream, memory, HEADLESS_STREAM_CAPACITY, &fences);
+    }
+  }
+
+  return (platformApi);
+}
+
+/* Loads speg_update (and speg_simulate/speg_submit if it has them) from the shared object build of speg.c. Returns 0 on failure. */
+int headless_load_code(char *soName)
+{
+  void *handle = dlopen(soName, RTLD_NOW | RTLD_LOCAL);
+
+  if (!handle)
+  {
+    printf("[headless] cannot load code: %s (%s)\n", soName, dlerror());
+    return 0;
+  }
+
+  /* FIX for ERROR: ISO C forbids conversion of object pointer to function pointer type*/
+  /* https://pubs.opengroup.org/onlinepubs/009695399/functions/dlsym.html */
+  *(void **)(&speg_update) = dlsym(handle, "speg_update");
+  *(void **)(&speg_simulate) = dlsym(handle, "speg_simulate");
+  *(void **)(&speg_submit) = dlsym(handle, "speg_submit");
+
+  return (speg_update != NULL);
+}
+
+/* 1 memory allocation for everything, same layout as the win32 platform layer */
+int headless_memory_init(speg_memory *memory, uint32_t permanentMemorySize, uint32_t transientMemorySize)
+{
+  void *base = mmap(0, (size_t)permanentMemorySize + (size_t)transientMemorySize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  if (base == MAP_FAILED)
+  {
+    return 0;
+  }
+
+  memory->initialized = false;
+  memory->permanentMemorySize = permanentMemorySize;
+  memory->transientMemorySize = transientMemorySize;
+  memory->permanentMemory = base;
+  memory->transientMemory = ((uint8_t *)base + permanentMemorySize);
+
+  return 1;
+}
+
+/* Cycle counter frequency for the trace export, measured against the monotonic clock */
+double headless_cycles_per_microsecond(void)
+{
+  double startNano = headless_perf_current_time_nanoseconds();
+  unsigned long startCycles = headless_rdtsc();
+
+  headless_sleep(20);
+
+  unsigned long cycles = headless_rdtsc() - startCycles;
+  double nanoseconds = headless_perf_current_time_nanoseconds() - startNano;
+
+  return (nanoseconds > 0.0 ? (double)cycles * 1000.0 / nanoseconds : 1.0);
+}
+
+/* Preallocated trace buffer so capturing does not allocate while frames are measured */
+int headless_trace_begin(speg_profiler_trace *trace, unsigned long capacity)
+{
+  void *buffer = mmap(0, (size_t)capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  if (buffer == MAP_FAILED)
+  {
+    return 0;
+  }
+
+  speg_profiler_trace_begin(trace, (char *)buffer, capacity, headless_cycles_per_microsecond());
+  return 1;
+}
+
+int headless_trace_write(speg_profiler_trace *trace, char *fileName)
+{
+  unsigned long size = speg_profiler_trace_end(trace);
+  FILE *file = fopen(fileName, "wb");
+
+  if (!file)
+  {
+    printf("[headless] cannot write trace: %s\n", fileName);
+    return 0;
+  }
+
+  fwrite(trace->buffer, 1, (size_t)size, file);
+  fclose(file);
+
+  printf("[headless] trace: %s, %lu frames, %lu bytes%s\n", fileName, trace->frames, size, trace->truncated ? ", truncated (buffer full)" : "");
+
+  return 1;
+}
+
+typedef struct headless_frame_timing
+{
+  double nanoseconds;
+  unsigned long cycles;
+  double frameBeginMicroseconds; /* For speg_profiler_trace_frame */
+
+} headless_frame_timing;
+
+/* Runs one speg_update with a fixed dt and returns the time spent inside it */
+headless_frame_timing headless_run_frame(speg_memory *memory, platform_controller_input *input, speg_platform_api *platformApi, double dt, int width, int height)
+{
+  static int zoneUpdate = -1;
+  headless_frame_timing result;
+  speg_state *state = (speg_state *)memory->permanentMemory;
+  double startNano;
+  unsigned long startCycles;
+
+  state->renderedObjects = 0;
+  state->culledObjects = 0;
+  state->occludedObjects = 0;
+  state->dt = dt;
+  state->width = width;
+  state->height = height;
+
+  recorder.draw_records_count = 0;
+  recorder.frame_instances = 0;
+  recorder.frame_bytes_uploaded = 0;
+  recorder.frame_bytes_streamed = 0;
+  recorder.capture_models_count = 0;
+
+  if (zoneUpdate < 0)
+  {
+    zoneUpdate = (int)speg_profiler_zone_register(&state->profiler, "speg_update");
+  }
+
+  result.frameBeginMicroseconds = headless_perf_current_time_nanoseconds() / 1000.0;
+  speg_profiler_frame_begin(&state->profiler, headless_rdtsc);
+  speg_profiler_begin(&state->profiler, (unsigned int)zoneUpdate);
+
+  if (headless_stream.memory)
+  {
+    speg_ring_begin_frame(&headless_stream);
+  }
+
+  startNano = headless_perf_current_time_nanoseconds();
+  startCycles = headless_rdtsc();
+
+  speg_update(memory, input, platformApi);
+
+  result.cycles = headless_rdtsc() - startCycles;
+  result.nanoseconds = headless_perf_current_time_nanoseconds() - startNano;
+
+  /* Fence behind the draws of the frame */
+  if (headless_stream.memory)
+  {
+    speg_ring_end_frame(&headless_stream);
+  }
+
+  speg_profiler_end(&state->profiler, (unsigned int)zoneUpdate);
+  speg_profiler_frame_end(&state->profiler);
+
+  return (result);
+}
+
+/* The simulate phase of a pipelined frame as a job */
+typedef struct headless_simulate_job
+{
+  speg_memory *memory;
+  platform_controller_input *input;
+  speg_platform_api *platformApi;
+  int packet; /* Filled, then the packet to submit */
+
+} headless_simulate_job;
+
+void headless_simulate_job_run(void *data, int worker)
+{
+  headless_simulate_job *job = (headless_simulate_job *)data;
+  (void)worker;
+
+  job->packet = speg_simulate(job->memory, job->input, job->platformApi, job->packet);
+}
+
+/* Draws packet (nothing if it is -1) into a frame of the streaming buffer, zones go to the submit profiler */
+void headless_submit_frame(speg_memory *memory, speg_platform_api *platformApi, int packet)
+{
+  static int zoneSubmit = -1;
+  speg_state *state = (speg_state *)memory->permanentMemory;
+
+  recorder.draw_records_count = 0;
+  recorder.frame_instances = 0;
+  recorder.frame_bytes_uploaded = 0;
+  recorder.frame_bytes_streamed = 0;
+  recorder.capture_models_count = 0;
+
+  if (zoneSubmit < 0)
+  {
+    zoneSubmit = (int)speg_profiler_zone_register(&state->profiler_submit, "speg_submit");
+  }
+
+  speg_profiler_frame_begin(&state->profiler_submit, headless_rdtsc);
+  speg_profiler_begin(&state->profiler_submit, (unsigned int)zoneSubmit);
+
+  if (headless_stream.memory)
+  {
+    speg_ring_begin_frame(&headless_stream);
+  }
+
+  speg_submit(memory, platformApi, packet);
+
+  if (headless_stream.memory)
+  {
+    speg_ring_end_frame(&headless_stream);
+  }
+
+  speg_profiler_end(&state->profiler_submit, (unsigned int)zoneSubmit);
+  speg_profiler_frame_end(&state->profiler_submit);
+}
+
+/* Pipelined frame: simulates the next packet on a worker while *pending (the packet of the previous frame, -1 for
+ * none) is submitted, then makes the new packet the pending one. Returns the time of both phases together */
+headless_frame_timing headless_run_frame_pipelined(speg_memory *memory, platform_controller_input *input, speg_platform_api *platformApi, double dt, int width, int height, int *pending)
+{
+  static int zoneSimulate = -1;
+  headless_frame_timing result;
+  speg_state *state = (speg_state *)memory->permanentMemory;
+  speg_job_counter counter = {0};
+  headless_simulate_job job;
+  double startNano;
+  unsigned long startCycles;
+
+  state->renderedObjects = 0;
+  state->culledObjects = 0;
+  state->occludedObjects = 0;
+  state->dt = dt;
+  state->width = width;
+  state->height = height;
+
+  job.memory = memory;
+  job.input = input;
+  job.platformApi = platformApi;
+  job.packet = *pending < 0 ? 0 : (*pending + 1) % SPEG_FRAME_PACKETS;
+
+  if (zoneSimulate < 0)
+  {
+    zoneSimulate = (int)speg_profiler_zone_register(&state->profiler, "speg_simulate");
+  }
+
+  result.frameBeginMicroseconds = headless_perf_current_time_nanoseconds() / 1000.0;
+  speg_profiler_frame_begin(&state->profiler, headless_rdtsc);
+  speg_profiler_begin(&state->profiler, (unsigned int)zoneSimulate);
+
+  startNano = headless_perf_current_time_nanoseconds();
+  startCycles = headless_rdtsc();
+
+  headless_job_submit(headless_simulate_job_run, &job, &counter);
+  headless_submit_frame(memory, platformApi, *pending);
+  headless_job_wait(&counter);
+
+  result.cycles = headless_rdtsc() - startCycles;
+  result.nanoseconds = headless_perf_current_time_nanoseconds() - startNano;
+
+  speg_profiler_end(&state->profiler, (unsigned int)zoneSimulate);
+  speg_profiler_frame_end(&state->profiler);
+
+  *pending = job.packet;
+
+  return (result);
+}
+
+#endif /* SPEG_HEADLESS_H */
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+*/
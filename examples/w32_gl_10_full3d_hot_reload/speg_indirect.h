@@ -0,0 +1,290 @@
+/* speg_indirect.h - v0.1 - public domain multi draw indirect commands and shared geometry - nickscha 2025
+
+A C89 standard compliant, single header, nostdlib (no C Standard Library) command generator for multi draw indirect.
+
+All meshes live in one shared geometry (one vertex, uv and index buffer), each mesh is a sub allocation found by
+its first index and base vertex. A pass of many meshes with the same render state becomes a list of draw commands
+in the layout of the GL DrawElementsIndirectCommand (count, instanceCount, firstIndex, baseVertex, baseInstance)
+and is drawn with one glMultiDrawElementsIndirect call. baseInstance selects the instance data of a command from
+one instance buffer, so culling can emit commands for visible instance ranges without copying the instances.
+
+Commands for the same mesh whose instances follow each other are merged. speg_indirect_validate checks commands
+against the geometry and the instance count (the headless platform layer runs it for every indirect draw).
+
+All memory is provided by the caller, nothing is allocated.
+
+USAGE
+
+  speg_geometry_init(&geometry, positions, uvs, vertices_capacity, indices, indices_capacity);
+  speg_geometry_add(&geometry, mesh_positions, mesh_uvs, vertices_count, mesh_indices, indices_count, &base_vertex, &first_index);
+
+  speg_indirect_clear(&list);
+  speg_indirect_push(&list, indices_count, first_index, base_vertex, base_instance, instance_count);
+  (draw list.commands[0 .. list.count - 1] with one multi draw)
+
+LICENSE
+
+  Placed in the public domain and also MIT licensed.
+  See end of file for detailed license information.
+
+*/
+#ifndef SPEG_INDIRECT_H
+#define SPEG_INDIRECT_H
+
+/* #############################################################################
+ * # COMPILER SETTINGS
+ * #############################################################################
+ */
+/* Check if using C99 or later (inline is supported) */
+#if __STDC_VERSION__ >= 199901L
+#define SPEG_INDIRECT_INLINE inline
+#define SPEG_INDIRECT_API extern
+#elif defined(__GNUC__) || defined(__clang__)
+#define SPEG_INDIRECT_INLINE __inline__
+#define SPEG_INDIRECT_API static
+#elif defined(_MSC_VER)
+#define SPEG_INDIRECT_INLINE __inline
+#define SPEG_INDIRECT_API static
+#else
+#define SPEG_INDIRECT_INLINE
+#define SPEG_INDIRECT_API static
+#endif
+
+/* #############################################################################
+ * # DATA STRUCTURES
+ * #############################################################################
+ */
+/* Same layout as the GL DrawElementsIndirectCommand, 20 bytes */
+typedef struct speg_indirect_command
+{
+    unsigned int count; /* indices of the mesh */
+    unsigned int instance_count;
+    unsigned int first_index;
+    int base_vertex;
+    unsigned int base_instance; /* first instance in the instance buffer */
+
+} speg_indirect_command;
+
+typedef struct speg_indirect_list
+{
+    speg_indirect_command *commands;
+    unsigned int count;
+    unsigned int capacity;
+    unsigned int dropped; /* pushes beyond the capacity since the last clear */
+
+} speg_indirect_list;
+
+typedef struct speg_geometry
+{
+    float *positions; /* 3 floats per vertex */
+    float *uvs;       /* 2 floats per vertex */
+    unsigned int *indices;
+    unsigned int vertices_count;
+    unsigned int vertices_capacity;
+    unsigned int indices_count;
+    unsigned int indices_capacity;
+
+    int changed; /* set by speg_geometry_add, the platform uploads the buffers and clears it */
+
+    /* Filled by platform */
+    unsigned int VAO;
+    unsigned int VBO;
+    unsigned int UBO; /* UV's */
+    unsigned int EBO;
+
+} speg_geometry;
+
+/* #############################################################################
+ * # FUNCTIONS
+ * #############################################################################
+ */
+SPEG_INDIRECT_API SPEG_INDIRECT_INLINE void speg_geometry_init(speg_geometry *geometry, float *positions, float *uvs, unsigned int vertices_capacity, unsigned int *indices, unsigned int indices_capacity)
+{
+    geometry->positions = positions;
+    geometry->uvs = uvs;
+    geometry->indices = indices;
+    geometry->vertices_count = 0;
+    geometry->vertices_capacity = vertices_capacity;
+    geometry->indices_count = 0;
+    geometry->indices_capacity = indices_capacity;
+    geometry->changed = 0;
+    geometry->VAO = 0;
+    geometry->VBO = 0;
+    geometry->UBO = 0;
+    geometry->EBO = 0;
+}
+
+/* Copies a mesh into the shared buffers. Indices stay relative to the mesh, draws add base_vertex.
+ * Returns 0 when the geometry is full */
+SPEG_INDIRECT_API SPEG_INDIRECT_INLINE int speg_geometry_add(speg_geometry *geometry, const float *positions, const float *uvs, unsigned int vertices_count, const unsigned int *indices, unsigned int indices_count, int *base_vertex, unsigned int *first_index)
+{
+    float *dst_positions = geometry->positions + geometry->vertices_count * 3;
+    float *dst_uvs = geometry->uvs + geometry->vertices_count * 2;
+    unsigned int *dst_indices = geometry->indices + geometry->indices_count;
+    unsigned int i;
+
+    if (vertices_count > geometry->vertices_capacity - geometry->vertices_count || indices_count > geometry->indices_capacity - geometry->indices_count)
+    {
+        return (0);
+    }
+
+    for (i = 0; i < vertices_count * 3; ++i)
+    {
+        dst_positions[i] = positions[i];
+    }
+    for (i = 0; i < vertices_count * 2; ++i)
+    {
+        dst_uvs[i] = uvs[i];
+    }
+    for (i = 0; i < indices_count; ++i)
+    {
+        dst_indices[i] = indices[i];
+    }
+
+    *base_vertex = (int)geometry->vertices_count;
+    *first_index = geometry->indices_count;
+
+    geometry->vertices_count += vertices_count;
+    geometry->indices_count += indices_count;
+    geometry->changed = 1;
+
+    return (1);
+}
+
+SPEG_INDIRECT_API SPEG_INDIRECT_INLINE void speg_indirect_init(speg_indirect_list *list, speg_indirect_command *commands, unsigned int capacity)
+{
+    list->commands = commands;
+    list->count = 0;
+    list->capacity = capacity;
+    list->dropped = 0;
+}
+
+SPEG_INDIRECT_API SPEG_INDIRECT_INLINE void speg_indirect_clear(speg_indirect_list *list)
+{
+    list->count = 0;
+    list->dropped = 0;
+}
+
+/* Appends a command, extends the last one if it draws the same mesh and the instances follow its own.
+ * Returns 0 (and counts the command as dropped) when the list is full */
+SPEG_INDIRECT_API SPEG_INDIRECT_INLINE int speg_indirect_push(speg_indirect_list *list, unsigned int count, unsigned int first_index, int base_vertex, unsigned int base_instance, unsigned int instance_count)
+{
+    speg_indirect_command *command;
+
+    if (instance_count == 0)
+    {
+        return (1);
+    }
+
+    if (list->count > 0)
+    {
+        command = &list->commands[list->count - 1];
+
+        if (command->first_index == first_index && command->base_vertex == base_vertex && command->count == count &&
+            command->base_instance + command->instance_count == base_instance)
+        {
+            command->instance_count += instance_count;
+            return (1);
+        }
+    }
+
+    if (list->count == list->capacity)
+    {
+        list->dropped++;
+        return (0);
+    }
+
+    command = &list->commands[list->count++];
+    command->count = count;
+    command->instance_count = instance_count;
+    command->first_index = first_index;
+    command->base_vertex = base_vertex;
+    command->base_instance = base_instance;
+
+    return (1);
+}
+
+/* Instances drawn by the commands */
+SPEG_INDIRECT_API SPEG_INDIRECT_INLINE unsigned int speg_indirect_instances(const speg_indirect_command *commands, unsigned int count)
+{
+    unsigned int instances = 0;
+    unsigned int i;
+
+    for (i = 0; i < count; ++i)
+    {
+        instances += commands[i].instance_count;
+    }
+
+    return (instances);
+}
+
+/* Commands that would read outside of the geometry or past the instances of the instance buffer */
+SPEG_INDIRECT_API SPEG_INDIRECT_INLINE unsigned int speg_indirect_validate(const speg_indirect_command *commands, unsigned int count, const speg_geometry *geometry, unsigned int instances)
+{
+    unsigned int invalid = 0;
+    unsigned int i;
+    unsigned int k;
+
+    for (i = 0; i < count; ++i)
+    {
+        const speg_indirect_command *command = &commands[i];
+        int bad = command->instance_count == 0 ||
+                  command->base_instance > instances || command->instance_count > instances - command->base_instance ||
+                  command->first_index > geometry->indices_count || command->count > geometry->indices_count - command->first_index ||
+                  command->base_vertex < 0;
+
+        for (k = 0; !bad && k < command->count; ++k)
+        {
+            bad = geometry->indices[command->first_index + k] + (unsigned int)command->base_vertex >= geometry->vertices_count;
+        }
+
+        invalid += (unsigned int)bad;
+    }
+
+    return (invalid);
+}
+
+#endif /* SPEG_INDIRECT_H */
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+
+*/
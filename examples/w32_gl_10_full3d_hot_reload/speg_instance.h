@@ -0,0 +1,545 @@
+/* speg_instance.h - v0.1 - public domain compact per instance data layouts - nickscha 2025
+
+A C89 standard compliant, single header, nostdlib (no C Standard Library) packer for per instance model matrices
+and colors.
+
+A full 4x4 model matrix per instance is 64 bytes of which the last row is always (0, 0, 0, 1). The compact
+formats below store only what an affine transform needs and the matching vertex shader rebuilds the 4x4 matrix
+on the GPU. The half float variants keep the translation as float (world positions need the precision) and
+store the rest as IEEE 754 binary16.
+
+  format                             layout (bytes)                                          size
+  SPEG_INSTANCE_FORMAT_M4X4          float m[16] column major                                  64
+  SPEG_INSTANCE_FORMAT_AFFINE        float t[3], float linear[9] column major 3x3              48
+  SPEG_INSTANCE_FORMAT_AFFINE_HALF   float t[3], half linear[9], half pad                      32
+  SPEG_INSTANCE_FORMAT_TRS           float position[3], float rotation[4], float s[3]          40
+  SPEG_INSTANCE_FORMAT_TRS_HALF      float position[3], half rotation[4], half s[3], half pad  28
+
+  color                              layout (bytes)                                          size
+  SPEG_INSTANCE_COLOR_RGB32F         float rgb[3]                                              12
+  SPEG_INSTANCE_COLOR_RGBA8          unsigned char rgba[4], normalized, a = 255                 4
+
+The TRS formats describe model = translate * rotate * scale and can not represent shear (e.g. a non uniform
+scaled parent with a rotated child). A mirrored matrix is stored with a negative x scale. Use the affine
+formats for arbitrary transforms.
+
+Rotations are quaternions (x, y, z, w). Packing and unpacking only touches the memory passed in and is meant to be tested on the CPU.
+
+USAGE
+
+  speg_instance_pack_model(SPEG_INSTANCE_FORMAT_AFFINE_HALF, model, dst);   (model: 16 floats, column major)
+  speg_instance_pack_color(SPEG_INSTANCE_COLOR_RGBA8, rgb, dst);
+
+  dst += speg_instance_model_size(SPEG_INSTANCE_FORMAT_AFFINE_HALF);
+
+LICENSE
+
+  Placed in the public domain and also MIT licensed.
+  See end of file for detailed license information.
+
+*/
+#ifndef SPEG_INSTANCE_H
+#define SPEG_INSTANCE_H
+
+/* #############################################################################
+ * # COMPILER SETTINGS
+ * #############################################################################
+ */
+/* Check if using C99 or later (inline is supported) */
+#if __STDC_VERSION__ >= 199901L
+#define SPEG_INSTANCE_INLINE inline
+#define SPEG_INSTANCE_API extern
+#elif defined(__GNUC__) || defined(__clang__)
+#define SPEG_INSTANCE_INLINE __inline__
+#define SPEG_INSTANCE_API static
+#elif defined(_MSC_VER)
+#define SPEG_INSTANCE_INLINE __inline
+#define SPEG_INSTANCE_API static
+#else
+#define SPEG_INSTANCE_INLINE
+#define SPEG_INSTANCE_API static
+#endif
+
+#define SPEG_INSTANCE_FORMAT_M4X4 0        /* default, zero initialized draw calls keep the full matrix */
+#define SPEG_INSTANCE_FORMAT_AFFINE 1      /* 3x4 affine matrix */
+#define SPEG_INSTANCE_FORMAT_AFFINE_HALF 2 /* 3x4 affine matrix, half float 3x3 part */
+#define SPEG_INSTANCE_FORMAT_TRS 3         /* position + quaternion + scale */
+#define SPEG_INSTANCE_FORMAT_TRS_HALF 4    /* position + half float quaternion + half float scale */
+#define SPEG_INSTANCE_FORMAT_COUNT 5
+
+#define SPEG_INSTANCE_COLOR_RGB32F 0 /* default */
+#define SPEG_INSTANCE_COLOR_RGBA8 1
+#define SPEG_INSTANCE_COLOR_COUNT 2
+
+#define SPEG_INSTANCE_MAX_MODEL_SIZE 64 /* bytes, largest model format */
+#define SPEG_INSTANCE_MAX_COLOR_SIZE 12 /* bytes, largest color format */
+
+typedef unsigned short speg_instance_half;
+
+typedef union speg_instance_bits
+{
+    float f;
+    unsigned int u;
+
+} speg_instance_bits;
+
+/* #############################################################################
+ * # SIZES
+ * #############################################################################
+ */
+/* Bytes per instance of a model format */
+SPEG_INSTANCE_API SPEG_INSTANCE_INLINE int speg_instance_model_size(int format)
+{
+    switch (format)
+    {
+    case SPEG_INSTANCE_FORMAT_AFFINE:
+        return 48;
+    case SPEG_INSTANCE_FORMAT_AFFINE_HALF:
+        return 32;
+    case SPEG_INSTANCE_FORMAT_TRS:
+        return 40;
+    case SPEG_INSTANCE_FORMAT_TRS_HALF:
+        return 28;
+    default:
+        return 64;
+    }
+}
+
+/* Bytes per instance of a color format */
+SPEG_INSTANCE_API SPEG_INSTANCE_INLINE int speg_instance_color_size(int format)
+{
+    return (format == SPEG_INSTANCE_COLOR_RGBA8 ? 4 : 12);
+}
+
+/* #############################################################################
+ * # HALF FLOAT
+ * #############################################################################
+ */
+/* float to IEEE 754 binary16, round to nearest even. Overflow gives infinity, NaN stays NaN */
+SPEG_INSTANCE_API SPEG_INSTANCE_INLINE speg_instance_half speg_instance_float_to_half(float value)
+{
+    speg_instance_bits f;
+    speg_instance_bits denorm_magic;
+    unsigned int sign;
+    unsigned int result;
+
+    f.f = value;
+    sign = f.u & 0x80000000u;
+    f.u ^= sign;
+
+    if (f.u >= 0x47800000u) /* >= 65536 (rounds to infinity) or Inf/NaN */
+    {
+        result = f.u > 0x7F800000u ? 0x7E00u : 0x7C00u;
+    }
+    else if (f.u < 0x38800000u) /* below the smallest normal half, the float add does the rounding */
+    {
+        denorm_magic.u = 0x3F000000u; /* 0.5, aligns the half denormal bits to the low float mantissa bits */
+        f.f += denorm_magic.f;
+        result = f.u - denorm_magic.u;
+    }
+    else
+    {
+        unsigned int mantissa_odd = (f.u >> 13) & 1u;
+
+        f.u += 0xC8000FFFu; /* rebias the exponent (15 - 127) << 23 and add the rounding bias */
+        f.u += mantissa_odd;
+        result = f.u >> 13;
+    }
+
+    return (speg_instance_half)(result | (sign >> 16));
+}
+
+/* IEEE 754 binary16 to float, exact */
+SPEG_INSTANCE_API SPEG_INSTANCE_INLINE float speg_instance_half_to_float(speg_instance_half value)
+{
+    speg_instance_bits o;
+    speg_instance_bits magic;
+    unsigned int exponent;
+
+    o.u = ((unsigned int)value & 0x7FFFu) << 13;
+    exponent = o.u & 0x0F800000u;
+    o.u += 0x38000000u; /* (127 - 15) << 23 */
+
+    if (exponent == 0x0F800000u) /* Inf/NaN */
+    {
+        o.u += 0x38000000u;
+    }
+    else if (exponent == 0) /* zero/denormal, renormalize with a float subtract */
+    {
+        magic.u = 0x38800000u; /* 2^-14 */
+        o.u += 0x00800000u;
+        o.f -= magic.f;
+    }
+
+    o.u |= ((unsigned int)value & 0x8000u) << 16;
+
+    return (o.f);
+}
+
+/* Halves are written byte wise (little endian, as read by the GPU) so any buffer type can hold them */
+SPEG_INSTANCE_API SPEG_INSTANCE_INLINE void speg_instance_store_half(unsigned char *dst, float value)
+{
+    speg_instance_half h = speg_instance_float_to_half(value);
+
+    dst[0] = (unsigned char)(h & 0xFFu);
+    dst[1] = (unsigned char)(h >> 8);
+}
+
+SPEG_INSTANCE_API SPEG_INSTANCE_INLINE float speg_instance_load_half(const unsigned char *src)
+{
+    return (speg_instance_half_to_float((speg_instance_half)(src[0] | (src[1] << 8))));
+}
+
+/* #############################################################################
+ * # MODEL
+ * #############################################################################
+ */
+SPEG_INSTANCE_API SPEG_INSTANCE_INLINE float speg_instance_sqrtf(float x)
+{
+    speg_instance_bits i;
+    float y;
+    int k;
+
+    if (x <= 0.0f)
+    {
+        return (0.0f);
+    }
+
+    /* Inverse square root estimate refined by newton steps (relative error 3e-2, 2e-3, 5e-6, < 1 ulp) */
+    i.f = x;
+    i.u = 0x5F375A86u - (i.u >> 1);
+    y = i.f;
+
+    for (k = 0; k < 3; ++k)
+    {
+        y = y * (1.5f - 0.5f * x * y * y);
+    }
+
+    return (x * y);
+}
+
+/* Splits the affine matrix m (column major) into translation, rotation quaternion (x, y, z, w) and scale */
+SPEG_INSTANCE_API SPEG_INSTANCE_INLINE void speg_instance_decompose(const float *m, float *position, float *rotation, float *scale)
+{
+    float r[9]; /* column major rotation */
+    float trace;
+    float s;
+    float det;
+    int c;
+
+    scale[0] = speg_instance_sqrtf(m[0] * m[0] + m[1] * m[1] + m[2] * m[2]);
+    scale[1] = speg_instance_sqrtf(m[4] * m[4] + m[5] * m[5] + m[6] * m[6]);
+    scale[2] = speg_instance_sqrtf(m[8] * m[8] + m[9] * m[9] + m[10] * m[10]);
+
+    det = m[0] * (m[5] * m[10] - m[9] * m[6]) -
+          m[4] * (m[1] * m[10] - m[9] * m[2]) +
+          m[8] * (m[1] * m[6] - m[5] * m[2]);
+
+    if (det < 0.0f)
+    {
+        scale[0] = -scale[0];
+    }
+
+    for (c = 0; c < 3; ++c)
+    {
+        float inv = scale[c] != 0.0f ? 1.0f / scale[c] : 0.0f;
+
+        r[c * 3 + 0] = m[c * 4 + 0] * inv;
+        r[c * 3 + 1] = m[c * 4 + 1] * inv;
+        r[c * 3 + 2] = m[c * 4 + 2] * inv;
+    }
+
+    /* r(row, col) = r[col * 3 + row], largest diagonal term first for a stable division */
+    trace = r[0] + r[4] + r[8];
+
+    if (trace > 0.0f)
+    {
+        s = speg_instance_sqrtf(trace + 1.0f) * 2.0f;
+        rotation[3] = 0.25f * s;
+        rotation[0] = (r[5] - r[7]) / s;
+        rotation[1] = (r[6] - r[2]) / s;
+        rotation[2] = (r[1] - r[3]) / s;
+    }
+    else if (r[0] > r[4] && r[0] > r[8])
+    {
+        s = speg_instance_sqrtf(1.0f + r[0] - r[4] - r[8]) * 2.0f;
+        rotation[3] = (r[5] - r[7]) / s;
+        rotation[0] = 0.25f * s;
+        rotation[1] = (r[3] + r[1]) / s;
+        rotation[2] = (r[6] + r[2]) / s;
+    }
+    else if (r[4] > r[8])
+    {
+        s = speg_instance_sqrtf(1.0f + r[4] - r[0] - r[8]) * 2.0f;
+        rotation[3] = (r[6] - r[2]) / s;
+        rotation[0] = (r[3] + r[1]) / s;
+        rotation[1] = 0.25f * s;
+        rotation[2] = (r[7] + r[5]) / s;
+    }
+    else
+    {
+        s = speg_instance_sqrtf(1.0f + r[8] - r[0] - r[4]) * 2.0f;
+        rotation[3] = (r[1] - r[3]) / s;
+        rotation[0] = (r[6] + r[2]) / s;
+        rotation[1] = (r[7] + r[5]) / s;
+        rotation[2] = 0.25f * s;
+    }
+
+    position[0] = m[12];
+    position[1] = m[13];
+    position[2] = m[14];
+}
+
+/* Rebuilds translate * rotate * scale as column major 4x4 matrix (same math as the TRS vertex shader) */
+SPEG_INSTANCE_API SPEG_INSTANCE_INLINE void speg_instance_compose(const float *position, const float *rotation, const float *scale, float *m)
+{
+    float x = rotation[0];
+    float y = rotation[1];
+    float z = rotation[2];
+    float w = rotation[3];
+    float len = x * x + y * y + z * z + w * w;
+    float n = len > 0.0f ? 2.0f / len : 0.0f; /* normalizes quantized quaternions */
+
+    m[0] = (1.0f - n * (y * y + z * z)) * scale[0];
+    m[1] = (n * (x * y + w * z)) * scale[0];
+    m[2] = (n * (x * z - w * y)) * scale[0];
+    m[3] = 0.0f;
+
+    m[4] = (n * (x * y - w * z)) * scale[1];
+    m[5] = (1.0f - n * (x * x + z * z)) * scale[1];
+    m[6] = (n * (y * z + w * x)) * scale[1];
+    m[7] = 0.0f;
+
+    m[8] = (n * (x * z + w * y)) * scale[2];
+    m[9] = (n * (y * z - w * x)) * scale[2];
+    m[10] = (1.0f - n * (x * x + y * y)) * scale[2];
+    m[11] = 0.0f;
+
+    m[12] = position[0];
+    m[13] = position[1];
+    m[14] = position[2];
+    m[15] = 1.0f;
+}
+
+/* Writes the column major 4x4 model matrix m as format to dst (speg_instance_model_size(format) bytes, 4 byte aligned) */
+SPEG_INSTANCE_API SPEG_INSTANCE_INLINE void speg_instance_pack_model(int format, const float *m, void *dst)
+{
+    float *f = (float *)dst;
+    unsigned char *h = (unsigned char *)dst + 12;
+    float rotation[4];
+    float scale[3];
+    int i;
+
+    switch (format)
+    {
+    case SPEG_INSTANCE_FORMAT_AFFINE:
+        f[0] = m[12];
+        f[1] = m[13];
+        f[2] = m[14];
+        for (i = 0; i < 3; ++i)
+        {
+            f[3 + i * 3 + 0] = m[i * 4 + 0];
+            f[3 + i * 3 + 1] = m[i * 4 + 1];
+            f[3 + i * 3 + 2] = m[i * 4 + 2];
+        }
+        break;
+
+    case SPEG_INSTANCE_FORMAT_AFFINE_HALF:
+        f[0] = m[12];
+        f[1] = m[13];
+        f[2] = m[14];
+        for (i = 0; i < 3; ++i)
+        {
+            speg_instance_store_half(h + (i * 3 + 0) * 2, m[i * 4 + 0]);
+            speg_instance_store_half(h + (i * 3 + 1) * 2, m[i * 4 + 1]);
+            speg_instance_store_half(h + (i * 3 + 2) * 2, m[i * 4 + 2]);
+        }
+        h[18] = 0;
+        h[19] = 0;
+        break;
+
+    case SPEG_INSTANCE_FORMAT_TRS:
+        speg_instance_decompose(m, f, f + 3, f + 7);
+        break;
+
+    case SPEG_INSTANCE_FORMAT_TRS_HALF:
+        speg_instance_decompose(m, f, rotation, scale);
+        for (i = 0; i < 4; ++i)
+        {
+            speg_instance_store_half(h + i * 2, rotation[i]);
+        }
+        for (i = 0; i < 3; ++i)
+        {
+            speg_instance_store_half(h + 8 + i * 2, scale[i]);
+        }
+        h[14] = 0;
+        h[15] = 0;
+        break;
+
+    default:
+        for (i = 0; i < 16; ++i)
+        {
+            f[i] = m[i];
+        }
+        break;
+    }
+}
+
+/* Reads one instance of format from src back into the column major 4x4 matrix m */
+SPEG_INSTANCE_API SPEG_INSTANCE_INLINE void speg_instance_unpack_model(int format, const void *src, float *m)
+{
+    const float *f = (const float *)src;
+    const unsigned char *h = (const unsigned char *)src + 12;
+    float rotation[4];
+    float scale[3];
+    int i;
+
+    switch (format)
+    {
+    case SPEG_INSTANCE_FORMAT_AFFINE:
+    case SPEG_INSTANCE_FORMAT_AFFINE_HALF:
+        for (i = 0; i < 3; ++i)
+        {
+            if (format == SPEG_INSTANCE_FORMAT_AFFINE)
+            {
+                m[i * 4 + 0] = f[3 + i * 3 + 0];
+                m[i * 4 + 1] = f[3 + i * 3 + 1];
+                m[i * 4 + 2] = f[3 + i * 3 + 2];
+            }
+            else
+            {
+                m[i * 4 + 0] = speg_instance_load_half(h + (i * 3 + 0) * 2);
+                m[i * 4 + 1] = speg_instance_load_half(h + (i * 3 + 1) * 2);
+                m[i * 4 + 2] = speg_instance_load_half(h + (i * 3 + 2) * 2);
+            }
+            m[i * 4 + 3] = 0.0f;
+        }
+        m[12] = f[0];
+        m[13] = f[1];
+        m[14] = f[2];
+        m[15] = 1.0f;
+        break;
+
+    case SPEG_INSTANCE_FORMAT_TRS:
+        speg_instance_compose(f, f + 3, f + 7, m);
+        break;
+
+    case SPEG_INSTANCE_FORMAT_TRS_HALF:
+        for (i = 0; i < 4; ++i)
+        {
+            rotation[i] = speg_instance_load_half(h + i * 2);
+        }
+        for (i = 0; i < 3; ++i)
+        {
+            scale[i] = speg_instance_load_half(h + 8 + i * 2);
+        }
+        speg_instance_compose(f, rotation, scale, m);
+        break;
+
+    default:
+        for (i = 0; i < 16; ++i)
+        {
+            m[i] = f[i];
+        }
+        break;
+    }
+}
+
+/* #############################################################################
+ * # COLOR
+ * #############################################################################
+ */
+SPEG_INSTANCE_API SPEG_INSTANCE_INLINE unsigned char speg_instance_unorm8(float value)
+{
+    value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+    return ((unsigned char)(value * 255.0f + 0.5f));
+}
+
+/* Writes the color rgb (3 floats) as format to dst (speg_instance_color_size(format) bytes) */
+SPEG_INSTANCE_API SPEG_INSTANCE_INLINE void speg_instance_pack_color(int format, const float *rgb, void *dst)
+{
+    if (format == SPEG_INSTANCE_COLOR_RGBA8)
+    {
+        unsigned char *c = (unsigned char *)dst;
+
+        c[0] = speg_instance_unorm8(rgb[0]);
+        c[1] = speg_instance_unorm8(rgb[1]);
+        c[2] = speg_instance_unorm8(rgb[2]);
+        c[3] = 255;
+    }
+    else
+    {
+        float *c = (float *)dst;
+
+        c[0] = rgb[0];
+        c[1] = rgb[1];
+        c[2] = rgb[2];
+    }
+}
+
+/* Reads one color of format from src back into rgb (3 floats) */
+SPEG_INSTANCE_API SPEG_INSTANCE_INLINE void speg_instance_unpack_color(int format, const void *src, float *rgb)
+{
+    if (format == SPEG_INSTANCE_COLOR_RGBA8)
+    {
+        const unsigned char *c = (const unsigned char *)src;
+        const float inv = 1.0f / 255.0f;
+
+        rgb[0] = (float)c[0] * inv;
+        rgb[1] = (float)c[1] * inv;
+        rgb[2] = (float)c[2] * inv;
+    }
+    else
+    {
+        const float *c = (const float *)src;
+
+        rgb[0] = c[0];
+        rgb[1] = c[1];
+        rgb[2] = c[2];
+    }
+}
+
+#endif /* SPEG_INSTANCE_H */
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+
+*/
@@ -0,0 +1,750 @@
+/* speg_jobs.h - v0.1 - public domain work stealing job system - nickscha 2025
+
+A C89 standard compliant, single header work stealing job system with a Win32 and a pthreads backend.
+
+The platform layers start the workers at startup and hand submit, wait and parallel-for to the application through
+speg_platform_api, so speg.c stays a nostdlib library without threads of its own. Without SPEG_JOBS_THREADS only
+the job types and the atomics are declared (nostdlib, what speg.c sees through speg.h).
+
+Every worker owns a fixed size deque (Chase-Lev). The owner pushes and pops jobs at the bottom (the newest jobs,
+still hot in its cache), idle workers steal from the top of a random victim (the oldest jobs). Worker 0 is the
+thread that called speg_jobs_init, it runs jobs while it waits for them. The other workers spin for a while when
+they run out of work and then sleep on a semaphore until the next submit wakes them.
+
+A parallel-for is a single job over the whole range. Whoever runs it splits off the upper half as a new job until
+at most batch elements are left, so thieves take the largest ranges first and a parallel-for never puts more than
+log2(count / batch) jobs into one deque.
+
+Jobs are counted on a speg_job_counter of the caller: submit increments it, the finished job decrements it and wait
+runs jobs until it reaches 0. All memory (the deques) is provided by the caller at startup, nothing is allocated
+after speg_jobs_init. Submitting to a full deque or from a thread that is not a worker runs the job in place.
+
+USAGE
+
+  (platform) #define SPEG_JOBS_THREADS, include windows.h or w32_gl.h first on win32
+
+  speg_jobs_init(&jobs, workers, workers_count);  (workers: speg_jobs_worker[workers_count], the calling thread is worker 0)
+
+  speg_job_counter counter = {0};
+  speg_jobs_submit(&jobs, function, data, &counter);
+  speg_jobs_parallel_for(&jobs, range_function, data, count, batch, &counter);
+  speg_jobs_wait(&jobs, &counter);
+
+  speg_jobs_shutdown(&jobs);
+
+LICENSE
+
+  Placed in the public domain and also MIT licensed.
+  See end of file for detailed license information.
+
+*/
+#ifndef SPEG_JOBS_H
+#define SPEG_JOBS_H
+
+/* #############################################################################
+ * # COMPILER SETTINGS
+ * #############################################################################
+ */
+/* Check if using C99 or later (inline is supported) */
+#if __STDC_VERSION__ >= 199901L
+#define SPEG_JOBS_INLINE inline
+#define SPEG_JOBS_API extern
+#elif defined(__GNUC__) || defined(__clang__)
+#define SPEG_JOBS_INLINE __inline__
+#define SPEG_JOBS_API static
+#elif defined(_MSC_VER)
+#define SPEG_JOBS_INLINE __inline
+#define SPEG_JOBS_API static
+#else
+#define SPEG_JOBS_INLINE
+#define SPEG_JOBS_API static
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+#define SPEG_JOBS_MAX_WORKERS 64
+#define SPEG_JOBS_DEQUE_CAPACITY 1024 /* jobs per worker, power of two */
+#define SPEG_JOBS_SPIN 2048           /* rounds without work before an idle worker sleeps */
+#define SPEG_JOBS_CACHE_LINE 64
+
+/* #############################################################################
+ * # ATOMICS
+ * #############################################################################
+ *
+ * Sequentially consistent unless noted, on x86 only the fence and the read-modify-write operations cost anything.
+ */
+SPEG_JOBS_API SPEG_JOBS_INLINE long speg_atomic_load(volatile long *value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (__atomic_load_n(value, __ATOMIC_ACQUIRE));
+#else
+    long result = *value;
+    _ReadWriteBarrier();
+    return (result);
+#endif
+}
+
+SPEG_JOBS_API SPEG_JOBS_INLINE void speg_atomic_store(volatile long *value, long desired)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __atomic_store_n(value, desired, __ATOMIC_RELEASE);
+#else
+    _ReadWriteBarrier();
+    *value = desired;
+#endif
+}
+
+/* Returns the value before the addition */
+SPEG_JOBS_API SPEG_JOBS_INLINE long speg_atomic_fetch_add(volatile long *value, long addend)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (__atomic_fetch_add(value, addend, __ATOMIC_SEQ_CST));
+#else
+    return (_InterlockedExchangeAdd(value, addend));
+#endif
+}
+
+/* Returns 1 when value was expected and is now desired */
+SPEG_JOBS_API SPEG_JOBS_INLINE int speg_atomic_compare_exchange(volatile long *value, long expected, long desired)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (__atomic_compare_exchange_n(value, &expected, desired, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
+#else
+    return (_InterlockedCompareExchange(value, desired, expected) == expected);
+#endif
+}
+
+SPEG_JOBS_API SPEG_JOBS_INLINE void speg_atomic_fence(void)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+#else
+    _mm_mfence();
+#endif
+}
+
+/* Spin loop hint, lets the other hyper thread of the core run */
+SPEG_JOBS_API SPEG_JOBS_INLINE void speg_atomic_pause(void)
+{
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_ia32_pause();
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_pause();
+#endif
+}
+
+/* #############################################################################
+ * # DATA STRUCTURES
+ * #############################################################################
+ */
+/* worker is the index of the running worker (0 to workers_count - 1), e.g. for per worker buffers */
+typedef void (*speg_job_function)(void *data, int worker);
+typedef void (*speg_job_range_function)(void *data, int first, int count, int worker);
+
+/* Jobs submitted and not finished yet */
+typedef struct speg_job_counter
+{
+    volatile long pending;
+
+} speg_job_counter;
+
+#ifdef SPEG_JOBS_THREADS
+
+#if defined(_WIN32)
+typedef void *speg_jobs_thread;
+typedef void *speg_jobs_semaphore;
+#else
+#include <pthread.h>
+#include <semaphore.h>
+#include <sched.h>
+#include <unistd.h>
+typedef pthread_t speg_jobs_thread;
+typedef sem_t speg_jobs_semaphore;
+#endif
+
+typedef struct speg_job
+{
+    speg_job_function function;
+    speg_job_range_function range_function; /* parallel-for over [first, first + count) when set */
+    void *data;
+    speg_job_counter *counter;
+    int first;
+    int count;
+    int batch;
+
+} speg_job;
+
+typedef struct speg_jobs_worker
+{
+    /* Top is moved by the thieves and bottom by the owner, each on its own cache line */
+    volatile long top;
+    char padding_top[SPEG_JOBS_CACHE_LINE - sizeof(long)];
+    volatile long bottom;
+    char padding_bottom[SPEG_JOBS_CACHE_LINE - sizeof(long)];
+
+    speg_job jobs[SPEG_JOBS_DEQUE_CAPACITY];
+
+    struct speg_jobs *system;
+    speg_jobs_thread thread;
+    int index;
+    unsigned int random; /* victim selection (xorshift) */
+
+    /* Statistics */
+    volatile long executed;
+    volatile long stolen;
+    volatile long inline_runs; /* submits to a full deque or from other threads */
+
+} speg_jobs_worker;
+
+typedef struct speg_jobs
+{
+    speg_jobs_worker *workers;
+    int workers_count;
+
+    volatile long quit;
+    volatile long sleeping; /* workers waiting on the semaphore or about to */
+    speg_jobs_semaphore wake;
+
+#if defined(_WIN32)
+    unsigned long tls;
+#else
+    pthread_key_t tls;
+#endif
+
+} speg_jobs;
+
+/* #############################################################################
+ * # BACKENDS
+ * #############################################################################
+ */
+#if defined(_WIN32)
+
+/* Worker of the calling thread + 1, 0 for threads that are no worker */
+#define SPEG_JOBS_TLS_GET(jobs) ((int)(UINT_PTR)TlsGetValue((jobs)->tls))
+#define SPEG_JOBS_TLS_SET(jobs, value) TlsSetValue((jobs)->tls, (void *)(UINT_PTR)(value))
+
+SPEG_JOBS_API SPEG_JOBS_INLINE int speg_jobs_processor_count(void)
+{
+    return ((int)GetActiveProcessorCount(ALL_PROCESSOR_GROUPS));
+}
+
+SPEG_JOBS_API SPEG_JOBS_INLINE void speg_jobs_yield(void)
+{
+    SwitchToThread();
+}
+
+SPEG_JOBS_API SPEG_JOBS_INLINE void speg_jobs_sleep(speg_jobs *jobs)
+{
+    WaitForSingleObject(jobs->wake, INFINITE);
+}
+
+SPEG_JOBS_API SPEG_JOBS_INLINE void speg_jobs_wake(speg_jobs *jobs, int count)
+{
+    ReleaseSemaphore(jobs->wake, count, 0);
+}
+
+#else
+
+#define SPEG_JOBS_TLS_GET(jobs) ((int)(long)pthread_getspecific((jobs)->tls))
+#define SPEG_JOBS_TLS_SET(jobs, value) pthread_setspecific((jobs)->tls, (void *)(long)(value))
+
+SPEG_JOBS_API SPEG_JOBS_INLINE int speg_jobs_processor_count(void)
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (count > 0 ? (int)count : 1);
+}
+
+SPEG_JOBS_API SPEG_JOBS_INLINE void speg_jobs_yield(void)
+{
+    sched_yield();
+}
+
+SPEG_JOBS_API SPEG_JOBS_INLINE void speg_jobs_sleep(speg_jobs *jobs)
+{
+    while (sem_wait(&jobs->wake) != 0)
+    {
+        /* interrupted by a signal */
+    }
+}
+
+SPEG_JOBS_API SPEG_JOBS_INLINE void speg_jobs_wake(speg_jobs *jobs, int count)
+{
+    while (count-- > 0)
+    {
+        sem_post(&jobs->wake);
+    }
+}
+
+#endif
+
+/* #############################################################################
+ * # DEQUE
+ * #############################################################################
+ */
+/* Owner only. Returns 0 when the deque is full */
+SPEG_JOBS_API SPEG_JOBS_INLINE int speg_jobs_push(speg_jobs_worker *worker, const speg_job *job)
+{
+    long bottom = worker->bottom;
+
+    if (bottom - speg_atomic_load(&worker->top) >= SPEG_JOBS_DEQUE_CAPACITY)
+    {
+        return (0);
+    }
+
+    worker->jobs[bottom & (SPEG_JOBS_DEQUE_CAPACITY - 1)] = *job;
+    speg_atomic_store(&worker->bottom, bottom + 1);
+
+    return (1);
+}
+
+/* Owner only, the newest job. The last job is raced for with the thieves on top */
+SPEG_JOBS_API SPEG_JOBS_INLINE int speg_jobs_pop(speg_jobs_worker *worker, speg_job *job)
+{
+    long bottom = worker->bottom - 1;
+    long top;
+    int taken = 1;
+
+    speg_atomic_store(&worker->bottom, bottom);
+    speg_atomic_fence();
+    top = speg_atomic_load(&worker->top);
+
+    if (top > bottom)
+    {
+        speg_atomic_store(&worker->bottom, bottom + 1);
+        return (0);
+    }
+
+    *job = worker->jobs[bottom & (SPEG_JOBS_DEQUE_CAPACITY - 1)];
+
+    if (top == bottom)
+    {
+        taken = speg_atomic_compare_exchange(&worker->top, top, top + 1);
+        speg_atomic_store(&worker->bottom, bottom + 1);
+    }
+
+    return (taken);
+}
+
+/* Any thread, the oldest job. The slot is read before the claim, the owner never overwrites it before top moved */
+SPEG_JOBS_API SPEG_JOBS_INLINE int speg_jobs_steal(speg_jobs_worker *worker, speg_job *job)
+{
+    long top = speg_atomic_load(&worker->top);
+    long bottom;
+
+    speg_atomic_fence();
+    bottom = speg_atomic_load(&worker->bottom);
+
+    if (top >= bottom)
+    {
+        return (0);
+    }
+
+    *job = worker->jobs[top & (SPEG_JOBS_DEQUE_CAPACITY - 1)];
+
+    return (speg_atomic_compare_exchange(&worker->top, top, top + 1));
+}
+
+/* #############################################################################
+ * # SCHEDULER
+ * #############################################################################
+ */
+/* Worker of the calling thread, 0 for threads that are no worker */
+SPEG_JOBS_API SPEG_JOBS_INLINE speg_jobs_worker *speg_jobs_current(speg_jobs *jobs)
+{
+    int index = jobs->workers_count > 0 ? SPEG_JOBS_TLS_GET(jobs) : 0;
+    return (index > 0 ? &jobs->workers[index - 1] : 0);
+}
+
+SPEG_JOBS_API SPEG_JOBS_INLINE void speg_jobs_notify(speg_jobs *jobs)
+{
+    /* Pairs with the fence between sleeping++ and the last look at the deques of a worker going to sleep */
+    speg_atomic_fence();
+
+    if (speg_atomic_load(&jobs->sleeping) > 0)
+    {
+        speg_jobs_wake(jobs, 1);
+    }
+}
+
+/* Own deque first, then one round over the others starting at a random victim */
+SPEG_JOBS_API SPEG_JOBS_INLINE int speg_jobs_find(speg_jobs *jobs, speg_jobs_worker *worker, speg_job *job)
+{
+    unsigned int victim;
+    int i;
+
+    if (worker && speg_jobs_pop(worker, job))
+    {
+        return (1);
+    }
+
+    if (worker)
+    {
+        worker->random ^= worker->random << 13;
+        worker->random ^= worker->random >> 17;
+        worker->random ^= worker->random << 5;
+        victim = worker->random;
+    }
+    else
+    {
+        victim = 0;
+    }
+
+    for (i = 0; i < jobs->workers_count; ++i)
+    {
+        speg_jobs_worker *other = &jobs->workers[(victim + (unsigned int)i) % (unsigned int)jobs->workers_count];
+
+        if (other != worker && speg_jobs_steal(other, job))
+        {
+            if (worker)
+            {
+                worker->stolen++;
+            }
+            return (1);
+        }
+    }
+
+    return (0);
+}
+
+SPEG_JOBS_API SPEG_JOBS_INLINE int speg_jobs_has_work(speg_jobs *jobs)
+{
+    int i;
+
+    for (i = 0; i < jobs->workers_count; ++i)
+    {
+        if (speg_atomic_load(&jobs->workers[i].bottom) > speg_atomic_load(&jobs->workers[i].top))
+        {
+            return (1);
+        }
+    }
+
+    return (0);
+}
+
+SPEG_JOBS_API SPEG_JOBS_INLINE void speg_jobs_run(speg_jobs *jobs, speg_jobs_worker *worker, speg_job *job)
+{
+    int index = worker ? worker->index : 0;
+
+    if (job->range_function)
+    {
+        /* Split off the upper half for the thieves while the range is larger than a batch */
+        while (worker && job->count > job->batch)
+        {
+            speg_job upper = *job;
+            int half = job->count / 2;
+
+            upper.first = job->first + job->count - half;
+            upper.count = half;
+
+            speg_atomic_fetch_add(&job->counter->pending, 1);
+            if (!speg_jobs_push(worker, &upper))
+            {
+                speg_atomic_fetch_add(&job->counter->pending, -1);
+                break;
+            }
+            speg_jobs_notify(jobs);
+
+            job->count -= half;
+        }
+
+        job->range_function(job->data, job->first, job->count, index);
+    }
+    else
+    {
+        job->function(job->data, index);
+    }
+
+    if (worker)
+    {
+        worker->executed++;
+    }
+
+    speg_atomic_fetch_add(&job->counter->pending, -1);
+}
+
+SPEG_JOBS_API SPEG_JOBS_INLINE void speg_jobs_submit_job(speg_jobs *jobs, speg_job *job)
+{
+    speg_jobs_worker *worker = speg_jobs_current(jobs);
+
+    speg_atomic_fetch_add(&job->counter->pending, 1);
+
+    if (worker && speg_jobs_push(worker, job))
+    {
+        speg_jobs_notify(jobs);
+        return;
+    }
+
+    if (worker)
+    {
+        worker->inline_runs++;
+    }
+
+    speg_jobs_run(jobs, worker, job);
+}
+
+SPEG_JOBS_API SPEG_JOBS_INLINE void speg_jobs_submit(speg_jobs *jobs, speg_job_function function, void *data, speg_job_counter *counter)
+{
+    speg_job job = {0};
+
+    job.function = function;
+    job.data = data;
+    job.counter = counter;
+
+    speg_jobs_submit_job(jobs, &job);
+}
+
+/* function(data, first, count, worker) over [0, count) in pieces of at most batch elements (0 = automatic) */
+SPEG_JOBS_API SPEG_JOBS_INLINE void speg_jobs_parallel_for(speg_jobs *jobs, speg_job_range_function function, void *data, int count, int batch, speg_job_counter *counter)
+{
+    speg_job job = {0};
+
+    if (count <= 0)
+    {
+        return;
+    }
+
+    /* About 4 pieces per worker leave room to balance uneven pieces */
+    if (batch <= 0)
+    {
+        batch = count / ((jobs->workers_count > 0 ? jobs->workers_count : 1) * 4);
+        batch = batch > 0 ? batch : 1;
+    }
+
+    job.range_function = function;
+    job.data = data;
+    job.counter = counter;
+    job.first = 0;
+    job.count = count;
+    job.batch = batch;
+
+    speg_jobs_submit_job(jobs, &job);
+}
+
+/* Runs jobs (the own ones first) until every job counted on counter has finished */
+SPEG_JOBS_API SPEG_JOBS_INLINE void speg_jobs_wait(speg_jobs *jobs, speg_job_counter *counter)
+{
+    speg_jobs_worker *worker = speg_jobs_current(jobs);
+    speg_job job;
+    int spin = 0;
+
+    while (speg_atomic_load(&counter->pending) > 0)
+    {
+        if (speg_jobs_find(jobs, worker, &job))
+        {
+            speg_jobs_run(jobs, worker, &job);
+            spin = 0;
+        }
+        else if (++spin < SPEG_JOBS_SPIN)
+        {
+            speg_atomic_pause();
+        }
+        else
+        {
+            /* The remaining jobs run on other threads, let them have the core */
+            speg_jobs_yield();
+        }
+    }
+}
+
+SPEG_JOBS_API SPEG_JOBS_INLINE void speg_jobs_worker_loop(speg_jobs_worker *worker)
+{
+    speg_jobs *jobs = worker->system;
+    speg_job job;
+    int spin = 0;
+
+    SPEG_JOBS_TLS_SET(jobs, worker->index + 1);
+
+    while (!speg_atomic_load(&jobs->quit))
+    {
+        if (speg_jobs_find(jobs, worker, &job))
+        {
+            speg_jobs_run(jobs, worker, &job);
+            spin = 0;
+            continue;
+        }
+
+        if (++spin < SPEG_JOBS_SPIN)
+        {
+            speg_atomic_pause();
+            continue;
+        }
+
+        /* A submit after this point either sees sleeping > 0 and wakes a worker or its job is seen below */
+        speg_atomic_fetch_add(&jobs->sleeping, 1);
+        speg_atomic_fence();
+
+        if (!speg_jobs_has_work(jobs) && !speg_atomic_load(&jobs->quit))
+        {
+            speg_jobs_sleep(jobs);
+        }
+
+        speg_atomic_fetch_add(&jobs->sleeping, -1);
+        spin = 0;
+    }
+}
+
+#if defined(_WIN32)
+SPEG_JOBS_API unsigned long __stdcall speg_jobs_thread_main(void *parameter)
+{
+    speg_jobs_worker_loop((speg_jobs_worker *)parameter);
+    return (0);
+}
+#else
+SPEG_JOBS_API void *speg_jobs_thread_main(void *parameter)
+{
+    speg_jobs_worker_loop((speg_jobs_worker *)parameter);
+    return (0);
+}
+#endif
+
+/* Starts workers_count - 1 threads, the calling thread becomes worker 0. Returns the number of workers, 0 on
+ * failure (jobs then run in place on submit) */
+SPEG_JOBS_API SPEG_JOBS_INLINE int speg_jobs_init(speg_jobs *jobs, speg_jobs_worker *workers, int workers_count)
+{
+    int i;
+
+    workers_count = workers_count < SPEG_JOBS_MAX_WORKERS ? workers_count : SPEG_JOBS_MAX_WORKERS;
+
+    jobs->workers = workers;
+    jobs->workers_count = 0;
+    jobs->quit = 0;
+    jobs->sleeping = 0;
+
+    if (workers_count <= 0)
+    {
+        return (0);
+    }
+
+#if defined(_WIN32)
+    jobs->wake = CreateSemaphoreA(0, 0, 0x7fffffff, 0);
+    jobs->tls = TlsAlloc();
+    if (!jobs->wake || jobs->tls == 0xFFFFFFFF)
+    {
+        return (0);
+    }
+#else
+    if (sem_init(&jobs->wake, 0, 0) != 0 || pthread_key_create(&jobs->tls, 0) != 0)
+    {
+        return (0);
+    }
+#endif
+
+    for (i = 0; i < workers_count; ++i)
+    {
+        workers[i].top = 0;
+        workers[i].bottom = 0;
+        workers[i].system = jobs;
+        workers[i].index = i;
+        workers[i].random = 0x9E3779B9u * (unsigned int)(i + 1);
+        workers[i].executed = 0;
+        workers[i].stolen = 0;
+        workers[i].inline_runs = 0;
+    }
+
+    jobs->workers_count = workers_count;
+    SPEG_JOBS_TLS_SET(jobs, 1);
+
+    for (i = 1; i < workers_count; ++i)
+    {
+#if defined(_WIN32)
+        workers[i].thread = CreateThread(0, 0, speg_jobs_thread_main, &workers[i], 0, 0);
+        if (!workers[i].thread)
+        {
+            break;
+        }
+#else
+        if (pthread_create(&workers[i].thread, 0, speg_jobs_thread_main, &workers[i]) != 0)
+        {
+            break;
+        }
+#endif
+    }
+
+    /* Fewer threads than asked for, the deques of the missing ones are never filled */
+    jobs->workers_count = i;
+
+    return (jobs->workers_count);
+}
+
+/* Stops and joins the worker threads, the submitted jobs have to be waited for before */
+SPEG_JOBS_API SPEG_JOBS_INLINE void speg_jobs_shutdown(speg_jobs *jobs)
+{
+    int i;
+
+    if (jobs->workers_count <= 0)
+    {
+        return;
+    }
+
+    speg_atomic_store(&jobs->quit, 1);
+    speg_jobs_wake(jobs, jobs->workers_count);
+
+    for (i = 1; i < jobs->workers_count; ++i)
+    {
+#if defined(_WIN32)
+        WaitForSingleObject(jobs->workers[i].thread, INFINITE);
+        CloseHandle(jobs->workers[i].thread);
+#else
+        pthread_join(jobs->workers[i].thread, 0);
+#endif
+    }
+
+#if defined(_WIN32)
+    CloseHandle(jobs->wake);
+    TlsFree(jobs->tls);
+#else
+    sem_destroy(&jobs->wake);
+    pthread_key_delete(jobs->tls);
+#endif
+
+    jobs->workers_count = 0;
+}
+
+#endif /* SPEG_JOBS_THREADS */
+
+#endif /* SPEG_JOBS_H */
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+
+*/
@@ -0,0 +1,589 @@
+/* speg_occlusion.h - v0.1 - public domain software occlusion culling - nickscha 2025
+
+A C89 standard compliant, single header, nostdlib (no C Standard Library) CPU occlusion culler.
+
+Occluder meshes are rasterized into a small depth buffer (SPEG_OCCLUSION_WIDTH x SPEG_OCCLUSION_HEIGHT),
+4 pixels per step with SPEG_OCCLUSION_USE_SSE. Afterwards a hierarchical-Z pyramid is built where every
+texel holds the farthest depth of the 2x2 texels below it. A box is occluded if its nearest projected depth
+is behind the farthest occluder depth of every texel its screen rectangle covers, the level is chosen so
+that the rectangle spans only a few texels.
+
+The test is conservative so an occluded box is really hidden:
+ - pixels are covered by their center like on the GPU (a per triangle "fully covered" rule would leave holes
+   along the shared edges of a mesh), instead the screen rectangle of a tested box is grown by one pixel so
+   partially covered pixels at the silhouette of an occluder are always next to an uncovered one
+ - the written depth is the farthest depth of the triangle plane inside the pixel
+ - triangles touching the near plane are skipped as occluders, boxes touching it are always visible
+
+Depth is the OpenGL window depth (z / w * 0.5 + 0.5), 0 = near plane, 1 = far plane.
+
+USAGE
+
+  speg_occlusion_begin(&occlusion, projection_view.e); (column major, clears the depth buffer)
+  speg_occlusion_rasterize_mesh(&occlusion, model.e, vertices, vertices_count, indices, indices_count, cull_back_faces);
+  speg_occlusion_finish(&occlusion); (builds the hierarchical-Z pyramid)
+
+  if (!speg_occlusion_is_visible_aabb(&occlusion, center, extents)) -> skip the instance
+
+LICENSE
+
+  Placed in the public domain and also MIT licensed.
+  See end of file for detailed license information.
+
+*/
+#ifndef SPEG_OCCLUSION_H
+#define SPEG_OCCLUSION_H
+
+/* #############################################################################
+ * # COMPILER SETTINGS
+ * #############################################################################
+ */
+/* Check if using C99 or later (inline is supported) */
+#if __STDC_VERSION__ >= 199901L
+#define SPEG_OCCLUSION_INLINE inline
+#define SPEG_OCCLUSION_API extern
+#elif defined(__GNUC__) || defined(__clang__)
+#define SPEG_OCCLUSION_INLINE __inline__
+#define SPEG_OCCLUSION_API static
+#elif defined(_MSC_VER)
+#define SPEG_OCCLUSION_INLINE __inline
+#define SPEG_OCCLUSION_API static
+#else
+#define SPEG_OCCLUSION_INLINE
+#define SPEG_OCCLUSION_API static
+#endif
+
+#ifdef SPEG_OCCLUSION_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+#define SPEG_OCCLUSION_WIDTH 256 /* multiple of 4 << (SPEG_OCCLUSION_LEVELS - 1) */
+#define SPEG_OCCLUSION_HEIGHT 128
+#define SPEG_OCCLUSION_LEVELS 5         /* 256x128 down to 16x8 */
+#define SPEG_OCCLUSION_MAX_VERTICES 64  /* larger occluder meshes are skipped */
+#define SPEG_OCCLUSION_NEAR_W 0.0001f   /* clip space w below which a vertex counts as touching the near plane */
+#define SPEG_OCCLUSION_TEST_TEXELS 4    /* max texels per axis a box test reads */
+
+/* #############################################################################
+ * # DATA STRUCTURES
+ * #############################################################################
+ */
+typedef struct speg_occlusion
+{
+    float view_projection[16]; /* column major */
+
+    /* Level 0 is the depth buffer, level n has half the size of level n - 1 */
+    float depth[(SPEG_OCCLUSION_WIDTH * SPEG_OCCLUSION_HEIGHT * 4) / 3 + SPEG_OCCLUSION_LEVELS];
+    int level_offset[SPEG_OCCLUSION_LEVELS];
+    int level_width[SPEG_OCCLUSION_LEVELS];
+    int level_height[SPEG_OCCLUSION_LEVELS];
+
+    /* Pixel rectangle around everything written, boxes outside of it are visible without reading texels */
+    int covered_x0;
+    int covered_y0;
+    int covered_x1;
+    int covered_y1;
+
+    /* Stats of the current frame */
+    unsigned int occluders;
+    unsigned int triangles;
+    unsigned int tests;
+    unsigned int occluded;
+
+} speg_occlusion;
+
+/* #############################################################################
+ * # RASTERIZATION
+ * #############################################################################
+ */
+SPEG_OCCLUSION_API SPEG_OCCLUSION_INLINE float speg_occlusion_absf(float x)
+{
+    return (x < 0.0f ? -x : x);
+}
+
+/* Clears the depth buffer to the far plane and sets the matrix occluders and boxes are projected with */
+SPEG_OCCLUSION_API SPEG_OCCLUSION_INLINE void speg_occlusion_begin(speg_occlusion *occlusion, const float *view_projection)
+{
+    int offset = 0;
+    int i;
+
+    for (i = 0; i < 16; ++i)
+    {
+        occlusion->view_projection[i] = view_projection[i];
+    }
+
+    for (i = 0; i < SPEG_OCCLUSION_LEVELS; ++i)
+    {
+        occlusion->level_offset[i] = offset;
+        occlusion->level_width[i] = SPEG_OCCLUSION_WIDTH >> i;
+        occlusion->level_height[i] = SPEG_OCCLUSION_HEIGHT >> i;
+        offset += occlusion->level_width[i] * occlusion->level_height[i];
+    }
+
+    for (i = 0; i < SPEG_OCCLUSION_WIDTH * SPEG_OCCLUSION_HEIGHT; ++i)
+    {
+        occlusion->depth[i] = 1.0f;
+    }
+
+    occlusion->covered_x0 = SPEG_OCCLUSION_WIDTH;
+    occlusion->covered_y0 = SPEG_OCCLUSION_HEIGHT;
+    occlusion->covered_x1 = -1;
+    occlusion->covered_y1 = -1;
+
+    occlusion->occluders = 0;
+    occlusion->triangles = 0;
+    occlusion->tests = 0;
+    occlusion->occluded = 0;
+}
+
+/* Rasterizes one triangle given in screen space (x, y in pixels, z = window depth).
+ * Pixels whose center is covered are written with the farthest depth of the triangle plane inside the pixel.
+ * With cull_back_faces clockwise triangles (back faces of a closed counter clockwise mesh) are skipped,
+ * they are always behind the front faces. */
+SPEG_OCCLUSION_API SPEG_OCCLUSION_INLINE void speg_occlusion_rasterize_triangle(speg_occlusion *occlusion, const float *v0, const float *v1, const float *v2, int cull_back_faces)
+{
+    float area = (v1[0] - v0[0]) * (v2[1] - v0[1]) - (v1[1] - v0[1]) * (v2[0] - v0[0]);
+    float edge_a[3], edge_b[3], edge_c[3];
+    float dz_dx, dz_dy, z_max;
+    float min_x, max_x, min_y, max_y;
+    int x0, x1, y0, y1;
+    int x, y;
+
+    if (speg_occlusion_absf(area) < 1e-6f || (cull_back_faces && area < 0.0f))
+    {
+        return;
+    }
+
+    /* Counter clockwise in screen space, back and front faces are both valid occluders */
+    if (area < 0.0f)
+    {
+        const float *swap = v1;
+        v1 = v2;
+        v2 = swap;
+        area = -area;
+    }
+
+    /* E(x, y) = a * x + b * y + c >= 0 inside, the edges are (v1, v2), (v2, v0), (v0, v1) */
+    edge_a[0] = v1[1] - v2[1];
+    edge_b[0] = v2[0] - v1[0];
+    edge_a[1] = v2[1] - v0[1];
+    edge_b[1] = v0[0] - v2[0];
+    edge_a[2] = v0[1] - v1[1];
+    edge_b[2] = v1[0] - v0[0];
+    edge_c[0] = v1[0] * v2[1] - v1[1] * v2[0];
+    edge_c[1] = v2[0] * v0[1] - v2[1] * v0[0];
+    edge_c[2] = v0[0] * v1[1] - v0[1] * v1[0];
+
+    /* Depth plane z = z0 + dz_dx * (x - x0) + dz_dy * (y - y0), moved to the farthest point inside a pixel */
+    dz_dx = ((v1[2] - v0[2]) * (v2[1] - v0[1]) - (v2[2] - v0[2]) * (v1[1] - v0[1])) / area;
+    dz_dy = ((v2[2] - v0[2]) * (v1[0] - v0[0]) - (v1[2] - v0[2]) * (v2[0] - v0[0])) / area;
+    z_max = v0[2] > v1[2] ? (v0[2] > v2[2] ? v0[2] : v2[2]) : (v1[2] > v2[2] ? v1[2] : v2[2]);
+
+    min_x = v0[0] < v1[0] ? (v0[0] < v2[0] ? v0[0] : v2[0]) : (v1[0] < v2[0] ? v1[0] : v2[0]);
+    max_x = v0[0] > v1[0] ? (v0[0] > v2[0] ? v0[0] : v2[0]) : (v1[0] > v2[0] ? v1[0] : v2[0]);
+    min_y = v0[1] < v1[1] ? (v0[1] < v2[1] ? v0[1] : v2[1]) : (v1[1] < v2[1] ? v1[1] : v2[1]);
+    max_y = v0[1] > v1[1] ? (v0[1] > v2[1] ? v0[1] : v2[1]) : (v1[1] > v2[1] ? v1[1] : v2[1]);
+
+    /* Pixel rows and columns whose center can be inside, x is aligned down to a 4 pixel block */
+    x0 = min_x < 0.0f ? 0 : (int)min_x;
+    x1 = max_x >= (float)SPEG_OCCLUSION_WIDTH ? SPEG_OCCLUSION_WIDTH - 1 : (int)max_x;
+    y0 = min_y < 0.0f ? 0 : (int)min_y;
+    y1 = max_y >= (float)SPEG_OCCLUSION_HEIGHT ? SPEG_OCCLUSION_HEIGHT - 1 : (int)max_y;
+    x0 &= ~3;
+
+    if (x0 > x1 || y0 > y1)
+    {
+        return;
+    }
+
+    occlusion->triangles += 1;
+    occlusion->covered_x0 = x0 < occlusion->covered_x0 ? x0 : occlusion->covered_x0;
+    occlusion->covered_y0 = y0 < occlusion->covered_y0 ? y0 : occlusion->covered_y0;
+    occlusion->covered_x1 = x1 > occlusion->covered_x1 ? x1 : occlusion->covered_x1;
+    occlusion->covered_y1 = y1 > occlusion->covered_y1 ? y1 : occlusion->covered_y1;
+
+    for (y = y0; y <= y1; ++y)
+    {
+        float py = (float)y + 0.5f;
+        float *row = &occlusion->depth[y * SPEG_OCCLUSION_WIDTH];
+
+#ifdef SPEG_OCCLUSION_USE_SSE
+        __m128 step = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+        __m128 a0 = _mm_set1_ps(edge_a[0]);
+        __m128 a1 = _mm_set1_ps(edge_a[1]);
+        __m128 a2 = _mm_set1_ps(edge_a[2]);
+        __m128 row0 = _mm_set1_ps(edge_b[0] * py + edge_c[0]);
+        __m128 row1 = _mm_set1_ps(edge_b[1] * py + edge_c[1]);
+        __m128 row2 = _mm_set1_ps(edge_b[2] * py + edge_c[2]);
+        __m128 zx = _mm_set1_ps(dz_dx);
+        __m128 zrow = _mm_set1_ps(v0[2] + dz_dy * (py - v0[1]) - dz_dx * v0[0] + 0.5f * (speg_occlusion_absf(dz_dx) + speg_occlusion_absf(dz_dy)));
+        __m128 zlimit = _mm_set1_ps(z_max);
+        __m128 zero = _mm_setzero_ps();
+
+        for (x = x0; x <= x1; x += 4)
+        {
+            __m128 px = _mm_add_ps(_mm_set1_ps((float)x + 0.5f), step);
+            __m128 inside = _mm_and_ps(
+                _mm_and_ps(_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a0, px), row0), zero), _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a1, px), row1), zero)),
+                _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a2, px), row2), zero));
+
+            if (_mm_movemask_ps(inside))
+            {
+                __m128 z = _mm_min_ps(_mm_add_ps(_mm_mul_ps(zx, px), zrow), zlimit);
+                __m128 stored = _mm_loadu_ps(row + x);
+                __m128 nearer = _mm_min_ps(stored, z);
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, stored)));
+            }
+        }
+#else
+        for (x = x0; x <= x1; ++x)
+        {
+            float px = (float)x + 0.5f;
+
+            if (edge_a[0] * px + (edge_b[0] * py + edge_c[0]) >= 0.0f &&
+                edge_a[1] * px + (edge_b[1] * py + edge_c[1]) >= 0.0f &&
+                edge_a[2] * px + (edge_b[2] * py + edge_c[2]) >= 0.0f)
+            {
+                float z = dz_dx * px + (v0[2] + dz_dy * (py - v0[1]) - dz_dx * v0[0] + 0.5f * (speg_occlusion_absf(dz_dx) + speg_occlusion_absf(dz_dy)));
+                z = z < z_max ? z : z_max;
+                row[x] = z < row[x] ? z : row[x];
+            }
+        }
+#endif
+    }
+}
+
+/* Transforms the mesh with view_projection * model and rasterizes all its triangles.
+ * Returns 0 if the mesh was skipped (too many vertices). */
+SPEG_OCCLUSION_API SPEG_OCCLUSION_INLINE int speg_occlusion_rasterize_mesh(
+    speg_occlusion *occlusion,
+    const float *model,
+    const float *vertices, int vertices_count,
+    const unsigned int *indices, int indices_count,
+    int cull_back_faces)
+{
+    float screen[SPEG_OCCLUSION_MAX_VERTICES][3];
+    unsigned char clipped[SPEG_OCCLUSION_MAX_VERTICES];
+    float mvp[16];
+    const float *vp = occlusion->view_projection;
+    int i;
+
+    if (vertices_count > SPEG_OCCLUSION_MAX_VERTICES)
+    {
+        return (0);
+    }
+
+    /* Column major: mvp(row, col) = sum_k vp(row, k) * model(k, col) */
+    for (i = 0; i < 16; ++i)
+    {
+        int row = i % 4;
+        int col = i / 4;
+        mvp[i] = vp[0 * 4 + row] * model[col * 4 + 0] + vp[1 * 4 + row] * model[col * 4 + 1] +
+                 vp[2 * 4 + row] * model[col * 4 + 2] + vp[3 * 4 + row] * model[col * 4 + 3];
+    }
+
+    for (i = 0; i < vertices_count; ++i)
+    {
+        const float *v = &vertices[i * 3];
+        float cx = mvp[0] * v[0] + mvp[4] * v[1] + mvp[8] * v[2] + mvp[12];
+        float cy = mvp[1] * v[0] + mvp[5] * v[1] + mvp[9] * v[2] + mvp[13];
+        float cz = mvp[2] * v[0] + mvp[6] * v[1] + mvp[10] * v[2] + mvp[14];
+        float cw = mvp[3] * v[0] + mvp[7] * v[1] + mvp[11] * v[2] + mvp[15];
+
+        clipped[i] = (unsigned char)(cw < SPEG_OCCLUSION_NEAR_W || cz < -cw);
+
+        if (!clipped[i])
+        {
+            float w_inverse = 1.0f / cw;
+            screen[i][0] = (cx * w_inverse * 0.5f + 0.5f) * (float)SPEG_OCCLUSION_WIDTH;
+            screen[i][1] = (cy * w_inverse * 0.5f + 0.5f) * (float)SPEG_OCCLUSION_HEIGHT;
+            screen[i][2] = cz * w_inverse * 0.5f + 0.5f;
+        }
+    }
+
+    for (i = 0; i + 2 < indices_count; i += 3)
+    {
+        unsigned int i0 = indices[i + 0];
+        unsigned int i1 = indices[i + 1];
+        unsigned int i2 = indices[i + 2];
+
+        if (i0 >= (unsigned int)vertices_count || i1 >= (unsigned int)vertices_count || i2 >= (unsigned int)vertices_count ||
+            clipped[i0] || clipped[i1] || clipped[i2])
+        {
+            continue;
+        }
+
+        speg_occlusion_rasterize_triangle(occlusion, screen[i0], screen[i1], screen[i2], cull_back_faces);
+    }
+
+    occlusion->occluders += 1;
+
+    return (1);
+}
+
+/* Builds the hierarchical-Z levels, each texel is the farthest depth of its 2x2 texels of the level below */
+SPEG_OCCLUSION_API SPEG_OCCLUSION_INLINE void speg_occlusion_finish(speg_occlusion *occlusion)
+{
+    int level;
+
+    for (level = 1; level < SPEG_OCCLUSION_LEVELS; ++level)
+    {
+        const float *source = &occlusion->depth[occlusion->level_offset[level - 1]];
+        float *target = &occlusion->depth[occlusion->level_offset[level]];
+        int source_width = occlusion->level_width[level - 1];
+        int width = occlusion->level_width[level];
+        int height = occlusion->level_height[level];
+        int x, y;
+
+        for (y = 0; y < height; ++y)
+        {
+            const float *row0 = &source[(y * 2) * source_width];
+            const float *row1 = row0 + source_width;
+
+#ifdef SPEG_OCCLUSION_USE_SSE
+            for (x = 0; x + 4 <= width; x += 4)
+            {
+                /* 8 source texels per row, max of the pairs after the rows are combined */
+                __m128 lo = _mm_max_ps(_mm_loadu_ps(row0 + x * 2), _mm_loadu_ps(row1 + x * 2));
+                __m128 hi = _mm_max_ps(_mm_loadu_ps(row0 + x * 2 + 4), _mm_loadu_ps(row1 + x * 2 + 4));
+                __m128 even = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+                __m128 odd = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+                _mm_storeu_ps(target + y * width + x, _mm_max_ps(even, odd));
+            }
+#else
+            x = 0;
+#endif
+            for (; x < width; ++x)
+            {
+                float a = row0[x * 2] > row0[x * 2 + 1] ? row0[x * 2] : row0[x * 2 + 1];
+                float b = row1[x * 2] > row1[x * 2 + 1] ? row1[x * 2] : row1[x * 2 + 1];
+                target[y * width + x] = a > b ? a : b;
+            }
+        }
+    }
+}
+
+/* #############################################################################
+ * # OCCLUSION TEST
+ * #############################################################################
+ */
+
+/* Returns 0 if the box (center, half extents in world space) is hidden behind the rasterized occluders */
+SPEG_OCCLUSION_API SPEG_OCCLUSION_INLINE int speg_occlusion_is_visible_aabb(speg_occlusion *occlusion, const float *center, const float *extents)
+{
+    const float *vp = occlusion->view_projection;
+    float min_x, min_y, min_z;
+    float max_x, max_y;
+    int x0, x1, y0, y1;
+    int level;
+    int x, y;
+
+    /* The corners are center +- the three scaled box axes, in clip space that is 4 projected vectors */
+    float c[4], ax[4], ay[4], az[4];
+    int i;
+
+    occlusion->tests += 1;
+
+    if (occlusion->triangles == 0)
+    {
+        return (1);
+    }
+
+    for (i = 0; i < 4; ++i)
+    {
+        c[i] = vp[i] * center[0] + vp[4 + i] * center[1] + vp[8 + i] * center[2] + vp[12 + i];
+        ax[i] = vp[i] * extents[0];
+        ay[i] = vp[4 + i] * extents[1];
+        az[i] = vp[8 + i] * extents[2];
+    }
+
+#ifdef SPEG_OCCLUSION_USE_SSE
+    {
+        /* Corners 0..3 (-z) and 4..7 (+z), bit 0 = +x, bit 1 = +y */
+        __m128 sign_x = _mm_set_ps(1.0f, -1.0f, 1.0f, -1.0f);
+        __m128 sign_y = _mm_set_ps(1.0f, 1.0f, -1.0f, -1.0f);
+        __m128 near_w = _mm_set1_ps(SPEG_OCCLUSION_NEAR_W);
+        __m128 half = _mm_set1_ps(0.5f);
+        __m128 lo_x = _mm_set1_ps(3.402823466e+38f), lo_y = lo_x, lo_z = lo_x;
+        __m128 hi_x = _mm_set1_ps(-3.402823466e+38f), hi_y = hi_x;
+        float lanes[4];
+        int side;
+
+        for (side = 0; side < 2; ++side)
+        {
+            float sz = side ? 1.0f : -1.0f;
+            __m128 clip[4];
+            __m128 w_inverse;
+            __m128 sx, sy, sz_window;
+
+            for (i = 0; i < 4; ++i)
+            {
+                clip[i] = _mm_add_ps(_mm_set1_ps(c[i] + sz * az[i]),
+                                     _mm_add_ps(_mm_mul_ps(sign_x, _mm_set1_ps(ax[i])), _mm_mul_ps(sign_y, _mm_set1_ps(ay[i]))));
+            }
+
+            /* Touches the near plane */
+            if (_mm_movemask_ps(_mm_or_ps(_mm_cmplt_ps(clip[3], near_w), _mm_cmplt_ps(clip[2], _mm_sub_ps(_mm_setzero_ps(), clip[3])))))
+            {
+                return (1);
+            }
+
+            w_inverse = _mm_div_ps(_mm_set1_ps(1.0f), clip[3]);
+            sx = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(clip[0], w_inverse), half), half), _mm_set1_ps((float)SPEG_OCCLUSION_WIDTH));
+            sy = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(clip[1], w_inverse), half), half), _mm_set1_ps((float)SPEG_OCCLUSION_HEIGHT));
+            sz_window = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(clip[2], w_inverse), half), half);
+
+            lo_x = _mm_min_ps(lo_x, sx);
+            hi_x = _mm_max_ps(hi_x, sx);
+            lo_y = _mm_min_ps(lo_y, sy);
+            hi_y = _mm_max_ps(hi_y, sy);
+            lo_z = _mm_min_ps(lo_z, sz_window);
+        }
+
+        _mm_storeu_ps(lanes, lo_x);
+        min_x = lanes[0] < lanes[1] ? lanes[0] : lanes[1];
+        min_x = lanes[2] < min_x ? lanes[2] : min_x;
+        min_x = lanes[3] < min_x ? lanes[3] : min_x;
+        _mm_storeu_ps(lanes, lo_y);
+        min_y = lanes[0] < lanes[1] ? lanes[0] : lanes[1];
+        min_y = lanes[2] < min_y ? lanes[2] : min_y;
+        min_y = lanes[3] < min_y ? lanes[3] : min_y;
+        _mm_storeu_ps(lanes, lo_z);
+        min_z = lanes[0] < lanes[1] ? lanes[0] : lanes[1];
+        min_z = lanes[2] < min_z ? lanes[2] : min_z;
+        min_z = lanes[3] < min_z ? lanes[3] : min_z;
+        _mm_storeu_ps(lanes, hi_x);
+        max_x = lanes[0] > lanes[1] ? lanes[0] : lanes[1];
+        max_x = lanes[2] > max_x ? lanes[2] : max_x;
+        max_x = lanes[3] > max_x ? lanes[3] : max_x;
+        _mm_storeu_ps(lanes, hi_y);
+        max_y = lanes[0] > lanes[1] ? lanes[0] : lanes[1];
+        max_y = lanes[2] > max_y ? lanes[2] : max_y;
+        max_y = lanes[3] > max_y ? lanes[3] : max_y;
+    }
+#else
+    {
+        int corner;
+
+        min_x = min_y = min_z = 3.402823466e+38f;
+        max_x = max_y = -3.402823466e+38f;
+
+        for (corner = 0; corner < 8; ++corner)
+        {
+            float sx = (corner & 1) ? 1.0f : -1.0f;
+            float sy = (corner & 2) ? 1.0f : -1.0f;
+            float sz = (corner & 4) ? 1.0f : -1.0f;
+            float clip[4];
+            float w_inverse;
+            float px, py, pz;
+
+            for (i = 0; i < 4; ++i)
+            {
+                clip[i] = c[i] + sz * az[i] + (sx * ax[i] + sy * ay[i]);
+            }
+
+            if (clip[3] < SPEG_OCCLUSION_NEAR_W || clip[2] < -clip[3])
+            {
+                return (1); /* touches the near plane */
+            }
+
+            w_inverse = 1.0f / clip[3];
+            px = (clip[0] * w_inverse * 0.5f + 0.5f) * (float)SPEG_OCCLUSION_WIDTH;
+            py = (clip[1] * w_inverse * 0.5f + 0.5f) * (float)SPEG_OCCLUSION_HEIGHT;
+            pz = clip[2] * w_inverse * 0.5f + 0.5f;
+
+            min_x = px < min_x ? px : min_x;
+            max_x = px > max_x ? px : max_x;
+            min_y = py < min_y ? py : min_y;
+            max_y = py > max_y ? py : max_y;
+            min_z = pz < min_z ? pz : min_z;
+        }
+    }
+#endif
+
+    /* Screen rectangle grown by one pixel on each side, it has to be inside the area the occluders wrote to
+     * (this includes boxes reaching off screen) */
+    if (min_x - 1.0f < (float)occlusion->covered_x0 || min_y - 1.0f < (float)occlusion->covered_y0 ||
+        max_x + 1.0f >= (float)(occlusion->covered_x1 + 1) || max_y + 1.0f >= (float)(occlusion->covered_y1 + 1))
+    {
+        return (1);
+    }
+
+    x0 = (int)min_x - 1;
+    y0 = (int)min_y - 1;
+    x1 = (int)max_x + 1;
+    y1 = (int)max_y + 1;
+
+    /* The finest level where the rectangle spans only a few texels */
+    level = 0;
+    while (level + 1 < SPEG_OCCLUSION_LEVELS &&
+           ((x1 >> level) - (x0 >> level) >= SPEG_OCCLUSION_TEST_TEXELS || (y1 >> level) - (y0 >> level) >= SPEG_OCCLUSION_TEST_TEXELS))
+    {
+        ++level;
+    }
+
+    {
+        const float *texels = &occlusion->depth[occlusion->level_offset[level]];
+        int width = occlusion->level_width[level];
+
+        for (y = y0 >> level; y <= (y1 >> level); ++y)
+        {
+            for (x = x0 >> level; x <= (x1 >> level); ++x)
+            {
+                if (min_z <= texels[y * width + x])
+                {
+                    return (1);
+                }
+            }
+        }
+    }
+
+    occlusion->occluded += 1;
+
+    return (0);
+}
+
+#endif /* SPEG_OCCLUSION_H */
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+
+*/
@@ -0,0 +1,626 @@
+/* speg_profiler.h - v0.1 - public domain hierarchical zone profiler - nickscha 2025
+
+A C89 standard compliant, single header, nostdlib (no C Standard Library) frame profiler.
+Included by speg.h which provides bool, true and false.
+
+Zones are recorded as begin/end events (zone index + cycle count) into a fixed-capacity per frame event buffer.
+The profiler is part of speg_state and therefore lives in permanent memory which means the platform and the
+application record into the same buffer and the registered zones survive a code hot reload.
+
+When the frame ends the events are aggregated into per zone inclusive cycles (including nested zones) and
+exclusive cycles (without nested zones). The raw events of the last frame stay valid until the next frame begins.
+
+Completed frames can be appended to a Chrome Trace Event JSON (chrome://tracing, ui.perfetto.dev) which is written
+into a buffer preallocated by the platform, so capturing does not allocate or touch files while frames are measured.
+
+Recording a zone is a bounds check, two stores and an inline rdtsc for begin and end each so it can stay
+enabled in production builds. A zone costs its two counter reads plus a few cycles of bookkeeping, speg_bench
+reports both on the machine it runs on.
+
+USAGE
+
+  speg_profiler_frame_begin(&state->profiler, platform_perf_current_cycle_count);
+  {
+      unsigned int zone = speg_profiler_zone_register(&state->profiler, "render");
+      speg_profiler_begin(&state->profiler, zone);
+      render();
+      speg_profiler_end(&state->profiler, zone);
+  }
+  speg_profiler_frame_end(&state->profiler);
+
+  speg_profiler_trace_begin(&trace, buffer, buffer_size, cycles_per_microsecond);
+  speg_profiler_trace_frame(&trace, &state->profiler, frame_begin_microseconds); (after each frame_end)
+  speg_profiler_trace_thread(&trace, &state->profiler_submit, 2, "submit"); (a profiler of another thread)
+  speg_profiler_trace_end(&trace); (trace.buffer now holds trace.size bytes of JSON)
+
+LICENSE
+
+  Placed in the public domain and also MIT licensed.
+  See end of file for detailed license information.
+
+*/
+#ifndef SPEG_PROFILER_H
+#define SPEG_PROFILER_H
+
+/* #############################################################################
+ * # COMPILER SETTINGS
+ * #############################################################################
+ */
+/* Check if using C99 or later (inline is supported) */
+#if __STDC_VERSION__ >= 199901L
+#define SPEG_PROFILER_INLINE inline
+#define SPEG_PROFILER_API extern
+#elif defined(__GNUC__) || defined(__clang__)
+#define SPEG_PROFILER_INLINE __inline__
+#define SPEG_PROFILER_API static
+#elif defined(_MSC_VER)
+#define SPEG_PROFILER_INLINE __inline
+#define SPEG_PROFILER_API static
+#else
+#define SPEG_PROFILER_INLINE
+#define SPEG_PROFILER_API static
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+#define SPEG_PROFILER_MAX_EVENTS 8192 /* begin + end per zone */
+#define SPEG_PROFILER_MAX_ZONES 64    /* the last zone collects all names registered after the registry is full */
+#define SPEG_PROFILER_MAX_DEPTH 32    /* deeper nested zones are not aggregated */
+#define SPEG_PROFILER_NAME_LENGTH 64
+
+/* #############################################################################
+ * # DATA STRUCTURES
+ * #############################################################################
+ */
+typedef unsigned long (*speg_profiler_cycle_count)(void);
+
+typedef struct speg_profiler_event
+{
+    unsigned long cycles;
+    unsigned short zone;
+    unsigned short begin; /* 1 = zone begin, 0 = zone end */
+
+} speg_profiler_event;
+
+typedef struct speg_profiler_zone
+{
+    char name[SPEG_PROFILER_NAME_LENGTH];
+
+    /* Aggregated over the last completed frame */
+    unsigned long cycles_inclusive; /* including nested zones, recursive zones are counted once */
+    unsigned long cycles_exclusive; /* without nested zones */
+    unsigned int hits;
+
+} speg_profiler_zone;
+
+typedef struct speg_profiler
+{
+    speg_profiler_cycle_count cycle_count;
+
+    unsigned long frame_index;
+    unsigned long frame_cycles_begin;
+    unsigned long frame_cycles; /* Duration of the last completed frame */
+
+    unsigned int events_count;
+    unsigned int events_dropped; /* Events that did not fit into the buffer in the last frame */
+    speg_profiler_event events[SPEG_PROFILER_MAX_EVENTS];
+
+    unsigned int zones_count;
+    speg_profiler_zone zones[SPEG_PROFILER_MAX_ZONES];
+
+} speg_profiler;
+
+/* #############################################################################
+ * # ZONE RECORDING
+ * #############################################################################
+ */
+
+/* Reads the time stamp counter inline on x86 so a zone does not pay for a call through profiler->cycle_count.
+ * Begin, end and the frame bounds all use this read so the events share one time base. Other targets fall back
+ * to the counter passed to speg_profiler_frame_begin. */
+SPEG_PROFILER_API SPEG_PROFILER_INLINE unsigned long speg_profiler_cycles(speg_profiler *profiler)
+{
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    unsigned int low_part, high_part;
+    (void)profiler;
+    __asm__ __volatile__("rdtsc" : "=a"(low_part), "=d"(high_part));
+    return ((unsigned long)high_part << 31 << 1) | (unsigned long)low_part;
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    (void)profiler;
+    return ((unsigned long)__rdtsc());
+#else
+    return (profiler->cycle_count());
+#endif
+}
+
+/* Returns the zone index for name. Lookup is linear so call sites should cache the index (see PROFILE in speg.c).
+ * Names longer than SPEG_PROFILER_NAME_LENGTH - 1 are truncated. */
+SPEG_PROFILER_API SPEG_PROFILER_INLINE unsigned int speg_profiler_zone_register(speg_profiler *profiler, char *name)
+{
+    unsigned int i;
+    unsigned int index;
+    char *other = "(other)";
+
+    for (i = 0; i < profiler->zones_count; ++i)
+    {
+        char *a = profiler->zones[i].name;
+        char *b = name;
+        unsigned int n = 0;
+
+        while (n < SPEG_PROFILER_NAME_LENGTH - 1 && *a && *a == *b)
+        {
+            ++a;
+            ++b;
+            ++n;
+        }
+
+        if (*a == *b || (n == SPEG_PROFILER_NAME_LENGTH - 1 && *a == '\0'))
+        {
+            return (i);
+        }
+    }
+
+    if (profiler->zones_count == SPEG_PROFILER_MAX_ZONES - 1)
+    {
+        name = other;
+    }
+    else if (profiler->zones_count == SPEG_PROFILER_MAX_ZONES)
+    {
+        return (SPEG_PROFILER_MAX_ZONES - 1);
+    }
+
+    index = profiler->zones_count++;
+
+    for (i = 0; i < SPEG_PROFILER_NAME_LENGTH - 1 && name[i]; ++i)
+    {
+        profiler->zones[index].name[i] = name[i];
+    }
+    profiler->zones[index].name[i] = '\0';
+
+    return (index);
+}
+
+SPEG_PROFILER_API SPEG_PROFILER_INLINE void speg_profiler_begin(speg_profiler *profiler, unsigned int zone)
+{
+    unsigned int index = profiler->events_count;
+
+    if (index < SPEG_PROFILER_MAX_EVENTS)
+    {
+        speg_profiler_event *event = &profiler->events[index];
+        profiler->events_count = index + 1;
+        event->zone = (unsigned short)zone;
+        event->begin = 1;
+        event->cycles = speg_profiler_cycles(profiler);
+    }
+    else
+    {
+        profiler->events_dropped++;
+    }
+}
+
+SPEG_PROFILER_API SPEG_PROFILER_INLINE void speg_profiler_end(speg_profiler *profiler, unsigned int zone)
+{
+    unsigned long cycles = speg_profiler_cycles(profiler);
+    unsigned int index = profiler->events_count;
+
+    if (index < SPEG_PROFILER_MAX_EVENTS)
+    {
+        speg_profiler_event *event = &profiler->events[index];
+        profiler->events_count = index + 1;
+        event->zone = (unsigned short)zone;
+        event->begin = 0;
+        event->cycles = cycles;
+    }
+    else
+    {
+        profiler->events_dropped++;
+    }
+}
+
+/* #############################################################################
+ * # FRAME AGGREGATION
+ * #############################################################################
+ */
+SPEG_PROFILER_API SPEG_PROFILER_INLINE void speg_profiler_frame_begin(speg_profiler *profiler, speg_profiler_cycle_count cycle_count)
+{
+    profiler->cycle_count = cycle_count;
+    profiler->events_count = 0;
+    profiler->events_dropped = 0;
+    profiler->frame_cycles_begin = speg_profiler_cycles(profiler);
+}
+
+typedef struct speg_profiler_open_zone
+{
+    unsigned int zone;
+    unsigned long cycles_begin;
+    unsigned long cycles_children;
+
+} speg_profiler_open_zone;
+
+SPEG_PROFILER_API SPEG_PROFILER_INLINE void speg_profiler_close_zone(speg_profiler *profiler, speg_profiler_open_zone *stack, unsigned int *depth, unsigned char *open, unsigned long cycles_end)
+{
+    speg_profiler_open_zone *closed = &stack[--(*depth)];
+    speg_profiler_zone *zone = &profiler->zones[closed->zone];
+    unsigned long elapsed = cycles_end - closed->cycles_begin;
+
+    zone->cycles_exclusive += elapsed - closed->cycles_children;
+
+    /* Recursive zones only add the outermost duration */
+    if (--open[closed->zone] == 0)
+    {
+        zone->cycles_inclusive += elapsed;
+    }
+
+    if (*depth > 0)
+    {
+        stack[*depth - 1].cycles_children += elapsed;
+    }
+}
+
+/* Aggregates the recorded events into the zones. Zones without an end event (buffer full) are closed at the frame end */
+SPEG_PROFILER_API SPEG_PROFILER_INLINE void speg_profiler_frame_end(speg_profiler *profiler)
+{
+    speg_profiler_open_zone stack[SPEG_PROFILER_MAX_DEPTH];
+    unsigned char open[SPEG_PROFILER_MAX_ZONES];
+    unsigned int depth = 0;
+    unsigned int skipped = 0;
+    unsigned int i;
+    unsigned long frame_cycles_end = speg_profiler_cycles(profiler);
+
+    for (i = 0; i < SPEG_PROFILER_MAX_ZONES; ++i)
+    {
+        profiler->zones[i].cycles_inclusive = 0;
+        profiler->zones[i].cycles_exclusive = 0;
+        profiler->zones[i].hits = 0;
+        open[i] = 0;
+    }
+
+    for (i = 0; i < profiler->events_count; ++i)
+    {
+        speg_profiler_event *event = &profiler->events[i];
+
+        if (event->begin)
+        {
+            if (depth == SPEG_PROFILER_MAX_DEPTH)
+            {
+                skipped++;
+                continue;
+            }
+
+            stack[depth].zone = event->zone;
+            stack[depth].cycles_begin = event->cycles;
+            stack[depth].cycles_children = 0;
+            depth++;
+
+            open[event->zone]++;
+            profiler->zones[event->zone].hits++;
+        }
+        else if (skipped > 0)
+        {
+            skipped--;
+        }
+        else if (depth > 0)
+        {
+            speg_profiler_close_zone(profiler, stack, &depth, open, event->cycles);
+        }
+    }
+
+    while (depth > 0)
+    {
+        speg_profiler_close_zone(profiler, stack, &depth, open, frame_cycles_end);
+    }
+
+    profiler->frame_cycles = frame_cycles_end - profiler->frame_cycles_begin;
+    profiler->frame_index++;
+}
+
+/* #############################################################################
+ * # CHROME TRACE EXPORT
+ * #############################################################################
+ */
+#define SPEG_PROFILER_TRACE_FOOTER "\n]}\n"
+#define SPEG_PROFILER_TRACE_FOOTER_SIZE 4
+
+typedef struct speg_profiler_trace
+{
+    char *buffer;
+    unsigned long capacity;
+    unsigned long size;
+
+    double cycles_per_microsecond;
+    double origin_microseconds; /* frame begin of the first captured frame, becomes timestamp 0 */
+
+    unsigned long frames;
+    bool truncated; /* a frame did not fit into the buffer anymore, no further frames are captured */
+
+    double frame_begin;               /* last captured frame relative to the origin, places the frames of other threads */
+    unsigned long frame_cycles_begin; /* cycle counter at the begin of the last captured frame */
+    unsigned long threads;            /* bit per trace thread id that has its thread_name entry */
+
+} speg_profiler_trace;
+
+SPEG_PROFILER_API SPEG_PROFILER_INLINE void speg_profiler_trace_write(speg_profiler_trace *trace, char *text)
+{
+    /* The footer space is reserved in speg_profiler_trace_begin */
+    while (*text && trace->size + SPEG_PROFILER_TRACE_FOOTER_SIZE < trace->capacity)
+    {
+        trace->buffer[trace->size++] = *text++;
+    }
+
+    if (*text)
+    {
+        trace->truncated = true;
+    }
+}
+
+SPEG_PROFILER_API SPEG_PROFILER_INLINE void speg_profiler_trace_write_name(speg_profiler_trace *trace, char *name)
+{
+    char escaped[3] = {'\\', 0, 0};
+    char character[2] = {0, 0};
+
+    for (; *name; ++name)
+    {
+        if (*name == '"' || *name == '\\')
+        {
+            escaped[1] = *name;
+            speg_profiler_trace_write(trace, escaped);
+        }
+        else
+        {
+            character[0] = *name;
+            speg_profiler_trace_write(trace, character);
+        }
+    }
+}
+
+SPEG_PROFILER_API SPEG_PROFILER_INLINE void speg_profiler_trace_write_unsigned(speg_profiler_trace *trace, unsigned long value)
+{
+    char digits[24];
+    int i = 22;
+
+    digits[23] = '\0';
+
+    do
+    {
+        digits[i--] = (char)('0' + (value % 10));
+        value /= 10;
+    } while (value > 0);
+
+    speg_profiler_trace_write(trace, &digits[i + 1]);
+}
+
+/* Trace Event timestamps are microseconds, written with nanosecond precision */
+SPEG_PROFILER_API SPEG_PROFILER_INLINE void speg_profiler_trace_write_timestamp(speg_profiler_trace *trace, double microseconds)
+{
+    unsigned long whole;
+    unsigned long fraction;
+    char decimals[5];
+
+    microseconds = microseconds < 0.0 ? 0.0 : microseconds;
+    whole = (unsigned long)microseconds;
+    fraction = (unsigned long)((microseconds - (double)whole) * 1000.0 + 0.5);
+
+    if (fraction >= 1000)
+    {
+        whole++;
+        fraction -= 1000;
+    }
+
+    decimals[0] = '.';
+    decimals[1] = (char)('0' + fraction / 100);
+    decimals[2] = (char)('0' + (fraction / 10) % 10);
+    decimals[3] = (char)('0' + fraction % 10);
+    decimals[4] = '\0';
+
+    speg_profiler_trace_write_unsigned(trace, whole);
+    speg_profiler_trace_write(trace, decimals);
+}
+
+SPEG_PROFILER_API SPEG_PROFILER_INLINE void speg_profiler_trace_write_event(speg_profiler_trace *trace, char *name, bool begin, unsigned int tid, double microseconds)
+{
+    speg_profiler_trace_write(trace, ",\n{\"ph\":\"");
+    speg_profiler_trace_write(trace, begin ? "B" : "E");
+    speg_profiler_trace_write(trace, "\",\"pid\":1,\"tid\":");
+    speg_profiler_trace_write_unsigned(trace, tid);
+    speg_profiler_trace_write(trace, ",\"ts\":");
+    speg_profiler_trace_write_timestamp(trace, microseconds);
+
+    if (name)
+    {
+        speg_profiler_trace_write(trace, ",\"name\":\"");
+        speg_profiler_trace_write_name(trace, name);
+        speg_profiler_trace_write(trace, "\"");
+    }
+
+    speg_profiler_trace_write(trace, "}");
+}
+
+/* Names the trace thread tid once, tid is 1 to 31 */
+SPEG_PROFILER_API SPEG_PROFILER_INLINE void speg_profiler_trace_write_thread_name(speg_profiler_trace *trace, unsigned int tid, char *name)
+{
+    if (trace->threads & (1UL << tid))
+    {
+        return;
+    }
+
+    speg_profiler_trace_write(trace, trace->threads ? ",\n{\"ph\":\"M\",\"pid\":1,\"tid\":" : "{\"ph\":\"M\",\"pid\":1,\"tid\":");
+    speg_profiler_trace_write_unsigned(trace, tid);
+    speg_profiler_trace_write(trace, ",\"name\":\"thread_name\",\"args\":{\"name\":\"");
+    speg_profiler_trace_write_name(trace, name);
+    speg_profiler_trace_write(trace, "\"}}");
+
+    trace->threads |= 1UL << tid;
+}
+
+/* Writes the events of the last completed frame of profiler as trace thread tid, frame_begin is relative to the origin */
+SPEG_PROFILER_API SPEG_PROFILER_INLINE void speg_profiler_trace_write_frame(speg_profiler_trace *trace, speg_profiler *profiler, unsigned int tid, double frame_begin)
+{
+    unsigned long frame_cycles_end = profiler->frame_cycles_begin + profiler->frame_cycles;
+    unsigned int depth = 0;
+    unsigned int i;
+
+    speg_profiler_trace_write_event(trace, "frame", true, tid, frame_begin);
+
+    for (i = 0; i < profiler->events_count; ++i)
+    {
+        speg_profiler_event *event = &profiler->events[i];
+        double timestamp = frame_begin + (double)(event->cycles - profiler->frame_cycles_begin) / trace->cycles_per_microsecond;
+
+        if (event->begin)
+        {
+            depth++;
+            speg_profiler_trace_write_event(trace, profiler->zones[event->zone].name, true, tid, timestamp);
+        }
+        else if (depth > 0)
+        {
+            depth--;
+            speg_profiler_trace_write_event(trace, 0, false, tid, timestamp);
+        }
+    }
+
+    /* Zones left open by a full event buffer and the frame itself end with the frame */
+    for (depth++; depth > 0; --depth)
+    {
+        speg_profiler_trace_write_event(trace, 0, false, tid, frame_begin + (double)(frame_cycles_end - profiler->frame_cycles_begin) / trace->cycles_per_microsecond);
+    }
+}
+
+/* buffer must hold at least a few hundred bytes, cycles_per_microsecond converts the cycle counter into time */
+SPEG_PROFILER_API SPEG_PROFILER_INLINE void speg_profiler_trace_begin(speg_profiler_trace *trace, char *buffer, unsigned long capacity, double cycles_per_microsecond)
+{
+    trace->buffer = buffer;
+    trace->capacity = capacity;
+    trace->size = 0;
+    trace->cycles_per_microsecond = cycles_per_microsecond > 0.0 ? cycles_per_microsecond : 1.0;
+    trace->origin_microseconds = 0.0;
+    trace->frames = 0;
+    trace->truncated = capacity <= SPEG_PROFILER_TRACE_FOOTER_SIZE;
+    trace->frame_begin = 0.0;
+    trace->frame_cycles_begin = 0;
+    trace->threads = 0;
+
+    speg_profiler_trace_write(trace, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    speg_profiler_trace_write_thread_name(trace, 1, "main");
+}
+
+/* Appends the events of the last completed frame (call after speg_profiler_frame_end).
+ * frame_begin_microseconds is the wall clock time of speg_profiler_frame_begin, only cycle differences within
+ * a frame are used which keeps 32 bit cycle counters (unsigned long on win64) usable.
+ * Returns false if the frame did not fit, the frame is then dropped completely. */
+SPEG_PROFILER_API SPEG_PROFILER_INLINE bool speg_profiler_trace_frame(speg_profiler_trace *trace, speg_profiler *profiler, double frame_begin_microseconds)
+{
+    unsigned long size_before = trace->size;
+    double frame_begin;
+
+    if (trace->truncated)
+    {
+        return (false);
+    }
+
+    if (trace->frames == 0)
+    {
+        trace->origin_microseconds = frame_begin_microseconds;
+    }
+
+    frame_begin = frame_begin_microseconds - trace->origin_microseconds;
+
+    speg_profiler_trace_write_frame(trace, profiler, 1, frame_begin);
+
+    if (trace->truncated)
+    {
+        trace->size = size_before;
+        return (false);
+    }
+
+    trace->frame_begin = frame_begin;
+    trace->frame_cycles_begin = profiler->frame_cycles_begin;
+    trace->frames++;
+    return (true);
+}
+
+/* Appends the last completed frame of a profiler another thread recorded into during the frame of the last
+ * speg_profiler_trace_frame (e.g. speg_state.profiler_submit of pipelined frames) as trace thread tid (2 to 31).
+ * All profilers read the same cycle counter, so the frame is placed by its cycle distance to that frame.
+ * Returns false if the frame did not fit, the frame is then dropped completely. */
+SPEG_PROFILER_API SPEG_PROFILER_INLINE bool speg_profiler_trace_thread(speg_profiler_trace *trace, speg_profiler *profiler, unsigned int tid, char *thread_name)
+{
+    unsigned long size_before = trace->size;
+    unsigned long threads_before = trace->threads;
+
+    if (trace->truncated || trace->frames == 0)
+    {
+        return (false);
+    }
+
+    speg_profiler_trace_write_thread_name(trace, tid, thread_name);
+    speg_profiler_trace_write_frame(trace, profiler, tid, trace->frame_begin + (double)(profiler->frame_cycles_begin - trace->frame_cycles_begin) / trace->cycles_per_microsecond);
+
+    if (trace->truncated)
+    {
+        trace->size = size_before;
+        trace->threads = threads_before;
+        return (false);
+    }
+
+    return (true);
+}
+
+/* Closes the JSON document, returns the number of bytes in trace->buffer */
+SPEG_PROFILER_API SPEG_PROFILER_INLINE unsigned long speg_profiler_trace_end(speg_profiler_trace *trace)
+{
+    char *footer = SPEG_PROFILER_TRACE_FOOTER;
+
+    while (*footer && trace->size < trace->capacity)
+    {
+        trace->buffer[trace->size++] = *footer++;
+    }
+
+    return (trace->size);
+}
+
+#endif /* SPEG_PROFILER_H */
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+
+*/
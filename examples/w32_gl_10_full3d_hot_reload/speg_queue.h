@@ -0,0 +1,331 @@
+/* speg_queue.h - v0.1 - public domain render queue with 64 bit sort keys - nickscha 2025
+
+A C89 standard compliant, single header, nostdlib (no C Standard Library) render queue.
+
+Every submission (an instance or a prebuilt draw call) carries a 64 bit key and an index into the data of the
+caller. Once per frame the keys are radix sorted (LSD, 8 bits per pass, passes over a byte all keys share are
+skipped) and the sorted queue is walked in batches: neighbouring instance submissions whose keys only differ in
+depth share mesh and render state and become one instanced draw. Sorting is stable, submissions with equal keys
+(e.g. 2D overlays at depth 0) keep their submission order.
+
+Key layout, most significant bit first:
+
+  63..60  layer       draw order of whole passes (world, gui, text, ...)
+      59  2d          depth test off, orthographic projection
+      58  no culling  face culling disabled
+  57..54  program     shader, the instance format
+  53..42  mesh        index into the mesh table of the caller (4096 meshes)
+      41  prebuilt    a whole draw call, never merged with other submissions
+  40..32  reserved
+  31..0   depth       view depth as float bits (positive floats sort like integers), front to back
+
+All memory is provided by the caller, nothing is allocated.
+
+USAGE
+
+  speg_queue_init(&queue, items, scratch, capacity);
+
+  speg_queue_clear(&queue);
+  speg_queue_push(&queue, speg_queue_key_make(layer, is_2d, culling, program, mesh, 0, depth), index);
+  speg_queue_sort(&queue);
+
+  for (first = 0; first < queue.count; first = end)
+  {
+    end = speg_queue_batch_end(&queue, first);
+    (draw the submissions queue.items[first .. end - 1] as one instanced draw)
+  }
+
+  speg_queue_pass_end(&queue, first) groups the batches of all meshes with the same state for one multi draw.
+
+LICENSE
+
+  Placed in the public domain and also MIT licensed.
+  See end of file for detailed license information.
+
+*/
+#ifndef SPEG_QUEUE_H
+#define SPEG_QUEUE_H
+
+/* #############################################################################
+ * # COMPILER SETTINGS
+ * #############################################################################
+ */
+/* Check if using C99 or later (inline is supported) */
+#if __STDC_VERSION__ >= 199901L
+#define SPEG_QUEUE_INLINE inline
+#define SPEG_QUEUE_API extern
+#elif defined(__GNUC__) || defined(__clang__)
+#define SPEG_QUEUE_INLINE __inline__
+#define SPEG_QUEUE_API static
+#elif defined(_MSC_VER)
+#define SPEG_QUEUE_INLINE __inline
+#define SPEG_QUEUE_API static
+#else
+#define SPEG_QUEUE_INLINE
+#define SPEG_QUEUE_API static
+#endif
+
+/* C89 has no 64 bit integer type, __extension__ keeps -pedantic quiet */
+#if defined(__GNUC__) || defined(__clang__)
+__extension__ typedef unsigned long long speg_queue_key;
+#elif defined(_MSC_VER)
+typedef unsigned __int64 speg_queue_key;
+#else
+typedef unsigned long long speg_queue_key;
+#endif
+
+#define SPEG_QUEUE_SHIFT_LAYER 60
+#define SPEG_QUEUE_SHIFT_2D 59
+#define SPEG_QUEUE_SHIFT_NO_CULLING 58
+#define SPEG_QUEUE_SHIFT_PROGRAM 54
+#define SPEG_QUEUE_SHIFT_MESH 42
+#define SPEG_QUEUE_SHIFT_PREBUILT 41
+#define SPEG_QUEUE_SHIFT_STATE 32 /* everything above is render state, below is depth */
+
+#define SPEG_QUEUE_MAX_LAYERS 16
+#define SPEG_QUEUE_MAX_PROGRAMS 16
+#define SPEG_QUEUE_MAX_MESHES 4096
+
+/* #############################################################################
+ * # DATA STRUCTURES
+ * #############################################################################
+ */
+typedef struct speg_queue_item
+{
+    speg_queue_key key;
+    unsigned int index; /* submission data of the caller */
+
+} speg_queue_item;
+
+typedef struct speg_queue
+{
+    speg_queue_item *items;   /* sorted after speg_queue_sort */
+    speg_queue_item *scratch; /* radix sort ping pong buffer, same capacity */
+    unsigned int count;
+    unsigned int capacity;
+    unsigned int dropped; /* pushes beyond the capacity since the last clear */
+
+} speg_queue;
+
+/* #############################################################################
+ * # FUNCTIONS
+ * #############################################################################
+ */
+SPEG_QUEUE_API SPEG_QUEUE_INLINE void speg_queue_init(speg_queue *queue, speg_queue_item *items, speg_queue_item *scratch, unsigned int capacity)
+{
+    queue->items = items;
+    queue->scratch = scratch;
+    queue->count = 0;
+    queue->capacity = capacity;
+    queue->dropped = 0;
+}
+
+SPEG_QUEUE_API SPEG_QUEUE_INLINE void speg_queue_clear(speg_queue *queue)
+{
+    queue->count = 0;
+    queue->dropped = 0;
+}
+
+/* Depth as sortable bits, negative depths (behind the camera) and NaN sort first */
+SPEG_QUEUE_API SPEG_QUEUE_INLINE unsigned int speg_queue_depth_bits(float depth)
+{
+    union
+    {
+        float f;
+        unsigned int u;
+    } bits;
+
+    bits.f = depth;
+
+    return ((bits.u & 0x80000000u) || bits.u > 0x7F800000u ? 0u : bits.u);
+}
+
+SPEG_QUEUE_API SPEG_QUEUE_INLINE speg_queue_key speg_queue_key_make(unsigned int layer, int is_2d, int culling, unsigned int program, unsigned int mesh, int prebuilt, float depth)
+{
+    return (((speg_queue_key)(layer & (SPEG_QUEUE_MAX_LAYERS - 1)) << SPEG_QUEUE_SHIFT_LAYER) |
+            ((speg_queue_key)(is_2d != 0) << SPEG_QUEUE_SHIFT_2D) |
+            ((speg_queue_key)(culling == 0) << SPEG_QUEUE_SHIFT_NO_CULLING) |
+            ((speg_queue_key)(program & (SPEG_QUEUE_MAX_PROGRAMS - 1)) << SPEG_QUEUE_SHIFT_PROGRAM) |
+            ((speg_queue_key)(mesh & (SPEG_QUEUE_MAX_MESHES - 1)) << SPEG_QUEUE_SHIFT_MESH) |
+            ((speg_queue_key)(prebuilt != 0) << SPEG_QUEUE_SHIFT_PREBUILT) |
+            (speg_queue_key)speg_queue_depth_bits(depth));
+}
+
+SPEG_QUEUE_API SPEG_QUEUE_INLINE unsigned int speg_queue_key_mesh(speg_queue_key key)
+{
+    return ((unsigned int)(key >> SPEG_QUEUE_SHIFT_MESH) & (SPEG_QUEUE_MAX_MESHES - 1));
+}
+
+SPEG_QUEUE_API SPEG_QUEUE_INLINE int speg_queue_key_prebuilt(speg_queue_key key)
+{
+    return ((int)(key >> SPEG_QUEUE_SHIFT_PREBUILT) & 1);
+}
+
+/* Returns 0 (and counts the submission as dropped) when the queue is full */
+SPEG_QUEUE_API SPEG_QUEUE_INLINE int speg_queue_push(speg_queue *queue, speg_queue_key key, unsigned int index)
+{
+    speg_queue_item *item;
+
+    if (queue->count == queue->capacity)
+    {
+        queue->dropped++;
+        return (0);
+    }
+
+    item = &queue->items[queue->count++];
+    item->key = key;
+    item->index = index;
+
+    return (1);
+}
+
+/* Stable LSD radix sort by key, one histogram pass for all 8 digits */
+SPEG_QUEUE_API SPEG_QUEUE_INLINE void speg_queue_sort(speg_queue *queue)
+{
+    unsigned int histograms[8][256];
+    speg_queue_item *src = queue->items;
+    speg_queue_item *dst = queue->scratch;
+    unsigned int count = queue->count;
+    unsigned int i;
+    unsigned int d;
+
+    if (count < 2)
+    {
+        return;
+    }
+
+    for (d = 0; d < 8; ++d)
+    {
+        for (i = 0; i < 256; ++i)
+        {
+            histograms[d][i] = 0;
+        }
+    }
+
+    for (i = 0; i < count; ++i)
+    {
+        speg_queue_key key = src[i].key;
+
+        for (d = 0; d < 8; ++d)
+        {
+            histograms[d][(unsigned int)(key >> (d * 8)) & 0xFF]++;
+        }
+    }
+
+    for (d = 0; d < 8; ++d)
+    {
+        unsigned int *histogram = histograms[d];
+        unsigned int offset = 0;
+        speg_queue_item *tmp;
+
+        /* All keys share this byte */
+        if (histogram[(unsigned int)(src[0].key >> (d * 8)) & 0xFF] == count)
+        {
+            continue;
+        }
+
+        for (i = 0; i < 256; ++i)
+        {
+            unsigned int bucket = histogram[i];
+            histogram[i] = offset;
+            offset += bucket;
+        }
+
+        for (i = 0; i < count; ++i)
+        {
+            dst[histogram[(unsigned int)(src[i].key >> (d * 8)) & 0xFF]++] = src[i];
+        }
+
+        tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    /* The sorted items may have ended up in the scratch buffer */
+    queue->items = src;
+    queue->scratch = dst;
+}
+
+/* End of the batch starting at first: the following instance submissions with the same render state */
+SPEG_QUEUE_API SPEG_QUEUE_INLINE unsigned int speg_queue_batch_end(const speg_queue *queue, unsigned int first)
+{
+    speg_queue_key state = queue->items[first].key >> SPEG_QUEUE_SHIFT_STATE;
+    unsigned int end = first + 1;
+
+    if (speg_queue_key_prebuilt(queue->items[first].key))
+    {
+        return (end);
+    }
+
+    while (end < queue->count && (queue->items[end].key >> SPEG_QUEUE_SHIFT_STATE) == state)
+    {
+        ++end;
+    }
+
+    return (end);
+}
+
+/* End of the pass starting at first: the following instance submissions with the same layer, 2D, culling and
+ * program and any mesh, drawn together by one multi draw indirect. A prebuilt item is a pass of its own */
+SPEG_QUEUE_API SPEG_QUEUE_INLINE unsigned int speg_queue_pass_end(const speg_queue *queue, unsigned int first)
+{
+    speg_queue_key pass = queue->items[first].key >> SPEG_QUEUE_SHIFT_PROGRAM;
+    unsigned int end = first + 1;
+
+    if (speg_queue_key_prebuilt(queue->items[first].key))
+    {
+        return (end);
+    }
+
+    while (end < queue->count && (queue->items[end].key >> SPEG_QUEUE_SHIFT_PROGRAM) == pass && !speg_queue_key_prebuilt(queue->items[end].key))
+    {
+        ++end;
+    }
+
+    return (end);
+}
+
+#endif /* SPEG_QUEUE_H */
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+
+*/
@@ -0,0 +1,329 @@
+/* speg_ring.h - v0.1 - public domain streaming ring buffer with fences - nickscha 2025
+
+A C89 standard compliant, single header, nostdlib (no C Standard Library) ring allocator for per frame GPU data.
+
+The platform maps one buffer persistently (glBufferStorage + glMapBufferRange with GL_MAP_PERSISTENT_BIT) and the
+application writes the instance data of a frame straight into it, so nothing is uploaded and the driver never has
+to reallocate buffer storage. Every frame ends with a fence behind the draws that read its data. Before an
+allocation reaches memory of an earlier frame the ring waits for the fence of that frame. At most SPEG_RING_FRAMES
+frames use the ring at the same time (triple buffering): the one the CPU writes and two the GPU may still read.
+
+Fences are inserted, polled, waited for and released through the speg_ring_fences callbacks (glFenceSync,
+glClientWaitSync and glDeleteSync on win32, a simulated GPU in the headless platform and in speg_bench).
+
+Allocations never wrap around the end of the buffer (attribute arrays have to be contiguous), an allocation that
+does not fit the rest of the buffer starts at offset 0. Positions count bytes modulo 2^32 and are only compared by
+their distance, the capacity has to be a power of two so the buffer offset is the position masked.
+
+USAGE
+
+  speg_ring_init(&ring, mapped_memory, capacity, &fences);
+
+  speg_ring_begin_frame(&ring);
+  data = speg_ring_alloc(&ring, size, 16, &position);    (write, then draw from speg_ring_offset(&ring, position))
+  speg_ring_end_frame(&ring);                            (after the draws of the frame were submitted)
+
+LICENSE
+
+  Placed in the public domain and also MIT licensed.
+  See end of file for detailed license information.
+
+*/
+#ifndef SPEG_RING_H
+#define SPEG_RING_H
+
+/* #############################################################################
+ * # COMPILER SETTINGS
+ * #############################################################################
+ */
+/* Check if using C99 or later (inline is supported) */
+#if __STDC_VERSION__ >= 199901L
+#define SPEG_RING_INLINE inline
+#define SPEG_RING_API extern
+#elif defined(__GNUC__) || defined(__clang__)
+#define SPEG_RING_INLINE __inline__
+#define SPEG_RING_API static
+#elif defined(_MSC_VER)
+#define SPEG_RING_INLINE __inline
+#define SPEG_RING_API static
+#else
+#define SPEG_RING_INLINE
+#define SPEG_RING_API static
+#endif
+
+#define SPEG_RING_FRAMES 3 /* frames whose data can be alive at the same time */
+
+/* #############################################################################
+ * # DATA STRUCTURES
+ * #############################################################################
+ */
+typedef void *(*speg_ring_fence_insert)(void *user);              /* fence behind all commands submitted so far */
+typedef int (*speg_ring_fence_signaled)(void *user, void *fence); /* non blocking, 1 when the GPU passed the fence */
+typedef void (*speg_ring_fence_wait)(void *user, void *fence);    /* blocks until the GPU passed the fence */
+typedef void (*speg_ring_fence_release)(void *user, void *fence);
+
+typedef struct speg_ring_fences
+{
+    speg_ring_fence_insert insert;
+    speg_ring_fence_signaled signaled;
+    speg_ring_fence_wait wait;
+    speg_ring_fence_release release;
+    void *user;
+
+} speg_ring_fences;
+
+typedef struct speg_ring_frame
+{
+    void *fence;
+    unsigned int begin; /* oldest position the draws of the frame read */
+
+} speg_ring_frame;
+
+typedef struct speg_ring
+{
+    unsigned char *memory;
+    unsigned int capacity; /* power of two */
+    unsigned int head;     /* position of the next allocation */
+    unsigned int begin;    /* oldest position the open frame reads */
+
+    speg_ring_frame frames[SPEG_RING_FRAMES]; /* fenced frames, oldest first */
+    int frames_first;
+    int frames_count;
+
+    speg_ring_fences fences;
+
+    /* Statistics */
+    unsigned long frames_total;
+    unsigned long waits; /* blocking fence waits, the CPU caught up with the GPU */
+    unsigned long wraps;
+    unsigned long bytes; /* allocated including alignment and wrap padding */
+
+} speg_ring;
+
+/* #############################################################################
+ * # FUNCTIONS
+ * #############################################################################
+ */
+/* Returns 0 when the capacity is not a power of two */
+SPEG_RING_API SPEG_RING_INLINE int speg_ring_init(speg_ring *ring, void *memory, unsigned int capacity, const speg_ring_fences *fences)
+{
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0)
+    {
+        return (0);
+    }
+
+    ring->memory = (unsigned char *)memory;
+    ring->capacity = capacity;
+    ring->head = 0;
+    ring->begin = 0;
+    ring->frames_first = 0;
+    ring->frames_count = 0;
+    ring->fences.insert = fences->insert;
+    ring->fences.signaled = fences->signaled;
+    ring->fences.wait = fences->wait;
+    ring->fences.release = fences->release;
+    ring->fences.user = fences->user;
+    ring->frames_total = 0;
+    ring->waits = 0;
+    ring->wraps = 0;
+    ring->bytes = 0;
+
+    return (1);
+}
+
+/* Byte offset of a position in the buffer */
+SPEG_RING_API SPEG_RING_INLINE unsigned int speg_ring_offset(const speg_ring *ring, unsigned int position)
+{
+    return (position & (ring->capacity - 1));
+}
+
+/* Oldest position still read by the open frame or a frame in flight */
+SPEG_RING_API SPEG_RING_INLINE unsigned int speg_ring_tail(const speg_ring *ring)
+{
+    unsigned int tail = ring->begin;
+    int i;
+
+    for (i = 0; i < ring->frames_count; ++i)
+    {
+        unsigned int begin = ring->frames[(ring->frames_first + i) % SPEG_RING_FRAMES].begin;
+
+        if (ring->head - begin > ring->head - tail)
+        {
+            tail = begin;
+        }
+    }
+
+    return (tail);
+}
+
+/* Releases the oldest fenced frame. Without block it is kept while the GPU still reads it. Returns 0 if nothing was released */
+SPEG_RING_API SPEG_RING_INLINE int speg_ring_retire(speg_ring *ring, int block)
+{
+    speg_ring_frame *frame;
+
+    if (ring->frames_count == 0)
+    {
+        return (0);
+    }
+
+    frame = &ring->frames[ring->frames_first];
+
+    if (!ring->fences.signaled(ring->fences.user, frame->fence))
+    {
+        if (!block)
+        {
+            return (0);
+        }
+
+        ring->fences.wait(ring->fences.user, frame->fence);
+        ring->waits++;
+    }
+
+    ring->fences.release(ring->fences.user, frame->fence);
+    ring->frames_first = (ring->frames_first + 1) % SPEG_RING_FRAMES;
+    ring->frames_count--;
+
+    return (1);
+}
+
+SPEG_RING_API SPEG_RING_INLINE void speg_ring_begin_frame(speg_ring *ring)
+{
+    /* Release what the GPU already finished */
+    while (speg_ring_retire(ring, 0))
+    {
+    }
+
+    /* Triple buffering, the new frame and SPEG_RING_FRAMES - 1 frames in flight */
+    while (ring->frames_count > SPEG_RING_FRAMES - 1)
+    {
+        speg_ring_retire(ring, 1);
+    }
+
+    ring->begin = ring->head;
+}
+
+/* Reserves size bytes for the open frame, waits for the GPU if the memory is still in use.
+ * Returns 0 when size does not fit next to the data of the open frame itself. Alignment has to be a power of two */
+SPEG_RING_API SPEG_RING_INLINE void *speg_ring_alloc(speg_ring *ring, unsigned int size, unsigned int alignment, unsigned int *position)
+{
+    unsigned int mask = ring->capacity - 1;
+    unsigned int start;
+    int wrapped;
+
+    if (size > ring->capacity || alignment > ring->capacity)
+    {
+        return (0);
+    }
+
+    for (;;)
+    {
+        start = (ring->head + alignment - 1) & ~(alignment - 1);
+        wrapped = (start & mask) + size > ring->capacity;
+
+        if (wrapped)
+        {
+            start += ring->capacity - (start & mask);
+        }
+
+        /* Everything from the oldest live position up to the end of the allocation has to fit the buffer */
+        if (start + size - speg_ring_tail(ring) <= ring->capacity)
+        {
+            break;
+        }
+
+        if (!speg_ring_retire(ring, 1))
+        {
+            return (0);
+        }
+    }
+
+    ring->wraps += (unsigned long)wrapped;
+    ring->bytes += (unsigned long)(start + size - ring->head);
+    ring->head = start + size;
+
+    *position = start;
+
+    return (ring->memory + (start & mask));
+}
+
+/* The open frame draws data allocated in an earlier frame again (e.g. a paused simulation redraws the last frame).
+ * Keeps it alive until the fence of the open frame. The position must not have been released in between */
+SPEG_RING_API SPEG_RING_INLINE void speg_ring_reuse(speg_ring *ring, unsigned int position)
+{
+    if (ring->head - position > ring->head - ring->begin)
+    {
+        ring->begin = position;
+    }
+}
+
+/* Fences the data of the open frame, call after its draws were submitted */
+SPEG_RING_API SPEG_RING_INLINE void speg_ring_end_frame(speg_ring *ring)
+{
+    speg_ring_frame *frame;
+
+    if (ring->frames_count == SPEG_RING_FRAMES)
+    {
+        speg_ring_retire(ring, 1);
+    }
+
+    frame = &ring->frames[(ring->frames_first + ring->frames_count) % SPEG_RING_FRAMES];
+    frame->fence = ring->fences.insert(ring->fences.user);
+    frame->begin = ring->begin;
+    ring->frames_count++;
+    ring->frames_total++;
+
+    ring->begin = ring->head;
+}
+
+/* Waits for and releases all frames in flight (before the buffer is unmapped) */
+SPEG_RING_API SPEG_RING_INLINE void speg_ring_finish(speg_ring *ring)
+{
+    while (speg_ring_retire(ring, 1))
+    {
+    }
+}
+
+#endif /* SPEG_RING_H */
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+
+*/
@@ -0,0 +1,250 @@
+/* speg_scene.h - v0.1 - public domain transformation hierarchy with cached world matrices - nickscha 2025
+
+A C89 standard compliant, single header, nostdlib (no C Standard Library) scene graph over vm.h transformations.
+
+vm_transformation_matrix follows the parent pointers and rebuilds the matrix of every ancestor on each call, so
+a hierarchy of depth d costs O(d) matrix chains per node and O(d^2) along a single branch. The scene graph keeps
+the nodes in flat arrays in topological order (the parent of a node always has a smaller index, -1 for roots)
+together with the cached local matrix (translate * rotate * scale) and world matrix (parent world * local).
+
+Setting the position, rotation or scale of a node marks its local matrix dirty. speg_scene_update is one linear
+pass from the first dirty node to the end: a node rebuilds its local matrix when it is dirty and its world matrix
+when it is dirty or the world matrix of its parent changed in the same pass. Parents are always visited before
+their children, so only the dirty subtrees are recomputed and every matrix is built at most once per update.
+The results are identical to vm_transformation_matrix on the same hierarchy.
+
+vm.h has to be included before this file. All memory is provided by the caller, nothing is allocated.
+
+USAGE
+
+  speg_scene_init(&scene, locals, worlds, positions, rotations, scales, parents, flags, capacity);
+
+  root = speg_scene_add(&scene, -1, position, rotation, scale);
+  child = speg_scene_add(&scene, root, position, rotation, scale);
+
+  speg_scene_set_rotation(&scene, root, rotation);
+  speg_scene_update(&scene);
+  (use scene.worlds[child])
+
+LICENSE
+
+  Placed in the public domain and also MIT licensed.
+  See end of file for detailed license information.
+
+*/
+#ifndef SPEG_SCENE_H
+#define SPEG_SCENE_H
+
+/* #############################################################################
+ * # COMPILER SETTINGS
+ * #############################################################################
+ */
+/* Check if using C99 or later (inline is supported) */
+#if __STDC_VERSION__ >= 199901L
+#define SPEG_SCENE_INLINE inline
+#define SPEG_SCENE_API extern
+#elif defined(__GNUC__) || defined(__clang__)
+#define SPEG_SCENE_INLINE __inline__
+#define SPEG_SCENE_API static
+#elif defined(_MSC_VER)
+#define SPEG_SCENE_INLINE __inline
+#define SPEG_SCENE_API static
+#else
+#define SPEG_SCENE_INLINE
+#define SPEG_SCENE_API static
+#endif
+
+#define SPEG_SCENE_DIRTY_LOCAL 1   /* position, rotation or scale changed since the last update */
+#define SPEG_SCENE_WORLD_CHANGED 2 /* world matrix rebuilt by the last update (read by the children) */
+
+/* #############################################################################
+ * # DATA STRUCTURES
+ * #############################################################################
+ */
+typedef struct speg_scene
+{
+    m4x4 *locals; /* translate(position) * rotate(rotation) * scale(scale) */
+    m4x4 *worlds; /* worlds[parent] * locals, locals for roots */
+
+    v3 *positions;
+    quat *rotations;
+    v3 *scales;
+    int *parents;         /* parent index (always smaller than the node index), -1 for roots */
+    unsigned char *flags; /* SPEG_SCENE_DIRTY_LOCAL | SPEG_SCENE_WORLD_CHANGED */
+
+    int count;
+    int capacity;
+    int first_dirty; /* smallest dirty node, count if nothing is dirty */
+
+    int locals_updated; /* local matrices rebuilt by the last update */
+    int worlds_updated; /* world matrices rebuilt by the last update */
+
+} speg_scene;
+
+/* #############################################################################
+ * # FUNCTIONS
+ * #############################################################################
+ */
+/* Every array holds capacity elements */
+SPEG_SCENE_API SPEG_SCENE_INLINE void speg_scene_init(speg_scene *scene, m4x4 *locals, m4x4 *worlds, v3 *positions, quat *rotations, v3 *scales, int *parents, unsigned char *flags, int capacity)
+{
+    scene->locals = locals;
+    scene->worlds = worlds;
+    scene->positions = positions;
+    scene->rotations = rotations;
+    scene->scales = scales;
+    scene->parents = parents;
+    scene->flags = flags;
+
+    scene->count = 0;
+    scene->capacity = capacity;
+    scene->first_dirty = 0;
+    scene->locals_updated = 0;
+    scene->worlds_updated = 0;
+}
+
+SPEG_SCENE_API SPEG_SCENE_INLINE void speg_scene_mark(speg_scene *scene, int node)
+{
+    scene->flags[node] |= SPEG_SCENE_DIRTY_LOCAL;
+    scene->first_dirty = node < scene->first_dirty ? node : scene->first_dirty;
+}
+
+/* Appends a node below parent (-1 for a root) and returns its index, -1 when the scene is full. The parent has
+ * to be added before its children, which keeps the arrays in topological order. */
+SPEG_SCENE_API SPEG_SCENE_INLINE int speg_scene_add(speg_scene *scene, int parent, v3 position, quat rotation, v3 scale)
+{
+    int node = scene->count;
+
+    if (node >= scene->capacity || parent >= node)
+    {
+        return (-1);
+    }
+
+    scene->positions[node] = position;
+    scene->rotations[node] = rotation;
+    scene->scales[node] = scale;
+    scene->parents[node] = parent < 0 ? -1 : parent;
+    scene->flags[node] = 0;
+    scene->count = node + 1;
+
+    speg_scene_mark(scene, node);
+
+    return (node);
+}
+
+SPEG_SCENE_API SPEG_SCENE_INLINE void speg_scene_set_position(speg_scene *scene, int node, v3 position)
+{
+    scene->positions[node] = position;
+    speg_scene_mark(scene, node);
+}
+
+SPEG_SCENE_API SPEG_SCENE_INLINE void speg_scene_set_rotation(speg_scene *scene, int node, quat rotation)
+{
+    scene->rotations[node] = rotation;
+    speg_scene_mark(scene, node);
+}
+
+SPEG_SCENE_API SPEG_SCENE_INLINE void speg_scene_set_scale(speg_scene *scene, int node, v3 scale)
+{
+    scene->scales[node] = scale;
+    speg_scene_mark(scene, node);
+}
+
+SPEG_SCENE_API SPEG_SCENE_INLINE void speg_scene_set_transform(speg_scene *scene, int node, v3 position, quat rotation, v3 scale)
+{
+    scene->positions[node] = position;
+    scene->rotations[node] = rotation;
+    scene->scales[node] = scale;
+    speg_scene_mark(scene, node);
+}
+
+/* Rebuilds the local matrices of the dirty nodes and the world matrices of the dirty subtrees in one pass over
+ * [first_dirty, count). Nodes before first_dirty are untouched and their WORLD_CHANGED flags are stale, so a
+ * parent only counts as changed when it was visited by this pass. */
+SPEG_SCENE_API SPEG_SCENE_INLINE void speg_scene_update(speg_scene *scene)
+{
+    int first = scene->first_dirty;
+    int locals_updated = 0;
+    int worlds_updated = 0;
+    int i;
+
+    for (i = first; i < scene->count; ++i)
+    {
+        unsigned char flags = scene->flags[i];
+        int parent = scene->parents[i];
+
+        if (flags & SPEG_SCENE_DIRTY_LOCAL)
+        {
+            float e[12];
+
+            vm_trs_columns(&scene->positions[i], &scene->rotations[i], &scene->scales[i], e);
+            vm_trs_store(e, scene->locals[i].e, 0);
+            ++locals_updated;
+        }
+        else if (parent < first || !(scene->flags[parent] & SPEG_SCENE_WORLD_CHANGED))
+        {
+            scene->flags[i] = 0;
+            continue;
+        }
+
+        scene->worlds[i] = parent < 0 ? scene->locals[i] : vm_m4x4_mul(scene->worlds[parent], scene->locals[i]);
+        scene->flags[i] = SPEG_SCENE_WORLD_CHANGED;
+        ++worlds_updated;
+    }
+
+    scene->first_dirty = scene->count;
+    scene->locals_updated = locals_updated;
+    scene->worlds_updated = worlds_updated;
+}
+
+/* Removes all nodes */
+SPEG_SCENE_API SPEG_SCENE_INLINE void speg_scene_clear(speg_scene *scene)
+{
+    scene->count = 0;
+    scene->first_dirty = 0;
+}
+
+#endif /* SPEG_SCENE_H */
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+
+*/
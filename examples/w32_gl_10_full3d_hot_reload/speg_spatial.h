@@ -0,0 +1,742 @@
+/* speg_spatial.h - v0.1 - public domain loose uniform grid for dynamic objects - nickscha 2025
+
+A C89 standard compliant, single header, nostdlib (no C Standard Library) incremental spatial index.
+
+The world box [origin, origin + cell_size * cells) is divided into a uniform grid. Every object is stored in
+exactly one cell, the one containing its center (objects outside the world box go into the nearest border
+cell). Cells are loose: each keeps the bounds of its objects which may reach into neighbouring cells, so an
+object never has to be stored twice and moving it inside its cell only updates two boxes.
+
+Insert, move and remove are O(1) (intrusive doubly linked list per cell plus a dense list of occupied
+cells). Frustum and ray queries visit only the occupied cells, sphere and box queries visit the cells in
+range when that is cheaper. A cell completely inside the frustum accepts all its objects without testing them.
+
+Cell bounds only grow while objects move, speg_spatial_refit shrinks them again (e.g. once per frame).
+
+All memory is provided by the caller, nothing is allocated.
+
+USAGE
+
+  speg_spatial_init(&grid, origin, 4.0f, 16, 16, 16, cells, occupied, objects, capacity); (cells/occupied: 16 * 16 * 16)
+
+  handle = speg_spatial_insert(&grid, center, extents, user);
+  speg_spatial_move(&grid, handle, center, extents);
+  speg_spatial_remove(&grid, handle);
+
+  count = speg_spatial_query_frustum(&grid, planes, results, results_capacity); (results: handles)
+  user = grid.objects[results[i]].user;
+
+LICENSE
+
+  Placed in the public domain and also MIT licensed.
+  See end of file for detailed license information.
+
+*/
+#ifndef SPEG_SPATIAL_H
+#define SPEG_SPATIAL_H
+
+/* #############################################################################
+ * # COMPILER SETTINGS
+ * #############################################################################
+ */
+/* Check if using C99 or later (inline is supported) */
+#if __STDC_VERSION__ >= 199901L
+#define SPEG_SPATIAL_INLINE inline
+#define SPEG_SPATIAL_API extern
+#elif defined(__GNUC__) || defined(__clang__)
+#define SPEG_SPATIAL_INLINE __inline__
+#define SPEG_SPATIAL_API static
+#elif defined(_MSC_VER)
+#define SPEG_SPATIAL_INLINE __inline
+#define SPEG_SPATIAL_API static
+#else
+#define SPEG_SPATIAL_INLINE
+#define SPEG_SPATIAL_API static
+#endif
+
+#define SPEG_SPATIAL_PLANES 6 /* left, right, bottom, top, near, far as (x, y, z, w) each */
+#define SPEG_SPATIAL_NONE -1
+#define SPEG_SPATIAL_FAR 3.402823466e+38f
+
+/* #############################################################################
+ * # DATA STRUCTURES
+ * #############################################################################
+ */
+typedef struct speg_spatial_object
+{
+    float center[3];
+    float extents[3]; /* half size of the box */
+    int user;         /* caller defined, e.g. the instance index */
+
+    int cell; /* SPEG_SPATIAL_NONE for free slots */
+    int next; /* next object in the cell or next free slot */
+    int prev;
+
+} speg_spatial_object;
+
+typedef struct speg_spatial_cell
+{
+    float min[3]; /* loose bounds of all objects in the cell */
+    float max[3];
+    int head;
+    int count;
+    int occupied; /* slot in the occupied list */
+
+} speg_spatial_cell;
+
+typedef struct speg_spatial_grid
+{
+    float origin[3];
+    float cell_size;
+    float cell_size_inverse;
+    int cells_x;
+    int cells_y;
+    int cells_z;
+
+    speg_spatial_cell *cells;
+    int *occupied; /* indices of the non empty cells */
+    int occupied_count;
+
+    speg_spatial_object *objects;
+    int objects_capacity;
+    int objects_count;
+    int objects_used; /* slots ever handed out, the rest has never been touched */
+    int free_list;
+
+    float overhang; /* largest distance an object reaches out of its cell, widens the range of sphere/box queries */
+
+} speg_spatial_grid;
+
+/* #############################################################################
+ * # HELPERS
+ * #############################################################################
+ */
+SPEG_SPATIAL_API SPEG_SPATIAL_INLINE float speg_spatial_absf(float x)
+{
+    return (x < 0.0f ? -x : x);
+}
+
+/* Cell coordinate of a world position on one axis, clamped into the grid */
+SPEG_SPATIAL_API SPEG_SPATIAL_INLINE int speg_spatial_coordinate(speg_spatial_grid *grid, float position, int axis, int cells)
+{
+    float f = (position - grid->origin[axis]) * grid->cell_size_inverse;
+    int i;
+
+    if (!(f > 0.0f)) /* negative or NaN */
+    {
+        return (0);
+    }
+    if (f >= (float)cells)
+    {
+        return (cells - 1);
+    }
+
+    i = (int)f;
+    return (i);
+}
+
+SPEG_SPATIAL_API SPEG_SPATIAL_INLINE int speg_spatial_cell_index(speg_spatial_grid *grid, const float *center)
+{
+    int x = speg_spatial_coordinate(grid, center[0], 0, grid->cells_x);
+    int y = speg_spatial_coordinate(grid, center[1], 1, grid->cells_y);
+    int z = speg_spatial_coordinate(grid, center[2], 2, grid->cells_z);
+
+    return ((z * grid->cells_y + y) * grid->cells_x + x);
+}
+
+SPEG_SPATIAL_API SPEG_SPATIAL_INLINE void speg_spatial_cell_grow(speg_spatial_grid *grid, int cell_index, const speg_spatial_object *object)
+{
+    speg_spatial_cell *cell = &grid->cells[cell_index];
+    int cell_coordinate[3];
+    int a;
+
+    /* The object center lies in this cell (or was clamped into it) */
+    cell_coordinate[0] = speg_spatial_coordinate(grid, object->center[0], 0, grid->cells_x);
+    cell_coordinate[1] = speg_spatial_coordinate(grid, object->center[1], 1, grid->cells_y);
+    cell_coordinate[2] = speg_spatial_coordinate(grid, object->center[2], 2, grid->cells_z);
+
+    for (a = 0; a < 3; ++a)
+    {
+        float object_min = object->center[a] - object->extents[a];
+        float object_max = object->center[a] + object->extents[a];
+        float cell_min = grid->origin[a] + (float)cell_coordinate[a] * grid->cell_size;
+        float cell_max = cell_min + grid->cell_size;
+
+        cell->min[a] = object_min < cell->min[a] ? object_min : cell->min[a];
+        cell->max[a] = object_max > cell->max[a] ? object_max : cell->max[a];
+
+        /* Objects outside the world box are clamped into border cells, their distance counts as overhang as well */
+        grid->overhang = cell_min - object_min > grid->overhang ? cell_min - object_min : grid->overhang;
+        grid->overhang = object_max - cell_max > grid->overhang ? object_max - cell_max : grid->overhang;
+    }
+}
+
+SPEG_SPATIAL_API SPEG_SPATIAL_INLINE void speg_spatial_link(speg_spatial_grid *grid, int handle, int cell_index)
+{
+    speg_spatial_object *object = &grid->objects[handle];
+    speg_spatial_cell *cell = &grid->cells[cell_index];
+
+    if (cell->count == 0)
+    {
+        int a;
+
+        for (a = 0; a < 3; ++a)
+        {
+            cell->min[a] = SPEG_SPATIAL_FAR;
+            cell->max[a] = -SPEG_SPATIAL_FAR;
+        }
+
+        cell->occupied = grid->occupied_count;
+        grid->occupied[grid->occupied_count++] = cell_index;
+    }
+
+    object->cell = cell_index;
+    object->prev = SPEG_SPATIAL_NONE;
+    object->next = cell->head;
+
+    if (cell->head != SPEG_SPATIAL_NONE)
+    {
+        grid->objects[cell->head].prev = handle;
+    }
+
+    cell->head = handle;
+    cell->count += 1;
+
+    speg_spatial_cell_grow(grid, cell_index, object);
+}
+
+SPEG_SPATIAL_API SPEG_SPATIAL_INLINE void speg_spatial_unlink(speg_spatial_grid *grid, int handle)
+{
+    speg_spatial_object *object = &grid->objects[handle];
+    speg_spatial_cell *cell = &grid->cells[object->cell];
+
+    if (object->prev != SPEG_SPATIAL_NONE)
+    {
+        grid->objects[object->prev].next = object->next;
+    }
+    else
+    {
+        cell->head = object->next;
+    }
+
+    if (object->next != SPEG_SPATIAL_NONE)
+    {
+        grid->objects[object->next].prev = object->prev;
+    }
+
+    cell->count -= 1;
+
+    if (cell->count == 0)
+    {
+        /* Swap remove from the occupied list */
+        int last = grid->occupied[--grid->occupied_count];
+        grid->occupied[cell->occupied] = last;
+        grid->cells[last].occupied = cell->occupied;
+    }
+
+    object->cell = SPEG_SPATIAL_NONE;
+}
+
+/* #############################################################################
+ * # OBJECTS
+ * #############################################################################
+ */
+
+/* cells and occupied must hold cells_x * cells_y * cells_z entries, objects objects_capacity entries */
+SPEG_SPATIAL_API SPEG_SPATIAL_INLINE void speg_spatial_init(
+    speg_spatial_grid *grid,
+    const float *origin, float cell_size, int cells_x, int cells_y, int cells_z,
+    speg_spatial_cell *cells, int *occupied,
+    speg_spatial_object *objects, int objects_capacity)
+{
+    int i;
+
+    grid->origin[0] = origin[0];
+    grid->origin[1] = origin[1];
+    grid->origin[2] = origin[2];
+    grid->cell_size = cell_size;
+    grid->cell_size_inverse = 1.0f / cell_size;
+    grid->cells_x = cells_x;
+    grid->cells_y = cells_y;
+    grid->cells_z = cells_z;
+    grid->cells = cells;
+    grid->occupied = occupied;
+    grid->occupied_count = 0;
+    grid->objects = objects;
+    grid->objects_capacity = objects_capacity;
+    grid->objects_count = 0;
+    grid->objects_used = 0;
+    grid->free_list = SPEG_SPATIAL_NONE;
+    grid->overhang = 0.0f;
+
+    for (i = 0; i < cells_x * cells_y * cells_z; ++i)
+    {
+        cells[i].head = SPEG_SPATIAL_NONE;
+        cells[i].count = 0;
+        cells[i].occupied = SPEG_SPATIAL_NONE;
+    }
+}
+
+/* Returns the handle of the new object or SPEG_SPATIAL_NONE if the grid is full */
+SPEG_SPATIAL_API SPEG_SPATIAL_INLINE int speg_spatial_insert(speg_spatial_grid *grid, const float *center, const float *extents, int user)
+{
+    speg_spatial_object *object;
+    int handle;
+    int a;
+
+    if (grid->free_list != SPEG_SPATIAL_NONE)
+    {
+        handle = grid->free_list;
+        grid->free_list = grid->objects[handle].next;
+    }
+    else if (grid->objects_used < grid->objects_capacity)
+    {
+        handle = grid->objects_used++;
+    }
+    else
+    {
+        return (SPEG_SPATIAL_NONE);
+    }
+
+    object = &grid->objects[handle];
+
+    for (a = 0; a < 3; ++a)
+    {
+        object->center[a] = center[a];
+        object->extents[a] = extents[a];
+    }
+    object->user = user;
+
+    speg_spatial_link(grid, handle, speg_spatial_cell_index(grid, center));
+    grid->objects_count += 1;
+
+    return (handle);
+}
+
+/* Updates the box of an object, it only changes lists if the center moved into another cell */
+SPEG_SPATIAL_API SPEG_SPATIAL_INLINE void speg_spatial_move(speg_spatial_grid *grid, int handle, const float *center, const float *extents)
+{
+    speg_spatial_object *object = &grid->objects[handle];
+    int cell_index = speg_spatial_cell_index(grid, center);
+    int a;
+
+    for (a = 0; a < 3; ++a)
+    {
+        object->center[a] = center[a];
+        object->extents[a] = extents[a];
+    }
+
+    if (cell_index == object->cell)
+    {
+        speg_spatial_cell *cell = &grid->cells[cell_index];
+
+        /* Common case: small moves stay inside the current cell bounds */
+        if (center[0] - extents[0] < cell->min[0] || center[0] + extents[0] > cell->max[0] ||
+            center[1] - extents[1] < cell->min[1] || center[1] + extents[1] > cell->max[1] ||
+            center[2] - extents[2] < cell->min[2] || center[2] + extents[2] > cell->max[2])
+        {
+            speg_spatial_cell_grow(grid, cell_index, object);
+        }
+    }
+    else
+    {
+        speg_spatial_unlink(grid, handle);
+        speg_spatial_link(grid, handle, cell_index);
+    }
+}
+
+SPEG_SPATIAL_API SPEG_SPATIAL_INLINE void speg_spatial_remove(speg_spatial_grid *grid, int handle)
+{
+    speg_spatial_unlink(grid, handle);
+
+    grid->objects[handle].next = grid->free_list;
+    grid->free_list = handle;
+    grid->objects_count -= 1;
+}
+
+/* Recomputes the cell bounds and the overhang from the current objects, O(objects) */
+SPEG_SPATIAL_API SPEG_SPATIAL_INLINE void speg_spatial_refit(speg_spatial_grid *grid)
+{
+    int i;
+
+    grid->overhang = 0.0f;
+
+    for (i = 0; i < grid->occupied_count; ++i)
+    {
+        int cell_index = grid->occupied[i];
+        speg_spatial_cell *cell = &grid->cells[cell_index];
+        int handle;
+        int a;
+
+        for (a = 0; a < 3; ++a)
+        {
+            cell->min[a] = SPEG_SPATIAL_FAR;
+            cell->max[a] = -SPEG_SPATIAL_FAR;
+        }
+
+        for (handle = cell->head; handle != SPEG_SPATIAL_NONE; handle = grid->objects[handle].next)
+        {
+            speg_spatial_cell_grow(grid, cell_index, &grid->objects[handle]);
+        }
+    }
+}
+
+/* #############################################################################
+ * # QUERIES
+ * #############################################################################
+ */
+
+/* Appends all objects of a cell without testing them */
+SPEG_SPATIAL_API SPEG_SPATIAL_INLINE int speg_spatial_collect(speg_spatial_grid *grid, speg_spatial_cell *cell, int *results, int results_capacity, int count)
+{
+    int handle;
+
+    for (handle = cell->head; handle != SPEG_SPATIAL_NONE && count < results_capacity; handle = grid->objects[handle].next)
+    {
+        results[count++] = handle;
+    }
+
+    return (count);
+}
+
+/* Box against the frustum planes: 0 = outside, 1 = intersecting, 2 = completely inside.
+ * Outside means completely behind one plane like vm_frustum_cull_aabb_soa. plane_abs holds |x|, |y|, |z| per plane. */
+SPEG_SPATIAL_API SPEG_SPATIAL_INLINE int speg_spatial_frustum_test(const float *planes, const float *plane_abs, const float *center, const float *extents)
+{
+    int inside = 2;
+    int p;
+
+    for (p = 0; p < SPEG_SPATIAL_PLANES; ++p)
+    {
+        const float *plane = &planes[p * 4];
+        const float *a = &plane_abs[p * 3];
+        float distance = (plane[0] * center[0] + plane[1] * center[1]) + (plane[2] * center[2] + plane[3]);
+        float radius = (a[0] * extents[0] + a[1] * extents[1]) + a[2] * extents[2];
+
+        if (distance + radius < 0.0f)
+        {
+            return (0);
+        }
+
+        if (distance - radius <= 0.0f)
+        {
+            inside = 1;
+        }
+    }
+
+    return (inside);
+}
+
+/* Writes the handles of all objects inside or intersecting the frustum planes, returns the number of handles */
+SPEG_SPATIAL_API SPEG_SPATIAL_INLINE int speg_spatial_query_frustum(speg_spatial_grid *grid, const float *planes, int *results, int results_capacity)
+{
+    float plane_abs[SPEG_SPATIAL_PLANES * 3];
+    int count = 0;
+    int i;
+
+    for (i = 0; i < SPEG_SPATIAL_PLANES * 3; ++i)
+    {
+        plane_abs[i] = speg_spatial_absf(planes[(i / 3) * 4 + i % 3]);
+    }
+
+    for (i = 0; i < grid->occupied_count; ++i)
+    {
+        speg_spatial_cell *cell = &grid->cells[grid->occupied[i]];
+        float center[3], extents[3];
+        int a;
+        int test;
+
+        for (a = 0; a < 3; ++a)
+        {
+            center[a] = (cell->min[a] + cell->max[a]) * 0.5f;
+            extents[a] = (cell->max[a] - cell->min[a]) * 0.5f;
+        }
+
+        test = speg_spatial_frustum_test(planes, plane_abs, center, extents);
+
+        if (test == 2)
+        {
+            count = speg_spatial_collect(grid, cell, results, results_capacity, count);
+        }
+        else if (test == 1)
+        {
+            int handle;
+
+            for (handle = cell->head; handle != SPEG_SPATIAL_NONE && count < results_capacity; handle = grid->objects[handle].next)
+            {
+                if (speg_spatial_frustum_test(planes, plane_abs, grid->objects[handle].center, grid->objects[handle].extents))
+                {
+                    results[count++] = handle;
+                }
+            }
+        }
+    }
+
+    return (count);
+}
+
+/* Squared distance between a point and a box given by min and max */
+SPEG_SPATIAL_API SPEG_SPATIAL_INLINE float speg_spatial_distance_squared(const float *point, const float *box_min, const float *box_max)
+{
+    float distance_squared = 0.0f;
+    int a;
+
+    for (a = 0; a < 3; ++a)
+    {
+        float d = point[a] < box_min[a] ? box_min[a] - point[a] : (point[a] > box_max[a] ? point[a] - box_max[a] : 0.0f);
+        distance_squared += d * d;
+    }
+
+    return (distance_squared);
+}
+
+/* Shared walk of sphere and box queries. The query region is the box [query_min, query_max], a sphere query
+ * additionally rejects boxes further than radius away from center. Visits either the cells in range or the
+ * occupied cells, whichever are fewer. */
+SPEG_SPATIAL_API SPEG_SPATIAL_INLINE int speg_spatial_query_region(
+    speg_spatial_grid *grid,
+    const float *query_min, const float *query_max,
+    const float *sphere_center, float sphere_radius,
+    int *results, int results_capacity)
+{
+    float radius_squared = sphere_radius * sphere_radius;
+    int range_min[3], range_max[3];
+    int cells_in_range;
+    int use_range;
+    int visit_count;
+    int count = 0;
+    int i;
+
+    range_min[0] = speg_spatial_coordinate(grid, query_min[0] - grid->overhang, 0, grid->cells_x);
+    range_min[1] = speg_spatial_coordinate(grid, query_min[1] - grid->overhang, 1, grid->cells_y);
+    range_min[2] = speg_spatial_coordinate(grid, query_min[2] - grid->overhang, 2, grid->cells_z);
+    range_max[0] = speg_spatial_coordinate(grid, query_max[0] + grid->overhang, 0, grid->cells_x);
+    range_max[1] = speg_spatial_coordinate(grid, query_max[1] + grid->overhang, 1, grid->cells_y);
+    range_max[2] = speg_spatial_coordinate(grid, query_max[2] + grid->overhang, 2, grid->cells_z);
+
+    cells_in_range = (range_max[0] - range_min[0] + 1) * (range_max[1] - range_min[1] + 1) * (range_max[2] - range_min[2] + 1);
+    use_range = cells_in_range < grid->occupied_count;
+    visit_count = use_range ? cells_in_range : grid->occupied_count;
+
+    for (i = 0; i < visit_count; ++i)
+    {
+        speg_spatial_cell *cell;
+        int handle;
+
+        if (use_range)
+        {
+            int size_x = range_max[0] - range_min[0] + 1;
+            int size_y = range_max[1] - range_min[1] + 1;
+            int x = range_min[0] + i % size_x;
+            int y = range_min[1] + (i / size_x) % size_y;
+            int z = range_min[2] + i / (size_x * size_y);
+
+            cell = &grid->cells[(z * grid->cells_y + y) * grid->cells_x + x];
+
+            if (cell->count == 0)
+            {
+                continue;
+            }
+        }
+        else
+        {
+            cell = &grid->cells[grid->occupied[i]];
+        }
+
+        if (cell->max[0] < query_min[0] || cell->min[0] > query_max[0] ||
+            cell->max[1] < query_min[1] || cell->min[1] > query_max[1] ||
+            cell->max[2] < query_min[2] || cell->min[2] > query_max[2])
+        {
+            continue;
+        }
+
+        if (sphere_center && speg_spatial_distance_squared(sphere_center, cell->min, cell->max) > radius_squared)
+        {
+            continue;
+        }
+
+        for (handle = cell->head; handle != SPEG_SPATIAL_NONE && count < results_capacity; handle = grid->objects[handle].next)
+        {
+            speg_spatial_object *object = &grid->objects[handle];
+            float object_min[3], object_max[3];
+            int a;
+            int overlaps = 1;
+
+            for (a = 0; a < 3; ++a)
+            {
+                object_min[a] = object->center[a] - object->extents[a];
+                object_max[a] = object->center[a] + object->extents[a];
+                overlaps = overlaps && object_max[a] >= query_min[a] && object_min[a] <= query_max[a];
+            }
+
+            if (overlaps && (!sphere_center || speg_spatial_distance_squared(sphere_center, object_min, object_max) <= radius_squared))
+            {
+                results[count++] = handle;
+            }
+        }
+    }
+
+    return (count);
+}
+
+/* Writes the handles of all objects whose box touches the sphere, returns the number of handles */
+SPEG_SPATIAL_API SPEG_SPATIAL_INLINE int speg_spatial_query_sphere(speg_spatial_grid *grid, const float *center, float radius, int *results, int results_capacity)
+{
+    float query_min[3], query_max[3];
+    int a;
+
+    for (a = 0; a < 3; ++a)
+    {
+        query_min[a] = center[a] - radius;
+        query_max[a] = center[a] + radius;
+    }
+
+    return (speg_spatial_query_region(grid, query_min, query_max, center, radius, results, results_capacity));
+}
+
+/* Writes the handles of all objects whose box overlaps the box (center, extents), returns the number of handles */
+SPEG_SPATIAL_API SPEG_SPATIAL_INLINE int speg_spatial_query_aabb(speg_spatial_grid *grid, const float *center, const float *extents, int *results, int results_capacity)
+{
+    float query_min[3], query_max[3];
+    int a;
+
+    for (a = 0; a < 3; ++a)
+    {
+        query_min[a] = center[a] - extents[a];
+        query_max[a] = center[a] + extents[a];
+    }
+
+    return (speg_spatial_query_region(grid, query_min, query_max, (const float *)0, 0.0f, results, results_capacity));
+}
+
+/* Slab test of the ray against the box, returns the entry distance or SPEG_SPATIAL_FAR on a miss */
+SPEG_SPATIAL_API SPEG_SPATIAL_INLINE float speg_spatial_ray_box(const float *origin, const float *direction_inverse, float max_distance, const float *box_min, const float *box_max)
+{
+    float t_near = 0.0f;
+    float t_far = max_distance;
+    int a;
+
+    for (a = 0; a < 3; ++a)
+    {
+        float t0 = (box_min[a] - origin[a]) * direction_inverse[a];
+        float t1 = (box_max[a] - origin[a]) * direction_inverse[a];
+
+        if (t0 > t1)
+        {
+            float swap = t0;
+            t0 = t1;
+            t1 = swap;
+        }
+
+        t_near = t0 > t_near ? t0 : t_near;
+        t_far = t1 < t_far ? t1 : t_far;
+
+        if (t_near > t_far)
+        {
+            return (SPEG_SPATIAL_FAR);
+        }
+    }
+
+    return (t_near);
+}
+
+/* Closest object whose box is hit by the ray within max_distance (direction does not need to be normalized,
+ * distances are in multiples of it). Returns the handle or SPEG_SPATIAL_NONE, the hit distance goes to *distance. */
+SPEG_SPATIAL_API SPEG_SPATIAL_INLINE int speg_spatial_raycast(speg_spatial_grid *grid, const float *origin, const float *direction, float max_distance, float *distance)
+{
+    float direction_inverse[3];
+    float closest = max_distance;
+    int hit = SPEG_SPATIAL_NONE;
+    int a;
+    int i;
+
+    for (a = 0; a < 3; ++a)
+    {
+        /* Parallel axes get a huge but finite inverse so the slab test never computes 0 * inf */
+        direction_inverse[a] = speg_spatial_absf(direction[a]) > 1e-20f ? 1.0f / direction[a] : (direction[a] < 0.0f ? -1e30f : 1e30f);
+    }
+
+    for (i = 0; i < grid->occupied_count; ++i)
+    {
+        speg_spatial_cell *cell = &grid->cells[grid->occupied[i]];
+        int handle;
+
+        if (speg_spatial_ray_box(origin, direction_inverse, closest, cell->min, cell->max) == SPEG_SPATIAL_FAR)
+        {
+            continue;
+        }
+
+        for (handle = cell->head; handle != SPEG_SPATIAL_NONE; handle = grid->objects[handle].next)
+        {
+            speg_spatial_object *object = &grid->objects[handle];
+            float object_min[3], object_max[3];
+            float t;
+
+            for (a = 0; a < 3; ++a)
+            {
+                object_min[a] = object->center[a] - object->extents[a];
+                object_max[a] = object->center[a] + object->extents[a];
+            }
+
+            t = speg_spatial_ray_box(origin, direction_inverse, closest, object_min, object_max);
+
+            if (t != SPEG_SPATIAL_FAR && (hit == SPEG_SPATIAL_NONE || t < closest))
+            {
+                closest = t;
+                hit = handle;
+            }
+        }
+    }
+
+    if (distance)
+    {
+        *distance = closest;
+    }
+
+    return (hit);
+}
+
+#endif /* SPEG_SPATIAL_H */
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+
+*/
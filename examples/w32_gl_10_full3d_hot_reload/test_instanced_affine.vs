@@ -0,0 +1,30 @@
+#version 330 core
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec2 texCoord;
+layout (location = 2) in vec3 translation;
+layout (location = 3) in vec4 linear0; /* column major 3x3: x axis, y.x */
+layout (location = 4) in vec4 linear1; /* y.yz, z.xy */
+layout (location = 5) in float linear2; /* z.z */
+layout (location = 6) in vec3 instanceColor;
+layout (location = 9) in int textureIndex;
+
+uniform mat4 pv;
+
+out vec3 vColor;
+out vec2 vTexCoord;
+flat out int vTexIndex;
+
+void main()
+{
+    mat4 model = mat4(
+        vec4(linear0.xyz, 0.0f),
+        vec4(linear0.w, linear1.xy, 0.0f),
+        vec4(linear1.zw, linear2, 0.0f),
+        vec4(translation, 1.0f));
+
+    vColor = instanceColor;
+    vTexCoord = texCoord;
+    vTexIndex = textureIndex;
+    gl_Position = pv * model * vec4(position, 1.0f);
+}
@@ -0,0 +1,34 @@
+#version 330 core
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec2 texCoord;
+layout (location = 2) in vec3 translation;
+layout (location = 3) in vec4 rotation; /* quaternion x, y, z, w */
+layout (location = 4) in vec3 scale;
+layout (location = 6) in vec3 instanceColor;
+layout (location = 9) in int textureIndex;
+
+uniform mat4 pv;
+
+out vec3 vColor;
+out vec2 vTexCoord;
+flat out int vTexIndex;
+
+void main()
+{
+    /* Half float quaternions are not unit length anymore, 2 / |q|^2 normalizes them */
+    vec4 q = rotation;
+    float n = 2.0f / dot(q, q);
+
+    mat3 r = mat3(
+        1.0f - n * (q.y * q.y + q.z * q.z), n * (q.x * q.y + q.w * q.z), n * (q.x * q.z - q.w * q.y),
+        n * (q.x * q.y - q.w * q.z), 1.0f - n * (q.x * q.x + q.z * q.z), n * (q.y * q.z + q.w * q.x),
+        n * (q.x * q.z + q.w * q.y), n * (q.y * q.z - q.w * q.x), 1.0f - n * (q.x * q.x + q.y * q.y));
+
+    vec3 world = r * (position * scale) + translation;
+
+    vColor = instanceColor;
+    vTexCoord = texCoord;
+    vTexIndex = textureIndex;
+    gl_Position = pv * vec4(world, 1.0f);
+}
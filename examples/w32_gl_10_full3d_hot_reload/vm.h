@@ -43,8 +43,35 @@ LICENSE
 #undef VM_USE_SSE
 #endif
 
+/* SSE2 (every x86-64 cpu) for the integer quadrants of vm_sincosf4 */
 #ifdef VM_USE_SSE
-#include <xmmintrin.h>
+#include <emmintrin.h>
+#endif
+
+/* AVX2 is only used if the compiler targets it and FMA as well (e.g. -mavx2 -mfma or -march=native).
+ * MSVC has no __FMA__, /arch:AVX2 allows the FMA3 intrinsics */
+#if defined(VM_USE_AVX2) && !(defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER)))
+#undef VM_USE_AVX2
+#endif
+
+/* VM_USE_AVX2 builds on the 4-wide VM_USE_SSE path: 8-wide where there are 8 lanes of work, fused multiply-add in both */
+#ifdef VM_USE_AVX2
+#include <immintrin.h>
+#ifndef VM_USE_SSE
+#define VM_USE_SSE
+#include <emmintrin.h>
+#endif
+#endif
+
+/* a * b + c, c - a * b and a * b - c with one rounding on the VM_USE_AVX2 path */
+#ifdef VM_USE_AVX2
+#define VM_MADD_PS(a, b, c) _mm_fmadd_ps(a, b, c)
+#define VM_NMADD_PS(a, b, c) _mm_fnmadd_ps(a, b, c)
+#define VM_MSUB_PS(a, b, c) _mm_fmsub_ps(a, b, c)
+#elif defined(VM_USE_SSE)
+#define VM_MADD_PS(a, b, c) _mm_add_ps(_mm_mul_ps(a, b), c)
+#define VM_NMADD_PS(a, b, c) _mm_sub_ps(c, _mm_mul_ps(a, b))
+#define VM_MSUB_PS(a, b, c) _mm_sub_ps(_mm_mul_ps(a, b), c)
 #endif
 
 /* #############################################################################
@@ -65,20 +92,59 @@ LICENSE
 /* Seed for the random number generator */
 static unsigned int vm_seed_lcg = 1;
 
+/* Random numbers from a caller owned seed (e.g. one per thread), the same sequence as the global generator */
+VM_API VM_INLINE unsigned int vm_randi_seed(unsigned int *seed)
+{
+    *seed = (VM_LCG_A * *seed + VM_LCG_C);
+    return (*seed);
+}
+
+VM_API VM_INLINE float vm_randf_seed(unsigned int *seed)
+{
+    return ((float)vm_randi_seed(seed) / VM_LCG_M);
+}
+
+VM_API VM_INLINE float vm_randf_range_seed(unsigned int *seed, float min, float max)
+{
+    return (min + (max - min) * vm_randf_seed(seed));
+}
+
+/* The seed after count more numbers in O(log count), so parallel ranges can start where a serial loop would be */
+VM_API VM_INLINE unsigned int vm_seed_lcg_skip(unsigned int seed, unsigned int count)
+{
+    unsigned int mult = VM_LCG_A;
+    unsigned int plus = VM_LCG_C;
+    unsigned int acc_mult = 1;
+    unsigned int acc_plus = 0;
+
+    while (count)
+    {
+        if (count & 1)
+        {
+            acc_mult *= mult;
+            acc_plus = acc_plus * mult + plus;
+        }
+        plus = (mult + 1) * plus;
+        mult *= mult;
+        count >>= 1;
+    }
+
+    return (acc_mult * seed + acc_plus);
+}
+
 VM_API VM_INLINE unsigned int vm_randi(void)
 {
-    vm_seed_lcg = (VM_LCG_A * vm_seed_lcg + VM_LCG_C);
-    return (vm_seed_lcg);
+    return (vm_randi_seed(&vm_seed_lcg));
 }
 
 VM_API VM_INLINE float vm_randf(void)
 {
-    return ((float)vm_randi() / VM_LCG_M);
+    return (vm_randf_seed(&vm_seed_lcg));
 }
 
 VM_API VM_INLINE float vm_randf_range(float min, float max)
 {
-    return (min + (max - min) * vm_randf());
+    return (vm_randf_range_seed(&vm_seed_lcg, min, max));
 }
 
 VM_API VM_INLINE float vm_radf(float degree)
@@ -183,7 +249,7 @@ VM_API VM_INLINE float vm_invsqrt(float number)
     union
     {
         float f;
-        long i;
+        int i; /* 32 bit on LP64 as well, long is 64 bit there */
     } conv;
 
     float x2, y;
@@ -364,6 +430,221 @@ VM_API VM_INLINE float vm_tanf(float x)
     return (vm_sinf(x) / vm_cosf(x));
 }
 
+/* sin and cos of the same angle from one range reduction: x = q * pi / 2 + r with r in [-pi / 4, pi / 4],
+ * polynomials for sin(r) and cos(r) and the quadrant q picks and negates them. Accuracy tiers (max error for
+ * |x| <= 8192 and in ulp for |x| <= 2 pi, measured by speg_bench):
+ *
+ * VM_SINCOS_FAST    : degree 3 and 4 polynomials, one step reduction      7e-4 (the vm_sinf table as well)
+ * VM_SINCOS_MEDIUM  : degree 5 and 6 polynomials, three step reduction    1.5e-6, 26 ulp
+ * VM_SINCOS_PRECISE : degree 7 and 8 polynomials (cephes sinf and cosf)   9e-8, 1.5 ulp
+ *
+ * vm_sincosf uses VM_SINCOS_ACCURACY, vm_sincosf4 (VM_USE_SSE) and vm_sincosf8 (VM_USE_AVX2) compute 4 and 8
+ * angles at once, vm_sincosf_batch whole arrays with the widest of them.
+ */
+#define VM_SINCOS_FAST 0
+#define VM_SINCOS_MEDIUM 1
+#define VM_SINCOS_PRECISE 2
+
+#ifndef VM_SINCOS_ACCURACY
+#define VM_SINCOS_ACCURACY VM_SINCOS_MEDIUM
+#endif
+
+#define VM_SINCOS_2_DIV_PI 0.636619772367581343076f
+#define VM_SINCOS_PIO2_1 1.5703125f /* pi / 2 = PIO2_1 + PIO2_2 + PIO2_3, q * PIO2_1 is exact */
+#define VM_SINCOS_PIO2_2 4.837512969970703125e-4f
+#define VM_SINCOS_PIO2_3 7.54978995489188216e-8f
+
+/* sin(r) = r + r * z * S(z), cos(r) = 1 + z * C(z) with z = r * r (minimax fits on [-pi / 4, pi / 4]) */
+#define VM_SINCOS_FAST_S1 -1.6243748e-1f
+#define VM_SINCOS_FAST_C1 -4.9976174e-1f
+#define VM_SINCOS_FAST_C2 4.0461411e-2f
+#define VM_SINCOS_MEDIUM_S1 -1.6663406e-1f
+#define VM_SINCOS_MEDIUM_S2 8.1636899e-3f
+#define VM_SINCOS_MEDIUM_C1 -4.9999886e-1f
+#define VM_SINCOS_MEDIUM_C2 4.1655831e-2f
+#define VM_SINCOS_MEDIUM_C3 -1.3592591e-3f
+#define VM_SINCOS_PRECISE_S1 -1.6666654611e-1f
+#define VM_SINCOS_PRECISE_S2 8.3321608736e-3f
+#define VM_SINCOS_PRECISE_S3 -1.9515295891e-4f
+#define VM_SINCOS_PRECISE_C1 -0.5f
+#define VM_SINCOS_PRECISE_C2 4.166664568298827e-2f
+#define VM_SINCOS_PRECISE_C3 -1.388731625493765e-3f
+#define VM_SINCOS_PRECISE_C4 2.443315711809948e-5f
+
+VM_API VM_INLINE void vm_sincosf_accuracy(float x, int accuracy, float *s, float *c)
+{
+    int q = (int)(x * VM_SINCOS_2_DIV_PI + (x < 0.0f ? -0.5f : 0.5f));
+    float qf = (float)q;
+    float r, z, sin_r, cos_r;
+
+    if (accuracy == VM_SINCOS_FAST)
+    {
+        r = x - qf * VM_PI_HALF;
+        z = r * r;
+        sin_r = r + r * z * VM_SINCOS_FAST_S1;
+        cos_r = 1.0f + z * (VM_SINCOS_FAST_C1 + z * VM_SINCOS_FAST_C2);
+    }
+    else if (accuracy == VM_SINCOS_MEDIUM)
+    {
+        r = ((x - qf * VM_SINCOS_PIO2_1) - qf * VM_SINCOS_PIO2_2) - qf * VM_SINCOS_PIO2_3;
+        z = r * r;
+        sin_r = r + r * z * (VM_SINCOS_MEDIUM_S1 + z * VM_SINCOS_MEDIUM_S2);
+        cos_r = 1.0f + z * (VM_SINCOS_MEDIUM_C1 + z * (VM_SINCOS_MEDIUM_C2 + z * VM_SINCOS_MEDIUM_C3));
+    }
+    else
+    {
+        r = ((x - qf * VM_SINCOS_PIO2_1) - qf * VM_SINCOS_PIO2_2) - qf * VM_SINCOS_PIO2_3;
+        z = r * r;
+        sin_r = r + r * z * (VM_SINCOS_PRECISE_S1 + z * (VM_SINCOS_PRECISE_S2 + z * VM_SINCOS_PRECISE_S3));
+        cos_r = 1.0f + z * (VM_SINCOS_PRECISE_C1 + z * (VM_SINCOS_PRECISE_C2 + z * (VM_SINCOS_PRECISE_C3 + z * VM_SINCOS_PRECISE_C4)));
+    }
+
+    /* sin(x) = sin(r), cos(r), -sin(r), -cos(r) and cos(x) = cos(r), -sin(r), -cos(r), sin(r) for q = 0, 1, 2, 3.
+     * Table lookups instead of branches, the quadrants of random angles are not predictable */
+    {
+        static const float sign[2] = {1.0f, -1.0f};
+        float sin_cos[2];
+
+        sin_cos[0] = sin_r;
+        sin_cos[1] = cos_r;
+
+        *s = sin_cos[q & 1] * sign[(q >> 1) & 1];
+        *c = sin_cos[(q & 1) ^ 1] * sign[((q + 1) >> 1) & 1];
+    }
+}
+
+VM_API VM_INLINE void vm_sincosf(float x, float *s, float *c)
+{
+    vm_sincosf_accuracy(x, VM_SINCOS_ACCURACY, s, c);
+}
+
+#ifdef VM_USE_SSE
+VM_API VM_INLINE void vm_sincosf4(__m128 x, int accuracy, __m128 *s, __m128 *c)
+{
+    __m128i q = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(VM_SINCOS_2_DIV_PI)));
+    __m128 qf = _mm_cvtepi32_ps(q);
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128i one_i = _mm_set1_epi32(1);
+    __m128i two_i = _mm_set1_epi32(2);
+    __m128 r, z, sin_r, cos_r, swap;
+
+    if (accuracy == VM_SINCOS_FAST)
+    {
+        r = VM_NMADD_PS(qf, _mm_set1_ps(VM_PI_HALF), x);
+        z = _mm_mul_ps(r, r);
+        sin_r = VM_MADD_PS(_mm_mul_ps(r, z), _mm_set1_ps(VM_SINCOS_FAST_S1), r);
+        cos_r = VM_MADD_PS(z, VM_MADD_PS(z, _mm_set1_ps(VM_SINCOS_FAST_C2), _mm_set1_ps(VM_SINCOS_FAST_C1)), one);
+    }
+    else
+    {
+        r = VM_NMADD_PS(qf, _mm_set1_ps(VM_SINCOS_PIO2_1), x);
+        r = VM_NMADD_PS(qf, _mm_set1_ps(VM_SINCOS_PIO2_2), r);
+        r = VM_NMADD_PS(qf, _mm_set1_ps(VM_SINCOS_PIO2_3), r);
+        z = _mm_mul_ps(r, r);
+
+        if (accuracy == VM_SINCOS_MEDIUM)
+        {
+            sin_r = VM_MADD_PS(_mm_mul_ps(r, z), VM_MADD_PS(z, _mm_set1_ps(VM_SINCOS_MEDIUM_S2), _mm_set1_ps(VM_SINCOS_MEDIUM_S1)), r);
+            cos_r = VM_MADD_PS(z, _mm_set1_ps(VM_SINCOS_MEDIUM_C3), _mm_set1_ps(VM_SINCOS_MEDIUM_C2));
+            cos_r = VM_MADD_PS(z, VM_MADD_PS(z, cos_r, _mm_set1_ps(VM_SINCOS_MEDIUM_C1)), one);
+        }
+        else
+        {
+            sin_r = VM_MADD_PS(z, _mm_set1_ps(VM_SINCOS_PRECISE_S3), _mm_set1_ps(VM_SINCOS_PRECISE_S2));
+            sin_r = VM_MADD_PS(_mm_mul_ps(r, z), VM_MADD_PS(z, sin_r, _mm_set1_ps(VM_SINCOS_PRECISE_S1)), r);
+            cos_r = VM_MADD_PS(z, _mm_set1_ps(VM_SINCOS_PRECISE_C4), _mm_set1_ps(VM_SINCOS_PRECISE_C3));
+            cos_r = VM_MADD_PS(z, cos_r, _mm_set1_ps(VM_SINCOS_PRECISE_C2));
+            cos_r = VM_MADD_PS(z, VM_MADD_PS(z, cos_r, _mm_set1_ps(VM_SINCOS_PRECISE_C1)), one);
+        }
+    }
+
+    /* Odd quadrants swap sin and cos, bit 1 of q (of q + 1) is the sign of sin (of cos) */
+    swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, one_i), one_i));
+    *s = _mm_or_ps(_mm_and_ps(swap, cos_r), _mm_andnot_ps(swap, sin_r));
+    *c = _mm_or_ps(_mm_and_ps(swap, sin_r), _mm_andnot_ps(swap, cos_r));
+    *s = _mm_xor_ps(*s, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, two_i), 30)));
+    *c = _mm_xor_ps(*c, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(q, one_i), two_i), 30)));
+}
+#endif
+
+#ifdef VM_USE_AVX2
+VM_API VM_INLINE void vm_sincosf8(__m256 x, int accuracy, __m256 *s, __m256 *c)
+{
+    __m256i q = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(VM_SINCOS_2_DIV_PI)));
+    __m256 qf = _mm256_cvtepi32_ps(q);
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256i one_i = _mm256_set1_epi32(1);
+    __m256i two_i = _mm256_set1_epi32(2);
+    __m256 r, z, sin_r, cos_r, swap;
+
+    if (accuracy == VM_SINCOS_FAST)
+    {
+        r = _mm256_fnmadd_ps(qf, _mm256_set1_ps(VM_PI_HALF), x);
+        z = _mm256_mul_ps(r, r);
+        sin_r = _mm256_fmadd_ps(_mm256_mul_ps(r, z), _mm256_set1_ps(VM_SINCOS_FAST_S1), r);
+        cos_r = _mm256_fmadd_ps(z, _mm256_fmadd_ps(z, _mm256_set1_ps(VM_SINCOS_FAST_C2), _mm256_set1_ps(VM_SINCOS_FAST_C1)), one);
+    }
+    else
+    {
+        r = _mm256_fnmadd_ps(qf, _mm256_set1_ps(VM_SINCOS_PIO2_1), x);
+        r = _mm256_fnmadd_ps(qf, _mm256_set1_ps(VM_SINCOS_PIO2_2), r);
+        r = _mm256_fnmadd_ps(qf, _mm256_set1_ps(VM_SINCOS_PIO2_3), r);
+        z = _mm256_mul_ps(r, r);
+
+        if (accuracy == VM_SINCOS_MEDIUM)
+        {
+            sin_r = _mm256_fmadd_ps(_mm256_mul_ps(r, z), _mm256_fmadd_ps(z, _mm256_set1_ps(VM_SINCOS_MEDIUM_S2), _mm256_set1_ps(VM_SINCOS_MEDIUM_S1)), r);
+            cos_r = _mm256_fmadd_ps(z, _mm256_set1_ps(VM_SINCOS_MEDIUM_C3), _mm256_set1_ps(VM_SINCOS_MEDIUM_C2));
+            cos_r = _mm256_fmadd_ps(z, _mm256_fmadd_ps(z, cos_r, _mm256_set1_ps(VM_SINCOS_MEDIUM_C1)), one);
+        }
+        else
+        {
+            sin_r = _mm256_fmadd_ps(z, _mm256_set1_ps(VM_SINCOS_PRECISE_S3), _mm256_set1_ps(VM_SINCOS_PRECISE_S2));
+            sin_r = _mm256_fmadd_ps(_mm256_mul_ps(r, z), _mm256_fmadd_ps(z, sin_r, _mm256_set1_ps(VM_SINCOS_PRECISE_S1)), r);
+            cos_r = _mm256_fmadd_ps(z, _mm256_set1_ps(VM_SINCOS_PRECISE_C4), _mm256_set1_ps(VM_SINCOS_PRECISE_C3));
+            cos_r = _mm256_fmadd_ps(z, cos_r, _mm256_set1_ps(VM_SINCOS_PRECISE_C2));
+            cos_r = _mm256_fmadd_ps(z, _mm256_fmadd_ps(z, cos_r, _mm256_set1_ps(VM_SINCOS_PRECISE_C1)), one);
+        }
+    }
+
+    swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(q, one_i), one_i));
+    *s = _mm256_blendv_ps(sin_r, cos_r, swap);
+    *c = _mm256_blendv_ps(cos_r, sin_r, swap);
+    *s = _mm256_xor_ps(*s, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(q, two_i), 30)));
+    *c = _mm256_xor_ps(*c, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(q, one_i), two_i), 30)));
+}
+#endif
+
+VM_API VM_INLINE void vm_sincosf_batch(const float *x, float *s, float *c, int count, int accuracy)
+{
+    int i = 0;
+
+#ifdef VM_USE_AVX2
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 s8, c8;
+        vm_sincosf8(_mm256_loadu_ps(x + i), accuracy, &s8, &c8);
+        _mm256_storeu_ps(s + i, s8);
+        _mm256_storeu_ps(c + i, c8);
+    }
+#endif
+
+#ifdef VM_USE_SSE
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 s4, c4;
+        vm_sincosf4(_mm_loadu_ps(x + i), accuracy, &s4, &c4);
+        _mm_storeu_ps(s + i, s4);
+        _mm_storeu_ps(c + i, c4);
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        vm_sincosf_accuracy(x[i], accuracy, s + i, c + i);
+    }
+}
+
 VM_API VM_INLINE float vm_absf(float x)
 {
     return (x < 0.0f ? -x : x);
@@ -610,11 +891,11 @@ VM_API VM_INLINE int vm_v3_equals(v3 a, v3 b)
 VM_API VM_INLINE v3 vm_v3_add(v3 a, v3 b)
 {
 #ifdef VM_USE_SSE
-    __m128 a_vec = _mm_loadu_ps((float *)&a);
-    __m128 b_vec = _mm_loadu_ps((float *)&b);
+    __m128 a_vec = _mm_load_ps((float *)&a);
+    __m128 b_vec = _mm_load_ps((float *)&b);
     __m128 result_vec = _mm_add_ps(a_vec, b_vec);
     v3 result;
-    _mm_storeu_ps((float *)&result, result_vec);
+    _mm_store_ps((float *)&result, result_vec);
     return result;
 #else
     v3 result;
@@ -630,11 +911,11 @@ VM_API VM_INLINE v3 vm_v3_add(v3 a, v3 b)
 VM_API VM_INLINE v3 vm_v3_addf(v3 a, float b)
 {
 #ifdef VM_USE_SSE
-    __m128 a_vec = _mm_loadu_ps((float *)&a);
+    __m128 a_vec = _mm_load_ps((float *)&a);
     __m128 b_vec = _mm_set1_ps(b);
     __m128 result_vec = _mm_add_ps(a_vec, b_vec);
     v3 result;
-    _mm_storeu_ps((float *)&result, result_vec);
+    _mm_store_ps((float *)&result, result_vec);
     return result;
 #else
     v3 result;
@@ -650,11 +931,11 @@ VM_API VM_INLINE v3 vm_v3_addf(v3 a, float b)
 VM_API VM_INLINE v3 vm_v3_sub(v3 a, v3 b)
 {
 #ifdef VM_USE_SSE
-    __m128 a_vec = _mm_loadu_ps((float *)&a);
-    __m128 b_vec = _mm_loadu_ps((float *)&b);
+    __m128 a_vec = _mm_load_ps((float *)&a);
+    __m128 b_vec = _mm_load_ps((float *)&b);
     __m128 result_vec = _mm_sub_ps(a_vec, b_vec);
     v3 result;
-    _mm_storeu_ps((float *)&result, result_vec);
+    _mm_store_ps((float *)&result, result_vec);
     return result;
 #else
     v3 result;
@@ -670,11 +951,11 @@ VM_API VM_INLINE v3 vm_v3_sub(v3 a, v3 b)
 VM_API VM_INLINE v3 vm_v3_subf(v3 a, float b)
 {
 #ifdef VM_USE_SSE
-    __m128 a_vec = _mm_loadu_ps((float *)&a);
+    __m128 a_vec = _mm_load_ps((float *)&a);
     __m128 b_vec = _mm_set1_ps(b);
     __m128 result_vec = _mm_sub_ps(a_vec, b_vec);
     v3 result;
-    _mm_storeu_ps((float *)&result, result_vec);
+    _mm_store_ps((float *)&result, result_vec);
     return result;
 #else
     v3 result;
@@ -690,11 +971,11 @@ VM_API VM_INLINE v3 vm_v3_subf(v3 a, float b)
 VM_API VM_INLINE v3 vm_v3_mul(v3 a, v3 b)
 {
 #ifdef VM_USE_SSE
-    __m128 a_vec = _mm_loadu_ps((float *)&a);
-    __m128 b_vec = _mm_loadu_ps((float *)&b);
+    __m128 a_vec = _mm_load_ps((float *)&a);
+    __m128 b_vec = _mm_load_ps((float *)&b);
     __m128 result_vec = _mm_mul_ps(a_vec, b_vec);
     v3 result;
-    _mm_storeu_ps((float *)&result, result_vec);
+    _mm_store_ps((float *)&result, result_vec);
     return result;
 #else
     v3 result;
@@ -710,11 +991,11 @@ VM_API VM_INLINE v3 vm_v3_mul(v3 a, v3 b)
 VM_API VM_INLINE v3 vm_v3_mulf(v3 a, float b)
 {
 #ifdef VM_USE_SSE
-    __m128 a_vec = _mm_loadu_ps((float *)&a);
+    __m128 a_vec = _mm_load_ps((float *)&a);
     __m128 b_vec = _mm_set1_ps(b);
     __m128 result_vec = _mm_mul_ps(a_vec, b_vec);
     v3 result;
-    _mm_storeu_ps((float *)&result, result_vec);
+    _mm_store_ps((float *)&result, result_vec);
     return result;
 #else
     v3 result;
@@ -730,11 +1011,11 @@ VM_API VM_INLINE v3 vm_v3_mulf(v3 a, float b)
 VM_API VM_INLINE v3 vm_v3_div(v3 a, v3 b)
 {
 #ifdef VM_USE_SSE
-    __m128 a_vec = _mm_loadu_ps((float *)&a);
-    __m128 b_vec = _mm_loadu_ps((float *)&b);
+    __m128 a_vec = _mm_load_ps((float *)&a);
+    __m128 b_vec = _mm_load_ps((float *)&b);
     __m128 result_vec = _mm_div_ps(a_vec, b_vec);
     v3 result;
-    _mm_storeu_ps((float *)&result, result_vec);
+    _mm_store_ps((float *)&result, result_vec);
     return result;
 #else
     v3 result;
@@ -750,11 +1031,11 @@ VM_API VM_INLINE v3 vm_v3_div(v3 a, v3 b)
 VM_API VM_INLINE v3 vm_v3_divf(v3 a, float b)
 {
 #ifdef VM_USE_SSE
-    __m128 a_vec = _mm_loadu_ps((float *)&a);
+    __m128 a_vec = _mm_load_ps((float *)&a);
     __m128 b_vec = _mm_set1_ps(b);
     __m128 result_vec = _mm_div_ps(a_vec, b_vec);
     v3 result;
-    _mm_storeu_ps((float *)&result, result_vec);
+    _mm_store_ps((float *)&result, result_vec);
     return result;
 #else
     v3 result;
@@ -781,8 +1062,8 @@ VM_API VM_INLINE v3 vm_v3_cross(v3 a, v3 b)
 VM_API VM_INLINE float vm_v3_dot(v3 a, v3 b)
 {
 #ifdef VM_USE_SSE
-    __m128 a_vec = _mm_loadu_ps((float *)&a);
-    __m128 b_vec = _mm_loadu_ps((float *)&b);
+    __m128 a_vec = _mm_load_ps((float *)&a);
+    __m128 b_vec = _mm_load_ps((float *)&b);
     __m128 mul = _mm_mul_ps(a_vec, b_vec);
     __m128 shuf = _mm_shuffle_ps(mul, mul, _MM_SHUFFLE(2, 3, 0, 1));
     __m128 sum = _mm_add_ss(mul, shuf);
@@ -820,14 +1101,14 @@ VM_API VM_INLINE float vm_v3_length(v3 a)
 VM_API VM_INLINE v3 vm_v3_lerp(v3 a, v3 b, float t)
 {
 #ifdef VM_USE_SSE
-    __m128 a_vec = _mm_loadu_ps((float *)&a);
-    __m128 b_vec = _mm_loadu_ps((float *)&b);
+    __m128 a_vec = _mm_load_ps((float *)&a);
+    __m128 b_vec = _mm_load_ps((float *)&b);
     __m128 t_vec = _mm_set1_ps(t);
     __m128 sub_vec = _mm_sub_ps(b_vec, a_vec);
     __m128 mul_vec = _mm_mul_ps(sub_vec, t_vec);
     __m128 result_vec = _mm_add_ps(mul_vec, a_vec);
     v3 result;
-    _mm_storeu_ps((float *)&result, result_vec);
+    _mm_store_ps((float *)&result, result_vec);
     return result;
 #else
     v3 result;
@@ -924,11 +1205,11 @@ VM_API VM_INLINE int vm_v4_equals(v4 a, v4 b)
 VM_API VM_INLINE v4 vm_v4_add(v4 a, v4 b)
 {
 #ifdef VM_USE_SSE
-    __m128 a_vec = _mm_loadu_ps((float *)&a);
-    __m128 b_vec = _mm_loadu_ps((float *)&b);
+    __m128 a_vec = _mm_load_ps((float *)&a);
+    __m128 b_vec = _mm_load_ps((float *)&b);
     __m128 result_vec = _mm_add_ps(a_vec, b_vec);
     v4 result;
-    _mm_storeu_ps((float *)&result, result_vec);
+    _mm_store_ps((float *)&result, result_vec);
     return result;
 #else
     v4 result;
@@ -945,11 +1226,11 @@ VM_API VM_INLINE v4 vm_v4_add(v4 a, v4 b)
 VM_API VM_INLINE v4 vm_v4_addf(v4 a, float b)
 {
 #ifdef VM_USE_SSE
-    __m128 a_vec = _mm_loadu_ps((float *)&a);
+    __m128 a_vec = _mm_load_ps((float *)&a);
     __m128 b_vec = _mm_set1_ps(b);
     __m128 result_vec = _mm_add_ps(a_vec, b_vec);
     v4 result;
-    _mm_storeu_ps((float *)&result, result_vec);
+    _mm_store_ps((float *)&result, result_vec);
     return result;
 #else
     v4 result;
@@ -966,11 +1247,11 @@ VM_API VM_INLINE v4 vm_v4_addf(v4 a, float b)
 VM_API VM_INLINE v4 vm_v4_sub(v4 a, v4 b)
 {
 #ifdef VM_USE_SSE
-    __m128 a_vec = _mm_loadu_ps((float *)&a);
-    __m128 b_vec = _mm_loadu_ps((float *)&b);
+    __m128 a_vec = _mm_load_ps((float *)&a);
+    __m128 b_vec = _mm_load_ps((float *)&b);
     __m128 result_vec = _mm_sub_ps(a_vec, b_vec);
     v4 result;
-    _mm_storeu_ps((float *)&result, result_vec);
+    _mm_store_ps((float *)&result, result_vec);
     return result;
 #else
     v4 result;
@@ -987,11 +1268,11 @@ VM_API VM_INLINE v4 vm_v4_sub(v4 a, v4 b)
 VM_API VM_INLINE v4 vm_v4_subf(v4 a, float b)
 {
 #ifdef VM_USE_SSE
-    __m128 a_vec = _mm_loadu_ps((float *)&a);
+    __m128 a_vec = _mm_load_ps((float *)&a);
     __m128 b_vec = _mm_set1_ps(b);
     __m128 result_vec = _mm_sub_ps(a_vec, b_vec);
     v4 result;
-    _mm_storeu_ps((float *)&result, result_vec);
+    _mm_store_ps((float *)&result, result_vec);
     return result;
 #else
     v4 result;
@@ -1008,11 +1289,11 @@ VM_API VM_INLINE v4 vm_v4_subf(v4 a, float b)
 VM_API VM_INLINE v4 vm_v4_mul(v4 a, v4 b)
 {
 #ifdef VM_USE_SSE
-    __m128 a_vec = _mm_loadu_ps((float *)&a);
-    __m128 b_vec = _mm_loadu_ps((float *)&b);
+    __m128 a_vec = _mm_load_ps((float *)&a);
+    __m128 b_vec = _mm_load_ps((float *)&b);
     __m128 result_vec = _mm_mul_ps(a_vec, b_vec);
     v4 result;
-    _mm_storeu_ps((float *)&result, result_vec);
+    _mm_store_ps((float *)&result, result_vec);
     return result;
 #else
     v4 result;
@@ -1029,11 +1310,11 @@ VM_API VM_INLINE v4 vm_v4_mul(v4 a, v4 b)
 VM_API VM_INLINE v4 vm_v4_mulf(v4 a, float b)
 {
 #ifdef VM_USE_SSE
-    __m128 a_vec = _mm_loadu_ps((float *)&a);
+    __m128 a_vec = _mm_load_ps((float *)&a);
     __m128 b_vec = _mm_set1_ps(b);
     __m128 result_vec = _mm_mul_ps(a_vec, b_vec);
     v4 result;
-    _mm_storeu_ps((float *)&result, result_vec);
+    _mm_store_ps((float *)&result, result_vec);
     return result;
 #else
     v4 result;
@@ -1050,11 +1331,11 @@ VM_API VM_INLINE v4 vm_v4_mulf(v4 a, float b)
 VM_API VM_INLINE v4 vm_v4_div(v4 a, v4 b)
 {
 #ifdef VM_USE_SSE
-    __m128 a_vec = _mm_loadu_ps((float *)&a);
-    __m128 b_vec = _mm_loadu_ps((float *)&b);
+    __m128 a_vec = _mm_load_ps((float *)&a);
+    __m128 b_vec = _mm_load_ps((float *)&b);
     __m128 result_vec = _mm_div_ps(a_vec, b_vec);
     v4 result;
-    _mm_storeu_ps((float *)&result, result_vec);
+    _mm_store_ps((float *)&result, result_vec);
     return result;
 #else
     v4 result;
@@ -1071,11 +1352,11 @@ VM_API VM_INLINE v4 vm_v4_div(v4 a, v4 b)
 VM_API VM_INLINE v4 vm_v4_divf(v4 a, float b)
 {
 #ifdef VM_USE_SSE
-    __m128 a_vec = _mm_loadu_ps((float *)&a);
+    __m128 a_vec = _mm_load_ps((float *)&a);
     __m128 b_vec = _mm_set1_ps(b);
     __m128 result_vec = _mm_div_ps(a_vec, b_vec);
     v4 result;
-    _mm_storeu_ps((float *)&result, result_vec);
+    _mm_store_ps((float *)&result, result_vec);
     return result;
 #else
     v4 result;
@@ -1130,7 +1411,32 @@ static const m4x4 vm_m4x4_identity =
 
 VM_API VM_INLINE m4x4 vm_m4x4_mul(m4x4 a, m4x4 b)
 {
-#ifdef VM_USE_SSE
+#ifdef VM_USE_AVX2
+    /* Two result columns (rows) per step: both halves hold the same column (row) of y, x supplies the broadcasts */
+    m4x4 result;
+#ifdef VM_M4X4_ROW_MAJOR_ORDER
+    const float *x = a.e;
+    const float *y = b.e;
+#else
+    const float *x = b.e;
+    const float *y = a.e;
+#endif
+    __m256 y0 = _mm256_broadcast_ps((const __m128 *)(y + 0));
+    __m256 y1 = _mm256_broadcast_ps((const __m128 *)(y + 4));
+    __m256 y2 = _mm256_broadcast_ps((const __m128 *)(y + 8));
+    __m256 y3 = _mm256_broadcast_ps((const __m128 *)(y + 12));
+    int j;
+    for (j = 0; j < 16; j += 8)
+    {
+        __m256 xj = _mm256_loadu_ps(x + j);
+        __m256 sum = _mm256_mul_ps(_mm256_permute_ps(xj, _MM_SHUFFLE(0, 0, 0, 0)), y0);
+        sum = _mm256_fmadd_ps(_mm256_permute_ps(xj, _MM_SHUFFLE(1, 1, 1, 1)), y1, sum);
+        sum = _mm256_fmadd_ps(_mm256_permute_ps(xj, _MM_SHUFFLE(2, 2, 2, 2)), y2, sum);
+        sum = _mm256_fmadd_ps(_mm256_permute_ps(xj, _MM_SHUFFLE(3, 3, 3, 3)), y3, sum);
+        _mm256_storeu_ps(result.e + j, sum);
+    }
+    return result;
+#elif defined(VM_USE_SSE)
 #ifdef VM_M4X4_ROW_MAJOR_ORDER
     m4x4 result;
     int i;
@@ -1360,11 +1666,12 @@ VM_API VM_INLINE m4x4 vm_m4x4_swap(m4x4 src)
 
 VM_API VM_INLINE m4x4 vm_m4x4_rotate(m4x4 src, float angle, v3 axis)
 {
-    float c = vm_cosf(angle);
+    float s;
+    float c;
 
     v3 axisn = vm_v3_normalize(axis);
-    v3 v = vm_v3_mulf(axisn, 1.0f - c);
-    v3 vs = vm_v3_mulf(axisn, vm_sinf(angle));
+    v3 v;
+    v3 vs;
 
     m4x4 rot = vm_m4x4_zero;
 
@@ -1372,6 +1679,10 @@ VM_API VM_INLINE m4x4 vm_m4x4_rotate(m4x4 src, float angle, v3 axis)
     v3 b;
     v3 f;
 
+    vm_sincosf(angle, &s, &c);
+    v = vm_v3_mulf(axisn, 1.0f - c);
+    vs = vm_v3_mulf(axisn, s);
+
     a = vm_v3_mulf(axisn, v.x);
     rot.e[VM_M4X4_AT(0, 0)] = a.x;
     rot.e[VM_M4X4_AT(1, 0)] = a.y;
@@ -1459,6 +1770,63 @@ VM_API VM_INLINE m4x4 vm_m4x4_lookAt_model(v3 eye, v3 target, v3 up)
 
 VM_API VM_INLINE m4x4 vm_m4x4_inverse(m4x4 m)
 {
+#ifdef VM_USE_SSE
+    /* Same cofactors as below, 4 at a time. l(i) = (e[i + 8], e[i + 8], e[i], e[i]) so that
+     * m(k) = l(i) * l(j) - l(p) * l(q) holds (b_k, b_k, a_k, a_k) */
+    m4x4 inv;
+    __m128 c0 = _mm_loadu_ps(m.e + 0);
+    __m128 c1 = _mm_loadu_ps(m.e + 4);
+    __m128 c2 = _mm_loadu_ps(m.e + 8);
+    __m128 c3 = _mm_loadu_ps(m.e + 12);
+
+    __m128 l0 = _mm_shuffle_ps(c2, c0, _MM_SHUFFLE(0, 0, 0, 0));
+    __m128 l1 = _mm_shuffle_ps(c2, c0, _MM_SHUFFLE(1, 1, 1, 1));
+    __m128 l2 = _mm_shuffle_ps(c2, c0, _MM_SHUFFLE(2, 2, 2, 2));
+    __m128 l3 = _mm_shuffle_ps(c2, c0, _MM_SHUFFLE(3, 3, 3, 3));
+    __m128 l4 = _mm_shuffle_ps(c3, c1, _MM_SHUFFLE(0, 0, 0, 0));
+    __m128 l5 = _mm_shuffle_ps(c3, c1, _MM_SHUFFLE(1, 1, 1, 1));
+    __m128 l6 = _mm_shuffle_ps(c3, c1, _MM_SHUFFLE(2, 2, 2, 2));
+    __m128 l7 = _mm_shuffle_ps(c3, c1, _MM_SHUFFLE(3, 3, 3, 3));
+
+    __m128 m0 = VM_MSUB_PS(l0, l5, _mm_mul_ps(l1, l4));
+    __m128 m1 = VM_MSUB_PS(l0, l6, _mm_mul_ps(l2, l4));
+    __m128 m2 = VM_MSUB_PS(l0, l7, _mm_mul_ps(l3, l4));
+    __m128 m3 = VM_MSUB_PS(l1, l6, _mm_mul_ps(l2, l5));
+    __m128 m4 = VM_MSUB_PS(l1, l7, _mm_mul_ps(l3, l5));
+    __m128 m5 = VM_MSUB_PS(l2, l7, _mm_mul_ps(l3, l6));
+
+    /* (e4, e0, e12, e8), (e5, e1, e13, e9), (e6, e2, e14, e10), (e7, e3, e15, e11) */
+    __m128 lo01 = _mm_unpacklo_ps(c1, c0);
+    __m128 hi01 = _mm_unpackhi_ps(c1, c0);
+    __m128 lo23 = _mm_unpacklo_ps(c3, c2);
+    __m128 hi23 = _mm_unpackhi_ps(c3, c2);
+    __m128 xa = _mm_movelh_ps(lo01, lo23);
+    __m128 xb = _mm_movehl_ps(lo23, lo01);
+    __m128 xc = _mm_movelh_ps(hi01, hi23);
+    __m128 xd = _mm_movehl_ps(hi23, hi01);
+
+    /* det = a0 * b5 - a1 * b4 + a2 * b3 + a3 * b2 - a4 * b1 + a5 * b0 from lanes 0 and 2 */
+    __m128 d = _mm_mul_ps(m0, _mm_shuffle_ps(m5, m5, _MM_SHUFFLE(1, 0, 3, 2)));
+    __m128 sign;
+    float det;
+    d = VM_NMADD_PS(m1, _mm_shuffle_ps(m4, m4, _MM_SHUFFLE(1, 0, 3, 2)), d);
+    d = VM_MADD_PS(m2, _mm_shuffle_ps(m3, m3, _MM_SHUFFLE(1, 0, 3, 2)), d);
+    det = _mm_cvtss_f32(_mm_add_ss(d, _mm_movehl_ps(d, d)));
+
+    if (det == 0.0f)
+    {
+        return (vm_m4x4_zero);
+    }
+
+    sign = _mm_mul_ps(_mm_set1_ps(1.0f / det), _mm_set_ps(-1.0f, 1.0f, -1.0f, 1.0f));
+
+    _mm_storeu_ps(inv.e + 0, _mm_mul_ps(VM_MADD_PS(xd, m3, VM_MSUB_PS(xb, m5, _mm_mul_ps(xc, m4))), sign));
+    _mm_storeu_ps(inv.e + 4, _mm_mul_ps(VM_MADD_PS(xd, m1, VM_MSUB_PS(xa, m5, _mm_mul_ps(xc, m2))), _mm_sub_ps(_mm_setzero_ps(), sign)));
+    _mm_storeu_ps(inv.e + 8, _mm_mul_ps(VM_MADD_PS(xd, m0, VM_MSUB_PS(xa, m4, _mm_mul_ps(xb, m2))), sign));
+    _mm_storeu_ps(inv.e + 12, _mm_mul_ps(VM_MADD_PS(xc, m0, VM_MSUB_PS(xa, m3, _mm_mul_ps(xb, m1))), _mm_sub_ps(_mm_setzero_ps(), sign)));
+
+    return (inv);
+#else
     m4x4 inv;
     float *e = m.e;
     float *o = inv.e;
@@ -1508,6 +1876,7 @@ VM_API VM_INLINE m4x4 vm_m4x4_inverse(m4x4 m)
     o[15] = (+e[8] * a3 - e[9] * a1 + e[10] * a0) * inv_det;
 
     return (inv);
+#endif
 }
 
 /* #############################################################################
@@ -1560,9 +1929,10 @@ VM_API VM_INLINE quat vm_quat_rotate(v3 axis, float angle)
 {
     quat result;
 
-    const float halfAngle = angle * 0.5f;
-    const float sinHalfAngle = vm_sinf(halfAngle);
-    const float cosHalfAngle = vm_cosf(halfAngle);
+    float sinHalfAngle;
+    float cosHalfAngle;
+
+    vm_sincosf(angle * 0.5f, &sinHalfAngle, &cosHalfAngle);
 
     result.x = axis.x * sinHalfAngle;
     result.y = axis.y * sinHalfAngle;
@@ -1574,6 +1944,19 @@ VM_API VM_INLINE quat vm_quat_rotate(v3 axis, float angle)
 
 VM_API VM_INLINE quat vm_quat_normalize(quat a)
 {
+#ifdef VM_USE_SSE
+    /* Length squared in every lane, then vm_invsqrt (rsqrt and one Newton-Raphson step) without leaving the register */
+    __m128 a_vec = _mm_load_ps((float *)&a);
+    __m128 length_squared = _mm_mul_ps(a_vec, a_vec);
+    __m128 y;
+    quat result;
+    length_squared = _mm_add_ps(length_squared, _mm_shuffle_ps(length_squared, length_squared, _MM_SHUFFLE(2, 3, 0, 1)));
+    length_squared = _mm_add_ps(length_squared, _mm_shuffle_ps(length_squared, length_squared, _MM_SHUFFLE(1, 0, 3, 2)));
+    y = _mm_rsqrt_ps(length_squared);
+    y = _mm_mul_ps(y, VM_NMADD_PS(_mm_mul_ps(length_squared, _mm_set1_ps(0.5f)), _mm_mul_ps(y, y), _mm_set1_ps(1.5f)));
+    _mm_store_ps((float *)&result, _mm_mul_ps(a_vec, y));
+    return result;
+#else
     float length_squared = (a.x * a.x) + (a.y * a.y) + (a.z * a.z) + (a.w * a.w);
     float scalar = vm_invsqrt(length_squared);
 
@@ -1585,10 +1968,17 @@ VM_API VM_INLINE quat vm_quat_normalize(quat a)
     result.w = a.w * scalar;
 
     return (result);
+#endif
 }
 
 VM_API VM_INLINE quat vm_quat_conjugate(quat a)
 {
+#ifdef VM_USE_SSE
+    __m128 a_vec = _mm_load_ps((float *)&a);
+    quat result;
+    _mm_store_ps((float *)&result, _mm_xor_ps(a_vec, _mm_set_ps(0.0f, -0.0f, -0.0f, -0.0f)));
+    return result;
+#else
     quat result;
 
     result.x = -a.x;
@@ -1597,10 +1987,35 @@ VM_API VM_INLINE quat vm_quat_conjugate(quat a)
     result.w = a.w;
 
     return (result);
+#endif
+}
+
+#ifdef VM_USE_SSE
+/* a.w * b + (a.x, a.y, a.z, -a.x) * b.wwwx + (a.y, a.z, a.x, -a.y) * b.zxyy - a.zxyz * b.yzxz */
+VM_API VM_INLINE __m128 vm_quat_mul_m128(__m128 a, __m128 b)
+{
+    __m128 t = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 2, 1, 0)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 3, 3, 3)));
+    __m128 result = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)), b);
+    t = VM_MADD_PS(_mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 0, 2, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 1, 0, 2)), t);
+    result = _mm_add_ps(result, _mm_xor_ps(t, _mm_set_ps(-0.0f, 0.0f, 0.0f, 0.0f)));
+    return (VM_NMADD_PS(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 1, 0, 2)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 0, 2, 1)), result));
+}
+
+/* (x, y, z, 0) of a v3, the fourth float is padding */
+VM_API VM_INLINE __m128 vm_v3_load_m128(v3 *a)
+{
+    __m128 a_vec = _mm_load_ps((float *)a);
+    return (_mm_shuffle_ps(a_vec, _mm_unpackhi_ps(a_vec, _mm_setzero_ps()), _MM_SHUFFLE(1, 0, 1, 0)));
 }
+#endif
 
 VM_API VM_INLINE quat vm_quat_mul(quat a, quat b)
 {
+#ifdef VM_USE_SSE
+    quat result;
+    _mm_store_ps((float *)&result, vm_quat_mul_m128(_mm_load_ps((float *)&a), _mm_load_ps((float *)&b)));
+    return result;
+#else
     quat result;
 
     result.w = a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z;
@@ -1609,10 +2024,17 @@ VM_API VM_INLINE quat vm_quat_mul(quat a, quat b)
     result.z = a.z * b.w + a.w * b.z + a.x * b.y - a.y * b.x;
 
     return (result);
+#endif
 }
 
 VM_API VM_INLINE quat vm_quat_mulf(quat a, float b)
 {
+#ifdef VM_USE_SSE
+    __m128 a_vec = _mm_load_ps((float *)&a);
+    quat result;
+    _mm_store_ps((float *)&result, _mm_mul_ps(a_vec, _mm_set1_ps(b)));
+    return result;
+#else
     quat result;
 
     result.x = a.x * b;
@@ -1621,10 +2043,17 @@ VM_API VM_INLINE quat vm_quat_mulf(quat a, float b)
     result.w = a.w * b;
 
     return (result);
+#endif
 }
 
 VM_API VM_INLINE quat vm_quat_mulv3(quat a, v3 b)
 {
+#ifdef VM_USE_SSE
+    /* vm_quat_mul with b.w = 0 */
+    quat result;
+    _mm_store_ps((float *)&result, vm_quat_mul_m128(_mm_load_ps((float *)&a), vm_v3_load_m128(&b)));
+    return result;
+#else
     quat result;
 
     result.w = -a.x * b.x - a.y * b.y - a.z * b.z;
@@ -1633,10 +2062,18 @@ VM_API VM_INLINE quat vm_quat_mulv3(quat a, v3 b)
     result.z = a.w * b.z + a.x * b.y - a.y * b.x;
 
     return (result);
+#endif
 }
 
 VM_API VM_INLINE quat vm_quat_sub(quat a, quat b)
 {
+#ifdef VM_USE_SSE
+    __m128 a_vec = _mm_load_ps((float *)&a);
+    __m128 b_vec = _mm_load_ps((float *)&b);
+    quat result;
+    _mm_store_ps((float *)&result, _mm_sub_ps(a_vec, b_vec));
+    return result;
+#else
     quat result;
 
     result.x = a.x - b.x;
@@ -1645,10 +2082,18 @@ VM_API VM_INLINE quat vm_quat_sub(quat a, quat b)
     result.w = a.w - b.w;
 
     return (result);
+#endif
 }
 
 VM_API VM_INLINE quat vm_quat_add(quat a, quat b)
 {
+#ifdef VM_USE_SSE
+    __m128 a_vec = _mm_load_ps((float *)&a);
+    __m128 b_vec = _mm_load_ps((float *)&b);
+    quat result;
+    _mm_store_ps((float *)&result, _mm_add_ps(a_vec, b_vec));
+    return result;
+#else
     quat result;
 
     result.x = a.x + b.x;
@@ -1657,10 +2102,51 @@ VM_API VM_INLINE quat vm_quat_add(quat a, quat b)
     result.w = a.w + b.w;
 
     return (result);
+#endif
 }
 
+#ifdef VM_LEFT_HAND_LAYOUT
+#define VM_QUAT_HANDEDNESS 2.0f
+#else
+#define VM_QUAT_HANDEDNESS -2.0f
+#endif
+
 VM_API VM_INLINE m4x4 vm_quat_to_rotation_matrix(quat q)
 {
+#ifdef VM_USE_SSE
+    /* Column j = base + factor * (sum of two products), the same roundings as below:
+     * column 0 = (1, 0, 0) + (-2, 2, h) * (yy + zz, xy - wz, xz + wy)
+     * column 1 = (0, 1, 0) + (2, -2, h) * (xy + wz, xx + zz, yz - wx)
+     * column 2 = (0, 0, 1) + (h, h, -2) * (xz - wy, yz + wx, xx + yy) */
+    const float h = VM_QUAT_HANDEDNESS;
+    __m128 q_vec = _mm_load_ps((float *)&q);
+    __m128 column0 = _mm_add_ps(
+        _mm_mul_ps(_mm_shuffle_ps(q_vec, q_vec, _MM_SHUFFLE(3, 0, 0, 1)), _mm_shuffle_ps(q_vec, q_vec, _MM_SHUFFLE(3, 2, 1, 1))),
+        _mm_mul_ps(_mm_mul_ps(_mm_shuffle_ps(q_vec, q_vec, _MM_SHUFFLE(3, 3, 3, 2)), _mm_shuffle_ps(q_vec, q_vec, _MM_SHUFFLE(3, 1, 2, 2))), _mm_set_ps(0.0f, 1.0f, -1.0f, 1.0f)));
+    __m128 column1 = _mm_add_ps(
+        _mm_mul_ps(_mm_shuffle_ps(q_vec, q_vec, _MM_SHUFFLE(3, 1, 0, 0)), _mm_shuffle_ps(q_vec, q_vec, _MM_SHUFFLE(3, 2, 0, 1))),
+        _mm_mul_ps(_mm_mul_ps(_mm_shuffle_ps(q_vec, q_vec, _MM_SHUFFLE(3, 3, 2, 3)), _mm_shuffle_ps(q_vec, q_vec, _MM_SHUFFLE(3, 0, 2, 2))), _mm_set_ps(0.0f, -1.0f, 1.0f, 1.0f)));
+    __m128 column2 = _mm_add_ps(
+        _mm_mul_ps(_mm_shuffle_ps(q_vec, q_vec, _MM_SHUFFLE(3, 0, 1, 0)), _mm_shuffle_ps(q_vec, q_vec, _MM_SHUFFLE(3, 0, 2, 2))),
+        _mm_mul_ps(_mm_mul_ps(_mm_shuffle_ps(q_vec, q_vec, _MM_SHUFFLE(3, 1, 3, 3)), _mm_shuffle_ps(q_vec, q_vec, _MM_SHUFFLE(3, 1, 0, 1))), _mm_set_ps(0.0f, 1.0f, 1.0f, -1.0f)));
+    __m128 column3 = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+    m4x4 result;
+
+    column0 = VM_MADD_PS(_mm_set_ps(0.0f, h, 2.0f, -2.0f), column0, _mm_set_ps(0.0f, 0.0f, 0.0f, 1.0f));
+    column1 = VM_MADD_PS(_mm_set_ps(0.0f, h, -2.0f, 2.0f), column1, _mm_set_ps(0.0f, 0.0f, 1.0f, 0.0f));
+    column2 = VM_MADD_PS(_mm_set_ps(0.0f, -2.0f, h, h), column2, _mm_set_ps(0.0f, 1.0f, 0.0f, 0.0f));
+
+#ifdef VM_M4X4_ROW_MAJOR_ORDER
+    _MM_TRANSPOSE4_PS(column0, column1, column2, column3);
+#endif
+
+    _mm_storeu_ps(result.e + 0, column0);
+    _mm_storeu_ps(result.e + 4, column1);
+    _mm_storeu_ps(result.e + 8, column2);
+    _mm_storeu_ps(result.e + 12, column3);
+
+    return (result);
+#else
     float xx = q.x * q.x;
     float yy = q.y * q.y;
     float zz = q.z * q.z;
@@ -1694,6 +2180,7 @@ VM_API VM_INLINE m4x4 vm_quat_to_rotation_matrix(quat q)
 #endif
 
     return (result);
+#endif
 }
 
 VM_API VM_INLINE quat vm_quat_look_rotation(v3 from, v3 to)
@@ -1745,11 +2232,41 @@ VM_API VM_INLINE quat vm_quat_look_rotation(v3 from, v3 to)
 
 VM_API VM_INLINE float vm_quat_dot(quat a, quat b)
 {
+#ifdef VM_USE_SSE
+    __m128 a_vec = _mm_load_ps((float *)&a);
+    __m128 b_vec = _mm_load_ps((float *)&b);
+    __m128 mul = _mm_mul_ps(a_vec, b_vec);
+    mul = _mm_add_ps(mul, _mm_movehl_ps(mul, mul));
+    return (_mm_cvtss_f32(_mm_add_ss(mul, _mm_shuffle_ps(mul, mul, _MM_SHUFFLE(1, 1, 1, 1)))));
+#else
     return (a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w);
+#endif
+}
+
+/* Normalized lerp along the shorter arc, close to slerp for the small angles between two simulation steps */
+VM_API VM_INLINE quat vm_quat_nlerp(quat a, quat b, float t)
+{
+    float sign = vm_quat_dot(a, b) < 0.0f ? -1.0f : 1.0f;
+    quat result;
+
+    result.x = a.x + (b.x * sign - a.x) * t;
+    result.y = a.y + (b.y * sign - a.y) * t;
+    result.z = a.z + (b.z * sign - a.z) * t;
+    result.w = a.w + (b.w * sign - a.w) * t;
+
+    return (vm_quat_normalize(result));
 }
 
 VM_API VM_INLINE v3 vm_v3_rotate(v3 a, quat rotation)
 {
+#ifdef VM_USE_SSE
+    /* rotation * a * conjugate(rotation) without leaving the registers */
+    __m128 q = _mm_load_ps((float *)&rotation);
+    __m128 conjugate = _mm_xor_ps(q, _mm_set_ps(0.0f, -0.0f, -0.0f, -0.0f));
+    v3 result;
+    _mm_store_ps((float *)&result, vm_quat_mul_m128(vm_quat_mul_m128(q, vm_v3_load_m128(&a)), conjugate));
+    return result;
+#else
     v3 result;
 
     quat conjugate = vm_quat_conjugate(rotation);
@@ -1761,6 +2278,7 @@ VM_API VM_INLINE v3 vm_v3_rotate(v3 a, quat rotation)
     result.z = rotated.z;
 
     return (result);
+#endif
 }
 
 VM_API VM_INLINE v3 vm_quat_forward(quat rotation)
@@ -1990,6 +2508,192 @@ VM_API VM_INLINE int vm_frustum_is_sphere_in(frustum frustum, v3 center, float r
     return (1); /* Intersects or inside */
 }
 
+/* Oriented box given by its center and its box axes in world space (rotation and scale, not necessarily unit length).
+ * Per plane the box projects to the radius |dot(n, axis_x)| * h.x + |dot(n, axis_y)| * h.y + |dot(n, axis_z)| * h.z,
+ * which is exact for any rotation so no epsilon is needed.
+ * The frustum is passed by pointer since this runs once per instance and nostdlib builds copy structs byte by byte.
+ */
+VM_API VM_INLINE int vm_frustum_is_obb_in_axes(const frustum *frustum, v3 center, v3 axis_x, v3 axis_y, v3 axis_z, v3 half_extents)
+{
+    const v4 *frustum_data = (const v4 *)frustum;
+
+    int i;
+
+    for (i = 0; i < VM_FRUSTUM_PLANE_SIZE; ++i)
+    {
+        const v4 *plane = &frustum_data[i];
+        float distance = plane->x * center.x + plane->y * center.y + plane->z * center.z + plane->w;
+        float radius = vm_absf(plane->x * axis_x.x + plane->y * axis_x.y + plane->z * axis_x.z) * half_extents.x +
+                       vm_absf(plane->x * axis_y.x + plane->y * axis_y.y + plane->z * axis_y.z) * half_extents.y +
+                       vm_absf(plane->x * axis_z.x + plane->y * axis_z.y + plane->z * axis_z.z) * half_extents.z;
+
+        if (distance < -radius)
+        {
+            return (0); /* Completely outside */
+        }
+    }
+
+    return (1); /* Intersects or inside */
+}
+
+/* The local box [-half_extents, half_extents] transformed by the model matrix (translation, rotation and scale) */
+VM_API VM_INLINE int vm_frustum_is_obb_in(const frustum *frustum, const m4x4 *model, v3 half_extents)
+{
+    v3 axis_x = vm_v3(model->e[VM_M4X4_AT(0, 0)], model->e[VM_M4X4_AT(1, 0)], model->e[VM_M4X4_AT(2, 0)]);
+    v3 axis_y = vm_v3(model->e[VM_M4X4_AT(0, 1)], model->e[VM_M4X4_AT(1, 1)], model->e[VM_M4X4_AT(2, 1)]);
+    v3 axis_z = vm_v3(model->e[VM_M4X4_AT(0, 2)], model->e[VM_M4X4_AT(1, 2)], model->e[VM_M4X4_AT(2, 2)]);
+    v3 center = vm_v3(model->e[VM_M4X4_AT(0, 3)], model->e[VM_M4X4_AT(1, 3)], model->e[VM_M4X4_AT(2, 3)]);
+
+    return (vm_frustum_is_obb_in_axes(frustum, center, axis_x, axis_y, axis_z, half_extents));
+}
+
+/* The local box [-half_extents, half_extents] rotated by a unit quaternion and moved to center */
+VM_API VM_INLINE int vm_frustum_is_obb_in_rotation(const frustum *frustum, v3 center, quat rotation, v3 half_extents)
+{
+    m4x4 rotation_matrix = vm_quat_to_rotation_matrix(rotation);
+
+    rotation_matrix.e[VM_M4X4_AT(0, 3)] = center.x;
+    rotation_matrix.e[VM_M4X4_AT(1, 3)] = center.y;
+    rotation_matrix.e[VM_M4X4_AT(2, 3)] = center.z;
+
+    return (vm_frustum_is_obb_in(frustum, &rotation_matrix, half_extents));
+}
+
+/* Radius of the sphere around the model matrix translation that contains the local box [-half_extents, half_extents]
+ * for the rotation and scale of model. Cheaper but more conservative than the oriented box test (vm_frustum_is_sphere_in). */
+VM_API VM_INLINE float vm_m4x4_bounding_sphere_radius(const m4x4 *model, v3 half_extents)
+{
+    v3 axis_x = vm_v3(model->e[VM_M4X4_AT(0, 0)], model->e[VM_M4X4_AT(1, 0)], model->e[VM_M4X4_AT(2, 0)]);
+    v3 axis_y = vm_v3(model->e[VM_M4X4_AT(0, 1)], model->e[VM_M4X4_AT(1, 1)], model->e[VM_M4X4_AT(2, 1)]);
+    v3 axis_z = vm_v3(model->e[VM_M4X4_AT(0, 2)], model->e[VM_M4X4_AT(1, 2)], model->e[VM_M4X4_AT(2, 2)]);
+
+    /* Half diagonal of the box after scaling each axis */
+    v3 scaled = vm_v3(vm_v3_length(axis_x) * half_extents.x, vm_v3_length(axis_y) * half_extents.y, vm_v3_length(axis_z) * half_extents.z);
+
+    return (vm_v3_length(scaled));
+}
+
+/* Axis aligned box around the local box [-half_extents, half_extents] transformed by the model matrix */
+VM_API VM_INLINE void vm_m4x4_aabb(const m4x4 *model, v3 half_extents, v3 *center, v3 *extents)
+{
+    const float *m = model->e;
+
+    center->x = m[VM_M4X4_AT(0, 3)];
+    center->y = m[VM_M4X4_AT(1, 3)];
+    center->z = m[VM_M4X4_AT(2, 3)];
+
+    extents->x = vm_absf(m[VM_M4X4_AT(0, 0)]) * half_extents.x + vm_absf(m[VM_M4X4_AT(0, 1)]) * half_extents.y + vm_absf(m[VM_M4X4_AT(0, 2)]) * half_extents.z;
+    extents->y = vm_absf(m[VM_M4X4_AT(1, 0)]) * half_extents.x + vm_absf(m[VM_M4X4_AT(1, 1)]) * half_extents.y + vm_absf(m[VM_M4X4_AT(1, 2)]) * half_extents.z;
+    extents->z = vm_absf(m[VM_M4X4_AT(2, 0)]) * half_extents.x + vm_absf(m[VM_M4X4_AT(2, 1)]) * half_extents.y + vm_absf(m[VM_M4X4_AT(2, 2)]) * half_extents.z;
+}
+
+/* Visibility bitmask for count axis aligned boxes given as separate arrays (SoA) of centers and half extents.
+ * Bit (i % 32) of visibility_mask[i / 32] is set if box i is inside or intersects the frustum, the mask must hold
+ * (count + 31) / 32 words. A box is outside if it is completely behind one plane:
+ *
+ *   dot(plane.xyz, center) + plane.w < -(|plane.x| * extent.x + |plane.y| * extent.y + |plane.z| * extent.z)
+ *
+ * Tests 8 boxes per step with VM_USE_AVX2, 4 with VM_USE_SSE and the remaining boxes one by one.
+ */
+VM_API VM_INLINE void vm_frustum_cull_aabb_soa(
+    frustum frustum,
+    const float *center_x, const float *center_y, const float *center_z,
+    const float *extent_x, const float *extent_y, const float *extent_z,
+    int count,
+    unsigned int *visibility_mask)
+{
+    v4 *frustum_data = vm_frustum_data(&frustum);
+    float plane_abs[VM_FRUSTUM_PLANE_SIZE][3];
+    int i = 0;
+    int p;
+
+    for (p = 0; p < (count + 31) / 32; ++p)
+    {
+        visibility_mask[p] = 0;
+    }
+
+    for (p = 0; p < VM_FRUSTUM_PLANE_SIZE; ++p)
+    {
+        plane_abs[p][0] = vm_absf(frustum_data[p].x);
+        plane_abs[p][1] = vm_absf(frustum_data[p].y);
+        plane_abs[p][2] = vm_absf(frustum_data[p].z);
+    }
+
+#ifdef VM_USE_AVX2
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 cx = _mm256_loadu_ps(center_x + i);
+        __m256 cy = _mm256_loadu_ps(center_y + i);
+        __m256 cz = _mm256_loadu_ps(center_z + i);
+        __m256 ex = _mm256_loadu_ps(extent_x + i);
+        __m256 ey = _mm256_loadu_ps(extent_y + i);
+        __m256 ez = _mm256_loadu_ps(extent_z + i);
+        __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+        for (p = 0; p < VM_FRUSTUM_PLANE_SIZE; ++p)
+        {
+            __m256 distance = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(frustum_data[p].x), cx), _mm256_mul_ps(_mm256_set1_ps(frustum_data[p].y), cy)),
+                _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(frustum_data[p].z), cz), _mm256_set1_ps(frustum_data[p].w)));
+            __m256 radius = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane_abs[p][0]), ex), _mm256_mul_ps(_mm256_set1_ps(plane_abs[p][1]), ey)),
+                _mm256_mul_ps(_mm256_set1_ps(plane_abs[p][2]), ez));
+
+            visible = _mm256_and_ps(visible, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+
+        visibility_mask[i >> 5] |= (unsigned int)_mm256_movemask_ps(visible) << (i & 31);
+    }
+#endif
+
+#ifdef VM_USE_SSE
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 cx = _mm_loadu_ps(center_x + i);
+        __m128 cy = _mm_loadu_ps(center_y + i);
+        __m128 cz = _mm_loadu_ps(center_z + i);
+        __m128 ex = _mm_loadu_ps(extent_x + i);
+        __m128 ey = _mm_loadu_ps(extent_y + i);
+        __m128 ez = _mm_loadu_ps(extent_z + i);
+        __m128 visible = _mm_cmpeq_ps(cx, cx); /* all bits set, a NaN center is not visible like in the scalar loop */
+
+        for (p = 0; p < VM_FRUSTUM_PLANE_SIZE; ++p)
+        {
+            __m128 distance = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(frustum_data[p].x), cx), _mm_mul_ps(_mm_set1_ps(frustum_data[p].y), cy)),
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(frustum_data[p].z), cz), _mm_set1_ps(frustum_data[p].w)));
+            __m128 radius = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane_abs[p][0]), ex), _mm_mul_ps(_mm_set1_ps(plane_abs[p][1]), ey)),
+                _mm_mul_ps(_mm_set1_ps(plane_abs[p][2]), ez));
+
+            visible = _mm_and_ps(visible, _mm_cmpge_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+        }
+
+        visibility_mask[i >> 5] |= (unsigned int)_mm_movemask_ps(visible) << (i & 31);
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        unsigned int visible = 1;
+
+        for (p = 0; p < VM_FRUSTUM_PLANE_SIZE; ++p)
+        {
+            float distance = (frustum_data[p].x * center_x[i] + frustum_data[p].y * center_y[i]) + (frustum_data[p].z * center_z[i] + frustum_data[p].w);
+            float radius = (plane_abs[p][0] * extent_x[i] + plane_abs[p][1] * extent_y[i]) + plane_abs[p][2] * extent_z[i];
+
+            visible &= (unsigned int)(distance + radius >= 0.0f);
+        }
+
+        visibility_mask[i >> 5] |= visible << (i & 31);
+    }
+}
+
+VM_API VM_INLINE int vm_frustum_cull_mask_is_visible(unsigned int *visibility_mask, int index)
+{
+    return ((int)((visibility_mask[index >> 5] >> (index & 31)) & 1));
+}
+
 /* #############################################################################
  * # TRANSFORMATION FUNCTIONS
  * #############################################################################
@@ -2047,6 +2751,385 @@ VM_API VM_INLINE v3 vm_transformation_up(transformation *t)
     return vm_v3_rotate(vm_v3_up, t->rotation);
 }
 
+/* #############################################################################
+ * # BATCH TRANSFORMATION FUNCTIONS
+ * #############################################################################
+ *
+ * Model matrices of many instances at once, model = translate(position) * rotate(rotation) * scale(scale) like
+ * vm_transformation_matrix without parent. The matrices are written straight into the instance buffer (stride
+ * floats from one instance to the next) instead of being returned by value. rotations and scales may be 0
+ * (no rotation, scale one). VM_USE_SSE builds 4 instances per step from transposed (x, y, z, w) loads, VM_USE_AVX2
+ * 8 instances per step (instances i and i + 4 share a register, one in each 128 bit half).
+ *
+ * vm_m4x4_trs_batch   : float m[16] column major per instance
+ * vm_affine_trs_batch : float t[3], float linear[9] column major 3x3 per instance
+ */
+
+/* Quaternion of vm_m4x4_rotate(vm_m4x4_identity, angle, axis) for the batch kernels (axis normalized) */
+VM_API VM_INLINE quat vm_quat_from_axis_angle_m4x4(v3 axis, float angle)
+{
+#ifdef VM_LEFT_HAND_LAYOUT
+    return (vm_quat_rotate(axis, -angle));
+#else
+    /* The right-handed layout of vm_quat_to_rotation_matrix mirrors z */
+    return (vm_quat_rotate(vm_v3(axis.x, axis.y, -axis.z), angle));
+#endif
+}
+
+/* Columns of one instance: e[0..2] translation, e[3..11] the 3x3 part column major */
+VM_API VM_INLINE void vm_trs_columns(const v3 *position, const quat *rotation, const v3 *scale, float e[12])
+{
+    float sx = scale ? scale->x : 1.0f;
+    float sy = scale ? scale->y : 1.0f;
+    float sz = scale ? scale->z : 1.0f;
+
+    e[0] = position->x;
+    e[1] = position->y;
+    e[2] = position->z;
+
+    if (rotation)
+    {
+        float xx = rotation->x * rotation->x;
+        float yy = rotation->y * rotation->y;
+        float zz = rotation->z * rotation->z;
+        float xy = rotation->x * rotation->y;
+        float xz = rotation->x * rotation->z;
+        float yz = rotation->y * rotation->z;
+        float wx = rotation->w * rotation->x;
+        float wy = rotation->w * rotation->y;
+        float wz = rotation->w * rotation->z;
+
+        e[3] = (1.0f - 2.0f * (yy + zz)) * sx;
+        e[4] = (2.0f * (xy - wz)) * sx;
+        e[5] = (VM_QUAT_HANDEDNESS * (xz + wy)) * sx;
+        e[6] = (2.0f * (xy + wz)) * sy;
+        e[7] = (1.0f - 2.0f * (xx + zz)) * sy;
+        e[8] = (VM_QUAT_HANDEDNESS * (yz - wx)) * sy;
+        e[9] = (VM_QUAT_HANDEDNESS * (xz - wy)) * sz;
+        e[10] = (VM_QUAT_HANDEDNESS * (yz + wx)) * sz;
+        e[11] = (1.0f - 2.0f * (xx + yy)) * sz;
+    }
+    else
+    {
+        e[3] = sx;
+        e[4] = 0.0f;
+        e[5] = 0.0f;
+        e[6] = 0.0f;
+        e[7] = sy;
+        e[8] = 0.0f;
+        e[9] = 0.0f;
+        e[10] = 0.0f;
+        e[11] = sz;
+    }
+}
+
+VM_API VM_INLINE void vm_trs_store(const float e[12], float *out, int affine)
+{
+    int k;
+
+    if (affine)
+    {
+        for (k = 0; k < 12; ++k)
+        {
+            out[k] = e[k];
+        }
+        return;
+    }
+
+    out[0] = e[3];
+    out[1] = e[4];
+    out[2] = e[5];
+    out[3] = 0.0f;
+    out[4] = e[6];
+    out[5] = e[7];
+    out[6] = e[8];
+    out[7] = 0.0f;
+    out[8] = e[9];
+    out[9] = e[10];
+    out[10] = e[11];
+    out[11] = 0.0f;
+    out[12] = e[0];
+    out[13] = e[1];
+    out[14] = e[2];
+    out[15] = 1.0f;
+}
+
+#ifdef VM_USE_AVX2
+/* _MM_TRANSPOSE4_PS within both 128 bit halves */
+#define VM_TRANSPOSE4_256(r0, r1, r2, r3)                                    \
+    do                                                                       \
+    {                                                                        \
+        __m256 t0_ = _mm256_unpacklo_ps(r0, r1);                             \
+        __m256 t1_ = _mm256_unpacklo_ps(r2, r3);                             \
+        __m256 t2_ = _mm256_unpackhi_ps(r0, r1);                             \
+        __m256 t3_ = _mm256_unpackhi_ps(r2, r3);                             \
+        (r0) = _mm256_shuffle_ps(t0_, t1_, _MM_SHUFFLE(1, 0, 1, 0));         \
+        (r1) = _mm256_shuffle_ps(t0_, t1_, _MM_SHUFFLE(3, 2, 3, 2));         \
+        (r2) = _mm256_shuffle_ps(t2_, t3_, _MM_SHUFFLE(1, 0, 1, 0));         \
+        (r3) = _mm256_shuffle_ps(t2_, t3_, _MM_SHUFFLE(3, 2, 3, 2));         \
+    } while (0)
+
+#define VM_LOAD_256(lo, hi) _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_load_ps(lo)), _mm_load_ps(hi), 1)
+#endif
+
+VM_API VM_INLINE void vm_trs_batch(const v3 *positions, const quat *rotations, const v3 *scales, int count, float *out, int stride, int affine)
+{
+    int i = 0;
+
+#ifdef VM_USE_AVX2
+    const __m256 one8 = _mm256_set1_ps(1.0f);
+    const __m256 two8 = _mm256_set1_ps(2.0f);
+    const __m256 handedness8 = _mm256_set1_ps(VM_QUAT_HANDEDNESS);
+    const __m256 zero8 = _mm256_setzero_ps();
+    const int floats = affine ? 12 : 16;
+#endif
+#ifdef VM_USE_SSE
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 handedness = _mm_set1_ps(VM_QUAT_HANDEDNESS);
+    const __m128 zero = _mm_setzero_ps();
+#endif
+
+#ifdef VM_USE_AVX2
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 px = VM_LOAD_256(&positions[i + 0].x, &positions[i + 4].x);
+        __m256 py = VM_LOAD_256(&positions[i + 1].x, &positions[i + 5].x);
+        __m256 pz = VM_LOAD_256(&positions[i + 2].x, &positions[i + 6].x);
+        __m256 pw = VM_LOAD_256(&positions[i + 3].x, &positions[i + 7].x);
+        __m256 sx = one8;
+        __m256 sy = one8;
+        __m256 sz = one8;
+        __m256 m00, m10, m20, m01, m11, m21, m02, m12, m22;
+        __m256 rows[16];
+        int k;
+        int r;
+
+        VM_TRANSPOSE4_256(px, py, pz, pw);
+
+        if (scales)
+        {
+            __m256 sw = VM_LOAD_256(&scales[i + 3].x, &scales[i + 7].x);
+            sx = VM_LOAD_256(&scales[i + 0].x, &scales[i + 4].x);
+            sy = VM_LOAD_256(&scales[i + 1].x, &scales[i + 5].x);
+            sz = VM_LOAD_256(&scales[i + 2].x, &scales[i + 6].x);
+            VM_TRANSPOSE4_256(sx, sy, sz, sw);
+        }
+
+        if (rotations)
+        {
+            __m256 qx = VM_LOAD_256(&rotations[i + 0].x, &rotations[i + 4].x);
+            __m256 qy = VM_LOAD_256(&rotations[i + 1].x, &rotations[i + 5].x);
+            __m256 qz = VM_LOAD_256(&rotations[i + 2].x, &rotations[i + 6].x);
+            __m256 qw = VM_LOAD_256(&rotations[i + 3].x, &rotations[i + 7].x);
+            __m256 xx, yy, zz, xy, xz, yz, wx, wy, wz;
+
+            VM_TRANSPOSE4_256(qx, qy, qz, qw);
+
+            xx = _mm256_mul_ps(qx, qx);
+            yy = _mm256_mul_ps(qy, qy);
+            zz = _mm256_mul_ps(qz, qz);
+            xy = _mm256_mul_ps(qx, qy);
+            xz = _mm256_mul_ps(qx, qz);
+            yz = _mm256_mul_ps(qy, qz);
+            wx = _mm256_mul_ps(qw, qx);
+            wy = _mm256_mul_ps(qw, qy);
+            wz = _mm256_mul_ps(qw, qz);
+
+            /* 1 - 2 * s fused is still exact in the product, the results match the scalar loop bit for bit */
+            m00 = _mm256_mul_ps(_mm256_fnmadd_ps(two8, _mm256_add_ps(yy, zz), one8), sx);
+            m10 = _mm256_mul_ps(_mm256_mul_ps(two8, _mm256_sub_ps(xy, wz)), sx);
+            m20 = _mm256_mul_ps(_mm256_mul_ps(handedness8, _mm256_add_ps(xz, wy)), sx);
+            m01 = _mm256_mul_ps(_mm256_mul_ps(two8, _mm256_add_ps(xy, wz)), sy);
+            m11 = _mm256_mul_ps(_mm256_fnmadd_ps(two8, _mm256_add_ps(xx, zz), one8), sy);
+            m21 = _mm256_mul_ps(_mm256_mul_ps(handedness8, _mm256_sub_ps(yz, wx)), sy);
+            m02 = _mm256_mul_ps(_mm256_mul_ps(handedness8, _mm256_sub_ps(xz, wy)), sz);
+            m12 = _mm256_mul_ps(_mm256_mul_ps(handedness8, _mm256_add_ps(yz, wx)), sz);
+            m22 = _mm256_mul_ps(_mm256_fnmadd_ps(two8, _mm256_add_ps(xx, yy), one8), sz);
+        }
+        else
+        {
+            m00 = sx;
+            m11 = sy;
+            m22 = sz;
+            m10 = m20 = m01 = m21 = m02 = m12 = zero8;
+        }
+
+        /* Lanes back to instances, rows[r + k] holds floats r..r+3 of instance i + k and i + k + 4 */
+        if (affine)
+        {
+            rows[0] = px, rows[1] = py, rows[2] = pz, rows[3] = m00;
+            rows[4] = m10, rows[5] = m20, rows[6] = m01, rows[7] = m11;
+            rows[8] = m21, rows[9] = m02, rows[10] = m12, rows[11] = m22;
+        }
+        else
+        {
+            rows[0] = m00, rows[1] = m10, rows[2] = m20, rows[3] = zero8;
+            rows[4] = m01, rows[5] = m11, rows[6] = m21, rows[7] = zero8;
+            rows[8] = m02, rows[9] = m12, rows[10] = m22, rows[11] = zero8;
+            rows[12] = px, rows[13] = py, rows[14] = pz, rows[15] = one8;
+        }
+
+        for (r = 0; r < floats; r += 4)
+        {
+            VM_TRANSPOSE4_256(rows[r + 0], rows[r + 1], rows[r + 2], rows[r + 3]);
+        }
+
+        for (k = 0; k < 4; ++k)
+        {
+            float *lo = out + (i + k) * stride;
+            float *hi = out + (i + k + 4) * stride;
+
+            for (r = 0; r < floats; r += 4)
+            {
+                _mm_storeu_ps(lo + r, _mm256_castps256_ps128(rows[r + k]));
+                _mm_storeu_ps(hi + r, _mm256_extractf128_ps(rows[r + k], 1));
+            }
+        }
+    }
+#endif
+
+#ifdef VM_USE_SSE
+    for (; i + 4 <= count; i += 4)
+    {
+        /* Instances to lanes: (x, y, z, w) of 4 instances become x, y, z and w of 4 lanes */
+        __m128 px = _mm_load_ps(&positions[i + 0].x);
+        __m128 py = _mm_load_ps(&positions[i + 1].x);
+        __m128 pz = _mm_load_ps(&positions[i + 2].x);
+        __m128 pw = _mm_load_ps(&positions[i + 3].x);
+        __m128 sx = one;
+        __m128 sy = one;
+        __m128 sz = one;
+        __m128 m00, m10, m20, m01, m11, m21, m02, m12, m22;
+        float *o0 = out + (i + 0) * stride;
+        float *o1 = out + (i + 1) * stride;
+        float *o2 = out + (i + 2) * stride;
+        float *o3 = out + (i + 3) * stride;
+
+        _MM_TRANSPOSE4_PS(px, py, pz, pw);
+
+        if (scales)
+        {
+            __m128 sw = _mm_load_ps(&scales[i + 3].x);
+            sx = _mm_load_ps(&scales[i + 0].x);
+            sy = _mm_load_ps(&scales[i + 1].x);
+            sz = _mm_load_ps(&scales[i + 2].x);
+            _MM_TRANSPOSE4_PS(sx, sy, sz, sw);
+        }
+
+        if (rotations)
+        {
+            __m128 qx = _mm_load_ps(&rotations[i + 0].x);
+            __m128 qy = _mm_load_ps(&rotations[i + 1].x);
+            __m128 qz = _mm_load_ps(&rotations[i + 2].x);
+            __m128 qw = _mm_load_ps(&rotations[i + 3].x);
+            __m128 xx, yy, zz, xy, xz, yz, wx, wy, wz;
+
+            _MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+
+            xx = _mm_mul_ps(qx, qx);
+            yy = _mm_mul_ps(qy, qy);
+            zz = _mm_mul_ps(qz, qz);
+            xy = _mm_mul_ps(qx, qy);
+            xz = _mm_mul_ps(qx, qz);
+            yz = _mm_mul_ps(qy, qz);
+            wx = _mm_mul_ps(qw, qx);
+            wy = _mm_mul_ps(qw, qy);
+            wz = _mm_mul_ps(qw, qz);
+
+            m00 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+            m10 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sx);
+            m20 = _mm_mul_ps(_mm_mul_ps(handedness, _mm_add_ps(xz, wy)), sx);
+            m01 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sy);
+            m11 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+            m21 = _mm_mul_ps(_mm_mul_ps(handedness, _mm_sub_ps(yz, wx)), sy);
+            m02 = _mm_mul_ps(_mm_mul_ps(handedness, _mm_sub_ps(xz, wy)), sz);
+            m12 = _mm_mul_ps(_mm_mul_ps(handedness, _mm_add_ps(yz, wx)), sz);
+            m22 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+        }
+        else
+        {
+            m00 = sx;
+            m11 = sy;
+            m22 = sz;
+            m10 = m20 = m01 = m21 = m02 = m12 = zero;
+        }
+
+        /* Lanes back to instances, 4 floats of every instance per transpose */
+        if (affine)
+        {
+            __m128 a0 = px, a1 = py, a2 = pz, a3 = m00;
+            __m128 b0 = m10, b1 = m20, b2 = m01, b3 = m11;
+            __m128 c0 = m21, c1 = m02, c2 = m12, c3 = m22;
+
+            _MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+            _MM_TRANSPOSE4_PS(b0, b1, b2, b3);
+            _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+            _mm_storeu_ps(o0 + 0, a0);
+            _mm_storeu_ps(o0 + 4, b0);
+            _mm_storeu_ps(o0 + 8, c0);
+            _mm_storeu_ps(o1 + 0, a1);
+            _mm_storeu_ps(o1 + 4, b1);
+            _mm_storeu_ps(o1 + 8, c1);
+            _mm_storeu_ps(o2 + 0, a2);
+            _mm_storeu_ps(o2 + 4, b2);
+            _mm_storeu_ps(o2 + 8, c2);
+            _mm_storeu_ps(o3 + 0, a3);
+            _mm_storeu_ps(o3 + 4, b3);
+            _mm_storeu_ps(o3 + 8, c3);
+        }
+        else
+        {
+            __m128 a0 = m00, a1 = m10, a2 = m20, a3 = zero;
+            __m128 b0 = m01, b1 = m11, b2 = m21, b3 = zero;
+            __m128 c0 = m02, c1 = m12, c2 = m22, c3 = zero;
+            __m128 d0 = px, d1 = py, d2 = pz, d3 = one;
+
+            _MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+            _MM_TRANSPOSE4_PS(b0, b1, b2, b3);
+            _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+            _MM_TRANSPOSE4_PS(d0, d1, d2, d3);
+
+            _mm_storeu_ps(o0 + 0, a0);
+            _mm_storeu_ps(o0 + 4, b0);
+            _mm_storeu_ps(o0 + 8, c0);
+            _mm_storeu_ps(o0 + 12, d0);
+            _mm_storeu_ps(o1 + 0, a1);
+            _mm_storeu_ps(o1 + 4, b1);
+            _mm_storeu_ps(o1 + 8, c1);
+            _mm_storeu_ps(o1 + 12, d1);
+            _mm_storeu_ps(o2 + 0, a2);
+            _mm_storeu_ps(o2 + 4, b2);
+            _mm_storeu_ps(o2 + 8, c2);
+            _mm_storeu_ps(o2 + 12, d2);
+            _mm_storeu_ps(o3 + 0, a3);
+            _mm_storeu_ps(o3 + 4, b3);
+            _mm_storeu_ps(o3 + 8, c3);
+            _mm_storeu_ps(o3 + 12, d3);
+        }
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        float e[12];
+
+        vm_trs_columns(&positions[i], rotations ? &rotations[i] : 0, scales ? &scales[i] : 0, e);
+        vm_trs_store(e, out + i * stride, affine);
+    }
+}
+
+VM_API VM_INLINE void vm_m4x4_trs_batch(const v3 *positions, const quat *rotations, const v3 *scales, int count, float *out, int stride)
+{
+    vm_trs_batch(positions, rotations, scales, count, out, stride, 0);
+}
+
+VM_API VM_INLINE void vm_affine_trs_batch(const v3 *positions, const quat *rotations, const v3 *scales, int count, float *out, int stride)
+{
+    vm_trs_batch(positions, rotations, scales, count, out, stride, 1);
+}
+
 /* #############################################################################
  * # RIGID BODY FUNCTIONS
  * #############################################################################
@@ -2138,6 +3221,78 @@ VM_API VM_INLINE void vm_rigid_body_integrate(rigid_body *rb, float dt)
     rb->torque = vm_v3_zero;
 }
 
+/* State between two integrated states for rendering, alpha 0 is previous and 1 is current (no forces) */
+VM_API VM_INLINE rigid_body vm_rigid_body_interpolate(rigid_body *previous, rigid_body *current, float alpha)
+{
+    rigid_body result = *current;
+
+    result.position = vm_v3_lerp(previous->position, current->position, alpha);
+    result.velocity = vm_v3_lerp(previous->velocity, current->velocity, alpha);
+    result.angularVelocity = vm_v3_lerp(previous->angularVelocity, current->angularVelocity, alpha);
+    result.orientation = vm_quat_nlerp(previous->orientation, current->orientation, alpha);
+    result.force = vm_v3_zero;
+    result.torque = vm_v3_zero;
+
+    return (result);
+}
+
+/* #############################################################################
+ * # FIXED TIMESTEP FUNCTIONS
+ * #############################################################################
+ */
+/* Time is accumulated in double, a float accumulator would gain or lose a step over a few thousand short frames */
+typedef struct vm_fixed_step
+{
+    double step;         /* Seconds per simulation step (1 / hz) */
+    double accumulator;  /* Frame time not simulated yet, below step after vm_fixed_step_advance */
+    int max_substeps;    /* Steps per frame at most, a longer frame (hitch, breakpoint) drops the rest of its time */
+    unsigned long steps; /* Steps taken so far */
+
+} vm_fixed_step;
+
+VM_API VM_INLINE vm_fixed_step vm_fixed_step_init(float hz, int max_substeps)
+{
+    vm_fixed_step result;
+
+    result.step = hz > 0.0f ? 1.0 / (double)hz : 1.0 / 60.0;
+    result.accumulator = 0.0;
+    result.max_substeps = max_substeps > 0 ? max_substeps : 1;
+    result.steps = 0;
+
+    return (result);
+}
+
+/* Adds the frame time dt and returns the number of steps to simulate for it (0 to max_substeps) */
+VM_API VM_INLINE int vm_fixed_step_advance(vm_fixed_step *fs, double dt)
+{
+    int count = 0;
+
+    fs->accumulator += dt > 0.0 ? dt : 0.0;
+
+    /* accumulator - step of accumulator >= step is never negative, no time is created */
+    while (fs->accumulator >= fs->step)
+    {
+        if (count == fs->max_substeps)
+        {
+            fs->accumulator = 0.0;
+            break;
+        }
+
+        fs->accumulator -= fs->step;
+        count++;
+    }
+
+    fs->steps += (unsigned long)count;
+
+    return (count);
+}
+
+/* Position of the frame between the last two steps for vm_rigid_body_interpolate (0 to 1) */
+VM_API VM_INLINE float vm_fixed_step_alpha(vm_fixed_step *fs)
+{
+    return ((float)(fs->accumulator / fs->step));
+}
+
 #endif /* VM_H */
 
 /*
@@ -1,9 +1,11 @@
 #include "../../w32_gl.h"        /* Everything needed for Windows window/screen/opengl/mouse initialization */
 #include "../w32_open_gl_func.h" /* Load OpenGl functions not directly provided by windows (e.g. OPEN_GL_VERSION > 1.1) */
 
-/* The platform independent nostdlib application code/logic */
+/* The platform independent nostdlib application code/logic, the job system with its Win32 backend */
 #define SPEG_IMPORT
+#define SPEG_JOBS_THREADS
 #include "speg.h"
+#include "speg_ring.h"
 
 typedef struct w32_type_llu
 {
@@ -27,6 +29,7 @@ static bool globalRunning = true;
 static bool globalPause = false;
 static bool vsync = true;
 static bool wireframeMode = false;
+static bool traceCapture = false; /* F7 starts/stops writing the profiler frames to speg_trace.json */
 
 static int width = 800;
 static int height = 600;
@@ -34,7 +37,6 @@ static double dt = 0.0;
 void *window;
 
 static unsigned int drawCallsPerFrame = 0;
-static int occludedObjectsPerFrame = 0;
 
 typedef struct File
 {
@@ -94,6 +96,23 @@ File w32_read_entire_file(char *path)
   return tmp;
 }
 
+bool w32_write_entire_file(char *path, void *content, unsigned long size)
+{
+  unsigned long bytesWritten;
+  void *hFile = CreateFileA(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+
+  if (hFile == INVALID_HANDLE_VALUE)
+  {
+    win32_print_console("[win32] invalid handle for file %s\n", path);
+    return false;
+  }
+
+  bool written = WriteFile(hFile, content, size, &bytesWritten, NULL) && bytesWritten == size;
+  CloseHandle(hFile);
+
+  return written;
+}
+
 static FILETIME empty = {0, 0};
 FILETIME w32_file_mod_time(char *file)
 {
@@ -108,12 +127,15 @@ typedef struct speg_shader
   FILETIME fsTime;
   char *vsFile;
   char *fsFile;
+  int uniformLocationProjectionView;
 } speg_shader;
 
 typedef struct speg_shaders
 {
 
-  speg_shader instanced;
+  speg_shader instanced;        /* SPEG_INSTANCE_FORMAT_M4X4 */
+  speg_shader instanced_affine; /* SPEG_INSTANCE_FORMAT_AFFINE, SPEG_INSTANCE_FORMAT_AFFINE_HALF */
+  speg_shader instanced_trs;    /* SPEG_INSTANCE_FORMAT_TRS, SPEG_INSTANCE_FORMAT_TRS_HALF */
 
 } speg_shaders;
 
@@ -190,17 +212,43 @@ speg_shader shader_load(char *vertexShaderFile, char *fragmentShaderFile)
 void shader_load_all(void)
 {
   shaders.instanced = shader_load("test_instanced.vs", "test_instanced.fs");
+  shaders.instanced_affine = shader_load("test_instanced_affine.vs", "test_instanced.fs");
+  shaders.instanced_trs = shader_load("test_instanced_trs.vs", "test_instanced.fs");
+}
+
+/* The vertex shader that rebuilds the model matrix from the instance format */
+speg_shader *shader_for_format(int instance_format)
+{
+  switch (instance_format)
+  {
+  case SPEG_INSTANCE_FORMAT_AFFINE:
+  case SPEG_INSTANCE_FORMAT_AFFINE_HALF:
+    return &shaders.instanced_affine;
+  case SPEG_INSTANCE_FORMAT_TRS:
+  case SPEG_INSTANCE_FORMAT_TRS_HALF:
+    return &shaders.instanced_trs;
+  default:
+    return &shaders.instanced;
+  }
+}
+
+bool shader_changed(speg_shader *shader)
+{
+  FILETIME vs = w32_file_mod_time(shader->vsFile);
+  FILETIME fs = w32_file_mod_time(shader->fsFile);
+
+  return CompareFileTime(&vs, &shader->vsTime) != 0 || CompareFileTime(&fs, &shader->fsTime) != 0;
 }
 
+#ifndef GL_HALF_FLOAT
+#define GL_HALF_FLOAT 0x140B
+#endif
+
 static int sizeVec2 = sizeof(float) * 2;
 static int sizeVec3 = sizeof(float) * 3;
 static int sizeM4x4 = sizeof(float) * 16;
 
 static bool initialized_gl = false;
-static int uniformLocationProjectionView = -1;
-static int uniformLocationAtlasTexture = -1;
-static int uniformLocationAtlasRows = -1;
-static int uniformLocationAtlasColumns = -1;
 static unsigned int font_texture;
 
 static unsigned char font_atlas[] = {
@@ -237,14 +285,234 @@ static unsigned char font_atlas[] = {
     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
 
-void platform_draw(speg_draw_call *draw_call, float uniformProjectionView[16])
+/* Instance model attributes (layout = 2 - 5) for the instance format of the draw call starting at offset in the bound buffer */
+void platform_instance_attributes(int instance_format, unsigned long long offset)
 {
-  if (draw_call->count_instances == 0)
+  int stride = speg_instance_model_size(instance_format);
+  bool half = instance_format == SPEG_INSTANCE_FORMAT_AFFINE_HALF || instance_format == SPEG_INSTANCE_FORMAT_TRS_HALF;
+  unsigned int type = half ? GL_HALF_FLOAT : GL_FLOAT;
+  unsigned long long component = half ? 2 : 4;
+  unsigned int count = 4;
+
+  switch (instance_format)
   {
-    return;
+  case SPEG_INSTANCE_FORMAT_AFFINE:
+  case SPEG_INSTANCE_FORMAT_AFFINE_HALF:
+    /* translation (2), column major 3x3 split into vec4 (3), vec4 (4), float (5) */
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, stride, (void *)offset);
+    glVertexAttribPointer(3, 4, type, GL_FALSE, stride, (void *)(offset + 12));
+    glVertexAttribPointer(4, 4, type, GL_FALSE, stride, (void *)(offset + 12 + 4 * component));
+    glVertexAttribPointer(5, 1, type, GL_FALSE, stride, (void *)(offset + 12 + 8 * component));
+    break;
+
+  case SPEG_INSTANCE_FORMAT_TRS:
+  case SPEG_INSTANCE_FORMAT_TRS_HALF:
+    /* position (2), rotation quaternion (3), scale (4) */
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, stride, (void *)offset);
+    glVertexAttribPointer(3, 4, type, GL_FALSE, stride, (void *)(offset + 12));
+    glVertexAttribPointer(4, 3, type, GL_FALSE, stride, (void *)(offset + 12 + 4 * component));
+    count = 3;
+    break;
+
+  default:
+    /* set attribute pointers 2 - 5 for matrix (4 times vec4) */
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+      glVertexAttribPointer(2 + i, 4, GL_FLOAT, GL_FALSE, sizeM4x4, (void *)(offset + (unsigned long long)i * sizeof(float) * 4));
+    }
+    break;
   }
 
+  for (unsigned int i = 0; i < count; ++i)
+  {
+    glEnableVertexAttribArray(2 + i);
+    glVertexAttribDivisor(2 + i, 1);
+  }
+}
+
+/* Instance color attribute (layout = 6) starting at offset in the bound buffer */
+void platform_color_attribute(int color_format, unsigned long long offset)
+{
+  if (color_format == SPEG_INSTANCE_COLOR_RGBA8)
+  {
+    glVertexAttribPointer(6, 4, GL_UNSIGNED_BYTE, GL_TRUE, 4, (void *)offset);
+  }
+  else
+  {
+    glVertexAttribPointer(6, 3, GL_FLOAT, GL_FALSE, sizeVec3, (void *)offset);
+  }
+}
+
+/*************************/
+/* Instance streaming    */
+/*************************/
+#define STREAM_CAPACITY (1024 * 1024 * 2) /* power of two, some frames of dynamic instances */
+
+/* One persistently mapped buffer the dynamic draw calls write into (OpenGL 4.4 or ARB_buffer_storage) */
+static unsigned int streamBuffer;
+static speg_ring streamRing;
+
+void *stream_fence_insert(void *user)
+{
+  (void)user;
+  return (glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+}
+
+int stream_fence_signaled(void *user, void *fence)
+{
+  unsigned int result = glClientWaitSync((GLsync)fence, 0, 0);
+  (void)user;
+  return (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED);
+}
+
+void stream_fence_wait(void *user, void *fence)
+{
+  /* Flush once so the fence reaches the GPU, then wait in 1 ms steps */
+  unsigned int flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+  unsigned int result;
+  (void)user;
+
+  do
+  {
+    result = glClientWaitSync((GLsync)fence, flags, 1000000ULL);
+    flags = 0;
+  } while (result == GL_TIMEOUT_EXPIRED);
+}
+
+void stream_fence_release(void *user, void *fence)
+{
+  (void)user;
+  glDeleteSync((GLsync)fence);
+}
+
+/* Returns false if persistently mapped buffers are not supported, the draw calls then use their own arrays */
+bool stream_init(void)
+{
+  unsigned int flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+  speg_ring_fences fences;
+  void *memory;
+
+  if (!glBufferStorage || !glMapBufferRange)
+  {
+    return false;
+  }
+
+  glGenBuffers(1, &streamBuffer);
+  glBindBuffer(GL_ARRAY_BUFFER, streamBuffer);
+  glBufferStorage(GL_ARRAY_BUFFER, STREAM_CAPACITY, 0, flags);
+  memory = glMapBufferRange(GL_ARRAY_BUFFER, 0, STREAM_CAPACITY, flags);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  if (!memory)
+  {
+    glDeleteBuffers(1, &streamBuffer);
+    return false;
+  }
+
+  fences.insert = stream_fence_insert;
+  fences.signaled = stream_fence_signaled;
+  fences.wait = stream_fence_wait;
+  fences.release = stream_fence_release;
+  fences.user = 0;
+
+  return (speg_ring_init(&streamRing, memory, STREAM_CAPACITY, &fences) != 0);
+}
+
+void *platform_stream_alloc(unsigned int size, unsigned int *position)
+{
+  return (streamRing.memory ? speg_ring_alloc(&streamRing, size, 16, position) : 0);
+}
+
+/* Address space for the growable draw calls, pages are committed as the application appends instances */
+void *platform_memory_reserve(unsigned long size)
+{
+  return (VirtualAlloc(0, size, MEM_RESERVE, PAGE_NOACCESS));
+}
+
+int platform_memory_commit(void *memory, unsigned long size)
+{
+  return (size == 0 || VirtualAlloc(memory, size, MEM_COMMIT, PAGE_READWRITE) != 0);
+}
+
+void platform_memory_release(void *memory, unsigned long size)
+{
+  (void)size;
+  VirtualFree(memory, 0, MEM_RELEASE);
+}
+
+/* Job system behind platform_job_*, one worker per logical processor (the main thread is worker 0) */
+static speg_jobs jobs;
+
+int platform_job_workers(void)
+{
+  return (jobs.workers_count > 0 ? jobs.workers_count : 1);
+}
+
+void platform_job_submit(speg_job_function function, void *data, speg_job_counter *counter)
+{
+  speg_jobs_submit(&jobs, function, data, counter);
+}
+
+void platform_job_parallel_for(speg_job_range_function function, void *data, int count, int batch, speg_job_counter *counter)
+{
+  speg_jobs_parallel_for(&jobs, function, data, count, batch, counter);
+}
+
+void platform_job_wait(speg_job_counter *counter)
+{
+  speg_jobs_wait(&jobs, counter);
+}
+
+/* The simulate phase of a pipelined frame as a job */
+typedef struct simulate_job
+{
+  speg_memory *memory;
+  platform_controller_input *input;
+  speg_platform_api *platformApi;
+  int packet; /* Filled, then the packet to submit */
+
+} simulate_job;
+
+void simulate_job_run(void *data, int worker)
+{
+  simulate_job *job = (simulate_job *)data;
+  (void)worker;
+
+  job->packet = speg_simulate(job->memory, job->input, job->platformApi, job->packet);
+}
+
+int jobs_init(void)
+{
+  speg_jobs_worker *workers = VirtualAlloc(0, sizeof(speg_jobs_worker) * SPEG_JOBS_MAX_WORKERS, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+
+  return (workers ? speg_jobs_init(&jobs, workers, speg_jobs_processor_count()) : 0);
+}
+
+/* Points the instance attributes (layout = 2 - 6, 9) of the bound vertex array at the instances the application wrote into the stream buffer */
+void platform_stream_attributes(speg_draw_call *draw_call)
+{
+  unsigned long long offset = speg_ring_offset(&streamRing, draw_call->stream_position);
+
+  glBindBuffer(GL_ARRAY_BUFFER, streamBuffer);
+
+  platform_instance_attributes(draw_call->instance_format, offset);
+  offset += (unsigned long long)(draw_call->count_instances_max * speg_instance_model_size(draw_call->instance_format));
+
+  platform_color_attribute(draw_call->color_format, offset);
+  offset += (unsigned long long)(draw_call->count_instances_max * speg_instance_color_size(draw_call->color_format));
+
+  glVertexAttribIPointer(9, 1, GL_INT, sizeof(int), (void *)offset);
+
+  /* Keeps the data alive when an earlier frame is drawn again (debug mode) */
+  speg_ring_reuse(&streamRing, draw_call->stream_position);
+}
+
+/* Creates the mesh buffers on first use and uploads the instances of the draw call (all, grown or dirty ranges) */
+void platform_upload_instances(speg_draw_call *draw_call)
+{
   speg_mesh *mesh = draw_call->mesh;
+  int sizeModels = draw_call->count_instances * speg_instance_model_size(draw_call->instance_format);
+  int sizeColors = draw_call->count_instances * speg_instance_color_size(draw_call->color_format);
 
   if (!mesh->initialized)
   {
@@ -277,21 +545,14 @@ void platform_draw(speg_draw_call *draw_call, float uniformProjectionView[16])
 
     /* Instanced mesh */
     glBindBuffer(GL_ARRAY_BUFFER, mesh->IBO);
-    glBufferData(GL_ARRAY_BUFFER, draw_call->count_instances * sizeM4x4, &draw_call->models[0], draw_call->changed ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
-
-    /* set attribute pointers 2 - 5 for matrix (4 times vec4) */
-    for (int i = 0; i < 4; ++i)
-    {
-      glEnableVertexAttribArray((unsigned int)(2 + i));
-      glVertexAttribPointer((unsigned int)(2 + i), 4, GL_FLOAT, GL_FALSE, sizeM4x4, (void *)((unsigned long long)i * sizeof(float) * 4));
-      glVertexAttribDivisor((unsigned int)(2 + i), 1);
-    }
+    glBufferData(GL_ARRAY_BUFFER, sizeModels, &draw_call->models[0], draw_call->changed ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+    platform_instance_attributes(draw_call->instance_format, 0);
 
     /* Instance color attribute (layout = 6) */
     glBindBuffer(GL_ARRAY_BUFFER, mesh->CBO);
-    glBufferData(GL_ARRAY_BUFFER, draw_call->count_instances * sizeVec3, &draw_call->colors[0], draw_call->changed ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, sizeColors, &draw_call->colors[0], draw_call->changed ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
     glEnableVertexAttribArray(6);
-    glVertexAttribPointer(6, 3, GL_FLOAT, GL_FALSE, sizeVec3, (void *)0);
+    platform_color_attribute(draw_call->color_format, 0);
     glVertexAttribDivisor(6, 1);
 
     /* Instance texture index (layout = 9)*/
@@ -304,34 +565,83 @@ void platform_draw(speg_draw_call *draw_call, float uniformProjectionView[16])
 
     glBindVertexArray(0);
 
+    mesh->instancesCapacity = draw_call->count_instances;
     mesh->initialized = true;
 
     win32_print_console("[win32] mesh initialized id: %-20s, vao: %3i, vbo: %3i, ebo: %3i, ubo: %3i, ibo: %3i, cbo: %3i, tbo: %3i, face_culling: %5s, dynamic: %5s, is_2d: %5s\n", mesh->id, mesh->VAO, mesh->VBO, mesh->EBO, mesh->UBO, mesh->IBO, mesh->CBO, mesh->TBO, mesh->faceCulling ? "true" : "false", draw_call->changed ? "true" : "false", draw_call->is_2d ? "true" : "false");
   }
 
-  /* Mesh changed */
-  if (draw_call->changed)
+  if (draw_call->streamed)
+  {
+    /* The application wrote the instances into the mapped stream buffer, nothing to upload */
+  }
+  else if (draw_call->changed)
   {
     glBindBuffer(GL_ARRAY_BUFFER, mesh->IBO);
-    glBufferData(GL_ARRAY_BUFFER, draw_call->count_instances * sizeM4x4, &draw_call->models[0], GL_DYNAMIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, sizeModels, &draw_call->models[0], GL_DYNAMIC_DRAW);
 
     glBindBuffer(GL_ARRAY_BUFFER, mesh->CBO);
-    glBufferData(GL_ARRAY_BUFFER, draw_call->count_instances * sizeVec3, &draw_call->colors[0], GL_DYNAMIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, sizeColors, &draw_call->colors[0], GL_DYNAMIC_DRAW);
 
     glBindBuffer(GL_ARRAY_BUFFER, mesh->TBO);
     glBufferData(GL_ARRAY_BUFFER, draw_call->count_instances * (int)sizeof(int), draw_call->texture_indices, GL_DYNAMIC_DRAW);
+
+    mesh->instancesCapacity = draw_call->count_instances;
   }
+  else if (draw_call->count_instances > mesh->instancesCapacity)
+  {
+    /* Grown past the buffers: reallocate for count_instances_max so later dirty ranges always fit.
+     * All instances up to count_instances_max are uploaded, writes compare against them from now on */
+    int modelSize = speg_instance_model_size(draw_call->instance_format);
+    int colorSize = speg_instance_color_size(draw_call->color_format);
 
-  if (!initialized_gl)
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->IBO);
+    glBufferData(GL_ARRAY_BUFFER, draw_call->count_instances_max * modelSize, &draw_call->models[0], GL_DYNAMIC_DRAW);
+
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->CBO);
+    glBufferData(GL_ARRAY_BUFFER, draw_call->count_instances_max * colorSize, &draw_call->colors[0], GL_DYNAMIC_DRAW);
+
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->TBO);
+    glBufferData(GL_ARRAY_BUFFER, draw_call->count_instances_max * (int)sizeof(int), draw_call->texture_indices, GL_DYNAMIC_DRAW);
+
+    mesh->instancesCapacity = draw_call->count_instances_max;
+  }
+  else if (draw_call->dirty.count > 0)
   {
-    glUseProgram(shaders.instanced.program);
+    /* Only the instance ranges the application changed */
+    int modelSize = speg_instance_model_size(draw_call->instance_format);
+    int colorSize = speg_instance_color_size(draw_call->color_format);
 
-    uniformLocationProjectionView = glGetUniformLocation(shaders.instanced.program, "pv");
+    for (int i = 0; i < draw_call->dirty.count; ++i)
+    {
+      int first = draw_call->dirty.ranges[i].first;
+      int end = first + draw_call->dirty.ranges[i].count;
+      end = end > draw_call->count_instances ? draw_call->count_instances : end;
 
-    uniformLocationAtlasTexture = glGetUniformLocation(shaders.instanced.program, "atlasTexture");
-    uniformLocationAtlasRows = glGetUniformLocation(shaders.instanced.program, "atlasRows");
-    uniformLocationAtlasColumns = glGetUniformLocation(shaders.instanced.program, "atlasColumns");
+      if (end <= first)
+      {
+        continue;
+      }
 
+      glBindBuffer(GL_ARRAY_BUFFER, mesh->IBO);
+      glBufferSubData(GL_ARRAY_BUFFER, first * modelSize, (end - first) * modelSize, (unsigned char *)draw_call->models + first * modelSize);
+
+      glBindBuffer(GL_ARRAY_BUFFER, mesh->CBO);
+      glBufferSubData(GL_ARRAY_BUFFER, first * colorSize, (end - first) * colorSize, (unsigned char *)draw_call->colors + first * colorSize);
+
+      glBindBuffer(GL_ARRAY_BUFFER, mesh->TBO);
+      glBufferSubData(GL_ARRAY_BUFFER, first * (int)sizeof(int), (end - first) * (int)sizeof(int), draw_call->texture_indices + first);
+    }
+  }
+
+  speg_dirty_clear(&draw_call->dirty);
+}
+
+/* Font atlas, program uniforms and blending, once before the first draw */
+void platform_gl_init(void)
+{
+  if (!initialized_gl)
+  {
     glGenTextures(1, &font_texture);
     glBindTexture(GL_TEXTURE_2D, font_texture);
 
@@ -350,15 +660,46 @@ void platform_draw(speg_draw_call *draw_call, float uniformProjectionView[16])
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, font_texture);
 
-    glUniform1i(uniformLocationAtlasTexture, 0);
-    glUniform1i(uniformLocationAtlasRows, 1);
-    glUniform1i(uniformLocationAtlasColumns, 95);
+    /* Every instance format has its own program sharing the fragment shader and atlas */
+    speg_shader *programs[] = {&shaders.instanced, &shaders.instanced_affine, &shaders.instanced_trs};
+    for (int i = 0; i < (int)array_size(programs); ++i)
+    {
+      glUseProgram(programs[i]->program);
+
+      programs[i]->uniformLocationProjectionView = glGetUniformLocation(programs[i]->program, "pv");
+
+      glUniform1i(glGetUniformLocation(programs[i]->program, "atlasTexture"), 0);
+      glUniform1i(glGetUniformLocation(programs[i]->program, "atlasRows"), 1);
+      glUniform1i(glGetUniformLocation(programs[i]->program, "atlasColumns"), 95);
+    }
 
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     initialized_gl = true;
   }
+}
+
+void platform_draw(speg_draw_call *draw_call, float uniformProjectionView[16])
+{
+  if (draw_call->count_instances == 0)
+  {
+    return;
+  }
+
+  speg_mesh *mesh = draw_call->mesh;
+  speg_shader *shader = shader_for_format(draw_call->instance_format);
+
+  platform_upload_instances(draw_call);
+  platform_gl_init();
+
+  if (draw_call->streamed)
+  {
+    /* Only the attribute offsets into the stream buffer move */
+    glBindVertexArray(mesh->VAO);
+    platform_stream_attributes(draw_call);
+    glBindVertexArray(0);
+  }
 
   if (!mesh->faceCulling)
   {
@@ -370,8 +711,9 @@ void platform_draw(speg_draw_call *draw_call, float uniformProjectionView[16])
     glDisable(GL_DEPTH_TEST);
   }
 
+  glUseProgram(shader->program);
   glBindVertexArray(mesh->VAO);
-  glUniformMatrix4fv(uniformLocationProjectionView, 1, GL_FALSE, uniformProjectionView);
+  glUniformMatrix4fv(shader->uniformLocationProjectionView, 1, GL_FALSE, uniformProjectionView);
   glDrawElementsInstanced(GL_TRIANGLES, mesh->indicesCount, GL_UNSIGNED_INT, 0, draw_call->count_instances);
   glBindVertexArray(0);
 
@@ -388,6 +730,141 @@ void platform_draw(speg_draw_call *draw_call, float uniformProjectionView[16])
   drawCallsPerFrame++;
 }
 
+/*************************/
+/* Multi draw indirect   */
+/*************************/
+static unsigned int indirectBuffer;
+
+/* One glMultiDrawElementsIndirect over the shared geometry. The instances come from the buffers of draw_call->mesh
+ * (or the stream buffer), each command selects its mesh in the geometry and its instances by baseInstance */
+void platform_draw_indirect(speg_draw_call *draw_call, speg_geometry *geometry, speg_indirect_command *commands, int count_commands, float uniformProjectionView[16])
+{
+  if (count_commands <= 0 || draw_call->count_instances == 0)
+  {
+    return;
+  }
+
+  speg_mesh *mesh = draw_call->mesh;
+  speg_shader *shader = shader_for_format(draw_call->instance_format);
+
+  platform_upload_instances(draw_call);
+  platform_gl_init();
+
+  if (!geometry->VAO)
+  {
+    glGenVertexArrays(1, &geometry->VAO);
+    glGenBuffers(1, &geometry->VBO);
+    glGenBuffers(1, &geometry->UBO);
+    glGenBuffers(1, &geometry->EBO);
+    glGenBuffers(1, &indirectBuffer);
+
+    glBindVertexArray(geometry->VAO);
+
+    /* position layout location = 0 */
+    glBindBuffer(GL_ARRAY_BUFFER, geometry->VBO);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(geometry->positions[0]), (void *)0);
+    glEnableVertexAttribArray(0);
+
+    /* texture UVs layout location = 1 */
+    glBindBuffer(GL_ARRAY_BUFFER, geometry->UBO);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeVec2, (void *)0);
+    glEnableVertexAttribArray(1);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, geometry->EBO);
+
+    /* Instance color and texture index, their pointers are set per draw */
+    glEnableVertexAttribArray(6);
+    glVertexAttribDivisor(6, 1);
+    glEnableVertexAttribArray(9);
+    glVertexAttribDivisor(9, 1);
+
+    glBindVertexArray(0);
+
+    win32_print_console("[win32] geometry initialized vao: %3i, vbo: %3i, ubo: %3i, ebo: %3i, indirect: %3i\n", geometry->VAO, geometry->VBO, geometry->UBO, geometry->EBO, indirectBuffer);
+  }
+
+  glBindVertexArray(geometry->VAO);
+
+  if (geometry->changed)
+  {
+    glBindBuffer(GL_ARRAY_BUFFER, geometry->VBO);
+    glBufferData(GL_ARRAY_BUFFER, (int)(geometry->vertices_count * 3 * sizeof(float)), geometry->positions, GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ARRAY_BUFFER, geometry->UBO);
+    glBufferData(GL_ARRAY_BUFFER, (int)(geometry->vertices_count * 2 * sizeof(float)), geometry->uvs, GL_STATIC_DRAW);
+
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (int)(geometry->indices_count * sizeof(unsigned int)), geometry->indices, GL_STATIC_DRAW);
+
+    geometry->changed = false;
+  }
+
+  /* Instance attributes of this draw call */
+  if (draw_call->streamed)
+  {
+    platform_stream_attributes(draw_call);
+  }
+  else
+  {
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->IBO);
+    platform_instance_attributes(draw_call->instance_format, 0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->CBO);
+    platform_color_attribute(draw_call->color_format, 0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->TBO);
+    glVertexAttribIPointer(9, 1, GL_INT, sizeof(int), (void *)0);
+  }
+
+  /* The commands are small (20 bytes each) and change every frame */
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+  glBufferData(GL_DRAW_INDIRECT_BUFFER, count_commands * (int)sizeof(speg_indirect_command), commands, GL_STREAM_DRAW);
+
+  if (!mesh->faceCulling)
+  {
+    glDisable(GL_CULL_FACE);
+  }
+
+  if (draw_call->is_2d)
+  {
+    glDisable(GL_DEPTH_TEST);
+  }
+
+  glUseProgram(shader->program);
+  glUniformMatrix4fv(shader->uniformLocationProjectionView, 1, GL_FALSE, uniformProjectionView);
+  glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, 0, count_commands, 0);
+  glBindVertexArray(0);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+  if (draw_call->is_2d)
+  {
+    glEnable(GL_DEPTH_TEST);
+  }
+
+  if (!mesh->faceCulling)
+  {
+    glEnable(GL_CULL_FACE);
+  }
+
+  drawCallsPerFrame++;
+}
+
+/* Cycle counter frequency for the trace export */
+double w32_cycles_per_microsecond(void)
+{
+  LARGE_INTEGER frequency, start, end;
+  QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&start);
+  unsigned long startCycles = w32_rdtsc();
+
+  Sleep(20);
+
+  unsigned long cycles = w32_rdtsc() - startCycles;
+  QueryPerformanceCounter(&end);
+
+  double microseconds = (double)(end.QuadPart - start.QuadPart) * 1000000.0 / (double)frequency.QuadPart;
+  return (microseconds > 0.0 ? (double)cycles / microseconds : 1.0);
+}
+
 double platform_perf_current_time_nanoseconds(void)
 {
   static LARGE_INTEGER perfCountFrequency;
@@ -444,7 +921,7 @@ static speg_code code;
 
 void loadCode(void)
 {
-  char *dllName = "speg.dll";
+  char *dllName = speg_cpu_supports_avx2() ? "speg.dll" : "speg_sse.dll";
   char *dllTempName = "speg_temp.dll";
 
   win32_print_console("[win32] load code: %s -> %s\n", dllName, dllTempName);
@@ -475,6 +952,8 @@ void loadCode(void)
   /* FIX for ERROR: ISO C forbids conversion of object pointer to function pointer type*/
   /* https://pubs.opengroup.org/onlinepubs/009695399/functions/dlsym.html */
   *(void **)(&speg_update) = GetProcAddress(code.hDLL, "speg_update");
+  *(void **)(&speg_simulate) = GetProcAddress(code.hDLL, "speg_simulate");
+  *(void **)(&speg_submit) = GetProcAddress(code.hDLL, "speg_submit");
 
   assert(speg_update);
 }
@@ -874,6 +1353,11 @@ void processKeyboardMessages(platform_controller_input *oldInput, platform_contr
         {
           toggle_fullscreen(window);
         }
+
+        else if (vkCode == VK_F7)
+        {
+          traceCapture = !traceCapture;
+        }
       }
 
       bool altKeyWasDown = ((message.lParam & ((uint32_t)1 << 29)) != 0);
@@ -1200,10 +1684,33 @@ mainCRTStartup(void)
   platformApi.platform_sleep = Sleep;
   platformApi.platform_perf_current_cycle_count = w32_rdtsc;
   platformApi.platform_perf_current_time_nanoseconds = platform_perf_current_time_nanoseconds;
+  platformApi.platform_memory_reserve = platform_memory_reserve;
+  platformApi.platform_memory_commit = platform_memory_commit;
+  platformApi.platform_memory_release = platform_memory_release;
+
+  if (stream_init())
+  {
+    platformApi.platform_stream_alloc = platform_stream_alloc;
+  }
+
+  /* Needs baseInstance as well, OpenGL 4.3 has both */
+  if (glMultiDrawElementsIndirect)
+  {
+    platformApi.platform_draw_indirect = platform_draw_indirect;
+  }
+
+  win32_print_console("[win32] instance streaming: %s\n", platformApi.platform_stream_alloc ? "persistently mapped ring buffer" : "glBufferData (no glBufferStorage)");
+  win32_print_console("[win32] multi draw indirect: %s\n", platformApi.platform_draw_indirect ? "on" : "off (no glMultiDrawElementsIndirect)");
+
+  platformApi.platform_job_workers = platform_job_workers;
+  platformApi.platform_job_submit = platform_job_submit;
+  platformApi.platform_job_parallel_for = platform_job_parallel_for;
+  platformApi.platform_job_wait = platform_job_wait;
+  win32_print_console("[win32] job system: %i workers\n", jobs_init());
 
   speg_memory memory = {0};
-  memory.permanentMemorySize = 1024 * 1024 * 1; /* 1 MB Allocation */
-  memory.transientMemorySize = 1024 * 1024 * 1; /* 1 MB Allocation */
+  memory.permanentMemorySize = 1024 * 1024 * 8; /* 8 MB Allocation, static scene and bvh (speg_state permanent arena) */
+  memory.transientMemorySize = 1024 * 1024 * 4; /* 4 MB Allocation, reset every frame (speg_state transient arena) */
   memory.permanentMemory = VirtualAlloc(0, memory.permanentMemorySize + memory.transientMemorySize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
   memory.transientMemory = ((uint8_t *)memory.permanentMemory + memory.permanentMemorySize);
 
@@ -1218,11 +1725,43 @@ mainCRTStartup(void)
 
   void *currentProc = GetCurrentProcess();
 
+  /************/
+  /* Profiler */
+  /************/
+  speg_state *state = (speg_state *)memory.permanentMemory;
+
+  unsigned int zoneHotReload = speg_profiler_zone_register(&state->profiler, "platform_hot_reload");
+  unsigned int zoneInput = speg_profiler_zone_register(&state->profiler, "platform_input");
+  unsigned int zoneUpdate = speg_profiler_zone_register(&state->profiler, "speg_update");
+  unsigned int zoneSwap = speg_profiler_zone_register(&state->profiler, "platform_swap");
+
+  /* Pipelined frames: the main thread submits and swaps the last frame while a worker simulates the next one */
+  unsigned int zoneSimulate = speg_profiler_zone_register(&state->profiler, "speg_simulate");
+  unsigned int zoneSubmit = speg_profiler_zone_register(&state->profiler_submit, "speg_submit");
+  unsigned int zoneSubmitSwap = speg_profiler_zone_register(&state->profiler_submit, "platform_swap");
+  int pendingPacket = -1;
+  bool pipelinedFrame = false; /* profiler_submit holds the submit thread of the last frame */
+
+  /* Address space only, the pages are committed by the first capture (F7) */
+  unsigned long traceBufferSize = 1024 * 1024 * 64; /* 64 MB, about 30000 frames */
+  char *traceBuffer = VirtualAlloc(0, traceBufferSize, MEM_RESERVE, PAGE_READWRITE);
+  double cyclesPerMicrosecond = w32_cycles_per_microsecond();
+  speg_profiler_trace trace = {0};
+  bool traceCapturing = false;
+
+  assert(traceBuffer);
+
   while (globalRunning)
   {
+    pipelinedFrame = false;
+    speg_profiler_frame_begin(&state->profiler, w32_rdtsc);
+    double frameBeginMicroseconds = platform_perf_current_time_nanoseconds() / 1000.0;
+
     /*********************************/
     /* (1) HOT-Reload Code & Shaders */
     /*********************************/
+    speg_profiler_begin(&state->profiler, zoneHotReload);
+
     FILETIME ddlFtCurrent = w32_file_mod_time(code.dllName);
 
     if (CompareFileTime(&ddlFtCurrent, &code.lastWriteTime) != 0)
@@ -1232,29 +1771,33 @@ mainCRTStartup(void)
 
       /* TODO: should not be reset */
       memory.initialized = false;
-    }
 
-    FILETIME vs = w32_file_mod_time(shaders.instanced.vsFile);
-    FILETIME fs = w32_file_mod_time(shaders.instanced.fsFile);
+      /* The packets lived in the old code */
+      pendingPacket = -1;
+    }
 
-    if (CompareFileTime(&vs, &shaders.instanced.vsTime) != 0 || CompareFileTime(&fs, &shaders.instanced.fsTime) != 0)
+    if (shader_changed(&shaders.instanced) || shader_changed(&shaders.instanced_affine) || shader_changed(&shaders.instanced_trs))
     {
       win32_print_console("%s", "[win32] hot reload shader files\n");
       initialized_gl = false;
       glDeleteProgram(shaders.instanced.program);
+      glDeleteProgram(shaders.instanced_affine.program);
+      glDeleteProgram(shaders.instanced_trs.program);
       shader_load_all();
     }
 
+    speg_profiler_end(&state->profiler, zoneHotReload);
+
     /************************/
     /* (2) Input Processing */
     /************************/
+    speg_profiler_begin(&state->profiler, zoneInput);
     processKeyboardMessages(oldInput, newInput);
+    speg_profiler_end(&state->profiler, zoneInput);
 
     /*****************/
     /* (3) Rendering */
     /*****************/
-    speg_state *state = (speg_state *)memory.permanentMemory;
-
     if (!globalPause)
     {
       glClearColor(state->clearColorR, state->clearColorG, state->clearColorB, 1.0f);
@@ -1262,16 +1805,69 @@ mainCRTStartup(void)
 
       state->renderedObjects = 0;
       state->culledObjects = 0;
+      state->occludedObjects = 0;
       state->dt = dt;
       state->width = width;
       state->height = height;
 
       drawCallsPerFrame = 0;
-      occludedObjectsPerFrame = 0;
 
-      speg_update(&memory, newInput, &platformApi);
+      if (jobs.workers_count > 1 && speg_simulate && speg_submit)
+      {
+        simulate_job job = {&memory, newInput, &platformApi, pendingPacket < 0 ? 0 : (pendingPacket + 1) % SPEG_FRAME_PACKETS};
+        speg_job_counter counter = {0};
+
+        /* The worker records into state->profiler until the job is done, the main thread into profiler_submit */
+        speg_profiler_frame_begin(&state->profiler_submit, w32_rdtsc);
+        speg_profiler_begin(&state->profiler, zoneSimulate);
+        platform_job_submit(simulate_job_run, &job, &counter);
 
-      SwapBuffers(dc);
+        if (streamRing.memory)
+        {
+          speg_ring_begin_frame(&streamRing);
+        }
+
+        speg_profiler_begin(&state->profiler_submit, zoneSubmit);
+        speg_submit(&memory, &platformApi, pendingPacket);
+        speg_profiler_end(&state->profiler_submit, zoneSubmit);
+
+        if (streamRing.memory)
+        {
+          speg_ring_end_frame(&streamRing);
+        }
+
+        speg_profiler_begin(&state->profiler_submit, zoneSubmitSwap);
+        SwapBuffers(dc);
+        speg_profiler_end(&state->profiler_submit, zoneSubmitSwap);
+
+        platform_job_wait(&counter);
+        speg_profiler_end(&state->profiler, zoneSimulate);
+        speg_profiler_frame_end(&state->profiler_submit);
+
+        pendingPacket = job.packet;
+        pipelinedFrame = true;
+      }
+      else
+      {
+        if (streamRing.memory)
+        {
+          speg_ring_begin_frame(&streamRing);
+        }
+
+        speg_profiler_begin(&state->profiler, zoneUpdate);
+        speg_update(&memory, newInput, &platformApi);
+        speg_profiler_end(&state->profiler, zoneUpdate);
+
+        /* Fence behind the draws reading the streamed instances of this frame */
+        if (streamRing.memory)
+        {
+          speg_ring_end_frame(&streamRing);
+        }
+
+        speg_profiler_begin(&state->profiler, zoneSwap);
+        SwapBuffers(dc);
+        speg_profiler_end(&state->profiler, zoneSwap);
+      }
     }
     else
     {
@@ -1283,6 +1879,41 @@ mainCRTStartup(void)
     newInput = oldInput;
     oldInput = tmp;
 
+    speg_profiler_frame_end(&state->profiler);
+
+    /**********************/
+    /* (3.1) Trace Export */
+    /**********************/
+    if (traceCapture)
+    {
+      if (!traceCapturing && !VirtualAlloc(traceBuffer, traceBufferSize, MEM_COMMIT, PAGE_READWRITE))
+      {
+        win32_print_console("%s", "[win32] cannot commit the trace capture buffer\n");
+        traceCapture = false;
+      }
+      else if (!traceCapturing)
+      {
+        speg_profiler_trace_begin(&trace, traceBuffer, traceBufferSize, cyclesPerMicrosecond);
+        traceCapturing = true;
+        win32_print_console("%s", "[win32] trace capture started (F7 to stop)\n");
+      }
+
+      /* Stops the capture once the buffer is full. The submit and swap of pipelined frames are a second thread */
+      traceCapture = traceCapture && speg_profiler_trace_frame(&trace, &state->profiler, frameBeginMicroseconds);
+      traceCapture = traceCapture && (!pipelinedFrame || speg_profiler_trace_thread(&trace, &state->profiler_submit, 2, "submit"));
+    }
+
+    if (!traceCapture && traceCapturing)
+    {
+      unsigned long traceSize = speg_profiler_trace_end(&trace);
+      traceCapturing = false;
+
+      if (w32_write_entire_file("speg_trace.json", traceBuffer, traceSize))
+      {
+        win32_print_console("[win32] trace capture written to speg_trace.json, %lu frames, %lu bytes\n", trace.frames, traceSize);
+      }
+    }
+
     /******************/
     /* (4) Perf. Data */
     /******************/
@@ -1322,11 +1953,31 @@ mainCRTStartup(void)
 
       wsprintfA(buffer, "%4d ms/f, %4d fps, %10d cycles, size: %4d / %4d, %s, %s\n", msPerFrame, fps, cyclesElapsed, width, height, glRenderer, glVersion);
       SetWindowTextA(window, buffer);
-      win32_print_console("[win32] %4d objs, %4d culled, %4d occlu, %4d dc/f, %4d ms/f, %5d fps, %10d cycles, %4lu handles, %lu kb\n", state->renderedObjects, state->culledObjects, occludedObjectsPerFrame, drawCallsPerFrame, msPerFrame, fps, cyclesElapsed, handleCount, memoryKb);
+      win32_print_console("[win32] %4d objs, %4d culled, %4d occlu, %4d dc/f, %4d ms/f, %5d fps, %10d cycles, %4lu handles, %lu kb\n", state->renderedObjects, state->culledObjects, state->occludedObjects, drawCallsPerFrame, msPerFrame, fps, cyclesElapsed, handleCount, memoryKb);
+
+      /* Profiler zones of the last frame */
+      for (unsigned int i = 0; i < state->profiler.zones_count; ++i)
+      {
+        speg_profiler_zone *zone = &state->profiler.zones[i];
+        if (zone->hits > 0)
+        {
+          win32_print_console("[win32]   %10lu incl, %10lu excl, %5u hits, %s\n", zone->cycles_inclusive, zone->cycles_exclusive, zone->hits, zone->name);
+        }
+      }
+
+      for (unsigned int i = 0; pipelinedFrame && i < state->profiler_submit.zones_count; ++i)
+      {
+        speg_profiler_zone *zone = &state->profiler_submit.zones[i];
+        if (zone->hits > 0)
+        {
+          win32_print_console("[win32]   %10lu incl, %10lu excl, %5u hits, %s (submit)\n", zone->cycles_inclusive, zone->cycles_exclusive, zone->hits, zone->name);
+        }
+      }
       msPassed = 0;
     }
   }
 
+  speg_jobs_shutdown(&jobs);
   ExitProcess(0);
   return 0;
 }
@@ -55,6 +55,11 @@ typedef void (*PFNGLGETQUERYOBJECTIVPROC)(unsigned int id, unsigned int pname, i
 typedef void (*PFNGLGETQUERYOBJECTUIVPROC)(unsigned int id, unsigned int pname, unsigned int *params);
 typedef void (*PFNGLDELETEQUERIESPROC)(int n, unsigned int *ids);
 typedef GLsync (*PFNGLFENCESYNCPROC)(unsigned int condition, unsigned int flags);
+typedef unsigned int (*PFNGLCLIENTWAITSYNCPROC)(GLsync sync, unsigned int flags, unsigned long long timeout);
+typedef void (*PFNGLDELETESYNCPROC)(GLsync sync);
+typedef void (*PFNGLBUFFERSTORAGEPROC)(unsigned int target, LONG_PTR size, void *data, unsigned int flags);
+typedef void *(*PFNGLMAPBUFFERRANGEPROC)(unsigned int target, LONG_PTR offset, LONG_PTR length, unsigned int access);
+typedef void (*PFNGLMULTIDRAWELEMENTSINDIRECTPROC)(unsigned int mode, unsigned int type, const void *indirect, int drawcount, int stride);
 typedef void (*PFNGLGENFRAMEBUFFERSPROC)(int n, unsigned int *ids);
 typedef void (*PFNGLBINDFRAMEBUFFERPROC)(unsigned int target, unsigned int framebuffer);
 typedef void (*PFNGLFRAMEBUFFERTEXTURE2DPROC)(unsigned int target, unsigned int attachment, unsigned int textarget, unsigned int texture, int level);
@@ -106,6 +111,11 @@ static PFNGLGETQUERYOBJECTIVPROC glGetQueryObjectiv;
 static PFNGLGETQUERYOBJECTUIVPROC glGetQueryObjectuiv;
 static PFNGLDELETEQUERIESPROC glDeleteQueries;
 static PFNGLFENCESYNCPROC glFenceSync;
+static PFNGLCLIENTWAITSYNCPROC glClientWaitSync;
+static PFNGLDELETESYNCPROC glDeleteSync;
+static PFNGLBUFFERSTORAGEPROC glBufferStorage;
+static PFNGLMAPBUFFERRANGEPROC glMapBufferRange;
+static PFNGLMULTIDRAWELEMENTSINDIRECTPROC glMultiDrawElementsIndirect;
 static PFNGLGENFRAMEBUFFERSPROC glGenFramebuffers;
 static PFNGLBINDFRAMEBUFFERPROC glBindFramebuffer;
 static PFNGLFRAMEBUFFERTEXTURE2DPROC glFramebufferTexture2D;
@@ -166,6 +176,8 @@ int w32_gl_init_gl_functions(void)
   glGetQueryObjectuiv = (PFNGLGETQUERYOBJECTUIVPROC)wglGetProcAddress("glGetQueryObjectuiv");
   glDeleteQueries = (PFNGLDELETEQUERIESPROC)wglGetProcAddress("glDeleteQueries");
   glFenceSync = (PFNGLFENCESYNCPROC)wglGetProcAddress("glFenceSync");
+  glClientWaitSync = (PFNGLCLIENTWAITSYNCPROC)wglGetProcAddress("glClientWaitSync");
+  glDeleteSync = (PFNGLDELETESYNCPROC)wglGetProcAddress("glDeleteSync");
   glGenFramebuffers = (PFNGLGENFRAMEBUFFERSPROC)wglGetProcAddress("glGenFramebuffers");
   glBindFramebuffer = (PFNGLBINDFRAMEBUFFERPROC)wglGetProcAddress("glBindFramebuffer");
   glFramebufferTexture2D = (PFNGLFRAMEBUFFERTEXTURE2DPROC)wglGetProcAddress("glFramebufferTexture2D");
@@ -181,6 +193,13 @@ int w32_gl_init_gl_functions(void)
   glUniform1i = (PFNGLUNIFORM1IPROC)wglGetProcAddress("glUniform1i");
   glActiveTexture = (PFNGLACTIVETEXTUREPROC)wglGetProcAddress("glActiveTexture");
 
+  /* Optional, OpenGL 4.4 or ARB_buffer_storage (persistently mapped buffers). Null if the driver has none */
+  glBufferStorage = (PFNGLBUFFERSTORAGEPROC)wglGetProcAddress("glBufferStorage");
+  glMapBufferRange = (PFNGLMAPBUFFERRANGEPROC)wglGetProcAddress("glMapBufferRange");
+
+  /* Optional, OpenGL 4.3 or ARB_multi_draw_indirect (with baseInstance from 4.2 or ARB_base_instance). Null if the driver has none */
+  glMultiDrawElementsIndirect = (PFNGLMULTIDRAWELEMENTSINDIRECTPROC)wglGetProcAddress("glMultiDrawElementsIndirect");
+
   W32_ASSERT(wglChoosePixelFormatARB);
   W32_ASSERT(wglCreateContextAttribsARB);
   W32_ASSERT(wglSwapIntervalEXT);
@@ -218,6 +237,8 @@ int w32_gl_init_gl_functions(void)
   W32_ASSERT(glGetQueryObjectuiv);
   W32_ASSERT(glDeleteQueries);
   W32_ASSERT(glFenceSync);
+  W32_ASSERT(glClientWaitSync);
+  W32_ASSERT(glDeleteSync);
   W32_ASSERT(glGenFramebuffers);
   W32_ASSERT(glBindFramebuffer);
   W32_ASSERT(glFramebufferTexture2D);
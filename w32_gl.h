@@ -224,9 +224,15 @@ typedef RAWINPUTDEVICE *PCRAWINPUTDEVICE;
 
 #define MEM_COMMIT 0x00001000
 #define MEM_RESERVE 0x00002000
+#define MEM_RELEASE 0x00008000
+#define PAGE_NOACCESS 0x01
 #define PAGE_READWRITE 0x04
+#define INFINITE 0xFFFFFFFF
+#define ALL_PROCESSOR_GROUPS 0xffff
 #define INVALID_HANDLE_VALUE ((void *)(LONG_PTR) - 1)
 #define GENERIC_READ (0x80000000L)
+#define GENERIC_WRITE (0x40000000L)
+#define CREATE_ALWAYS 2
 #define FILE_SHARE_READ 0x00000001
 #define OPEN_EXISTING 3
 #define FILE_ATTRIBUTE_NORMAL 0x00000080
@@ -261,6 +267,7 @@ typedef RAWINPUTDEVICE *PCRAWINPUTDEVICE;
 #define VK_F4 0x73
 #define VK_F5 0x74
 #define VK_F6 0x75
+#define VK_F7 0x76
 #define CS_VREDRAW 0x0001
 #define CS_HREDRAW 0x0002
 #define WS_OVERLAPPED 0x00000000L
@@ -337,6 +344,7 @@ typedef RAWINPUTDEVICE *PCRAWINPUTDEVICE;
 #define GL_ARRAY_BUFFER 0x8892
 #define GL_STATIC_DRAW 0x88E4
 #define GL_DYNAMIC_DRAW 0x88E8
+#define GL_STREAM_DRAW 0x88E0
 #define GL_INT 0x1404
 #define GL_FLOAT 0x1406
 #define GL_FALSE 0
@@ -353,6 +361,15 @@ typedef RAWINPUTDEVICE *PCRAWINPUTDEVICE;
 #define GL_ELEMENT_ARRAY_BUFFER 0x8893
 #define GL_UNSIGNED_INT 0x1405
 #define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#define GL_ALREADY_SIGNALED 0x911A
+#define GL_TIMEOUT_EXPIRED 0x911B
+#define GL_CONDITION_SATISFIED 0x911C
+#define GL_WAIT_FAILED 0x911D
+#define GL_MAP_WRITE_BIT 0x0002
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
 #define GL_FRAMEBUFFER 0x8D40
 #define GL_DEPTH_ATTACHMENT 0x8D00
 #define GL_DEPTH_COMPONENT 0x1902
@@ -473,6 +490,8 @@ W32_API(void *)
 CreateFileA(char *lpFileName, unsigned long dwDesiredAccess, unsigned long dwShareMode, void *, unsigned long dwCreationDisposition, unsigned long dwFlagsAndAttributes, void *hTemplateFile);
 W32_API(int)
 ReadFile(void *hFile, void *lpBuffer, unsigned long nNumberOfBytesToRead, unsigned long *lpNumberOfBytesRead, void *lpOverlapped);
+W32_API(int)
+WriteFile(void *hFile, void *lpBuffer, unsigned long nNumberOfBytesToWrite, unsigned long *lpNumberOfBytesWritten, void *lpOverlapped);
 W32_API(unsigned long)
 GetFileSize(void *hFile, unsigned long *lpFileSizeHigh);
 W32_API(void *)
@@ -483,6 +502,28 @@ W32_API(int)
 HeapFree(void *hHeap, unsigned longdwFlags, void *lpMem);
 W32_API(void *)
 VirtualAlloc(void *lpAddress, UINT_PTR dwSize, unsigned longflAllocationType, unsigned longflProtect);
+W32_API(int)
+VirtualFree(void *lpAddress, UINT_PTR dwSize, unsigned long dwFreeType);
+W32_API(void *)
+CreateThread(void *lpThreadAttributes, UINT_PTR dwStackSize, unsigned long(__stdcall *lpStartAddress)(void *), void *lpParameter, unsigned long dwCreationFlags, unsigned long *lpThreadId);
+W32_API(int)
+SwitchToThread(void);
+W32_API(unsigned long)
+WaitForSingleObject(void *hHandle, unsigned long dwMilliseconds);
+W32_API(void *)
+CreateSemaphoreA(void *lpSemaphoreAttributes, long lInitialCount, long lMaximumCount, char *lpName);
+W32_API(int)
+ReleaseSemaphore(void *hSemaphore, long lReleaseCount, long *lpPreviousCount);
+W32_API(unsigned long)
+TlsAlloc(void);
+W32_API(void *)
+TlsGetValue(unsigned long dwTlsIndex);
+W32_API(int)
+TlsSetValue(unsigned long dwTlsIndex, void *lpTlsValue);
+W32_API(int)
+TlsFree(unsigned long dwTlsIndex);
+W32_API(unsigned long)
+GetActiveProcessorCount(unsigned short GroupNumber);
 W32_API(void *)
 GetStdHandle(unsigned long nStdHandle);
 W32_API(int)